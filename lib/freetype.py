@@ -5,9 +5,11 @@ from pygame._freetype import (
    Font as _Font,
    STYLE_NORMAL, STYLE_OBLIQUE, STYLE_STRONG, STYLE_UNDERLINE, STYLE_WIDE,
    STYLE_DEFAULT,
+   ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT, ALIGN_JUSTIFY,
    init, quit,
    was_init, get_cache_size, get_default_font, get_default_resolution, 
    get_error, get_version, set_default_resolution,
+   get_cache_limit, set_cache_limit, get_cache_stats,
    _PYGAME_C_API, __PYGAMEinit__,
    )
 from pygame.sysfont import match_font, get_fonts, SysFont as _SysFont
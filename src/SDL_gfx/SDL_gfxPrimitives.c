@@ -15,6 +15,12 @@ LGPL (c) A. Schiffler
 //#include "SDL_rotozoom.h"
 #include "SDL_gfxPrimitives_font.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SSE2_ALPHA_SPAN_ROUTINE
+#endif
+
 /* -===================- */
 
 #define DEFAULT_ALPHA_PIXEL_ROUTINE
@@ -541,6 +547,48 @@ int pixelColorNolock(SDL_Surface * dst, Sint16 x, Sint16 y, Uint32 color)
 	return (result);
 }
 
+#ifdef SSE2_ALPHA_SPAN_ROUTINE
+/*!
+\brief Internal function to alpha blend a 32bpp span with SSE2, four pixels at a time.
+
+Each byte becomes d + (s - d) * alpha / 256 rounded down, the same as the
+default 32bpp routine for formats with 8 bit channels on byte boundaries.
+Like that routine, the alpha channel is blended from 0 rather than from the pixel.
+
+\param pixel The first pixel of the span.
+\param n The number of pixels in the span.
+\param color The color value in destination format.
+\param alpha Alpha blending amount for pixels.
+\param keep The bits of the format channels, all other bits are cleared.
+\param amask The alpha mask of the format.
+*/
+static void _alphaSpan32SSE2(Uint32 *pixel, int n, Uint32 color, Uint8 alpha, Uint32 keep, Uint32 amask)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i vkeep = _mm_set1_epi32((int) keep);
+	__m128i vamask = _mm_set1_epi32((int) amask);
+	/* mulhi((s - d) * 2, alpha * 128) is (s - d) * alpha >> 8 */
+	__m128i src2 = _mm_slli_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int) color), zero), 1);
+	__m128i valpha = _mm_set1_epi16((short) (alpha << 7));
+	__m128i d, lo, hi;
+
+	for (; n >= 4; n -= 4, pixel += 4) {
+		d = _mm_andnot_si128(vamask, _mm_loadu_si128((__m128i *) pixel));
+		lo = _mm_unpacklo_epi8(d, zero);
+		hi = _mm_unpackhi_epi8(d, zero);
+		lo = _mm_add_epi16(lo, _mm_mulhi_epi16(_mm_sub_epi16(src2, _mm_slli_epi16(lo, 1)), valpha));
+		hi = _mm_add_epi16(hi, _mm_mulhi_epi16(_mm_sub_epi16(src2, _mm_slli_epi16(hi, 1)), valpha));
+		d = _mm_and_si128(_mm_packus_epi16(lo, hi), vkeep);
+		_mm_storeu_si128((__m128i *) pixel, d);
+	}
+	for (; n > 0; n--, pixel++) {
+		lo = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) (*pixel & ~amask)), zero);
+		lo = _mm_add_epi16(lo, _mm_mulhi_epi16(_mm_sub_epi16(src2, _mm_slli_epi16(lo, 1)), valpha));
+		d = _mm_and_si128(_mm_packus_epi16(lo, lo), vkeep);
+		*pixel = (Uint32) _mm_cvtsi128_si32(d);
+	}
+}
+#endif
 
 /*!
 \brief Internal function to draw filled rectangle with alpha blending.
@@ -691,23 +739,43 @@ int _filledRectAlpha(SDL_Surface * dst, Sint16 x1, Sint16 y1, Sint16 x2, Sint16
 			Bshift = format->Bshift;
 			Ashift = format->Ashift;
 
-			dR = (color & Rmask);
-			dG = (color & Gmask);
-			dB = (color & Bmask);
-			dA = (color & Amask);
+			dR = (color & Rmask) >> Rshift;
+			dG = (color & Gmask) >> Gshift;
+			dB = (color & Bmask) >> Bshift;
+			dA = (color & Amask) >> Ashift;
+
+#ifdef SSE2_ALPHA_SPAN_ROUTINE
+			/*
+			* 8 bit channels on byte boundaries can be blended bytewise 
+			*/
+			if (format->Rloss == 0 && format->Gloss == 0 && format->Bloss == 0 &&
+				(Amask == 0 || format->Aloss == 0) &&
+				((Rshift | Gshift | Bshift | Ashift) & 7) == 0) {
+					for (y = y1; y <= y2; y++) {
+						row = (Uint32 *) dst->pixels + y * dst->pitch / 4;
+						_alphaSpan32SSE2(row + x1, x2 - x1 + 1, color, alpha,
+							Rmask | Gmask | Bmask | Amask, Amask);
+					}
+					break;
+			}
+#endif
 
+			/*
+			* Channel differences are taken signed, so a channel in the top
+			* byte does not wrap when the color is darker than the pixel 
+			*/
 			for (y = y1; y <= y2; y++) {
 				row = (Uint32 *) dst->pixels + y * dst->pitch / 4;
 				for (x = x1; x <= x2; x++) {
 					pixel = row + x;
 
-					R = ((*pixel & Rmask) + ((((dR - (*pixel & Rmask)) >> Rshift) * alpha >> 8) << Rshift)) & Rmask;
-					G = ((*pixel & Gmask) + ((((dG - (*pixel & Gmask)) >> Gshift) * alpha >> 8) << Gshift)) & Gmask;
-					B = ((*pixel & Bmask) + ((((dB - (*pixel & Bmask)) >> Bshift) * alpha >> 8) << Bshift)) & Bmask;
+					R = ((*pixel & Rmask) + ((Uint32) (((Sint32) dR - (Sint32) ((*pixel & Rmask) >> Rshift)) * alpha >> 8) << Rshift)) & Rmask;
+					G = ((*pixel & Gmask) + ((Uint32) (((Sint32) dG - (Sint32) ((*pixel & Gmask) >> Gshift)) * alpha >> 8) << Gshift)) & Gmask;
+					B = ((*pixel & Bmask) + ((Uint32) (((Sint32) dB - (Sint32) ((*pixel & Bmask) >> Bshift)) * alpha >> 8) << Bshift)) & Bmask;
 					*pixel = R | G | B;
 					if (Amask!=0)
 					{
-						A = ((*pixel & Amask) + ((((dA - (*pixel & Amask)) >> Ashift) * alpha >> 8) << Ashift)) & Amask;
+						A = ((*pixel & Amask) + ((Uint32) (((Sint32) dA - (Sint32) ((*pixel & Amask) >> Ashift)) * alpha >> 8) << Ashift)) & Amask;
 						*pixel |= A;
 					}					
 				}
@@ -5676,6 +5744,414 @@ int texturedPolygon(SDL_Surface * dst, const Sint16 * vx, const Sint16 * vy, int
 }
 
 
+/* ---- Textured triangles */
+
+/*!
+\brief Longest run of pixels mapped affinely between two exact perspective divisions.
+*/
+#define GFX_TEXTRI_SUBSPAN 16
+
+/*!
+\brief Internal state for mapping one texture onto spans of triangles.
+*/
+typedef struct {
+	SDL_Surface *dst;
+	SDL_Surface *texture;
+	int w, h;
+	int umask, vmask;	/* w - 1 and h - 1 if both are powers of two, else -1 */
+	int mode;		/* one of the _TEXTRI_* span loops */
+	Uint32 colorkey;
+	int keyed;
+	Uint8 alpha;		/* per surface alpha, or 255 */
+} _TexturedTriangles;
+
+#define _TEXTRI_COPY32  0	/* same 32 bit format, texels copied */
+#define _TEXTRI_BLEND32 1	/* same 32 bit format, texels blended by their alpha */
+#define _TEXTRI_GENERIC 2	/* any format, through _putPixelAlpha */
+
+/*!
+\brief Internal function wrapping a texel coordinate into the texture.
+*/
+static int _texturedTrianglesWrap(int c, int size)
+{
+	c %= size;
+	return (c < 0) ? c + size : c;
+}
+
+/*!
+\brief Internal function reading the texel at 16.16 fixed point coordinates u and v.
+*/
+static Uint32 _texturedTrianglesTexel(_TexturedTriangles *tt, Sint32 u, Sint32 v)
+{
+	int x, y;
+	Uint8 *p;
+
+	if (tt->umask >= 0) {
+		x = (u >> 16) & tt->umask;
+		y = (v >> 16) & tt->vmask;
+	} else {
+		x = _texturedTrianglesWrap(u >> 16, tt->w);
+		y = _texturedTrianglesWrap(v >> 16, tt->h);
+	}
+	p = (Uint8 *) tt->texture->pixels + y * tt->texture->pitch + x * tt->texture->format->BytesPerPixel;
+	switch (tt->texture->format->BytesPerPixel) {
+	case 1:
+		return *p;
+	case 2:
+		return *(Uint16 *) p;
+	case 3:
+		if (SDL_BYTEORDER == SDL_BIG_ENDIAN) {
+			return (p[0] << 16) | (p[1] << 8) | p[2];
+		} else {
+			return p[0] | (p[1] << 8) | (p[2] << 16);
+		}
+	default:
+		return *(Uint32 *) p;
+	}
+}
+
+/*!
+\brief Internal function mapping the texture onto count pixels from (x, y) rightward.
+
+\param tt The mapping state.
+\param x X coordinate of the first pixel, inside the clipping rectangle.
+\param y Y coordinate of the pixels, inside the clipping rectangle.
+\param count Number of pixels.
+\param u Texture x coordinate of the first pixel, 16.16 fixed point.
+\param v Texture y coordinate of the first pixel, 16.16 fixed point.
+\param du Step of u from one pixel to the next.
+\param dv Step of v from one pixel to the next.
+*/
+static void _texturedTrianglesSpan(_TexturedTriangles *tt, int x, int y, int count,
+								   Sint32 u, Sint32 v, Sint32 du, Sint32 dv)
+{
+	Uint32 *row, *texels, texel, d, lo, hi, rgbmask;
+	int pitch, umask, vmask;
+	Uint32 a;
+	Uint8 r, g, b, ta;
+
+	if (tt->mode == _TEXTRI_COPY32 && tt->umask >= 0) {
+		/*
+		* The common case gets its own loop: a power of two texture
+		* copied into a surface of the same 32 bit format
+		*/
+		row = (Uint32 *) ((Uint8 *) tt->dst->pixels + y * tt->dst->pitch) + x;
+		texels = (Uint32 *) tt->texture->pixels;
+		pitch = tt->texture->pitch >> 2;
+		umask = tt->umask;
+		vmask = tt->vmask;
+		while (count--) {
+			*row++ = texels[((v >> 16) & vmask) * pitch + ((u >> 16) & umask)];
+			u += du;
+			v += dv;
+		}
+		return;
+	}
+
+	if (tt->mode == _TEXTRI_COPY32) {
+		row = (Uint32 *) ((Uint8 *) tt->dst->pixels + y * tt->dst->pitch) + x;
+		while (count--) {
+			*row++ = _texturedTrianglesTexel(tt, u, v);
+			u += du;
+			v += dv;
+		}
+		return;
+	}
+
+	if (tt->mode == _TEXTRI_BLEND32) {
+		/*
+		* Two channels at a time, a stretched to 0..256 so that a
+		* texel of full alpha is copied exactly; the destination
+		* alpha is kept, as SDL does when blitting
+		*/
+		row = (Uint32 *) ((Uint8 *) tt->dst->pixels + y * tt->dst->pitch) + x;
+		rgbmask = tt->dst->format->Rmask | tt->dst->format->Gmask | tt->dst->format->Bmask;
+		while (count--) {
+			texel = _texturedTrianglesTexel(tt, u, v);
+			a = (texel & tt->texture->format->Amask) >> tt->texture->format->Ashift;
+			a += a >> 7;
+			d = *row;
+			lo = (((texel & 0x00ff00ff) * a + (d & 0x00ff00ff) * (256 - a)) >> 8) & 0x00ff00ff;
+			hi = ((((texel >> 8) & 0x00ff00ff) * a + ((d >> 8) & 0x00ff00ff) * (256 - a)) >> 8) & 0x00ff00ff;
+			*row++ = ((lo | (hi << 8)) & rgbmask) | (d & ~rgbmask);
+			u += du;
+			v += dv;
+		}
+		return;
+	}
+
+	for (; count > 0; count--, x++, u += du, v += dv) {
+		texel = _texturedTrianglesTexel(tt, u, v);
+		if (tt->keyed && texel == tt->colorkey) {
+			continue;
+		}
+		SDL_GetRGBA(texel, tt->texture->format, &r, &g, &b, &ta);
+		if (!(tt->texture->flags & SDL_SRCALPHA)) {
+			ta = 255;
+		} else if (!tt->texture->format->Amask) {
+			ta = tt->alpha;
+		}
+		if (ta) {
+			_putPixelAlpha(tt->dst, (Sint16) x, (Sint16) y,
+				SDL_MapRGBA(tt->dst->format, r, g, b, ta), ta);
+		}
+	}
+}
+
+/*!
+\brief Internal function giving the x coordinate of an edge at height yc.
+
+All edges are evaluated from their upper to their lower end, so the triangles
+on either side of a shared edge get the same result.
+*/
+static double _texturedTrianglesEdge(const float *a, const float *b, double yc)
+{
+	return a[0] + (yc - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+}
+
+/*!
+\brief Internal function drawing one textured triangle.
+
+\param tt The mapping state.
+\param v0 The vertices as x, y, u, v and z, sorted top to bottom.
+\param v1 See v0.
+\param v2 See v0.
+\param perspective Set to interpolate u/z, v/z and 1/z instead of u and v.
+*/
+static void _texturedTriangle(_TexturedTriangles *tt, const float *v0, const float *v1,
+							  const float *v2, int perspective)
+{
+	double area, a[3][3], dadx[3], dady[3], yc, xl, xr, t, px, q, s0, t0, s1, t1;
+	int i, y, ystart, yend, xs, xe, n;
+	int left = tt->dst->clip_rect.x;
+	int right = tt->dst->clip_rect.x + tt->dst->clip_rect.w;
+	int top = tt->dst->clip_rect.y;
+	int bottom = tt->dst->clip_rect.y + tt->dst->clip_rect.h;
+
+	area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+	if (area == 0.0) {
+		return;
+	}
+
+	/*
+	* The attributes are planes over the screen: u and v, or u/z,
+	* v/z and 1/z for perspective
+	*/
+	for (i = 0; i < 3; i++) {
+		const float *vert = (i == 0) ? v0 : ((i == 1) ? v1 : v2);
+
+		if (perspective) {
+			a[i][2] = 1.0 / vert[4];
+			a[i][0] = vert[2] * a[i][2];
+			a[i][1] = vert[3] * a[i][2];
+		} else {
+			a[i][0] = vert[2];
+			a[i][1] = vert[3];
+			a[i][2] = 1.0;
+		}
+	}
+	for (i = 0; i < 3; i++) {
+		dadx[i] = ((a[1][i] - a[0][i]) * (v2[1] - v0[1]) - (a[2][i] - a[0][i]) * (v1[1] - v0[1])) / area;
+		dady[i] = ((a[2][i] - a[0][i]) * (v1[0] - v0[0]) - (a[1][i] - a[0][i]) * (v2[0] - v0[0])) / area;
+	}
+
+	/*
+	* Pixels are drawn when their center is inside, or on a top or
+	* left edge, so triangles sharing an edge neither overlap nor
+	* leave gaps
+	*/
+	ystart = (int) ceil(v0[1] - 0.5);
+	yend = (int) ceil(v2[1] - 0.5);
+	if (ystart < top) {
+		ystart = top;
+	}
+	if (yend > bottom) {
+		yend = bottom;
+	}
+	for (y = ystart; y < yend; y++) {
+		yc = y + 0.5;
+		xl = _texturedTrianglesEdge(v0, v2, yc);
+		xr = (yc < v1[1]) ? _texturedTrianglesEdge(v0, v1, yc) : _texturedTrianglesEdge(v1, v2, yc);
+		if (xl > xr) {
+			t = xl;
+			xl = xr;
+			xr = t;
+		}
+		xs = (int) ceil(xl - 0.5);
+		xe = (int) ceil(xr - 0.5);
+		if (xs < left) {
+			xs = left;
+		}
+		if (xe > right) {
+			xe = right;
+		}
+		if (xs >= xe) {
+			continue;
+		}
+
+		px = xs + 0.5 - v0[0];
+		s0 = a[0][0] + dadx[0] * px + dady[0] * (yc - v0[1]);
+		t0 = a[0][1] + dadx[1] * px + dady[1] * (yc - v0[1]);
+		if (!perspective) {
+			/* keep the fixed point values small */
+			s1 = floor(s0 / tt->w) * tt->w;
+			t1 = floor(t0 / tt->h) * tt->h;
+			_texturedTrianglesSpan(tt, xs, y, xe - xs,
+				(Sint32) ((s0 - s1) * 65536.0), (Sint32) ((t0 - t1) * 65536.0),
+				(Sint32) (dadx[0] * 65536.0), (Sint32) (dadx[1] * 65536.0));
+			continue;
+		}
+
+		/*
+		* Divide exactly every GFX_TEXTRI_SUBSPAN pixels, and step
+		* linearly in between.  Where the depth changes fast the runs
+		* are halved, until stepping linearly strays less than about
+		* half a texel from the curve u and v follow
+		*/
+		q = a[0][2] + dadx[2] * px + dady[2] * (yc - v0[1]);
+		s1 = s0 / q;
+		t1 = t0 / q;
+		while (xs < xe) {
+			double u0 = s1, w0 = t1, ub, vb, qn;
+
+			n = xe - xs;
+			if (n > GFX_TEXTRI_SUBSPAN) {
+				n = GFX_TEXTRI_SUBSPAN;
+			}
+			for (;;) {
+				qn = q + dadx[2] * n;
+				s1 = (s0 + dadx[0] * n) / qn;
+				t1 = (t0 + dadx[1] * n) / qn;
+				if (n == 1 || (fabs(s1 - u0) + fabs(t1 - w0)) * fabs(dadx[2] * n) <=
+					2.0 * (fabs(q) < fabs(qn) ? fabs(q) : fabs(qn))) {
+					break;
+				}
+				n >>= 1;
+			}
+			s0 += dadx[0] * n;
+			t0 += dadx[1] * n;
+			q = qn;
+			ub = floor(u0 / tt->w) * tt->w;
+			vb = floor(w0 / tt->h) * tt->h;
+			_texturedTrianglesSpan(tt, xs, y, n,
+				(Sint32) ((u0 - ub) * 65536.0), (Sint32) ((w0 - vb) * 65536.0),
+				(Sint32) ((s1 - u0) * 65536.0 / n), (Sint32) ((t1 - w0) * 65536.0 / n));
+			xs += n;
+		}
+	}
+}
+
+/*!
+\brief Draws triangles mapped with a texture.
+
+The texture is tiled, so texture coordinates outside of it wrap around. Pixels
+are drawn when their center is inside a triangle, or on its top or left edge,
+so triangles sharing edges cover each pixel once. Texels are copied straight
+when the texture has the same 32 bit format as the surface, and otherwise
+converted and blended like SDL_BlitSurface does, honoring colorkey, per surface
+and per pixel alpha.
+
+\param dst The surface to draw on.
+\param vertices Three vertices for each triangle, each as five floats: the screen
+x and y, the texture x and y in pixels, and the depth z.
+\param n The number of triangles.
+\param texture The surface to map onto the triangles.
+\param perspective When nonzero the texture is mapped perspective correct using
+the depths, which must be positive; otherwise the depths are ignored.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int texturedTriangles(SDL_Surface * dst, const float *vertices, int n, SDL_Surface * texture, int perspective)
+{
+	_TexturedTriangles tt;
+	SDL_PixelFormat *df, *tf;
+	const float *v[3], *tmp;
+	int i;
+
+	if ((dst->clip_rect.w==0) || (dst->clip_rect.h==0) || n <= 0) {
+		return(0);
+	}
+	if (texture->w <= 0 || texture->h <= 0) {
+		return(0);
+	}
+
+	tt.dst = dst;
+	tt.texture = texture;
+	tt.w = texture->w;
+	tt.h = texture->h;
+	tt.umask = tt.vmask = -1;
+	if (!(tt.w & (tt.w - 1)) && !(tt.h & (tt.h - 1))) {
+		tt.umask = tt.w - 1;
+		tt.vmask = tt.h - 1;
+	}
+	tt.keyed = (texture->flags & SDL_SRCCOLORKEY) != 0;
+	tt.colorkey = texture->format->colorkey;
+	tt.alpha = texture->format->alpha;
+
+	/*
+	* Pick the span loop
+	*/
+	df = dst->format;
+	tf = texture->format;
+	tt.mode = _TEXTRI_GENERIC;
+	if (df->BytesPerPixel == 4 && tf->BytesPerPixel == 4 && !tt.keyed &&
+		df->Rmask == tf->Rmask && df->Gmask == tf->Gmask && df->Bmask == tf->Bmask) {
+		if (!(texture->flags & SDL_SRCALPHA) && df->Amask == tf->Amask) {
+			tt.mode = _TEXTRI_COPY32;
+		} else if ((texture->flags & SDL_SRCALPHA) && tf->Amask && !tf->Aloss &&
+			!df->Rloss && !df->Gloss && !df->Bloss &&
+			!(df->Rshift & 7) && !(df->Gshift & 7) && !(df->Bshift & 7)) {
+			tt.mode = _TEXTRI_BLEND32;
+		}
+	}
+
+	/*
+	* Lock the surfaces
+	*/
+	if (SDL_MUSTLOCK(dst)) {
+		if (SDL_LockSurface(dst) < 0) {
+			return (-1);
+		}
+	}
+	if (texture != dst && SDL_MUSTLOCK(texture)) {
+		if (SDL_LockSurface(texture) < 0) {
+			if (SDL_MUSTLOCK(dst)) {
+				SDL_UnlockSurface(dst);
+			}
+			return (-1);
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		v[0] = vertices + i * 15;
+		v[1] = v[0] + 5;
+		v[2] = v[1] + 5;
+		if (v[1][1] < v[0][1]) {
+			tmp = v[0]; v[0] = v[1]; v[1] = tmp;
+		}
+		if (v[2][1] < v[1][1]) {
+			tmp = v[1]; v[1] = v[2]; v[2] = tmp;
+		}
+		if (v[1][1] < v[0][1]) {
+			tmp = v[0]; v[0] = v[1]; v[1] = tmp;
+		}
+		_texturedTriangle(&tt, v[0], v[1], v[2], perspective);
+	}
+
+	/*
+	* Unlock the surfaces
+	*/
+	if (texture != dst && SDL_MUSTLOCK(texture)) {
+		SDL_UnlockSurface(texture);
+	}
+	if (SDL_MUSTLOCK(dst)) {
+		SDL_UnlockSurface(dst);
+	}
+
+	return (0);
+}
+
+
 /* ---- Character */
 
 /*!
@@ -193,6 +193,7 @@ extern "C" {
 	SDL_GFXPRIMITIVES_SCOPE int filledPolygonRGBA(SDL_Surface * dst, const Sint16 * vx,
 		const Sint16 * vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	SDL_GFXPRIMITIVES_SCOPE int texturedPolygon(SDL_Surface * dst, const Sint16 * vx, const Sint16 * vy, int n, SDL_Surface * texture,int texture_dx,int texture_dy);
+	SDL_GFXPRIMITIVES_SCOPE int texturedTriangles(SDL_Surface * dst, const float *vertices, int n, SDL_Surface * texture, int perspective);
 
 	/* (Note: These MT versions are required for multi-threaded operation.) */
 
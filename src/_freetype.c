@@ -46,6 +46,9 @@ static PyObject *_ft_was_init(PyObject *);
 static PyObject *_ft_autoinit(PyObject *);
 static void _ft_autoquit(void);
 static PyObject *_ft_get_cache_size(PyObject *);
+static PyObject *_ft_get_cache_limit(PyObject *);
+static PyObject *_ft_set_cache_limit(PyObject *, PyObject *);
+static PyObject *_ft_get_cache_stats(PyObject *, PyObject *);
 static PyObject *_ft_get_default_resolution(PyObject *);
 static PyObject *_ft_set_default_resolution(PyObject *, PyObject *);
 static PyObject *_ft_get_default_font(PyObject* self);
@@ -65,6 +68,8 @@ static PyObject *_ftfont_getrect(PgFontObject *, PyObject *, PyObject *);
 static PyObject *_ftfont_getmetrics(PgFontObject *, PyObject *, PyObject *);
 static PyObject *_ftfont_render(PgFontObject *, PyObject *, PyObject *);
 static PyObject *_ftfont_render_to(PgFontObject *, PyObject *, PyObject *);
+static PyObject *_ftfont_render_paragraph(PgFontObject *, PyObject *,
+                                          PyObject *);
 static PyObject *_ftfont_render_raw(PgFontObject *, PyObject *, PyObject *);
 static PyObject *_ftfont_render_raw_to(PgFontObject *, PyObject *, PyObject *);
 static PyObject *_ftfont_getsizedascender(PgFontObject *, PyObject *);
@@ -95,6 +100,8 @@ static PyObject *_ftfont_getrotation(PgFontObject *, void *);
 static int _ftfont_setrotation(PgFontObject *, PyObject *, void *);
 static PyObject *_ftfont_getfgcolor(PgFontObject *, void *);
 static int _ftfont_setfgcolor(PgFontObject *, PyObject *, void *);
+static PyObject *_ftfont_getlayoutcachesize(PgFontObject *, void *);
+static int _ftfont_setlayoutcachesize(PgFontObject *, PyObject *, void *);
 
 static PyObject *_ftfont_getresolution(PgFontObject *, void *);
 
@@ -107,7 +114,6 @@ static PyObject *_ftfont_getrender_flag(PgFontObject *, void *);
 static int _ftfont_setrender_flag(PgFontObject *, PyObject *, void *);
 
 #if defined(PGFT_DEBUG_CACHE)
-static PyObject *_ftfont_getdebugcachestats(PgFontObject *, void *);
 #endif
 
 /*
@@ -466,6 +472,24 @@ static PyMethodDef _ft_methods[] = {
         METH_NOARGS,
         DOC_PYGAMEFREETYPEGETCACHESIZE
     },
+    {
+        "get_cache_limit",
+        (PyCFunction) _ft_get_cache_limit,
+        METH_NOARGS,
+        DOC_PYGAMEFREETYPEGETCACHELIMIT
+    },
+    {
+        "set_cache_limit",
+        (PyCFunction) _ft_set_cache_limit,
+        METH_VARARGS,
+        DOC_PYGAMEFREETYPESETCACHELIMIT
+    },
+    {
+        "get_cache_stats",
+        (PyCFunction) _ft_get_cache_stats,
+        METH_VARARGS,
+        DOC_PYGAMEFREETYPEGETCACHESTATS
+    },
     {
         "get_default_resolution",
         (PyCFunction) _ft_get_default_resolution,
@@ -547,6 +571,12 @@ static PyMethodDef _ftfont_methods[] = {
         METH_VARARGS | METH_KEYWORDS,
         DOC_FONTRENDERTO
     },
+    {
+        "render_paragraph",
+        (PyCFunction)_ftfont_render_paragraph,
+        METH_VARARGS | METH_KEYWORDS,
+        DOC_FONTRENDERPARAGRAPH
+    },
     {
         "render_raw",
         (PyCFunction)_ftfont_render_raw,
@@ -749,15 +779,20 @@ static PyGetSetDef _ftfont_getsets[] = {
         DOC_FONTORIGIN,
         (void *)FT_RFLAG_ORIGIN
     },
-#if defined(PGFT_DEBUG_CACHE)
     {
-        "_debug_cache_stats",
-        (getter)_ftfont_getdebugcachestats,
-        0,
-        "_debug cache fields as a tuple",
+        "layout_cache_size",
+        (getter)_ftfont_getlayoutcachesize,
+        (setter)_ftfont_setlayoutcachesize,
+        DOC_FONTLAYOUTCACHESIZE,
         0
     },
-#endif
+    {
+        "use_atlas",
+        (getter)_ftfont_getrender_flag,
+        (setter)_ftfont_setrender_flag,
+        DOC_FONTUSEATLAS,
+        (void *)FT_RFLAG_USE_ATLAS
+    },
 
     { 0, 0, 0, 0, 0 }
 };
@@ -1363,6 +1398,48 @@ _ftfont_setrotation(PgFontObject *self, PyObject *value, void *closure)
     return obj_to_rotation(value, &self->rotation) ? 0 : -1;
 }
 
+/** layout cache capacity */
+static PyObject *
+_ftfont_getlayoutcachesize(PgFontObject *self, void *closure)
+{
+    ASSERT_SELF_IS_ALIVE(self);
+    return PyInt_FromLong((long)self->_internals->layout_cache_size);
+}
+
+static int
+_ftfont_setlayoutcachesize(PgFontObject *self, PyObject *value,
+                           void *closure)
+{
+    long size;
+
+    if (!PgFont_IS_ALIVE(self)) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        MODULE_NAME "." FONT_TYPE_NAME
+                        " instance is not initialized");
+        return -1;
+    }
+    if (!value) {
+        PyErr_SetString(PyExc_AttributeError,
+                        "layout_cache_size cannot be deleted");
+        return -1;
+    }
+    if (!PyInt_Check(value) && !PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "layout_cache_size must be an integer");
+        return -1;
+    }
+    size = PyInt_AsLong(value);
+    if (size == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (size < 1 || size > 0xFFFF) {
+        PyErr_SetString(PyExc_ValueError,
+                        "layout_cache_size must be between 1 and 65535");
+        return -1;
+    }
+    return _PGFT_SetLayoutCacheSize(self, (int)size);
+}
+
 /** default glyph color */
 static PyObject *
 _ftfont_getfgcolor(PgFontObject *self, void *closure)
@@ -1382,28 +1459,6 @@ _ftfont_setfgcolor(PgFontObject *self, PyObject *value, void *closure)
     return 0;
 }
 
-/** testing and debugging */
-#if defined(PGFT_DEBUG_CACHE)
-static PyObject *
-_ftfont_getdebugcachestats(PgFontObject *self, void *closure)
-{
-    /* Yes, this kind of breaches the boundary between the top level
-     * freetype.c and the lower level ft_text.c. But it is built
-     * conditionally, and it keeps some of the Python api out
-     * of ft_text.c and ft_cache.c (hoping to remove the Python
-     * api completely from ft_text.c and support C modules at some point.)
-     */
-    const FontCache *cache = &PGFT_FONT_CACHE(self);
-
-    return Py_BuildValue("kkkkk",
-                         (unsigned long)cache->_debug_count,
-                         (unsigned long)cache->_debug_delete_count,
-                         (unsigned long)cache->_debug_access,
-                         (unsigned long)cache->_debug_hit,
-                         (unsigned long)cache->_debug_miss);
-}
-#endif
-
 /****************************************************
  * MAIN METHODS
  ****************************************************/
@@ -1940,6 +1995,137 @@ _ftfont_render(PgFontObject *self, PyObject *args, PyObject *kwds)
 #endif // HAVE_PYGAME_SDL_VIDEO
 }
 
+static PyObject *
+_ftfont_render_paragraph(PgFontObject *self, PyObject *args, PyObject *kwds)
+{
+#ifndef HAVE_PYGAME_SDL_VIDEO
+
+    PyErr_SetString(PyExc_RuntimeError,
+                    "SDL support is missing. Cannot render on surfaces");
+    return 0;
+
+#else
+    /* keyword list */
+    static char *kwlist[] =  {
+        "text", "width", "fgcolor", "bgcolor", "style", "size",
+        "align", "line_spacing", 0
+    };
+
+    /* input arguments */
+    PyObject *textobj = 0;
+    PGFT_String *text = 0;
+    int width = 0;
+    Scale_t face_size = FACE_SIZE_NONE;
+    PyObject *fg_color_obj = 0;
+    PyObject *bg_color_obj = 0;
+    int style = FT_STYLE_DEFAULT;
+    int align = FT_ALIGN_LEFT;
+    double line_spacing = 1.0;
+
+    /* output arguments */
+    SDL_Surface *surface = 0;
+    PyObject *surface_obj = 0;
+    PyObject *rtuple = 0;
+    SDL_Rect r;
+    PyObject *rect_obj = 0;
+
+    FontColor fg_color;
+    FontColor bg_color;
+    FontRenderMode render;
+
+    ASSERT_SELF_IS_ALIVE(self);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|iOOiO&id", kwlist,
+                                     /* required */
+                                     &textobj,
+                                     /* optional */
+                                     &width, &fg_color_obj, &bg_color_obj,
+                                     &style,
+                                     obj_to_scale, (void *)&face_size,
+                                     &align, &line_spacing))
+        goto error;
+
+    if (width < 0) {
+        PyErr_SetString(PyExc_ValueError, "width must not be negative");
+        goto error;
+    }
+    if (align < FT_ALIGN_LEFT || align > FT_ALIGN_JUSTIFY) {
+        PyErr_Format(PyExc_ValueError, "unknown alignment %d", align);
+        goto error;
+    }
+    if (line_spacing < 0.0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "line_spacing must not be negative");
+        goto error;
+    }
+
+    if (fg_color_obj == Py_None) {
+        fg_color_obj = 0;
+    }
+    if (bg_color_obj == Py_None) {
+        bg_color_obj = 0;
+    }
+
+    if (fg_color_obj) {
+        if (!RGBAFromColorObj(fg_color_obj, (Uint8 *)&fg_color)) {
+            PyErr_SetString(PyExc_TypeError, "fgcolor must be a Color");
+            goto error;
+        }
+    }
+    else {
+        fg_color.r = self->fgcolor[0];
+        fg_color.g = self->fgcolor[1];
+        fg_color.b = self->fgcolor[2];
+        fg_color.a = self->fgcolor[3];
+    }
+    if (bg_color_obj) {
+        if (!RGBAFromColorObj(bg_color_obj, (Uint8 *)&bg_color)) {
+            PyErr_SetString(PyExc_TypeError, "bgcolor must be a Color");
+            goto error;
+        }
+    }
+
+    /* Encode text */
+    text = _PGFT_EncodePyString(textobj, self->render_flags & FT_RFLAG_UCS4);
+    if (!text) goto error;
+
+    if (_PGFT_BuildRenderMode(self->freetype, self,
+                              &render, face_size, style, self->rotation))
+        goto error;
+
+    surface = _PGFT_Render_Paragraph(self->freetype, self, &render, text,
+                                     width, align, DBL_TO_FX16(line_spacing),
+                                     &fg_color,
+                                     bg_color_obj ? &bg_color : 0, &r);
+    if (!surface) goto error;
+    free_string(text);
+    surface_obj = PySurface_New(surface);
+    if (!surface_obj) goto error;
+
+    rect_obj = PyRect_New(&r);
+    if (!rect_obj) goto error;
+    rtuple = PyTuple_Pack(2, surface_obj, rect_obj);
+    if (!rtuple) goto error;
+    Py_DECREF(surface_obj);
+    Py_DECREF(rect_obj);
+
+    return rtuple;
+
+  error:
+    free_string(text);
+    if (surface_obj) {
+        Py_DECREF(surface_obj);
+    }
+    else if (surface) {
+        SDL_FreeSurface(surface);
+    }
+    Py_XDECREF(rect_obj);
+    Py_XDECREF(rtuple);
+    return 0;
+
+#endif // HAVE_PYGAME_SDL_VIDEO
+}
+
 static PyObject *
 _ftfont_render_to(PgFontObject *self, PyObject *args, PyObject *kwds)
 {
@@ -2110,6 +2296,8 @@ _ft_autoinit(PyObject *self)
         if (_PGFT_Init(&(FREETYPE_MOD_STATE(self)->freetype), cache_size)) {
             return 0;
         }
+        _PGFT_Cache_SetLimit(FREETYPE_MOD_STATE(self)->freetype,
+                             FREETYPE_MOD_STATE(self)->cache_limit);
         FREETYPE_MOD_STATE(self)->cache_size = cache_size;
     }
 
@@ -2197,6 +2385,63 @@ _ft_get_cache_size(PyObject *self)
     return PyLong_FromUnsignedLong((unsigned long)(FREETYPE_STATE->cache_size));
 }
 
+static PyObject *
+_ft_get_cache_limit(PyObject *self)
+{
+    return PyLong_FromSize_t(FREETYPE_STATE->cache_limit);
+}
+
+static PyObject *
+_ft_set_cache_limit(PyObject *self, PyObject *args)
+{
+    Py_ssize_t limit = 0;
+    _FreeTypeState *state = FREETYPE_MOD_STATE(self);
+
+    if (!PyArg_ParseTuple(args, "|n", &limit)) {
+        return 0;
+    }
+    if (limit < 0) {
+        return RAISE(PyExc_ValueError, "cache limit must be positive");
+    }
+
+    state->cache_limit = (limit ?
+                          (size_t)limit : PGFT_DEFAULT_CACHE_LIMIT);
+    if (state->freetype) {
+        _PGFT_Cache_SetLimit(state->freetype, state->cache_limit);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+_ft_get_cache_stats(PyObject *self, PyObject *args)
+{
+    PyObject *fontobj = 0;
+    FreeTypeInstance *ft;
+    const CacheStats *stats;
+    size_t memory;
+
+    if (!PyArg_ParseTuple(args, "|O!", &PgFont_Type, &fontobj)) {
+        return 0;
+    }
+
+    if (fontobj) {
+        const FontCache *cache;
+
+        ASSERT_SELF_IS_ALIVE(fontobj);
+        cache = &((PgFontObject *)fontobj)->_internals->glyph_cache;
+        stats = &cache->stats;
+        memory = cache->memory;
+    }
+    else {
+        ASSERT_GRAB_FREETYPE(ft, 0);
+        stats = &ft->cache_stats;
+        memory = ft->cache_memory;
+    }
+
+    return Py_BuildValue("kkkn", stats->hits, stats->misses,
+                         stats->evictions, (Py_ssize_t)memory);
+}
+
 static PyObject *
 _ft_get_default_resolution(PyObject *self)
 {
@@ -2318,6 +2563,7 @@ MODINIT_DEFINE (_freetype)
 
     FREETYPE_MOD_STATE(module)->freetype = 0;
     FREETYPE_MOD_STATE(module)->cache_size = 0;
+    FREETYPE_MOD_STATE(module)->cache_limit = PGFT_DEFAULT_CACHE_LIMIT;
     FREETYPE_MOD_STATE(module)->resolution = PGFT_DEFAULT_RESOLUTION;
 
     Py_INCREF((PyObject *)&PgFont_Type);
@@ -2342,6 +2588,11 @@ MODINIT_DEFINE (_freetype)
     DEC_CONST(BBOX_PIXEL);
     DEC_CONST(BBOX_PIXEL_GRIDFIT);
 
+    DEC_CONST(ALIGN_LEFT);
+    DEC_CONST(ALIGN_CENTER);
+    DEC_CONST(ALIGN_RIGHT);
+    DEC_CONST(ALIGN_JUSTIFY);
+
     /* export the c api */
 #   if PYGAMEAPI_FREETYPE_NUMSLOTS != 2
 #       error Mismatch between number of api slots and actual exports.
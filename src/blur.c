@@ -0,0 +1,481 @@
+/*
+    pygame - Python Game Library
+    Copyright (C) 2000-2001  Pete Shinners
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Pete Shinners
+    pete@shinners.org
+*/
+
+/*
+   Blurs and separable convolution for the transform module.
+
+   Every byte of a 24 or 32 bit pixel is filtered on its own, so these work
+   for any layout of 8 bit channels.  Edges repeat the outermost pixels.
+
+   Box blurs keep a running sum over the window, so their cost does not
+   depend on the radius.  A gaussian blur is three box blurs with radii
+   picked to match its standard deviation.  The horizontal pass of each
+   filter goes over rows, the vertical pass keeps one running sum per byte
+   of a row and slides it down the image, so both passes read memory in
+   order.  Both passes are split into bands of rows run on threads.
+*/
+
+#include <SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pgparallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLUR_SSE2
+#endif
+
+/* Images smaller than this many pixels per band are not worth a thread. */
+#define BLUR_MIN_BAND_PIXELS 32768
+
+#define CLAMP_INDEX(i, n) ((i) < 0 ? 0 : ((i) >= (n) ? (n) - 1 : (i)))
+
+typedef struct {
+    Uint8 *src;
+    int srcpitch;
+    Uint8 *dst;
+    int dstpitch;
+    float *fbuf;                /* w * h * bpp floats, convolve only */
+    int w, h, bpp;
+    int radius;
+    const float *kernel;
+    int klen;
+    int failed;
+} blur_job_t;
+
+int blur_box (SDL_Surface *src, SDL_Surface *dst, int radius);
+int blur_gaussian (SDL_Surface *src, SDL_Surface *dst, double radius);
+int blur_convolve (SDL_Surface *src, SDL_Surface *dst,
+                   const float *kernel_x, int nx,
+                   const float *kernel_y, int ny);
+
+/* Horizontal box pass over rows [start, end). */
+static void
+box_band_h (void *data, int band, int start, int end)
+{
+    blur_job_t *job = (blur_job_t *) data;
+    const int w = job->w, bpp = job->bpp, r = job->radius;
+    const float inv = 1.0f / (2 * r + 1);
+    Uint32 sums[4];
+    const Uint8 *src;
+    Uint8 *dst;
+    int x, y, c, i;
+#if defined(BLUR_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128 vinv = _mm_set1_ps (inv);
+    const __m128 vhalf = _mm_set1_ps (0.5f);
+    __m128i vsum, in, out;
+#endif
+
+    for (y = start; y < end; ++y) {
+        src = job->src + y * job->srcpitch;
+        dst = job->dst + y * job->dstpitch;
+        for (c = 0; c < bpp; ++c) {
+            sums[c] = src[c] * (r + 1);
+            for (i = 1; i <= r; ++i) {
+                sums[c] += src[CLAMP_INDEX (i, w) * bpp + c];
+            }
+        }
+#if defined(BLUR_SSE2)
+        if (bpp == 4) {
+            vsum = _mm_loadu_si128 ((const __m128i *) sums);
+            for (x = 0; x < w; ++x) {
+                out = _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (
+                          _mm_cvtepi32_ps (vsum), vinv), vhalf));
+                out = _mm_packs_epi32 (out, out);
+                *(Uint32 *) (dst + x * 4) =
+                    (Uint32) _mm_cvtsi128_si32 (_mm_packus_epi16 (out, out));
+                in = _mm_cvtsi32_si128 (
+                    *(const int *) (src + CLAMP_INDEX (x + r + 1, w) * 4));
+                vsum = _mm_add_epi32 (vsum, _mm_unpacklo_epi16 (
+                           _mm_unpacklo_epi8 (in, zero), zero));
+                in = _mm_cvtsi32_si128 (
+                    *(const int *) (src + CLAMP_INDEX (x - r, w) * 4));
+                vsum = _mm_sub_epi32 (vsum, _mm_unpacklo_epi16 (
+                           _mm_unpacklo_epi8 (in, zero), zero));
+            }
+            continue;
+        }
+#endif
+        for (x = 0; x < w; ++x) {
+            for (c = 0; c < bpp; ++c) {
+                dst[x * bpp + c] = (Uint8) (sums[c] * inv + 0.5f);
+                sums[c] += src[CLAMP_INDEX (x + r + 1, w) * bpp + c];
+                sums[c] -= src[CLAMP_INDEX (x - r, w) * bpp + c];
+            }
+        }
+    }
+}
+
+/* Vertical box pass writing rows [start, end), one running sum for each
+   byte of a row. */
+static void
+box_band_v (void *data, int band, int start, int end)
+{
+    blur_job_t *job = (blur_job_t *) data;
+    const int n = job->w * job->bpp, h = job->h, r = job->radius;
+    const float inv = 1.0f / (2 * r + 1);
+    Uint32 *sums;
+    const Uint8 *add, *sub;
+    Uint8 *dst;
+    int i, y, k;
+#if defined(BLUR_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128 vinv = _mm_set1_ps (inv);
+    const __m128 vhalf = _mm_set1_ps (0.5f);
+    __m128i s0, s1, s2, s3, in, lo, hi;
+#endif
+
+    sums = (Uint32 *) malloc (sizeof (Uint32) * (n + 1));
+    if (!sums) {
+        job->failed = 1;
+        return;
+    }
+    memset (sums, 0, sizeof (Uint32) * n);
+    for (k = -r; k <= r; ++k) {
+        add = job->src + CLAMP_INDEX (start + k, h) * job->srcpitch;
+        for (i = 0; i < n; ++i) {
+            sums[i] += add[i];
+        }
+    }
+
+    for (y = start; y < end; ++y) {
+        dst = job->dst + y * job->dstpitch;
+        add = job->src + CLAMP_INDEX (y + r + 1, h) * job->srcpitch;
+        sub = job->src + CLAMP_INDEX (y - r, h) * job->srcpitch;
+        i = 0;
+#if defined(BLUR_SSE2)
+        for (; i + 16 <= n; i += 16) {
+            s0 = _mm_loadu_si128 ((const __m128i *) (sums + i));
+            s1 = _mm_loadu_si128 ((const __m128i *) (sums + i + 4));
+            s2 = _mm_loadu_si128 ((const __m128i *) (sums + i + 8));
+            s3 = _mm_loadu_si128 ((const __m128i *) (sums + i + 12));
+
+#define BLUR_DIV(v) _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps ( \
+                        _mm_cvtepi32_ps (v), vinv), vhalf))
+            lo = _mm_packs_epi32 (BLUR_DIV (s0), BLUR_DIV (s1));
+            hi = _mm_packs_epi32 (BLUR_DIV (s2), BLUR_DIV (s3));
+#undef BLUR_DIV
+            _mm_storeu_si128 ((__m128i *) (dst + i), _mm_packus_epi16 (lo, hi));
+
+            in = _mm_loadu_si128 ((const __m128i *) (add + i));
+            lo = _mm_unpacklo_epi8 (in, zero);
+            hi = _mm_unpackhi_epi8 (in, zero);
+            s0 = _mm_add_epi32 (s0, _mm_unpacklo_epi16 (lo, zero));
+            s1 = _mm_add_epi32 (s1, _mm_unpackhi_epi16 (lo, zero));
+            s2 = _mm_add_epi32 (s2, _mm_unpacklo_epi16 (hi, zero));
+            s3 = _mm_add_epi32 (s3, _mm_unpackhi_epi16 (hi, zero));
+            in = _mm_loadu_si128 ((const __m128i *) (sub + i));
+            lo = _mm_unpacklo_epi8 (in, zero);
+            hi = _mm_unpackhi_epi8 (in, zero);
+            s0 = _mm_sub_epi32 (s0, _mm_unpacklo_epi16 (lo, zero));
+            s1 = _mm_sub_epi32 (s1, _mm_unpackhi_epi16 (lo, zero));
+            s2 = _mm_sub_epi32 (s2, _mm_unpacklo_epi16 (hi, zero));
+            s3 = _mm_sub_epi32 (s3, _mm_unpackhi_epi16 (hi, zero));
+
+            _mm_storeu_si128 ((__m128i *) (sums + i), s0);
+            _mm_storeu_si128 ((__m128i *) (sums + i + 4), s1);
+            _mm_storeu_si128 ((__m128i *) (sums + i + 8), s2);
+            _mm_storeu_si128 ((__m128i *) (sums + i + 12), s3);
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = (Uint8) (sums[i] * inv + 0.5f);
+            sums[i] += add[i];
+            sums[i] -= sub[i];
+        }
+    }
+    free (sums);
+}
+
+/* Horizontal convolution of rows [start, end) into the float buffer. */
+static void
+convolve_band_h (void *data, int band, int start, int end)
+{
+    blur_job_t *job = (blur_job_t *) data;
+    const int w = job->w, bpp = job->bpp, klen = job->klen;
+    const int r = klen / 2;
+    const float *kernel = job->kernel;
+    const Uint8 *src;
+    float *pad, *out, acc;
+    int x, y, c, k;
+#if defined(BLUR_SSE2)
+    __m128 vacc;
+#endif
+
+    /* One row with r edge pixels repeated on both sides, so the inner
+       loop does not need to clamp. */
+    pad = (float *) malloc (sizeof (float) * (w + klen) * bpp);
+    if (!pad) {
+        job->failed = 1;
+        return;
+    }
+
+    for (y = start; y < end; ++y) {
+        src = job->src + y * job->srcpitch;
+        out = job->fbuf + (size_t) y * w * bpp;
+        for (x = -r; x < w + r; ++x) {
+            for (c = 0; c < bpp; ++c) {
+                pad[(x + r) * bpp + c] = src[CLAMP_INDEX (x, w) * bpp + c];
+            }
+        }
+#if defined(BLUR_SSE2)
+        if (bpp == 4) {
+            for (x = 0; x < w; ++x) {
+                vacc = _mm_setzero_ps ();
+                for (k = 0; k < klen; ++k) {
+                    vacc = _mm_add_ps (vacc, _mm_mul_ps (
+                               _mm_loadu_ps (pad + (x + k) * 4),
+                               _mm_set1_ps (kernel[k])));
+                }
+                _mm_storeu_ps (out + x * 4, vacc);
+            }
+            continue;
+        }
+#endif
+        for (x = 0; x < w; ++x) {
+            for (c = 0; c < bpp; ++c) {
+                acc = 0.0f;
+                for (k = 0; k < klen; ++k) {
+                    acc += pad[(x + k) * bpp + c] * kernel[k];
+                }
+                out[x * bpp + c] = acc;
+            }
+        }
+    }
+    free (pad);
+}
+
+/* Vertical convolution of the float buffer into rows [start, end). */
+static void
+convolve_band_v (void *data, int band, int start, int end)
+{
+    blur_job_t *job = (blur_job_t *) data;
+    const int n = job->w * job->bpp, h = job->h, klen = job->klen;
+    const int r = klen / 2;
+    const float *kernel = job->kernel;
+    const float *row;
+    float *acc;
+    Uint8 *dst;
+    float v;
+    int i, y, k;
+#if defined(BLUR_SSE2)
+    const __m128 half = _mm_set1_ps (0.5f);
+    __m128 vk;
+    __m128i q0, q1, q2, q3;
+#endif
+
+    acc = (float *) malloc (sizeof (float) * (n + 1));
+    if (!acc) {
+        job->failed = 1;
+        return;
+    }
+
+    for (y = start; y < end; ++y) {
+        dst = job->dst + y * job->dstpitch;
+        memset (acc, 0, sizeof (float) * n);
+        for (k = 0; k < klen; ++k) {
+            row = job->fbuf + (size_t) CLAMP_INDEX (y + k - r, h) * n;
+            i = 0;
+#if defined(BLUR_SSE2)
+            vk = _mm_set1_ps (kernel[k]);
+            for (; i + 4 <= n; i += 4) {
+                _mm_storeu_ps (acc + i, _mm_add_ps (_mm_loadu_ps (acc + i),
+                               _mm_mul_ps (_mm_loadu_ps (row + i), vk)));
+            }
+#endif
+            for (; i < n; ++i) {
+                acc[i] += row[i] * kernel[k];
+            }
+        }
+
+        i = 0;
+#if defined(BLUR_SSE2)
+        /* add a half and truncate, rounding as the loop below does, then
+           saturate to 0 - 255 while packing */
+        for (; i + 16 <= n; i += 16) {
+            q0 = _mm_cvttps_epi32 (_mm_add_ps (_mm_loadu_ps (acc + i), half));
+            q1 = _mm_cvttps_epi32 (_mm_add_ps (_mm_loadu_ps (acc + i + 4),
+                                               half));
+            q2 = _mm_cvttps_epi32 (_mm_add_ps (_mm_loadu_ps (acc + i + 8),
+                                               half));
+            q3 = _mm_cvttps_epi32 (_mm_add_ps (_mm_loadu_ps (acc + i + 12),
+                                               half));
+            _mm_storeu_si128 ((__m128i *) (dst + i),
+                              _mm_packus_epi16 (_mm_packs_epi32 (q0, q1),
+                                                _mm_packs_epi32 (q2, q3)));
+        }
+#endif
+        for (; i < n; ++i) {
+            v = acc[i] + 0.5f;
+            dst[i] = v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (Uint8) v);
+        }
+    }
+    free (acc);
+}
+
+static int
+blur_run (pg_band_func func, blur_job_t *job)
+{
+    int min_rows = job->w ? BLUR_MIN_BAND_PIXELS / job->w : 1;
+
+    job->failed = 0;
+    pg_run_bands (func, job, job->h, min_rows);
+    return job->failed ? -1 : 0;
+}
+
+/* One box blur from src to dst, both w * h * bpp; tmp holds the
+   horizontal pass. */
+static int
+box_blur_buffers (blur_job_t *job, Uint8 *src, int srcpitch,
+                  Uint8 *tmp, Uint8 *dst, int dstpitch, int radius)
+{
+    job->radius = radius;
+    job->src = src;
+    job->srcpitch = srcpitch;
+    job->dst = tmp;
+    job->dstpitch = job->w * job->bpp;
+    if (blur_run (box_band_h, job))
+        return -1;
+    job->src = tmp;
+    job->srcpitch = job->w * job->bpp;
+    job->dst = dst;
+    job->dstpitch = dstpitch;
+    return blur_run (box_band_v, job);
+}
+
+/* Returns 0 on success, -1 when out of memory. */
+int
+blur_box (SDL_Surface *src, SDL_Surface *dst, int radius)
+{
+    blur_job_t job;
+    Uint8 *tmp;
+    int result;
+
+    if (!src->w || !src->h)
+        return 0;
+    job.w = src->w;
+    job.h = src->h;
+    job.bpp = src->format->BytesPerPixel;
+    tmp = (Uint8 *) malloc ((size_t) job.w * job.h * job.bpp);
+    if (!tmp)
+        return -1;
+    result = box_blur_buffers (&job, (Uint8 *) src->pixels, src->pitch,
+                               tmp, (Uint8 *) dst->pixels, dst->pitch,
+                               radius);
+    free (tmp);
+    return result;
+}
+
+/* Radii of three box blurs which together approximate a gaussian with
+   standard deviation sigma. */
+static void
+gaussian_boxes (double sigma, int radii[3])
+{
+    double wideal = sqrt (4.0 * sigma * sigma + 1.0);
+    double mideal;
+    int wl, m, i;
+
+    wl = (int) floor (wideal);
+    if (wl % 2 == 0)
+        --wl;
+    mideal = ((12.0 * sigma * sigma - 3.0 * wl * wl - 12.0 * wl - 9.0) /
+              (-4.0 * wl - 4.0));
+    m = (int) floor (mideal + 0.5);
+    for (i = 0; i < 3; ++i) {
+        radii[i] = ((i < m ? wl : wl + 2) - 1) / 2;
+    }
+}
+
+/* The gaussian has a standard deviation of radius / 3, so nearly all of
+   its weight is within radius pixels. */
+int
+blur_gaussian (SDL_Surface *src, SDL_Surface *dst, double radius)
+{
+    blur_job_t job;
+    Uint8 *a, *b;
+    int radii[3];
+    int pitch, result;
+
+    if (!src->w || !src->h)
+        return 0;
+    job.w = src->w;
+    job.h = src->h;
+    job.bpp = src->format->BytesPerPixel;
+    pitch = job.w * job.bpp;
+    gaussian_boxes (radius / 3.0, radii);
+
+    a = (Uint8 *) malloc ((size_t) pitch * job.h);
+    b = (Uint8 *) malloc ((size_t) pitch * job.h);
+    if (!a || !b) {
+        free (a);
+        free (b);
+        return -1;
+    }
+    result = box_blur_buffers (&job, (Uint8 *) src->pixels, src->pitch,
+                               a, b, pitch, radii[0]);
+    if (!result)
+        result = box_blur_buffers (&job, b, pitch, a, b, pitch, radii[1]);
+    if (!result)
+        result = box_blur_buffers (&job, b, pitch, a, (Uint8 *) dst->pixels,
+                                   dst->pitch, radii[2]);
+    free (a);
+    free (b);
+    return result;
+}
+
+/* Kernels have an odd length, their middle weight lands on the pixel
+   being filtered.  Returns 0 on success, -1 when out of memory. */
+int
+blur_convolve (SDL_Surface *src, SDL_Surface *dst,
+               const float *kernel_x, int nx,
+               const float *kernel_y, int ny)
+{
+    blur_job_t job;
+    int result;
+
+    if (!src->w || !src->h)
+        return 0;
+    job.w = src->w;
+    job.h = src->h;
+    job.bpp = src->format->BytesPerPixel;
+    job.fbuf = (float *) malloc (sizeof (float) * job.w * job.h * job.bpp);
+    if (!job.fbuf)
+        return -1;
+
+    job.src = (Uint8 *) src->pixels;
+    job.srcpitch = src->pitch;
+    job.kernel = kernel_x;
+    job.klen = nx;
+    result = blur_run (convolve_band_h, &job);
+    if (!result) {
+        job.dst = (Uint8 *) dst->pixels;
+        job.dstpitch = dst->pitch;
+        job.kernel = kernel_y;
+        job.klen = ny;
+        result = blur_run (convolve_band_v, &job);
+    }
+    free (job.fbuf);
+    return result;
+}
@@ -200,6 +200,7 @@ MODINIT_DEFINE(constants)
 #define PYGAME_BLEND_RGBA_MAX  0x10
 
 #define PYGAME_BLEND_PREMULTIPLIED  0x11
+#define PYGAME_BLEND_ALPHA  0x12
 
 
     DEC_CONSTS(BLEND_ADD,  PYGAME_BLEND_ADD);
@@ -220,6 +221,7 @@ MODINIT_DEFINE(constants)
     DEC_CONSTS(BLEND_RGBA_MIN,  PYGAME_BLEND_RGBA_MIN);
     DEC_CONSTS(BLEND_RGBA_MAX,  PYGAME_BLEND_RGBA_MAX);
     DEC_CONSTS(BLEND_PREMULTIPLIED,  PYGAME_BLEND_PREMULTIPLIED);
+    DEC_CONSTS(BLEND_ALPHA,  PYGAME_BLEND_ALPHA);
 
 
 
@@ -1,23 +1,53 @@
 /* Auto generated file: with makeref.py .  Docs go in src/ *.doc . */
 #define DOC_PYGAMEDRAW "pygame module for drawing shapes"
 
-#define DOC_PYGAMEDRAWRECT "rect(Surface, color, Rect, width=0) -> Rect\ndraw a rectangle shape"
+#define DOC_PYGAMEDRAWRECT "rect(Surface, color, Rect, width=0, special_flags=0) -> Rect\ndraw a rectangle shape"
 
-#define DOC_PYGAMEDRAWPOLYGON "polygon(Surface, color, pointlist, width=0) -> Rect\ndraw a shape with any number of sides"
+#define DOC_PYGAMEDRAWAARECT "aarect(Surface, color, Rect, border_radius=0, special_flags=0) -> Rect\ndraw a filled rectangle with antialiased rounded corners"
 
-#define DOC_PYGAMEDRAWCIRCLE "circle(Surface, color, pos, radius, width=0) -> Rect\ndraw a circle around a point"
+#define DOC_PYGAMEDRAWPOLYGON "polygon(Surface, color, pointlist, width=0, special_flags=0) -> Rect\ndraw a shape with any number of sides"
 
-#define DOC_PYGAMEDRAWELLIPSE "ellipse(Surface, color, Rect, width=0) -> Rect\ndraw a round shape inside a rectangle"
+#define DOC_PYGAMEDRAWAAPOLYGON "aapolygon(Surface, color, pointlist, special_flags=0) -> Rect\ndraw a filled antialiased shape with any number of sides"
 
-#define DOC_PYGAMEDRAWARC "arc(Surface, color, Rect, start_angle, stop_angle, width=1) -> Rect\ndraw a partial section of an ellipse"
+#define DOC_PYGAMEDRAWPOLYGONS "polygons(Surface, color, pointlists, special_flags=0) -> Rect\nfill many shapes in one call"
 
-#define DOC_PYGAMEDRAWLINE "line(Surface, color, start_pos, end_pos, width=1) -> Rect\ndraw a straight line segment"
+#define DOC_PYGAMEDRAWCIRCLE "circle(Surface, color, pos, radius, width=0, special_flags=0) -> Rect\ndraw a circle around a point"
 
-#define DOC_PYGAMEDRAWLINES "lines(Surface, color, closed, pointlist, width=1) -> Rect\ndraw multiple contiguous line segments"
+#define DOC_PYGAMEDRAWAACIRCLE "aacircle(Surface, color, pos, radius, special_flags=0) -> Rect\ndraw a filled antialiased circle"
 
-#define DOC_PYGAMEDRAWAALINE "aaline(Surface, color, startpos, endpos, blend=1) -> Rect\ndraw fine antialiased lines"
+#define DOC_PYGAMEDRAWELLIPSE "ellipse(Surface, color, Rect, width=0, special_flags=0) -> Rect\ndraw a round shape inside a rectangle"
 
-#define DOC_PYGAMEDRAWAALINES "aalines(Surface, color, closed, pointlist, blend=1) -> Rect\ndraw a connected sequence of antialiased lines"
+#define DOC_PYGAMEDRAWAAELLIPSE "aaellipse(Surface, color, Rect, special_flags=0) -> Rect\ndraw a filled antialiased ellipse inside a rectangle"
+
+#define DOC_PYGAMEDRAWARC "arc(Surface, color, Rect, start_angle, stop_angle, width=1, special_flags=0) -> Rect\ndraw a partial section of an ellipse"
+
+#define DOC_PYGAMEDRAWLINE "line(Surface, color, start_pos, end_pos, width=1, special_flags=0) -> Rect\ndraw a straight line segment"
+
+#define DOC_PYGAMEDRAWLINES "lines(Surface, color, closed, pointlist, width=1, special_flags=0) -> Rect\ndraw multiple contiguous line segments"
+
+#define DOC_PYGAMEDRAWAALINE "aaline(Surface, color, startpos, endpos, blend=1, special_flags=0) -> Rect\ndraw fine antialiased lines"
+
+#define DOC_PYGAMEDRAWAALINES "aalines(Surface, color, closed, pointlist, blend=1, special_flags=0) -> Rect\ndraw a connected sequence of antialiased lines"
+
+#define DOC_PYGAMEDRAWBATCH "batch(Surface, primitives, special_flags=0) -> Rect\ndraw many points, lines, rects, circles and ellipses in one call"
+
+#define DOC_PYGAMEDRAWPATH "Path(tolerance=0.1) -> Path\npygame object for drawing vector shapes"
+
+#define DOC_PATHMOVETO "move_to(x, y) -> None\nstart a new outline"
+
+#define DOC_PATHLINETO "line_to(x, y) -> None\nadd a straight line"
+
+#define DOC_PATHQUADTO "quad_to(cx, cy, x, y) -> None\nadd a quadratic Bézier curve"
+
+#define DOC_PATHCUBICTO "cubic_to(c1x, c1y, c2x, c2y, x, y) -> None\nadd a cubic Bézier curve"
+
+#define DOC_PATHCLOSE "close() -> None\nclose the current outline"
+
+#define DOC_PATHCLEAR "clear() -> None\nremove all outlines"
+
+#define DOC_PATHFILL "fill(Surface, color, pos=(0, 0), special_flags=0) -> Rect\nfill the inside of the path"
+
+#define DOC_PATHSTROKE "stroke(Surface, color, width=1, join=JOIN_MITER, cap=CAP_BUTT, pos=(0, 0), special_flags=0) -> Rect\ndraw the outlines of the path"
 
 
 
@@ -29,39 +59,99 @@ pygame.draw
 pygame module for drawing shapes
 
 pygame.draw.rect
- rect(Surface, color, Rect, width=0) -> Rect
+ rect(Surface, color, Rect, width=0, special_flags=0) -> Rect
 draw a rectangle shape
 
+pygame.draw.aarect
+ aarect(Surface, color, Rect, border_radius=0, special_flags=0) -> Rect
+draw a filled rectangle with antialiased rounded corners
+
 pygame.draw.polygon
- polygon(Surface, color, pointlist, width=0) -> Rect
+ polygon(Surface, color, pointlist, width=0, special_flags=0) -> Rect
 draw a shape with any number of sides
 
+pygame.draw.aapolygon
+ aapolygon(Surface, color, pointlist, special_flags=0) -> Rect
+draw a filled antialiased shape with any number of sides
+
+pygame.draw.polygons
+ polygons(Surface, color, pointlists, special_flags=0) -> Rect
+fill many shapes in one call
+
 pygame.draw.circle
- circle(Surface, color, pos, radius, width=0) -> Rect
+ circle(Surface, color, pos, radius, width=0, special_flags=0) -> Rect
 draw a circle around a point
 
+pygame.draw.aacircle
+ aacircle(Surface, color, pos, radius, special_flags=0) -> Rect
+draw a filled antialiased circle
+
 pygame.draw.ellipse
- ellipse(Surface, color, Rect, width=0) -> Rect
+ ellipse(Surface, color, Rect, width=0, special_flags=0) -> Rect
 draw a round shape inside a rectangle
 
+pygame.draw.aaellipse
+ aaellipse(Surface, color, Rect, special_flags=0) -> Rect
+draw a filled antialiased ellipse inside a rectangle
+
 pygame.draw.arc
- arc(Surface, color, Rect, start_angle, stop_angle, width=1) -> Rect
+ arc(Surface, color, Rect, start_angle, stop_angle, width=1, special_flags=0) -> Rect
 draw a partial section of an ellipse
 
 pygame.draw.line
- line(Surface, color, start_pos, end_pos, width=1) -> Rect
+ line(Surface, color, start_pos, end_pos, width=1, special_flags=0) -> Rect
 draw a straight line segment
 
 pygame.draw.lines
- lines(Surface, color, closed, pointlist, width=1) -> Rect
+ lines(Surface, color, closed, pointlist, width=1, special_flags=0) -> Rect
 draw multiple contiguous line segments
 
 pygame.draw.aaline
- aaline(Surface, color, startpos, endpos, blend=1) -> Rect
+ aaline(Surface, color, startpos, endpos, blend=1, special_flags=0) -> Rect
 draw fine antialiased lines
 
 pygame.draw.aalines
- aalines(Surface, color, closed, pointlist, blend=1) -> Rect
+ aalines(Surface, color, closed, pointlist, blend=1, special_flags=0) -> Rect
 draw a connected sequence of antialiased lines
 
+pygame.draw.batch
+ batch(Surface, primitives, special_flags=0) -> Rect
+draw many points, lines, rects, circles and ellipses in one call
+
+pygame.draw.Path
+ Path(tolerance=0.1) -> Path
+pygame object for drawing vector shapes
+
+pygame.draw.Path.move_to
+ move_to(x, y) -> None
+start a new outline
+
+pygame.draw.Path.line_to
+ line_to(x, y) -> None
+add a straight line
+
+pygame.draw.Path.quad_to
+ quad_to(cx, cy, x, y) -> None
+add a quadratic Bézier curve
+
+pygame.draw.Path.cubic_to
+ cubic_to(c1x, c1y, c2x, c2y, x, y) -> None
+add a cubic Bézier curve
+
+pygame.draw.Path.close
+ close() -> None
+close the current outline
+
+pygame.draw.Path.clear
+ clear() -> None
+remove all outlines
+
+pygame.draw.Path.fill
+ fill(Surface, color, pos=(0, 0), special_flags=0) -> Rect
+fill the inside of the path
+
+pygame.draw.Path.stroke
+ stroke(Surface, color, width=1, join=JOIN_MITER, cap=CAP_BUTT, pos=(0, 0), special_flags=0) -> Rect
+draw the outlines of the path
+
 */
\ No newline at end of file
@@ -42,6 +42,8 @@
 #define DOC_FONTGETASCENT "get_ascent() -> int\nget the ascent of the font"
 
 #define DOC_FONTGETDESCENT "get_descent() -> int\nget the descent of the font"
+#define DOC_FONTSETRENDERCACHE "set_render_cache(limit) -> None\nkeep recently rendered text surfaces for reuse"
+#define DOC_FONTGETRENDERCACHESTATS "get_render_cache_stats() -> (hits, misses, evictions, count, bytes)\nget render cache counters"
 
 
 
@@ -137,4 +139,12 @@ pygame.font.Font.get_descent
  get_descent() -> int
 get the descent of the font
 
+pygame.font.Font.set_render_cache
+ set_render_cache(limit) -> None
+keep recently rendered text surfaces for reuse
+
+pygame.font.Font.get_render_cache_stats
+ get_render_cache_stats() -> (hits, misses, evictions, count, bytes)
+get render cache counters
+
 */
\ No newline at end of file
@@ -13,6 +13,12 @@
 
 #define DOC_PYGAMEFREETYPEGETCACHESIZE "get_cache_size() -> long\nReturn the glyph case size"
 
+#define DOC_PYGAMEFREETYPEGETCACHELIMIT "get_cache_limit() -> long\nReturn the glyph cache memory limit in bytes"
+
+#define DOC_PYGAMEFREETYPESETCACHELIMIT "set_cache_limit([limit])\nSet the glyph cache memory limit in bytes"
+
+#define DOC_PYGAMEFREETYPEGETCACHESTATS "get_cache_stats() -> (hits, misses, evictions, memory)\nget_cache_stats(font) -> (hits, misses, evictions, memory)\nReturn glyph cache counters"
+
 #define DOC_PYGAMEFREETYPEGETDEFAULTRESOLUTION "get_default_resolution() -> long\nReturn the default pixel size in dots per inch"
 
 #define DOC_PYGAMEFREETYPESETDEFAULTRESOLUTION "set_default_resolution([resolution])\nSet the default pixel size in dots per inch for the module"
@@ -53,6 +59,8 @@
 
 #define DOC_FONTRENDERTO "render_to(surf, dest, text, fgcolor=None, bgcolor=None, style=STYLE_DEFAULT, rotation=0, size=0) -> Rect\nRender text onto an existing surface"
 
+#define DOC_FONTRENDERPARAGRAPH "render_paragraph(text, width=0, fgcolor=None, bgcolor=None, style=STYLE_DEFAULT, size=0, align=ALIGN_LEFT, line_spacing=1.0) -> (Surface, Rect)\nReturn a block of wrapped text as a surface"
+
 #define DOC_FONTRENDERRAW "render_raw(text, style=STYLE_DEFAULT, rotation=0, size=0, invert=False) -> (bytes, (int, int))\nReturn rendered text as a string of bytes"
 
 #define DOC_FONTRENDERRAWTO "render_raw_to(array, text, dest=None, style=STYLE_DEFAULT, rotation=0, size=0, invert=False) -> (int, int)\nRender text into an array of ints"
@@ -91,6 +99,10 @@
 
 #define DOC_FONTORIGIN "origin -> bool\nFont render to text origin mode"
 
+#define DOC_FONTLAYOUTCACHESIZE "layout_cache_size -> int\nnumber of laid out strings kept for reuse"
+
+#define DOC_FONTUSEATLAS "use_atlas -> bool\nblit glyphs from a shared glyph atlas"
+
 #define DOC_FONTPAD "pad -> bool\npadded boundary mode"
 
 #define DOC_FONTUCS4 "ucs4 -> bool\nEnable UCS-4 mode"
@@ -130,6 +142,19 @@ pygame.freetype.get_cache_size
  get_cache_size() -> long
 Return the glyph case size
 
+pygame.freetype.get_cache_limit
+ get_cache_limit() -> long
+Return the glyph cache memory limit in bytes
+
+pygame.freetype.set_cache_limit
+ set_cache_limit([limit])
+Set the glyph cache memory limit in bytes
+
+pygame.freetype.get_cache_stats
+ get_cache_stats() -> (hits, misses, evictions, memory)
+ get_cache_stats(font) -> (hits, misses, evictions, memory)
+Return glyph cache counters
+
 pygame.freetype.get_default_resolution
  get_default_resolution() -> long
 Return the default pixel size in dots per inch
@@ -212,6 +237,10 @@ pygame.freetype.Font.render_to
  render_to(surf, dest, text, fgcolor=None, bgcolor=None, style=STYLE_DEFAULT, rotation=0, size=0) -> Rect
 Render text onto an existing surface
 
+pygame.freetype.Font.render_paragraph
+ render_paragraph(text, width=0, fgcolor=None, bgcolor=None, style=STYLE_DEFAULT, size=0, align=ALIGN_LEFT, line_spacing=1.0) -> (Surface, Rect)
+Return a block of wrapped text as a surface
+
 pygame.freetype.Font.render_raw
  render_raw(text, style=STYLE_DEFAULT, rotation=0, size=0, invert=False) -> (bytes, (int, int))
 Return rendered text as a string of bytes
@@ -288,6 +317,14 @@ pygame.freetype.Font.origin
  origin -> bool
 Font render to text origin mode
 
+pygame.freetype.Font.layout_cache_size
+ layout_cache_size -> int
+number of laid out strings kept for reuse
+
+pygame.freetype.Font.use_atlas
+ use_atlas -> bool
+blit glyphs from a shared glyph atlas
+
 pygame.freetype.Font.pad
  pad -> bool
 padded boundary mode
@@ -11,6 +11,8 @@
 
 #define DOC_PYGAMEGFXDRAWBOX "box(surface, rect, color) -> None\ndraw a box"
 
+#define DOC_PYGAMEGFXDRAWAABOX "aabox(surface, rect, rad, color) -> None\ndraw an anti-aliased box"
+
 #define DOC_PYGAMEGFXDRAWLINE "line(surface, x1, y1, x2, y2, color) -> None\ndraw a line"
 
 #define DOC_PYGAMEGFXDRAWCIRCLE "circle(surface, x, y, r, color) -> None\ndraw a circle"
@@ -21,12 +23,16 @@
 
 #define DOC_PYGAMEGFXDRAWFILLEDCIRCLE "filled_circle(surface, x, y, r, color) -> None\ndraw a filled circle"
 
+#define DOC_PYGAMEGFXDRAWFILLEDAACIRCLE "filled_aacircle(surface, x, y, r, color) -> None\ndraw a filled anti-aliased circle"
+
 #define DOC_PYGAMEGFXDRAWELLIPSE "ellipse(surface, x, y, rx, ry, color) -> None\ndraw an ellipse"
 
 #define DOC_PYGAMEGFXDRAWAAELLIPSE "aaellipse(surface, x, y, rx, ry, color) -> None\ndraw an anti-aliased ellipse"
 
 #define DOC_PYGAMEGFXDRAWFILLEDELLIPSE "filled_ellipse(surface, x, y, rx, ry, color) -> None\ndraw a filled ellipse"
 
+#define DOC_PYGAMEGFXDRAWFILLEDAAELLIPSE "filled_aaellipse(surface, x, y, rx, ry, color) -> None\ndraw a filled anti-aliased ellipse"
+
 #define DOC_PYGAMEGFXDRAWPIE "pie(surface, x, y, r, start, end, color) -> None\ndraw a pie"
 
 #define DOC_PYGAMEGFXDRAWTRIGON "trigon(surface, x1, y1, x2, y2, x3, y3, color) -> None\ndraw a triangle"
@@ -35,14 +41,20 @@
 
 #define DOC_PYGAMEGFXDRAWFILLEDTRIGON "filled_trigon(surface, x1, y1, x2, y2, x3, y3, color) -> None\ndraw a filled trigon"
 
+#define DOC_PYGAMEGFXDRAWFILLEDAATRIGON "filled_aatrigon(surface, x1, y1, x2, y2, x3, y3, color) -> None\ndraw a filled anti-aliased trigon"
+
 #define DOC_PYGAMEGFXDRAWPOLYGON "polygon(surface, points, color) -> None\ndraw a polygon"
 
 #define DOC_PYGAMEGFXDRAWAAPOLYGON "aapolygon(surface, points, color) -> None\ndraw an anti-aliased polygon"
 
 #define DOC_PYGAMEGFXDRAWFILLEDPOLYGON "filled_polygon(surface, points, color) -> None\ndraw a filled polygon"
 
+#define DOC_PYGAMEGFXDRAWFILLEDAAPOLYGON "filled_aapolygon(surface, points, color) -> None\ndraw a filled anti-aliased polygon"
+
 #define DOC_PYGAMEGFXDRAWTEXTUREDPOLYGON "textured_polygon(surface, points, texture, tx, ty) -> None\ndraw a textured polygon"
 
+#define DOC_PYGAMEGFXDRAWTEXTUREDTRIANGLES "textured_triangles(surface, texture, vertices, perspective=False) -> None\ndraw triangles mapped with a texture"
+
 #define DOC_PYGAMEGFXDRAWBEZIER "bezier(surface, points, steps, color) -> None\ndraw a Bézier curve"
 
 
@@ -74,6 +86,10 @@ pygame.gfxdraw.box
  box(surface, rect, color) -> None
 draw a box
 
+pygame.gfxdraw.aabox
+ aabox(surface, rect, rad, color) -> None
+draw an anti-aliased box
+
 pygame.gfxdraw.line
  line(surface, x1, y1, x2, y2, color) -> None
 draw a line
@@ -94,6 +110,10 @@ pygame.gfxdraw.filled_circle
  filled_circle(surface, x, y, r, color) -> None
 draw a filled circle
 
+pygame.gfxdraw.filled_aacircle
+ filled_aacircle(surface, x, y, r, color) -> None
+draw a filled anti-aliased circle
+
 pygame.gfxdraw.ellipse
  ellipse(surface, x, y, rx, ry, color) -> None
 draw an ellipse
@@ -106,6 +126,10 @@ pygame.gfxdraw.filled_ellipse
  filled_ellipse(surface, x, y, rx, ry, color) -> None
 draw a filled ellipse
 
+pygame.gfxdraw.filled_aaellipse
+ filled_aaellipse(surface, x, y, rx, ry, color) -> None
+draw a filled anti-aliased ellipse
+
 pygame.gfxdraw.pie
  pie(surface, x, y, r, start, end, color) -> None
 draw a pie
@@ -122,6 +146,10 @@ pygame.gfxdraw.filled_trigon
  filled_trigon(surface, x1, y1, x2, y2, x3, y3, color) -> None
 draw a filled trigon
 
+pygame.gfxdraw.filled_aatrigon
+ filled_aatrigon(surface, x1, y1, x2, y2, x3, y3, color) -> None
+draw a filled anti-aliased trigon
+
 pygame.gfxdraw.polygon
  polygon(surface, points, color) -> None
 draw a polygon
@@ -134,10 +162,18 @@ pygame.gfxdraw.filled_polygon
  filled_polygon(surface, points, color) -> None
 draw a filled polygon
 
+pygame.gfxdraw.filled_aapolygon
+ filled_aapolygon(surface, points, color) -> None
+draw a filled anti-aliased polygon
+
 pygame.gfxdraw.textured_polygon
  textured_polygon(surface, points, texture, tx, ty) -> None
 draw a textured polygon
 
+pygame.gfxdraw.textured_triangles
+ textured_triangles(surface, texture, vertices, perspective=False) -> None
+draw triangles mapped with a texture
+
 pygame.gfxdraw.bezier
  bezier(surface, points, steps, color) -> None
 draw a Bézier curve
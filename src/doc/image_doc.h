@@ -1,14 +1,26 @@
 /* Auto generated file: with makeref.py .  Docs go in src/ *.doc . */
 #define DOC_PYGAMEIMAGE "pygame module for image transfer"
 
-#define DOC_PYGAMEIMAGELOAD "load(filename) -> Surface\nload(fileobj, namehint="") -> Surface\nload new image from a file"
+#define DOC_PYGAMEIMAGELOAD "load(filename, convert=False, convert_alpha=False) -> Surface\nload(fileobj, namehint="", convert=False, convert_alpha=False) -> Surface\nload new image from a file"
 
-#define DOC_PYGAMEIMAGESAVE "save(Surface, filename) -> None\nsave an image to disk"
+#define DOC_PYGAMEIMAGELOADMANY "load_many(paths, convert=False, convert_alpha=False, workers=0) -> list\nload many images from files at once"
+
+#define DOC_PYGAMEIMAGELOADASYNC "load_async(path, tag=None, type=USEREVENT, namehint=\"\") -> None\nload an image from a file in the background"
+
+#define DOC_PYGAMEIMAGELOADPACK "load_pack(filename) -> (surfaces, masks)\nload all the images in a texture pack"
+
+#define DOC_PYGAMEIMAGESAVEPACK "save_pack(filename, surfaces, masks=None) -> None\nsave images to a texture pack"
+
+#define DOC_PYGAMEIMAGESAVE "save(Surface, filename, quality=85, compression=-1, filters=-1) -> None\nsave an image to disk"
+
+#define DOC_PYGAMEIMAGESAVEASYNC "save_async(Surface, filename, tag=None, type=USEREVENT, quality=85, compression=-1, filters=-1) -> None\nsave an image to disk in the background"
 
 #define DOC_PYGAMEIMAGEGETEXTENDED "get_extended() -> bool\ntest if extended image formats can be loaded"
 
 #define DOC_PYGAMEIMAGETOSTRING "tostring(Surface, format, flipped=False) -> string\ntransfer image to string buffer"
 
+#define DOC_PYGAMEIMAGETOBUFFER "tobuffer(Surface, format, buffer, flipped=False) -> None\ntransfer image into a writable buffer"
+
 #define DOC_PYGAMEIMAGEFROMSTRING "fromstring(string, size, format, flipped=False) -> Surface\ncreate new Surface from a string buffer"
 
 #define DOC_PYGAMEIMAGEFROMBUFFER "frombuffer(string, size, format) -> Surface\ncreate a new Surface that shares data inside a string buffer"
@@ -23,14 +35,34 @@ pygame.image
 pygame module for image transfer
 
 pygame.image.load
- load(filename) -> Surface
- load(fileobj, namehint="") -> Surface
+ load(filename, convert=False, convert_alpha=False) -> Surface
+ load(fileobj, namehint="", convert=False, convert_alpha=False) -> Surface
 load new image from a file
 
+pygame.image.load_many
+ load_many(paths, convert=False, convert_alpha=False, workers=0) -> list
+load many images from files at once
+
+pygame.image.load_async
+ load_async(path, tag=None, type=USEREVENT, namehint="") -> None
+load an image from a file in the background
+
+pygame.image.load_pack
+ load_pack(filename) -> (surfaces, masks)
+load all the images in a texture pack
+
+pygame.image.save_pack
+ save_pack(filename, surfaces, masks=None) -> None
+save images to a texture pack
+
 pygame.image.save
- save(Surface, filename) -> None
+ save(Surface, filename, quality=85, compression=-1, filters=-1) -> None
 save an image to disk
 
+pygame.image.save_async
+ save_async(Surface, filename, tag=None, type=USEREVENT, quality=85, compression=-1, filters=-1) -> None
+save an image to disk in the background
+
 pygame.image.get_extended
  get_extended() -> bool
 test if extended image formats can be loaded
@@ -39,6 +71,10 @@ pygame.image.tostring
  tostring(Surface, format, flipped=False) -> string
 transfer image to string buffer
 
+pygame.image.tobuffer
+ tobuffer(Surface, format, buffer, flipped=False) -> None
+transfer image into a writable buffer
+
 pygame.image.fromstring
  fromstring(string, size, format, flipped=False) -> Surface
 create new Surface from a string buffer
@@ -11,6 +11,12 @@
 
 #define DOC_PYGAMETRANSFORMSCALE2X "scale2x(Surface, DestSurface = None) -> Surface\nspecialized image doubler"
 
+#define DOC_PYGAMETRANSFORMSCALE3X "scale3x(Surface, DestSurface = None) -> Surface\nspecialized image tripler"
+
+#define DOC_PYGAMETRANSFORMSCALE4X "scale4x(Surface, DestSurface = None) -> Surface\nspecialized image quadrupler"
+
+#define DOC_PYGAMETRANSFORMXBR2X "xbr2x(Surface, DestSurface = None) -> Surface\nsmooth pixel art image doubler"
+
 #define DOC_PYGAMETRANSFORMSMOOTHSCALE "smoothscale(Surface, (width, height), DestSurface = None) -> Surface\nscale a surface to an arbitrary size smoothly"
 
 #define DOC_PYGAMETRANSFORMGETSMOOTHSCALEBACKEND "get_smoothscale_backend() -> String\nreturn smoothscale filter version in use: 'GENERIC', 'MMX', or 'SSE'"
@@ -21,10 +27,30 @@
 
 #define DOC_PYGAMETRANSFORMLAPLACIAN "laplacian(Surface, DestSurface = None) -> Surface\nfind edges in a surface"
 
+#define DOC_PYGAMETRANSFORMBOXBLUR "box_blur(Surface, radius, DestSurface = None) -> Surface\nblur a surface with a box filter"
+
+#define DOC_PYGAMETRANSFORMGAUSSIANBLUR "gaussian_blur(Surface, radius, DestSurface = None) -> Surface\nblur a surface with an approximate gaussian filter"
+
+#define DOC_PYGAMETRANSFORMCONVOLVE "convolve(Surface, kernel_x, kernel_y = None, DestSurface = None) -> Surface\nfilter a surface with a separable kernel"
+
 #define DOC_PYGAMETRANSFORMAVERAGESURFACES "average_surfaces(Surfaces, DestSurface = None, palette_colors = 1) -> Surface\nfind the average surface from many surfaces."
 
 #define DOC_PYGAMETRANSFORMAVERAGECOLOR "average_color(Surface, Rect = None) -> Color\nfinds the average color of a surface"
 
+#define DOC_PYGAMETRANSFORMRUNNINGAVERAGE "RunningAverage((width, height), window = 8, weight = 0.0) -> RunningAverage\npygame object for averaging a stream of surfaces"
+
+#define DOC_RUNNINGAVERAGEADD "add(Surface) -> None\nadd a surface to the average"
+
+#define DOC_RUNNINGAVERAGEREMOVE "remove() -> None\nremove the oldest surface from the average"
+
+#define DOC_RUNNINGAVERAGECLEAR "clear() -> None\nremove all surfaces from the average"
+
+#define DOC_RUNNINGAVERAGEGETCOUNT "get_count() -> int\nget the number of surfaces in the average"
+
+#define DOC_RUNNINGAVERAGEGETSIZE "get_size() -> (width, height)\nget the size of the averaged surfaces"
+
+#define DOC_RUNNINGAVERAGEGETSURFACE "get_surface(DestSurface = None) -> Surface\nget the average as a surface"
+
 #define DOC_PYGAMETRANSFORMTHRESHOLD "threshold(DestSurface, Surface, color, threshold = (0,0,0,0), diff_color = (0,0,0,0), change_return = 1, Surface = None, inverse = False) -> num_threshold_pixels\nfinds which, and how many pixels in a surface are within a threshold of a color."
 
 
@@ -56,6 +82,18 @@ pygame.transform.scale2x
  scale2x(Surface, DestSurface = None) -> Surface
 specialized image doubler
 
+pygame.transform.scale3x
+ scale3x(Surface, DestSurface = None) -> Surface
+specialized image tripler
+
+pygame.transform.scale4x
+ scale4x(Surface, DestSurface = None) -> Surface
+specialized image quadrupler
+
+pygame.transform.xbr2x
+ xbr2x(Surface, DestSurface = None) -> Surface
+smooth pixel art image doubler
+
 pygame.transform.smoothscale
  smoothscale(Surface, (width, height), DestSurface = None) -> Surface
 scale a surface to an arbitrary size smoothly
@@ -76,6 +114,18 @@ pygame.transform.laplacian
  laplacian(Surface, DestSurface = None) -> Surface
 find edges in a surface
 
+pygame.transform.box_blur
+ box_blur(Surface, radius, DestSurface = None) -> Surface
+blur a surface with a box filter
+
+pygame.transform.gaussian_blur
+ gaussian_blur(Surface, radius, DestSurface = None) -> Surface
+blur a surface with an approximate gaussian filter
+
+pygame.transform.convolve
+ convolve(Surface, kernel_x, kernel_y = None, DestSurface = None) -> Surface
+filter a surface with a separable kernel
+
 pygame.transform.average_surfaces
  average_surfaces(Surfaces, DestSurface = None, palette_colors = 1) -> Surface
 find the average surface from many surfaces.
@@ -84,6 +134,34 @@ pygame.transform.average_color
  average_color(Surface, Rect = None) -> Color
 finds the average color of a surface
 
+pygame.transform.RunningAverage
+ RunningAverage((width, height), window = 8, weight = 0.0) -> RunningAverage
+pygame object for averaging a stream of surfaces
+
+pygame.transform.RunningAverage.add
+ add(Surface) -> None
+add a surface to the average
+
+pygame.transform.RunningAverage.remove
+ remove() -> None
+remove the oldest surface from the average
+
+pygame.transform.RunningAverage.clear
+ clear() -> None
+remove all surfaces from the average
+
+pygame.transform.RunningAverage.get_count
+ get_count() -> int
+get the number of surfaces in the average
+
+pygame.transform.RunningAverage.get_size
+ get_size() -> (width, height)
+get the size of the averaged surfaces
+
+pygame.transform.RunningAverage.get_surface
+ get_surface(DestSurface = None) -> Surface
+get the average as a surface
+
 pygame.transform.threshold
  threshold(DestSurface, Surface, color, threshold = (0,0,0,0), diff_color = (0,0,0,0), change_return = 1, Surface = None, inverse = False) -> num_threshold_pixels
 finds which, and how many pixels in a surface are within a threshold of a color.
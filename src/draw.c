@@ -26,7 +26,16 @@
 #include "pygame.h"
 #include "pgcompat.h"
 #include "doc/draw_doc.h"
+#include "surface.h"
+#include "pgraster.h"
 #include <math.h>
+#include <limits.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DRAW_SSE2
+#endif
 
 /* Many C libraries seem to lack the trunc call (added in C99) */
 #define trunc(d)   (((d) >= 0.0) ? (floor(d)) : (ceil(d)))
@@ -37,21 +46,152 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-static int clip_and_draw_line(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, int* pts);
-static int clip_and_draw_aaline(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, float* pts, int blend);
-static int clip_and_draw_line_width(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, int width, int* pts);
+typedef struct draw_pen draw_pen;
+typedef void (*span_writer)(Uint8 *pixel, int count, const draw_pen *pen);
+typedef void (*stride_writer)(Uint8 *pixel, int count, int step, const draw_pen *pen);
+
+/* What the primitives draw with: the mapped color, and the writers that
+   either store it or blend it in with one of the special_flags. */
+struct draw_pen {
+    Uint32 color;
+    span_writer span;
+    stride_writer stride;
+
+    /* only set up for blending */
+    int blend;               /* one of PYGAME_BLEND_* */
+    Uint8 rgba[4];           /* the color at 8 bits a channel */
+    SDL_PixelFormat *format;
+    int ppa;                 /* the pixels have their own alpha */
+    int offset[3];           /* r, g and b bytes of a 24 bit pixel */
+    int simd;                /* 32 bit with 8 bit channels, for SSE2 */
+    Uint32 amask;            /* the pixel byte that is not r, g or b */
+    Uint32 spixel;           /* rgba laid out like a pixel, for SSE2 */
+};
+
+static int clip_and_draw_line(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, int* pts);
+static int clip_and_draw_aaline(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, float* pts, int blend);
+static int clip_and_draw_line_width(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, int width, int* pts);
 static int clipline(int* pts, int left, int top, int right, int bottom);
 static int clipaaline(float* pts, int left, int top, int right, int bottom);
-static void drawline(SDL_Surface* surf, Uint32 color, int startx, int starty, int endx, int endy);
-static void drawaaline(SDL_Surface* surf, Uint32 color, float startx, float starty, float endx, float endy,
+static void drawline(SDL_Surface* surf, const draw_pen *pen, int startx, int starty, int endx, int endy);
+static void drawaaline(SDL_Surface* surf, const draw_pen *pen, float startx, float starty, float endx, float endy,
                        int blend);
-static void drawhorzline(SDL_Surface* surf, Uint32 color, int startx, int starty, int endx);
-static void drawvertline(SDL_Surface* surf, Uint32 color, int x1, int y1, int y2);
-static void draw_arc(SDL_Surface *dst, int x, int y, int radius1, int radius2, double angle_start, double angle_stop, Uint32 color);
-static void draw_ellipse(SDL_Surface *dst, int x, int y, int rx, int ry, Uint32 color);
-static void draw_fillellipse(SDL_Surface *dst, int x, int y, int rx, int ry, Uint32 color);
-static void draw_fillpoly(SDL_Surface *dst, int *vx, int *vy, int n, Uint32 color);
+static void drawhorzline(SDL_Surface* surf, const draw_pen *pen, int startx, int starty, int endx);
+static void drawvertline(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int y2);
+static void draw_arc(SDL_Surface *dst, int x, int y, int radius1, int radius2, double angle_start, double angle_stop, const draw_pen *pen);
+static void draw_ellipse(SDL_Surface *dst, int x, int y, int rx, int ry, const draw_pen *pen);
+static void draw_fillellipse(SDL_Surface *dst, int x, int y, int rx, int ry, const draw_pen *pen);
+static int draw_fillpoly(SDL_Surface *dst, int *vx, int *vy, int n, const draw_pen *pen);
+static int draw_aapoly(SDL_Surface *dst, float *vx, float *vy, int n, const draw_pen *pen);
+static int aa_fill_raster(SDL_Surface *dst, pg_raster *raster, int evenodd, const draw_pen *pen);
+static void draw_ellipse_width(SDL_Surface *dst, int x, int y, int rx, int ry, int width, const draw_pen *pen);
+static void drawline_runs(SDL_Surface* surf, SDL_Rect* clip, const draw_pen *pen, int* pts,
+                          int first, int last, int xlo, int xhi, int ylo, int yhi);
+static void fill_rect_spans(SDL_Surface *surf, int x, int y, int w, int h, const draw_pen *pen);
+static int pen_init(draw_pen *pen, SDL_Surface *surf, Uint32 color, const Uint8 *rgba, int blend);
+
+/* Shapes drawn in pieces, like joined lines, outlines and ellipse rows,
+   reach some pixels more than once.  Storing a color again does no harm,
+   but blending it twice does, so when blending they draw with the pen of
+   a blend_mask, which only marks the pixels in a byte per pixel mask, and
+   blend_mask_end then blends each marked run once. */
+typedef struct {
+    draw_pen pen;            /* marks the mask, must come first */
+    SDL_Surface *surf;
+    Uint8 *mask;
+    int x, y, w, h;          /* the area the mask covers */
+    int top, bottom;         /* the rows marked */
+} blend_mask;
+
+static const draw_pen *blend_mask_begin(blend_mask *mask, SDL_Surface *surf, const draw_pen *pen,
+                                        int x, int y, int w, int h);
+static void blend_mask_end(blend_mask *mask, const draw_pen *pen);
+
+
+/* Reads a sequence of points into new x and y lists, growing bounds
+   (left, top, right, bottom) to include them.  Bad points are silently
+   skipped like in the other functions, but the first one must be good.
+   Returns the number of points read, or -1 with an exception set. */
+static int points_from_obj(PyObject *points, int minpoints, int **xlist, int **ylist, int *bounds)
+{
+    PyObject *item;
+    int x, y, length, loop, numpoints, result;
+
+    if(!PySequence_Check(points))
+    {
+        PyErr_SetString(PyExc_TypeError, "points argument must be a sequence of number pairs");
+        return -1;
+    }
+    length = PySequence_Length(points);
+    if(length < minpoints)
+    {
+        PyErr_Format(PyExc_ValueError, "points argument must contain more than %d points",
+                     minpoints - 1);
+        return -1;
+    }
+
+    item = PySequence_GetItem(points, 0);
+    result = TwoIntsFromObj(item, &x, &y);
+    Py_DECREF(item);
+    if(!result)
+    {
+        PyErr_SetString(PyExc_TypeError, "points must be number pairs");
+        return -1;
+    }
+
+    *xlist = PyMem_New(int, length);
+    *ylist = PyMem_New(int, length);
+    if(!*xlist || !*ylist)
+    {
+        PyMem_Del(*xlist); PyMem_Del(*ylist);
+        *xlist = *ylist = NULL;
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    numpoints = 0;
+    for(loop = 0; loop < length; ++loop)
+    {
+        item = PySequence_GetItem(points, loop);
+        result = TwoIntsFromObj(item, &x, &y);
+        Py_DECREF(item);
+        if(!result) continue; /*note, we silently skip over bad points :[ */
+        (*xlist)[numpoints] = x;
+        (*ylist)[numpoints] = y;
+        ++numpoints;
+        bounds[0] = MIN(x, bounds[0]);
+        bounds[1] = MIN(y, bounds[1]);
+        bounds[2] = MAX(x, bounds[2]);
+        bounds[3] = MAX(y, bounds[3]);
+    }
+    return numpoints;
+}
+
+/* Sets up pen for colorobj, either a color already mapped for surf or a
+   color object, drawn with the special_flags blend mode.  Returns -1 with
+   an exception set if either is bad. */
+static int pen_from_obj(draw_pen *pen, SDL_Surface *surf, PyObject *colorobj, int special_flags)
+{
+    Uint8 rgba[4];
+    Uint32 color;
+    int mapped = PyInt_Check(colorobj);
 
+    if(mapped)
+        color = (Uint32)PyInt_AsLong(colorobj);
+    else if(RGBAFromColorObj(colorobj, rgba))
+        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
+    else
+    {
+        PyErr_SetString(PyExc_TypeError, "invalid color argument");
+        return -1;
+    }
+    if(!pen_init(pen, surf, color, mapped ? NULL : rgba, special_flags))
+    {
+        PyErr_SetString(PyExc_ValueError, "invalid special_flags for drawing");
+        return -1;
+    }
+    return 0;
+}
 
 
 static PyObject* aaline(PyObject* self, PyObject* arg)
@@ -62,22 +202,21 @@ static PyObject* aaline(PyObject* self, PyObject* arg)
     int top, left, bottom, right;
     int blend=1;
     float pts[4];
-    Uint8 rgba[4];
-    Uint32 color;
+    draw_pen pen;
+    int special_flags = 0;
     int anydraw;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OOO|i", &PySurface_Type, &surfobj, &colorobj, &start, &end, &blend))
+    if(!PyArg_ParseTuple(arg, "O!OOO|ii", &PySurface_Type, &surfobj, &colorobj, &start, &end, &blend,
+                         &special_flags))
         return NULL;
     surf = PySurface_AsSurface(surfobj);
 
     if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
         return RAISE(PyExc_ValueError, "unsupported bit depth for aaline draw (supports 32 & 24 bit)");
 
-    if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if(!TwoFloatsFromObj(start, &startx, &starty))
         return RAISE(PyExc_TypeError, "Invalid start position argument");
@@ -88,7 +227,7 @@ static PyObject* aaline(PyObject* self, PyObject* arg)
 
     pts[0] = startx; pts[1] = starty;
     pts[2] = endx; pts[3] = endy;
-    anydraw = clip_and_draw_aaline(surf, &surf->clip_rect, color, pts, blend);
+    anydraw = clip_and_draw_aaline(surf, &surf->clip_rect, &pen, pts, blend);
 
     if(!PySurface_Unlock(surfobj)) return NULL;
 
@@ -128,24 +267,21 @@ static PyObject* line(PyObject* self, PyObject* arg)
     int rtop, rleft, rwidth, rheight;
     int width = 1;
     int pts[4];
-    Uint8 rgba[4];
-    Uint32 color;
+    draw_pen pen;
+    int special_flags = 0;
     int anydraw;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OOO|i", &PySurface_Type, &surfobj, &colorobj, &start, &end, &width))
+    if(!PyArg_ParseTuple(arg, "O!OOO|ii", &PySurface_Type, &surfobj, &colorobj, &start, &end, &width,
+                         &special_flags))
         return NULL;
     surf = PySurface_AsSurface(surfobj);
 
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for line draw");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if(!TwoIntsFromObj(start, &startx, &starty))
         return RAISE(PyExc_TypeError, "Invalid start position argument");
@@ -160,7 +296,7 @@ static PyObject* line(PyObject* self, PyObject* arg)
 
     pts[0] = startx; pts[1] = starty;
     pts[2] = endx; pts[3] = endy;
-    anydraw = clip_and_draw_line_width(surf, &surf->clip_rect, color, width, pts);
+    anydraw = clip_and_draw_line_width(surf, &surf->clip_rect, &pen, width, pts);
 
     if(!PySurface_Unlock(surfobj)) return NULL;
 
@@ -193,25 +329,23 @@ static PyObject* aalines(PyObject* self, PyObject* arg)
     float x, y;
     int top, left, bottom, right;
     float pts[4];
-    Uint8 rgba[4];
-    Uint32 color;
-    int closed, blend;
+    draw_pen pen;
+    int special_flags = 0;
+    int closed, blend=1;
     int result, loop, length, drawn;
     float startx, starty;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OOO|i", &PySurface_Type, &surfobj, &colorobj, &closedobj,
-                         &points, &blend))
+    if(!PyArg_ParseTuple(arg, "O!OOO|ii", &PySurface_Type, &surfobj, &colorobj, &closedobj,
+                         &points, &blend, &special_flags))
         return NULL;
     surf = PySurface_AsSurface(surfobj);
 
     if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
         return RAISE(PyExc_ValueError, "unsupported bit depth for aaline draw (supports 32 & 24 bit)");
 
-    if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     closed = PyObject_IsTrue(closedobj);
 
@@ -245,7 +379,7 @@ static PyObject* aalines(PyObject* self, PyObject* arg)
         pts[1] = starty;
         startx = pts[2] = x;
         starty = pts[3] = y;
-        if(clip_and_draw_aaline(surf, &surf->clip_rect, color, pts, blend))
+        if(clip_and_draw_aaline(surf, &surf->clip_rect, &pen, pts, blend))
         {
             left = MIN((int)MIN(pts[0], pts[2]), left);
             top = MIN((int)MIN(pts[1], pts[3]), top);
@@ -264,7 +398,7 @@ static PyObject* aalines(PyObject* self, PyObject* arg)
             pts[1] = starty;
             pts[2] = x;
             pts[3] = y;
-            clip_and_draw_aaline(surf, &surf->clip_rect, color, pts, blend);
+            clip_and_draw_aaline(surf, &surf->clip_rect, &pen, pts, blend);
         }
     }
 
@@ -282,26 +416,25 @@ static PyObject* lines(PyObject* self, PyObject* arg)
     int x, y;
     int top, left, bottom, right;
     int pts[4], width=1;
-    Uint8 rgba[4];
-    Uint32 color;
+    draw_pen pen;
+    blend_mask mask;
+    const draw_pen *draw;
+    int special_flags = 0;
     int closed;
     int result, loop, length, drawn;
     int startx, starty;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OOO|i", &PySurface_Type, &surfobj, &colorobj, &closedobj, &points, &width))
+    if(!PyArg_ParseTuple(arg, "O!OOO|ii", &PySurface_Type, &surfobj, &colorobj, &closedobj, &points, &width,
+                         &special_flags))
         return NULL;
     surf = PySurface_AsSurface(surfobj);
 
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for line draw");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     closed = PyObject_IsTrue(closedobj);
 
@@ -324,6 +457,9 @@ static PyObject* lines(PyObject* self, PyObject* arg)
 
     if(!PySurface_Lock(surfobj)) return NULL;
 
+    /* joined segments share their end pixels */
+    draw = blend_mask_begin(&mask, surf, &pen, surf->clip_rect.x, surf->clip_rect.y,
+                            surf->clip_rect.w, surf->clip_rect.h);
     drawn = 1;
     for(loop = 1; loop < length; ++loop)
     {
@@ -336,7 +472,7 @@ static PyObject* lines(PyObject* self, PyObject* arg)
         pts[1] = starty;
         startx = pts[2] = x;
         starty = pts[3] = y;
-        if(clip_and_draw_line_width(surf, &surf->clip_rect, color, width, pts))
+        if(clip_and_draw_line_width(surf, &surf->clip_rect, draw, width, pts))
         {
             left = MIN(MIN(pts[0], pts[2]), left);
             top = MIN(MIN(pts[1], pts[3]), top);
@@ -355,10 +491,10 @@ static PyObject* lines(PyObject* self, PyObject* arg)
             pts[1] = starty;
             pts[2] = x;
             pts[3] = y;
-            clip_and_draw_line_width(surf, &surf->clip_rect, color, width, pts);
+            clip_and_draw_line_width(surf, &surf->clip_rect, draw, width, pts);
         }
     }
-
+    blend_mask_end(&mask, &pen);
 
     if(!PySurface_Unlock(surfobj)) return NULL;
 
@@ -372,14 +508,16 @@ static PyObject* arc(PyObject* self, PyObject* arg)
     PyObject *surfobj, *colorobj, *rectobj;
     GAME_Rect *rect, temp;
     SDL_Surface* surf;
-    Uint8 rgba[4];
-    Uint32 color;
+    draw_pen pen;
+    blend_mask mask;
+    const draw_pen *draw;
+    int special_flags = 0;
     int width=1, loop, t, l, b, r;
     double angle_start, angle_stop;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OOdd|i", &PySurface_Type, &surfobj, &colorobj, &rectobj,
-                                  &angle_start, &angle_stop, &width))
+    if(!PyArg_ParseTuple(arg, "O!OOdd|ii", &PySurface_Type, &surfobj, &colorobj, &rectobj,
+                                  &angle_start, &angle_stop, &width, &special_flags))
         return NULL;
     rect = GameRect_FromObject(rectobj, &temp);
     if(!rect)
@@ -389,12 +527,8 @@ static PyObject* arc(PyObject* self, PyObject* arg)
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for drawing");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if ( width < 0 )
         return RAISE(PyExc_ValueError, "negative width");
@@ -407,12 +541,15 @@ static PyObject* arc(PyObject* self, PyObject* arg)
     if(!PySurface_Lock(surfobj)) return NULL;
 
     width = MIN(width, MIN(rect->w, rect->h) / 2);
+    /* the segments and the arcs for each width overlap */
+    draw = blend_mask_begin(&mask, surf, &pen, rect->x, rect->y, rect->w + 1, rect->h + 1);
     for(loop=0; loop<width; ++loop)
     {
         draw_arc(surf, rect->x+rect->w/2, rect->y+rect->h/2,
                  rect->w/2-loop, rect->h/2-loop,
-                 angle_start, angle_stop, color);
+                 angle_start, angle_stop, draw);
     }
+    blend_mask_end(&mask, &pen);
 
     if(!PySurface_Unlock(surfobj)) return NULL;
 
@@ -429,12 +566,13 @@ static PyObject* ellipse(PyObject* self, PyObject* arg)
     PyObject *surfobj, *colorobj, *rectobj;
     GAME_Rect *rect, temp;
     SDL_Surface* surf;
-    Uint8 rgba[4];
-    Uint32 color;
-    int width=0, loop, t, l, b, r;
+    draw_pen pen;
+    int special_flags = 0;
+    int width=0, t, l, b, r;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &rectobj, &width))
+    if(!PyArg_ParseTuple(arg, "O!OO|ii", &PySurface_Type, &surfobj, &colorobj, &rectobj, &width,
+                         &special_flags))
         return NULL;
     rect = GameRect_FromObject(rectobj, &temp);
     if(!rect)
@@ -444,12 +582,8 @@ static PyObject* ellipse(PyObject* self, PyObject* arg)
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for drawing");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if ( width < 0 )
         return RAISE(PyExc_ValueError, "negative width");
@@ -460,15 +594,12 @@ static PyObject* ellipse(PyObject* self, PyObject* arg)
 
     if(!width)
         draw_fillellipse(surf, (Sint16)(rect->x+rect->w/2), (Sint16)(rect->y+rect->h/2),
-                         (Sint16)(rect->w/2), (Sint16)(rect->h/2), color);
+                         (Sint16)(rect->w/2), (Sint16)(rect->h/2), &pen);
     else
     {
         width = MIN(width, MIN(rect->w, rect->h) / 2);
-        for(loop=0; loop<width; ++loop)
-        {
-            draw_ellipse(surf, rect->x+rect->w/2, rect->y+rect->h/2,
-                         rect->w/2-loop, rect->h/2-loop, color);
-        }
+        draw_ellipse_width(surf, rect->x+rect->w/2, rect->y+rect->h/2,
+                           rect->w/2, rect->h/2, width, &pen);
     }
 
     if(!PySurface_Unlock(surfobj)) return NULL;
@@ -485,25 +616,22 @@ static PyObject* circle(PyObject* self, PyObject* arg)
 {
     PyObject *surfobj, *colorobj;
     SDL_Surface* surf;
-    Uint8 rgba[4];
-    Uint32 color;
+    draw_pen pen;
+    int special_flags = 0;
     int posx, posy, radius, t, l, b, r;
-    int width=0, loop;
+    int width=0;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!O(ii)i|i", &PySurface_Type, &surfobj, &colorobj, &posx, &posy, &radius, &width))
+    if(!PyArg_ParseTuple(arg, "O!O(ii)i|ii", &PySurface_Type, &surfobj, &colorobj, &posx, &posy, &radius, &width,
+                         &special_flags))
         return NULL;
 
     surf = PySurface_AsSurface(surfobj);
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for drawing");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if ( radius < 0 )
         return RAISE(PyExc_ValueError, "negative radius");
@@ -516,10 +644,9 @@ static PyObject* circle(PyObject* self, PyObject* arg)
     if(!PySurface_Lock(surfobj)) return NULL;
 
     if(!width)
-        draw_fillellipse(surf, (Sint16)posx, (Sint16)posy, (Sint16)radius, (Sint16)radius, color);
+        draw_fillellipse(surf, (Sint16)posx, (Sint16)posy, (Sint16)radius, (Sint16)radius, &pen);
     else
-        for(loop=0; loop<width; ++loop)
-            draw_ellipse(surf, posx, posy, radius-loop, radius-loop, color);
+        draw_ellipse_width(surf, posx, posy, radius, radius, width, &pen);
 
     if(!PySurface_Unlock(surfobj)) return NULL;
 
@@ -533,23 +660,24 @@ static PyObject* circle(PyObject* self, PyObject* arg)
 
 static PyObject* polygon(PyObject* self, PyObject* arg)
 {
-    PyObject *surfobj, *colorobj, *points, *item;
+    PyObject *surfobj, *colorobj, *points;
     SDL_Surface* surf;
-    Uint8 rgba[4];
-    Uint32 color;
-    int width=0, length, loop, numpoints;
+    draw_pen pen;
+    int special_flags = 0;
+    int width=0, numpoints, result;
     int *xlist, *ylist;
-    int x, y, top, left, bottom, right, result;
+    int bounds[4], top, left, bottom, right;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &points, &width))
+    if(!PyArg_ParseTuple(arg, "O!OO|ii", &PySurface_Type, &surfobj, &colorobj, &points, &width,
+                         &special_flags))
         return NULL;
 
 
     if(width)
     {
         PyObject *args, *ret;
-        args = Py_BuildValue("(OOiOi)", surfobj, colorobj, 1, points, width);
+        args = Py_BuildValue("(OOiOii)", surfobj, colorobj, 1, points, width, special_flags);
         if(!args) return NULL;
         ret = lines(NULL, args);
         Py_DECREF(args);
@@ -562,12 +690,91 @@ static PyObject* polygon(PyObject* self, PyObject* arg)
     if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
         return RAISE(PyExc_ValueError, "unsupport bit depth for line draw");
 
-    if(PyInt_Check(colorobj))
-        color = (Uint32)PyInt_AsLong(colorobj);
-    else if(RGBAFromColorObj(colorobj, rgba))
-        color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
-    else
-        return RAISE(PyExc_TypeError, "invalid color argument");
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
+
+    bounds[0] = bounds[1] = INT_MAX;
+    bounds[2] = bounds[3] = INT_MIN;
+    numpoints = points_from_obj(points, 3, &xlist, &ylist, bounds);
+    if(numpoints < 0)
+        return NULL;
+
+    if(!PySurface_Lock(surfobj))
+    {
+        PyMem_Del(xlist); PyMem_Del(ylist);
+        return NULL;
+    }
+
+    result = draw_fillpoly(surf, xlist, ylist, numpoints, &pen);
+
+    PyMem_Del(xlist); PyMem_Del(ylist);
+    if(!PySurface_Unlock(surfobj))
+        return NULL;
+    if(result)
+        return PyErr_NoMemory();
+
+    left = MAX(bounds[0], surf->clip_rect.x);
+    top = MAX(bounds[1], surf->clip_rect.y);
+    right = MIN(bounds[2], surf->clip_rect.x + surf->clip_rect.w);
+    bottom = MIN(bounds[3], surf->clip_rect.y + surf->clip_rect.h);
+    return PyRect_New4(left, top, right-left+1, bottom-top+1);
+}
+
+
+/* The Rect of the pixels an antialiased shape from left to right and top
+   to bottom touches, clipped to the surface.  Pixel edges are integers. */
+static PyObject* aa_bounds(SDL_Surface *surf, float left, float top, float right, float bottom)
+{
+    int l = MAX((int)floor(left), surf->clip_rect.x);
+    int t = MAX((int)floor(top), surf->clip_rect.y);
+    int r = MIN((int)ceil(right), surf->clip_rect.x + surf->clip_rect.w);
+    int b = MIN((int)ceil(bottom), surf->clip_rect.y + surf->clip_rect.h);
+
+    return PyRect_New4(l, t, MAX(r-l, 0), MAX(b-t, 0));
+}
+
+/* Locks the surface, fills the nonzero shapes added to raster, and
+   returns their bounds for the aa shape functions. */
+static PyObject* aa_fill_obj(PyObject *surfobj, pg_raster *raster, const draw_pen *pen,
+                             float left, float top, float right, float bottom)
+{
+    SDL_Surface *surf = PySurface_AsSurface(surfobj);
+    int result;
+
+    if(!PySurface_Lock(surfobj))
+    {
+        pg_raster_free(raster);
+        return NULL;
+    }
+    result = aa_fill_raster(surf, raster, 0, pen);
+    if(!PySurface_Unlock(surfobj))
+        return NULL;
+    if(result)
+        return PyErr_NoMemory();
+    return aa_bounds(surf, left, top, right, bottom);
+}
+
+
+static PyObject* aapolygon(PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *colorobj, *points, *item;
+    SDL_Surface* surf;
+    draw_pen pen;
+    int special_flags = 0;
+    int length, loop, numpoints, result;
+    float *xlist, *ylist;
+    float x, y, top, left, bottom, right;
+
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &points, &special_flags))
+        return NULL;
+    surf = PySurface_AsSurface(surfobj);
+
+    if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
+        return RAISE(PyExc_ValueError, "unsupported bit depth for aapolygon draw (supports 32 & 24 bit)");
+
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
     if(!PySequence_Check(points))
         return RAISE(PyExc_TypeError, "points argument must be a sequence of number pairs");
@@ -575,22 +782,26 @@ static PyObject* polygon(PyObject* self, PyObject* arg)
     if(length < 3)
         return RAISE(PyExc_ValueError, "points argument must contain more than 2 points");
 
-
     item = PySequence_GetItem(points, 0);
-    result = TwoIntsFromObj(item, &x, &y);
+    result = TwoFloatsFromObj(item, &x, &y);
     Py_DECREF(item);
     if(!result) return RAISE(PyExc_TypeError, "points must be number pairs");
     left = right = x;
     top = bottom = y;
 
-    xlist = PyMem_New(int, length);
-    ylist = PyMem_New(int, length);
+    xlist = PyMem_New(float, length);
+    ylist = PyMem_New(float, length);
+    if(!xlist || !ylist)
+    {
+        PyMem_Del(xlist); PyMem_Del(ylist);
+        return PyErr_NoMemory();
+    }
 
     numpoints = 0;
     for(loop = 0; loop < length; ++loop)
     {
         item = PySequence_GetItem(points, loop);
-        result = TwoIntsFromObj(item, &x, &y);
+        result = TwoFloatsFromObj(item, &x, &y);
         Py_DECREF(item);
         if(!result) continue; /*note, we silently skip over bad points :[ */
         xlist[numpoints] = x;
@@ -608,964 +819,3017 @@ static PyObject* polygon(PyObject* self, PyObject* arg)
         return NULL;
     }
 
-    draw_fillpoly(surf, xlist, ylist, numpoints, color);
+    result = draw_aapoly(surf, xlist, ylist, numpoints, &pen);
 
     PyMem_Del(xlist); PyMem_Del(ylist);
     if(!PySurface_Unlock(surfobj))
         return NULL;
+    if(result)
+        return PyErr_NoMemory();
 
-    left = MAX(left, surf->clip_rect.x);
-    top = MAX(top, surf->clip_rect.y);
-    right = MIN(right, surf->clip_rect.x + surf->clip_rect.w);
-    bottom = MIN(bottom, surf->clip_rect.y + surf->clip_rect.h);
-    return PyRect_New4(left, top, right-left+1, bottom-top+1);
+    return aa_bounds(surf, left + 0.5f, top + 0.5f, right + 0.5f, bottom + 0.5f);
 }
 
 
-static PyObject* rect(PyObject* self, PyObject* arg)
+static PyObject* aacircle(PyObject* self, PyObject* arg)
 {
-    PyObject *surfobj, *colorobj, *rectobj, *points, *args, *ret=NULL;
-    GAME_Rect* rect, temp;
-    int t, l, b, r, width=0;
+    PyObject *surfobj, *colorobj;
+    SDL_Surface* surf;
+    draw_pen pen;
+    pg_raster raster;
+    int special_flags = 0;
+    float posx, posy, radius;
 
     /*get all the arguments*/
-    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &rectobj, &width))
+    if(!PyArg_ParseTuple(arg, "O!O(ff)f|i", &PySurface_Type, &surfobj, &colorobj, &posx, &posy, &radius,
+                         &special_flags))
         return NULL;
+    surf = PySurface_AsSurface(surfobj);
 
-    if(!(rect = GameRect_FromObject(rectobj, &temp)))
-        return RAISE(PyExc_TypeError, "Rect argument is invalid");
-
-    l = rect->x; r = rect->x + rect->w - 1;
-    t = rect->y; b = rect->y + rect->h - 1;
+    if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
+        return RAISE(PyExc_ValueError, "unsupported bit depth for aacircle draw (supports 32 & 24 bit)");
 
-    /*build the pointlist*/
-    points = Py_BuildValue("((ii)(ii)(ii)(ii))", l, t, r, t, r, b, l, b);
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
-    args = Py_BuildValue("(OONi)", surfobj, colorobj, points, width);
-    if(args) ret = polygon(NULL, args);
+    if ( radius < 0 )
+        return RAISE(PyExc_ValueError, "negative radius");
 
-    Py_XDECREF(args);
-    return ret;
+    /*the center is in the middle of the pixel at pos*/
+    posx += 0.5f;
+    posy += 0.5f;
+    pg_raster_init(&raster, &surf->clip_rect);
+    pg_raster_ellipse(&raster, posx, posy, radius, radius);
+    return aa_fill_obj(surfobj, &raster, &pen, posx - radius, posy - radius,
+                       posx + radius, posy + radius);
 }
 
 
+static PyObject* aaellipse(PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *colorobj, *rectobj;
+    GAME_Rect *rect, temp;
+    SDL_Surface* surf;
+    draw_pen pen;
+    pg_raster raster;
+    int special_flags = 0;
+
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &rectobj, &special_flags))
+        return NULL;
+    rect = GameRect_FromObject(rectobj, &temp);
+    if(!rect)
+        return RAISE(PyExc_TypeError, "Invalid recstyle argument");
+    surf = PySurface_AsSurface(surfobj);
 
+    if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
+        return RAISE(PyExc_ValueError, "unsupported bit depth for aaellipse draw (supports 32 & 24 bit)");
 
-/*internal drawing tools*/
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
 
-static int clip_and_draw_aaline(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, float* pts, int blend)
-{
-    if(!clipaaline(pts, rect->x+1, rect->y+1, rect->x+rect->w-2, rect->y+rect->h-2))
-        return 0;
-    drawaaline(surf, color, pts[0], pts[1], pts[2], pts[3], blend);
-    return 1;
+    /*the ellipse fills the rect edge to edge*/
+    pg_raster_init(&raster, &surf->clip_rect);
+    pg_raster_ellipse(&raster, rect->x + rect->w / 2.0f, rect->y + rect->h / 2.0f,
+                      rect->w / 2.0f, rect->h / 2.0f);
+    return aa_fill_obj(surfobj, &raster, &pen, (float)rect->x, (float)rect->y,
+                       (float)(rect->x + rect->w), (float)(rect->y + rect->h));
 }
 
-static int clip_and_draw_line(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, int* pts)
+
+static PyObject* aarect(PyObject* self, PyObject* arg)
 {
-    if(!clipline(pts, rect->x, rect->y, rect->x+rect->w-1, rect->y+rect->h-1))
-        return 0;
-    if(pts[1] == pts[3])
-        drawhorzline(surf, color, pts[0], pts[1], pts[2]);
-    else if(pts[0] == pts[2])
-        drawvertline(surf, color, pts[0], pts[1], pts[3]);
-    else
-        drawline(surf, color, pts[0], pts[1], pts[2], pts[3]);
-    return 1;
+    PyObject *surfobj, *colorobj, *rectobj;
+    GAME_Rect *rect, temp;
+    SDL_Surface* surf;
+    draw_pen pen;
+    pg_raster raster;
+    int special_flags = 0;
+    float radius = 0;
+
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!OO|fi", &PySurface_Type, &surfobj, &colorobj, &rectobj, &radius,
+                         &special_flags))
+        return NULL;
+    rect = GameRect_FromObject(rectobj, &temp);
+    if(!rect)
+        return RAISE(PyExc_TypeError, "Rect argument is invalid");
+    surf = PySurface_AsSurface(surfobj);
+
+    if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
+        return RAISE(PyExc_ValueError, "unsupported bit depth for aarect draw (supports 32 & 24 bit)");
+
+    if(pen_from_obj(&pen, surf, colorobj, special_flags))
+        return NULL;
+
+    if ( radius < 0 )
+        return RAISE(PyExc_ValueError, "negative radius");
+
+    pg_raster_init(&raster, &surf->clip_rect);
+    pg_raster_rounded_rect(&raster, (float)rect->x, (float)rect->y, (float)rect->w, (float)rect->h,
+                           radius);
+    return aa_fill_obj(surfobj, &raster, &pen, (float)rect->x, (float)rect->y,
+                       (float)(rect->x + rect->w), (float)(rect->y + rect->h));
 }
 
-static int clip_and_draw_line_width(SDL_Surface* surf, SDL_Rect* rect, Uint32 color, int width, int* pts)
+
+static PyObject* polygons(PyObject* self, PyObject* arg)
 {
-    int loop;
-    int xinc=0, yinc=0;
-    int newpts[4];
-    int range[4];
-    int anydrawn = 0;
+    PyObject *surfobj, *colorobj, *pointlists, *item;
+    SDL_Surface* surf;
+    Uint8 rgba[4];
+    draw_pen *pens = NULL;
+    int **xlists = NULL, **ylists = NULL, *counts = NULL;
+    int npolys, loop, result = 0, single, special_flags = 0;
+    int bounds[4], top, left, bottom, right;
 
-    if(abs(pts[0]-pts[2]) > abs(pts[1]-pts[3]))
-        yinc = 1;
-    else
-        xinc = 1;
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!OO|i", &PySurface_Type, &surfobj, &colorobj, &pointlists, &special_flags))
+        return NULL;
+    surf = PySurface_AsSurface(surfobj);
+
+    if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
+        return RAISE(PyExc_ValueError, "unsupport bit depth for line draw");
 
-    memcpy(newpts, pts, sizeof(int)*4);
-    if(clip_and_draw_line(surf, rect, color, newpts))
+    if(!PySequence_Check(pointlists))
+        return RAISE(PyExc_TypeError, "pointlists argument must be a sequence of point sequences");
+    npolys = PySequence_Length(pointlists);
+
+    /* one color for all, or a sequence with a color for each polygon */
+    single = PyInt_Check(colorobj) || RGBAFromColorObj(colorobj, rgba);
+    if(!single && (!PySequence_Check(colorobj) || PySequence_Length(colorobj) != npolys))
+        return RAISE(PyExc_TypeError, "invalid color argument");
+
+    pens = PyMem_New(draw_pen, npolys + 1);
+    counts = PyMem_New(int, npolys + 1);
+    xlists = PyMem_New(int*, npolys + 1);
+    ylists = PyMem_New(int*, npolys + 1);
+    if(!pens || !counts || !xlists || !ylists)
     {
-        anydrawn = 1;
-        memcpy(range, newpts, sizeof(int)*4);
+        PyErr_NoMemory();
+        npolys = 0;
+        goto cleanup;
     }
-    else
+    memset(xlists, 0, sizeof(int*) * (npolys + 1));
+    memset(ylists, 0, sizeof(int*) * (npolys + 1));
+
+    bounds[0] = bounds[1] = INT_MAX;
+    bounds[2] = bounds[3] = INT_MIN;
+    for(loop = 0; loop < npolys; ++loop)
     {
-        range[0] = range[1] = 10000;
-        range[2] = range[3] = -10000;
+        item = single ? colorobj : PySequence_GetItem(colorobj, loop);
+        if(!item)
+            goto cleanup;
+        result = pen_from_obj(&pens[loop], surf, item, special_flags);
+        if(!single)
+            Py_DECREF(item);
+        if(result)
+            goto cleanup;
+
+        item = PySequence_GetItem(pointlists, loop);
+        if(!item)
+            goto cleanup;
+        counts[loop] = points_from_obj(item, 3, &xlists[loop], &ylists[loop], bounds);
+        Py_DECREF(item);
+        if(counts[loop] < 0)
+            goto cleanup;
     }
 
-    for(loop = 1; loop < width; loop += 2)
+    if(!PySurface_Lock(surfobj))
+        goto cleanup;
+
+    Py_BEGIN_ALLOW_THREADS;
+    for(loop = 0; loop < npolys && !result; ++loop)
+        result = draw_fillpoly(surf, xlists[loop], ylists[loop], counts[loop], &pens[loop]);
+    Py_END_ALLOW_THREADS;
+
+    if(!PySurface_Unlock(surfobj))
+        goto cleanup;
+    if(result)
+        PyErr_NoMemory();
+
+cleanup:
+    for(loop = 0; loop < npolys; ++loop)
     {
-        newpts[0] = pts[0] + xinc*(loop/2+1);
-        newpts[1] = pts[1] + yinc*(loop/2+1);
-        newpts[2] = pts[2] + xinc*(loop/2+1);
-        newpts[3] = pts[3] + yinc*(loop/2+1);
-        if(clip_and_draw_line(surf, rect, color, newpts))
-        {
-            anydrawn = 1;
-            range[0] = MIN(newpts[0], range[0]);
-            range[1] = MIN(newpts[1], range[1]);
-            range[2] = MAX(newpts[2], range[2]);
-            range[3] = MAX(newpts[3], range[3]);
-        }
-        if(loop+1<width)
-        {
-            newpts[0] = pts[0] - xinc*(loop/2+1);
-            newpts[1] = pts[1] - yinc*(loop/2+1);
-            newpts[2] = pts[2] - xinc*(loop/2+1);
-            newpts[3] = pts[3] - yinc*(loop/2+1);
-            if(clip_and_draw_line(surf, rect, color, newpts))
-            {
-                anydrawn = 1;
-                range[0] = MIN(newpts[0], range[0]);
-                range[1] = MIN(newpts[1], range[1]);
-                range[2] = MAX(newpts[2], range[2]);
-                range[3] = MAX(newpts[3], range[3]);
-            }
-        }
+        PyMem_Del(xlists[loop]);
+        PyMem_Del(ylists[loop]);
     }
-    if(anydrawn)
-        memcpy(pts, range, sizeof(int)*4);
-    return anydrawn;
+    PyMem_Del(pens); PyMem_Del(counts);
+    PyMem_Del(xlists); PyMem_Del(ylists);
+    if(PyErr_Occurred())
+        return NULL;
+
+    if(!npolys)
+        return PyRect_New4(0, 0, 0, 0);
+    left = MAX(bounds[0], surf->clip_rect.x);
+    top = MAX(bounds[1], surf->clip_rect.y);
+    right = MIN(bounds[2], surf->clip_rect.x + surf->clip_rect.w);
+    bottom = MIN(bounds[3], surf->clip_rect.y + surf->clip_rect.h);
+    return PyRect_New4(left, top, MAX(right-left+1, 0), MAX(bottom-top+1, 0));
 }
 
 
-/*this line clipping based heavily off of code from
-http://www.ncsa.uiuc.edu/Vis/Graphics/src/clipCohSuth.c */
-#define LEFT_EDGE   0x1
-#define RIGHT_EDGE  0x2
-#define BOTTOM_EDGE 0x4
-#define TOP_EDGE    0x8
-#define INSIDE(a)   (!a)
-#define REJECT(a,b) (a&b)
-#define ACCEPT(a,b) (!(a|b))
+static PyObject* rect(PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *colorobj, *rectobj, *points, *args, *ret=NULL;
+    GAME_Rect* rect, temp;
+    int t, l, b, r, width=0, special_flags=0;
 
-static int encode(int x, int y, int left, int top, int right, int bottom)
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!OO|ii", &PySurface_Type, &surfobj, &colorobj, &rectobj, &width,
+                         &special_flags))
+        return NULL;
+
+    if(!(rect = GameRect_FromObject(rectobj, &temp)))
+        return RAISE(PyExc_TypeError, "Rect argument is invalid");
+
+    l = rect->x; r = rect->x + rect->w - 1;
+    t = rect->y; b = rect->y + rect->h - 1;
+
+    /*build the pointlist*/
+    points = Py_BuildValue("((ii)(ii)(ii)(ii))", l, t, r, t, r, b, l, b);
+
+    args = Py_BuildValue("(OONii)", surfobj, colorobj, points, width, special_flags);
+    if(args) ret = polygon(NULL, args);
+
+    Py_XDECREF(args);
+    return ret;
+}
+
+
+/* primitive kinds for batch, exported as module constants */
+#define BATCH_POINT   0
+#define BATCH_LINE    1
+#define BATCH_RECT    2
+#define BATCH_CIRCLE  3
+#define BATCH_ELLIPSE 4
+
+/* one record is (kind, a, b, c, d, color, width) as native 32 bit ints */
+#define BATCH_FIELDS  7
+
+typedef struct {
+    Sint32 kind, a, b, c, d;
+    Uint32 color;
+    Sint32 width;
+} batch_item;
+
+/* Checks one record, and grows bounds (left, top, right, bottom, with
+   right and bottom exclusive) to hold it.  Returns -1 with an exception
+   set for a bad record. */
+static int batch_check_item(batch_item *item, int *bounds)
 {
-    int code = 0;
-    if(x < left)  code |= LEFT_EDGE;
-    if(x > right) code |= RIGHT_EDGE;
-    if(y < top)   code |= TOP_EDGE;
-    if(y > bottom)code |= BOTTOM_EDGE;
-    return code;
+    int l, t, r, b, half = item->width / 2;
+
+    if(item->width < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "negative width");
+        return -1;
+    }
+    switch(item->kind)
+    {
+    case BATCH_POINT:
+        l = item->a; t = item->b;
+        r = l + 1; b = t + 1;
+        break;
+    case BATCH_LINE:
+        if(item->width < 1)
+            return 0;
+        l = MIN(item->a, item->c) - half; t = MIN(item->b, item->d) - half;
+        r = MAX(item->a, item->c) + half + 1; b = MAX(item->b, item->d) + half + 1;
+        break;
+    case BATCH_RECT:
+    case BATCH_ELLIPSE:
+        if(item->c < 0 || item->d < 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "negative size");
+            return -1;
+        }
+        if(item->kind == BATCH_ELLIPSE && (item->width > item->c / 2 || item->width > item->d / 2))
+        {
+            PyErr_SetString(PyExc_ValueError, "width greater than ellipse radius");
+            return -1;
+        }
+        if(item->kind == BATCH_ELLIPSE)
+        {
+            /* the curve reaches radius pixels each side of the center */
+            l = item->a; t = item->b;
+            r = item->a + item->c / 2 * 2 + 1; b = item->b + item->d / 2 * 2 + 1;
+        }
+        else if(!item->width)
+        {
+            l = item->a; t = item->b;
+            r = item->a + item->c; b = item->b + item->d;
+        }
+        else
+        {
+            /* outline edges run through the last row and column */
+            l = MIN(item->a, item->a + item->c - 1) - half;
+            t = MIN(item->b, item->b + item->d - 1) - half;
+            r = MAX(item->a, item->a + item->c - 1) + half + 1;
+            b = MAX(item->b, item->b + item->d - 1) + half + 1;
+        }
+        break;
+    case BATCH_CIRCLE:
+        if(item->c < 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "negative radius");
+            return -1;
+        }
+        if(item->width > item->c)
+        {
+            PyErr_SetString(PyExc_ValueError, "width greater than radius");
+            return -1;
+        }
+        l = item->a - item->c; t = item->b - item->c;
+        r = item->a + item->c + 1; b = item->b + item->c + 1;
+        break;
+    default:
+        PyErr_Format(PyExc_ValueError, "invalid primitive type %d", (int)item->kind);
+        return -1;
+    }
+    bounds[0] = MIN(l, bounds[0]);
+    bounds[1] = MIN(t, bounds[1]);
+    bounds[2] = MAX(r, bounds[2]);
+    bounds[3] = MAX(b, bounds[3]);
+    return 0;
 }
 
-static int encodeFloat(float x, float y, int left, int top, int right, int bottom)
+/* Copies packed records from buf into a new array of records.
+   Returns the number of records, or -1 with an exception set. */
+static int batch_from_buf(const void *buf, Py_ssize_t buflen, batch_item **items)
 {
-    int code = 0;
-    if(x < left)  code |= LEFT_EDGE;
-    if(x > right) code |= RIGHT_EDGE;
-    if(y < top)   code |= TOP_EDGE;
-    if(y > bottom)code |= BOTTOM_EDGE;
-    return code;
+    int count;
+
+    if(buflen % (BATCH_FIELDS * 4))
+    {
+        PyErr_Format(PyExc_ValueError, "primitives buffer length must be a multiple of %d bytes",
+                     BATCH_FIELDS * 4);
+        return -1;
+    }
+    count = (int)(buflen / (BATCH_FIELDS * 4));
+    *items = PyMem_New(batch_item, count + 1);
+    if(!*items)
+    {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(*items, buf, buflen);
+    return count;
 }
 
-static int clipaaline(float* pts, int left, int top, int right, int bottom)
+/* Reads the primitives argument into a new array of records.  A buffer
+   holds packed records with already mapped colors, a sequence holds 7
+   item sequences where the color may also be a color object.
+   Returns the number of records, or -1 with an exception set. */
+static int batch_from_obj(SDL_Surface *surf, PyObject *prims, batch_item **items)
 {
-    float x1 = pts[0];
-    float y1 = pts[1];
-    float x2 = pts[2];
-    float y2 = pts[3];
-    int code1, code2;
-    int draw = 0;
-    float swaptmp;
-    int intswaptmp;
-    float m; /*slope*/
+    PyObject *item, *colorobj;
+    Uint8 rgba[4];
+    int count, loop, field, value[BATCH_FIELDS];
 
-    while(1) {
-        code1 = encodeFloat(x1, y1, left, top, right, bottom);
-        code2 = encodeFloat(x2, y2, left, top, right, bottom);
-        if(ACCEPT(code1, code2)) {
-            draw = 1;
-            break;
-        }
-        else if(REJECT(code1, code2)) {
-            break;
+    *items = NULL;
+#if PG_ENABLE_NEWBUF
+    if(PyObject_CheckBuffer(prims))
+    {
+        Py_buffer view;
+
+        view.obj = 0;
+        if(PyObject_GetBuffer(prims, &view, PyBUF_SIMPLE))
+            return -1;
+        count = batch_from_buf(view.buf, view.len, items);
+        PyBuffer_Release(&view);
+        return count;
+    }
+#endif
+#if PY2
+    if(PyObject_CheckReadBuffer(prims))
+    {
+        const void *buf;
+        Py_ssize_t buflen;
+
+        if(PyObject_AsReadBuffer(prims, &buf, &buflen))
+            return -1;
+        return batch_from_buf(buf, buflen, items);
+    }
+#endif
+
+    if(!PySequence_Check(prims))
+    {
+        PyErr_SetString(PyExc_TypeError, "primitives argument must be a buffer or a sequence");
+        return -1;
+    }
+    count = PySequence_Length(prims);
+    if(count < 0)
+        return -1;
+    *items = PyMem_New(batch_item, count + 1);
+    if(!*items)
+    {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for(loop = 0; loop < count; ++loop)
+    {
+        item = PySequence_GetItem(prims, loop);
+        if(!item)
+            goto fail;
+        if(!PySequence_Check(item) || PySequence_Length(item) != BATCH_FIELDS)
+        {
+            Py_DECREF(item);
+            PyErr_SetString(PyExc_TypeError, "primitives must be sequences of 7 items");
+            goto fail;
         }
-        else {
-            if(INSIDE(code1)) {
-                swaptmp = x2; x2 = x1; x1 = swaptmp;
-                swaptmp = y2; y2 = y1; y1 = swaptmp;
-                intswaptmp = code2; code2 = code1; code1 = intswaptmp;
-            }
-            if(x2 != x1)
-                m = (y2 - y1) / (x2 - x1);
-            else
-                m = 1.0f;
-            if(code1 & LEFT_EDGE) {
-                y1 += ((float)left - x1) * m;
-                x1 = (float)left;
-            }
-            else if(code1 & RIGHT_EDGE) {
-                y1 += ((float)right - x1) * m;
-                x1 = (float)right;
-            }
-            else if(code1 & BOTTOM_EDGE) {
-                if(x2 != x1)
-                    x1 += ((float)bottom - y1) / m;
-                y1 = (float)bottom;
-            }
-            else if(code1 & TOP_EDGE) {
-                if(x2 != x1)
-                    x1 += ((float)top - y1) / m;
-                y1 = (float)top;
+        for(field = 0; field < BATCH_FIELDS; ++field)
+        {
+            if(field == 5)
+                continue;
+            if(!IntFromObjIndex(item, field, &value[field]))
+            {
+                Py_DECREF(item);
+                PyErr_SetString(PyExc_TypeError, "primitive fields must be integers");
+                goto fail;
             }
         }
+        colorobj = PySequence_GetItem(item, 5);
+        Py_DECREF(item);
+        if(!colorobj)
+            goto fail;
+        if(PyInt_Check(colorobj))
+            (*items)[loop].color = (Uint32)PyInt_AsLong(colorobj);
+        else if(RGBAFromColorObj(colorobj, rgba))
+            (*items)[loop].color = SDL_MapRGBA(surf->format, rgba[0], rgba[1], rgba[2], rgba[3]);
+        else
+            PyErr_SetString(PyExc_TypeError, "invalid color argument");
+        Py_DECREF(colorobj);
+        if(PyErr_Occurred())
+            goto fail;
+        (*items)[loop].kind = value[0];
+        (*items)[loop].a = value[1];
+        (*items)[loop].b = value[2];
+        (*items)[loop].c = value[3];
+        (*items)[loop].d = value[4];
+        (*items)[loop].width = value[6];
     }
-    if(draw) {
-        pts[0] = x1; pts[1] = y1;
-        pts[2] = x2; pts[3] = y2;
-    }
-    return draw;
+    return count;
+
+fail:
+    PyMem_Del(*items);
+    *items = NULL;
+    return -1;
 }
 
-static int clipline(int* pts, int left, int top, int right, int bottom)
+/* Draws one checked record with the special_flags blend mode, which
+   pen_init has accepted.  Safe to call without the GIL. */
+static void batch_draw_item(SDL_Surface *surf, batch_item *item, int special_flags)
 {
-    int x1 = pts[0];
-    int y1 = pts[1];
-    int x2 = pts[2];
-    int y2 = pts[3];
-    int code1, code2;
-    int draw = 0;
-    int swaptmp;
-    float m; /*slope*/
+    int pts[4], l, t, r, b, loop;
+    draw_pen pen;
+    blend_mask mask;
+    const draw_pen *draw;
 
-    while(1)
+    pen_init(&pen, surf, item->color, NULL, special_flags);
+
+    switch(item->kind)
     {
-        code1 = encode(x1, y1, left, top, right, bottom);
-        code2 = encode(x2, y2, left, top, right, bottom);
-        if(ACCEPT(code1, code2)) {
-            draw = 1;
+    case BATCH_POINT:
+        fill_rect_spans(surf, item->a, item->b, 1, 1, &pen);
+        break;
+    case BATCH_LINE:
+        if(item->width < 1)
             break;
-        }
-        else if(REJECT(code1, code2))
+        pts[0] = item->a; pts[1] = item->b;
+        pts[2] = item->c; pts[3] = item->d;
+        clip_and_draw_line_width(surf, &surf->clip_rect, &pen, item->width, pts);
+        break;
+    case BATCH_RECT:
+        if(!item->width)
+        {
+            fill_rect_spans(surf, item->a, item->b, item->c, item->d, &pen);
             break;
-        else {
-            if(INSIDE(code1)) {
-                swaptmp = x2; x2 = x1; x1 = swaptmp;
-                swaptmp = y2; y2 = y1; y1 = swaptmp;
-                swaptmp = code2; code2 = code1; code1 = swaptmp;
-            }
-            if(x2 != x1)
-                m = (y2 - y1) / (float)(x2 - x1);
-            else
-                m = 1.0f;
-            if(code1 & LEFT_EDGE) {
-                y1 += (int)((left - x1) * m);
-                x1 = left;
-            }
-            else if(code1 & RIGHT_EDGE) {
-                y1 += (int)((right - x1) * m);
-                x1 = right;
-            }
-            else if(code1 & BOTTOM_EDGE) {
-                if(x2 != x1)
-                    x1 += (int)((bottom - y1) / m);
-                y1 = bottom;
-            }
-            else if(code1 & TOP_EDGE) {
-                if(x2 != x1)
-                    x1 += (int)((top - y1) / m);
-                y1 = top;
-            }
         }
+        /* the same closed outline rect() draws through polygon() */
+        l = item->a; r = item->a + item->c - 1;
+        t = item->b; b = item->b + item->d - 1;
+        draw = blend_mask_begin(&mask, surf, &pen, MIN(l, r) - item->width, MIN(t, b) - item->width,
+                                abs(r - l) + 1 + 2 * item->width, abs(b - t) + 1 + 2 * item->width);
+        for(loop = 0; loop < 4; ++loop)
+        {
+            pts[0] = (loop == 1 || loop == 2) ? r : l;
+            pts[1] = (loop >= 2) ? b : t;
+            pts[2] = (loop == 0 || loop == 1) ? r : l;
+            pts[3] = (loop == 1 || loop == 2) ? b : t;
+            clip_and_draw_line_width(surf, &surf->clip_rect, draw, item->width, pts);
+        }
+        blend_mask_end(&mask, &pen);
+        break;
+    case BATCH_CIRCLE:
+        if(!item->width)
+            draw_fillellipse(surf, item->a, item->b, item->c, item->c, &pen);
+        else
+            draw_ellipse_width(surf, item->a, item->b, item->c, item->c, item->width, &pen);
+        break;
+    case BATCH_ELLIPSE:
+        if(!item->width)
+            draw_fillellipse(surf, item->a + item->c / 2, item->b + item->d / 2,
+                             item->c / 2, item->d / 2, &pen);
+        else
+            draw_ellipse_width(surf, item->a + item->c / 2, item->b + item->d / 2,
+                               item->c / 2, item->d / 2, item->width, &pen);
+        break;
+    }
+}
+
+
+static PyObject* batch(PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *prims;
+    SDL_Surface* surf;
+    batch_item *items;
+    draw_pen pen;
+    int count, loop, bounds[4], top, left, bottom, right, special_flags = 0;
+
+    /*get all the arguments*/
+    if(!PyArg_ParseTuple(arg, "O!O|i", &PySurface_Type, &surfobj, &prims, &special_flags))
+        return NULL;
+    surf = PySurface_AsSurface(surfobj);
+
+    if(surf->format->BytesPerPixel <= 0 || surf->format->BytesPerPixel > 4)
+        return RAISE(PyExc_ValueError, "unsupport bit depth for drawing");
+    if(!pen_init(&pen, surf, 0, NULL, special_flags))
+        return RAISE(PyExc_ValueError, "invalid special_flags for drawing");
+
+    count = batch_from_obj(surf, prims, &items);
+    if(count < 0)
+        return NULL;
+
+    bounds[0] = bounds[1] = INT_MAX;
+    bounds[2] = bounds[3] = INT_MIN;
+    for(loop = 0; loop < count; ++loop)
+    {
+        if(batch_check_item(&items[loop], bounds))
+        {
+            PyMem_Del(items);
+            return NULL;
+        }
+    }
+
+    if(!PySurface_Lock(surfobj))
+    {
+        PyMem_Del(items);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    for(loop = 0; loop < count; ++loop)
+        batch_draw_item(surf, &items[loop], special_flags);
+    Py_END_ALLOW_THREADS;
+
+    PyMem_Del(items);
+    if(!PySurface_Unlock(surfobj))
+        return NULL;
+
+    if(bounds[0] > bounds[2])
+        return PyRect_New4(0, 0, 0, 0);
+    left = MAX(bounds[0], surf->clip_rect.x);
+    top = MAX(bounds[1], surf->clip_rect.y);
+    right = MIN(bounds[2], surf->clip_rect.x + surf->clip_rect.w);
+    bottom = MIN(bounds[3], surf->clip_rect.y + surf->clip_rect.h);
+    return PyRect_New4(left, top, MAX(right-left, 0), MAX(bottom-top, 0));
+}
+
+
+
+
+/*internal drawing tools*/
+
+/* All drawing ends up in the pen's writers.  A span writer fills count
+   pixels going right from pixel, a stride writer fills count pixels step
+   bytes apart, so it can walk columns, or rows backwards.  The solid
+   ones write the mapped color and are specialized for each
+   BytesPerPixel.  None of them do any clipping. */
+#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define COLOR_BYTES_3(color, c0, c1, c2) \
+    c0 = (Uint8)(color); c1 = (Uint8)((color) >> 8); c2 = (Uint8)((color) >> 16)
+#else
+#define COLOR_BYTES_3(color, c0, c1, c2) \
+    c0 = (Uint8)((color) >> 16); c1 = (Uint8)((color) >> 8); c2 = (Uint8)(color)
+#endif
+
+static void write_span_1(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    memset(pixel, (Uint8)pen->color, count);
+}
+
+static void write_span_2(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    Uint16 *dst = (Uint16*)pixel;
+    Uint16 color = (Uint16)pen->color;
+
+    for(; count > 0; --count)
+        *dst++ = color;
+}
+
+static void write_span_3(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    Uint8 c0, c1, c2;
+
+    COLOR_BYTES_3(pen->color, c0, c1, c2);
+    for(; count > 0; --count, pixel += 3)
+    {
+        pixel[0] = c0;
+        pixel[1] = c1;
+        pixel[2] = c2;
+    }
+}
+
+static void write_span_4(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    Uint32 *dst = (Uint32*)pixel;
+    Uint32 color = pen->color;
+
+    for(; count > 0; --count)
+        *dst++ = color;
+}
+
+static void write_stride_1(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    Uint8 color = (Uint8)pen->color;
+
+    for(; count > 0; --count, pixel += step)
+        *pixel = color;
+}
+
+static void write_stride_2(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    Uint16 color = (Uint16)pen->color;
+
+    for(; count > 0; --count, pixel += step)
+        *(Uint16*)pixel = color;
+}
+
+static void write_stride_3(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    Uint8 c0, c1, c2;
+
+    COLOR_BYTES_3(pen->color, c0, c1, c2);
+    for(; count > 0; --count, pixel += step)
+    {
+        pixel[0] = c0;
+        pixel[1] = c1;
+        pixel[2] = c2;
+    }
+}
+
+static void write_stride_4(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    Uint32 color = pen->color;
+
+    for(; count > 0; --count, pixel += step)
+        *(Uint32*)pixel = color;
+}
+
+static const span_writer span_writers[4] =
+{
+    write_span_1, write_span_2, write_span_3, write_span_4
+};
+
+static const stride_writer stride_writers[4] =
+{
+    write_stride_1, write_stride_2, write_stride_3, write_stride_4
+};
+
+/* The blending writers work like Surface.fill with special_flags, using
+   the same BLEND_* macros: the pixel is read back into 8 bit channels,
+   combined with the pen's rgba and mapped again.  Pixels without their
+   own alpha read as 255.  PYGAME_BLEND_ALPHA composites the color by its
+   alpha the way a blit from a per pixel alpha surface does. */
+static void blend_pixel(Uint8 *pixel, const draw_pen *pen)
+{
+    SDL_PixelFormat *fmt = pen->format;
+    int bpp = fmt->BytesPerPixel;
+    int sR = pen->rgba[0], sG = pen->rgba[1], sB = pen->rgba[2], sA = pen->rgba[3];
+    int dR, dG, dB, dA, tmp;
+    Uint32 value;
+
+    if(bpp == 1)
+    {
+        GET_PIXELVALS_1(dR, dG, dB, dA, pixel, fmt);
+    }
+    else
+    {
+        GET_PIXEL(value, bpp, pixel);
+        GET_PIXELVALS(dR, dG, dB, dA, value, fmt, pen->ppa);
+    }
+
+    switch(pen->blend)
+    {
+    case PYGAME_BLEND_ADD:
+        BLEND_ADD(tmp, sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_SUB:
+        BLEND_SUB(tmp, sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_MULT:
+        BLEND_MULT(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_MIN:
+        BLEND_MIN(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_MAX:
+        BLEND_MAX(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_RGBA_ADD:
+        BLEND_RGBA_ADD(tmp, sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_RGBA_SUB:
+        BLEND_RGBA_SUB(tmp, sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_RGBA_MULT:
+        BLEND_RGBA_MULT(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_RGBA_MIN:
+        BLEND_RGBA_MIN(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_RGBA_MAX:
+        BLEND_RGBA_MAX(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    case PYGAME_BLEND_PREMULTIPLIED:
+        ALPHA_BLEND_PREMULTIPLIED(tmp, sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    default: /* PYGAME_BLEND_ALPHA */
+        ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB, dA);
+        break;
+    }
+
+    switch(bpp)
+    {
+    case 1:
+        *pixel = (Uint8)SDL_MapRGBA(fmt, (Uint8)dR, (Uint8)dG, (Uint8)dB, (Uint8)dA);
+        break;
+    case 3:
+        pixel[pen->offset[0]] = (Uint8)dR;
+        pixel[pen->offset[1]] = (Uint8)dG;
+        pixel[pen->offset[2]] = (Uint8)dB;
+        break;
+    default:
+        CREATE_PIXEL(pixel, (Uint32)dR, (Uint32)dG, (Uint32)dB, (Uint32)dA, bpp, fmt);
+        break;
+    }
+}
+
+#ifdef DRAW_SSE2
+/* Exact division of a product of two bytes by 255. */
+#define DIV255_EPU16(p) \
+    _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16((p), one), _mm_srli_epi16((p), 8)), 8)
+
+/* blend_pixel for quads * 4 pixels of a 32 bit surface with 8 bit
+   channels, giving the same pixels.  The byte that is not r, g or b
+   takes the part of alpha, set to 255 first when the pixels have no
+   alpha of their own, and cleared at the end when it is just padding. */
+static void blend_quads_sse2(Uint8 *pixel, int quads, const draw_pen *pen)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i amask = _mm_set1_epi32((int)pen->amask);
+    const __m128i src = _mm_set1_epi32((int)pen->spixel);
+    const __m128i srgb = _mm_andnot_si128(amask, src);
+    const __m128i src16 = _mm_unpacklo_epi8(src, zero);
+    const __m128i alpha16 = _mm_set1_epi16(pen->rgba[3]);
+    /* 16 bit lanes holding alpha in an unpacked pixel */
+    const __m128i amask16 = _mm_cmpeq_epi16(_mm_unpacklo_epi8(amask, zero),
+                                            _mm_set1_epi16(0xff));
+    /* for ALPHA_BLEND_COMP as (dC * (256 - sA) + sC * (sA + 1)) / 256,
+       which gives the same without going negative */
+    const __m128i inv16 = _mm_set1_epi16(256 - pen->rgba[3]);
+    const __m128i s16 = _mm_mullo_epi16(src16, _mm_add_epi16(alpha16, one));
+    const __m128i fill = pen->ppa ? zero : amask;
+    const __m128i keep = pen->format->Amask ? _mm_cmpeq_epi32(zero, zero) :
+                                              _mm_andnot_si128(amask, _mm_cmpeq_epi32(zero, zero));
+    __m128i d, lo, hi, plo, phi, clo, chi, res;
+
+    for(; quads > 0; --quads, pixel += 16)
+    {
+        d = _mm_or_si128(_mm_loadu_si128((__m128i*)pixel), fill);
+        switch(pen->blend)
+        {
+        case PYGAME_BLEND_ADD:
+            res = _mm_adds_epu8(d, srgb);
+            break;
+        case PYGAME_BLEND_SUB:
+            res = _mm_subs_epu8(d, srgb);
+            break;
+        case PYGAME_BLEND_MIN:
+            res = _mm_min_epu8(d, _mm_or_si128(src, amask));
+            break;
+        case PYGAME_BLEND_MAX:
+            res = _mm_max_epu8(d, srgb);
+            break;
+        case PYGAME_BLEND_RGBA_ADD:
+            res = _mm_adds_epu8(d, src);
+            break;
+        case PYGAME_BLEND_RGBA_SUB:
+            res = _mm_subs_epu8(d, src);
+            break;
+        case PYGAME_BLEND_RGBA_MIN:
+            res = _mm_min_epu8(d, src);
+            break;
+        case PYGAME_BLEND_RGBA_MAX:
+            res = _mm_max_epu8(d, src);
+            break;
+        case PYGAME_BLEND_MULT:
+        case PYGAME_BLEND_RGBA_MULT:
+            lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), src16), 8);
+            hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), src16), 8);
+            res = _mm_packus_epi16(lo, hi);
+            if(pen->blend == PYGAME_BLEND_MULT)
+                res = _mm_or_si128(_mm_andnot_si128(amask, res), _mm_and_si128(amask, d));
+            break;
+        default:
+            /* PYGAME_BLEND_ALPHA and PYGAME_BLEND_PREMULTIPLIED, with
+               alpha as sA + dA - sA * dA / 255 in both */
+            lo = _mm_unpacklo_epi8(d, zero);
+            hi = _mm_unpackhi_epi8(d, zero);
+            plo = _mm_mullo_epi16(lo, alpha16);
+            phi = _mm_mullo_epi16(hi, alpha16);
+            if(pen->blend == PYGAME_BLEND_PREMULTIPLIED)
+            {
+                /* sC + dC - dC * sA / 256, saturated by the pack */
+                clo = _mm_sub_epi16(_mm_add_epi16(src16, lo), _mm_srli_epi16(plo, 8));
+                chi = _mm_sub_epi16(_mm_add_epi16(src16, hi), _mm_srli_epi16(phi, 8));
+            }
+            else
+            {
+                clo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, inv16), s16), 8);
+                chi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, inv16), s16), 8);
+            }
+            lo = _mm_sub_epi16(_mm_add_epi16(alpha16, lo), DIV255_EPU16(plo));
+            hi = _mm_sub_epi16(_mm_add_epi16(alpha16, hi), DIV255_EPU16(phi));
+            lo = _mm_or_si128(_mm_andnot_si128(amask16, clo), _mm_and_si128(amask16, lo));
+            hi = _mm_or_si128(_mm_andnot_si128(amask16, chi), _mm_and_si128(amask16, hi));
+            res = _mm_packus_epi16(lo, hi);
+            if(pen->blend != PYGAME_BLEND_PREMULTIPLIED)
+            {
+                /* fully transparent pixels just take the color */
+                __m128i empty = _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero);
+
+                res = _mm_or_si128(_mm_and_si128(empty, src), _mm_andnot_si128(empty, res));
+            }
+            break;
+        }
+        _mm_storeu_si128((__m128i*)pixel, _mm_and_si128(res, keep));
+    }
+}
+#endif
+
+static void blend_span(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    int bpp = pen->format->BytesPerPixel;
+
+#ifdef DRAW_SSE2
+    if(pen->simd && count >= 4)
+    {
+        blend_quads_sse2(pixel, count >> 2, pen);
+        pixel += (count & ~3) * 4;
+        count &= 3;
+    }
+#endif
+    for(; count > 0; --count, pixel += bpp)
+        blend_pixel(pixel, pen);
+}
+
+static void blend_stride(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    for(; count > 0; --count, pixel += step)
+        blend_pixel(pixel, pen);
+}
+
+/* Sets up pen to draw the mapped color on surf, overwriting the pixels
+   when blend is 0, or blending with one of the PYGAME_BLEND_* modes.
+   rgba, when given, supplies the alpha to blend with even if the surface
+   has none.  Returns 0 for an unknown blend mode. */
+static int pen_init(draw_pen *pen, SDL_Surface *surf, Uint32 color, const Uint8 *rgba, int blend)
+{
+    SDL_PixelFormat *fmt = surf->format;
+    Uint32 amask = ~(fmt->Rmask | fmt->Gmask | fmt->Bmask);
+    int ashift;
+
+    pen->color = color;
+    pen->format = fmt;
+    pen->blend = blend;
+    if(!blend)
+    {
+        pen->span = span_writers[fmt->BytesPerPixel - 1];
+        pen->stride = stride_writers[fmt->BytesPerPixel - 1];
+        return 1;
+    }
+    if(blend < PYGAME_BLEND_ADD || blend > PYGAME_BLEND_ALPHA ||
+       (blend > PYGAME_BLEND_RGBA_MIN && blend < PYGAME_BLEND_RGBA_MAX))
+        return 0;
+
+    pen->span = blend_span;
+    pen->stride = blend_stride;
+    SDL_GetRGBA(color, fmt, &pen->rgba[0], &pen->rgba[1], &pen->rgba[2], &pen->rgba[3]);
+    if(rgba)
+        pen->rgba[3] = rgba[3];
+    pen->ppa = (surf->flags & SDL_SRCALPHA) && fmt->Amask;
+    SET_OFFSETS_24(pen->offset[0], pen->offset[1], pen->offset[2], fmt);
+
+    /* SSE2 needs 8 bit r, g and b with the spare byte free for alpha */
+    for(ashift = 0; ashift < 32 && !((amask >> ashift) & 1); ashift += 8)
+        ;
+    pen->simd = fmt->BytesPerPixel == 4 && !fmt->Rloss && !fmt->Gloss && !fmt->Bloss &&
+                ashift < 32 && amask == (Uint32)0xff << ashift &&
+                (!fmt->Amask || fmt->Amask == amask);
+    pen->amask = amask;
+    pen->spixel = ((Uint32)pen->rgba[0] << fmt->Rshift) | ((Uint32)pen->rgba[1] << fmt->Gshift) |
+                  ((Uint32)pen->rgba[2] << fmt->Bshift);
+    if(pen->simd)
+        pen->spixel |= (Uint32)pen->rgba[3] << ashift;
+    return 1;
+}
+
+#define PIXEL_AT(surf, x, y) \
+    ((Uint8*)(surf)->pixels + (y) * (surf)->pitch + (x) * (surf)->format->BytesPerPixel)
+
+
+static int set_at(SDL_Surface* surf, int x, int y, const draw_pen *pen)
+{
+    if(x < surf->clip_rect.x || x >= surf->clip_rect.x + surf->clip_rect.w ||
+       y < surf->clip_rect.y || y >= surf->clip_rect.y + surf->clip_rect.h)
+        return 0;
+
+    pen->span(PIXEL_AT(surf, x, y), 1, pen);
+    return 1;
+}
+
+/* Fills the part of a rectangle inside clip, one span per row, or one
+   column for rectangles a single pixel wide. */
+static void fill_rect_clip(SDL_Surface *surf, SDL_Rect *clip, int x, int y, int w, int h, const draw_pen *pen)
+{
+    int right = MIN(x + w, clip->x + clip->w);
+    int bottom = MIN(y + h, clip->y + clip->h);
+    Uint8 *row;
+
+    x = MAX(x, clip->x);
+    y = MAX(y, clip->y);
+    if(x >= right || y >= bottom)
+        return;
+    row = PIXEL_AT(surf, x, y);
+    if(right - x == 1)
+    {
+        pen->stride(row, bottom - y, surf->pitch, pen);
+        return;
+    }
+    for(; y < bottom; ++y, row += surf->pitch)
+        pen->span(row, right - x, pen);
+}
+
+static void fill_rect_spans(SDL_Surface *surf, int x, int y, int w, int h, const draw_pen *pen)
+{
+    fill_rect_clip(surf, &surf->clip_rect, x, y, w, h, pen);
+}
+
+static void mask_mark(blend_mask *mask, Uint8 *pixel, int count)
+{
+    SDL_Surface *surf = mask->surf;
+    int offset = (int)(pixel - (Uint8*)surf->pixels);
+    int y = offset / surf->pitch;
+    int x = (offset - y * surf->pitch) / surf->format->BytesPerPixel;
+    int right = MIN(x + count, mask->x + mask->w);
+
+    x = MAX(x, mask->x);
+    if(y < mask->y || y >= mask->y + mask->h || x >= right)
+        return;
+    memset(mask->mask + (y - mask->y) * mask->w + x - mask->x, 1, right - x);
+    mask->top = MIN(mask->top, y);
+    mask->bottom = MAX(mask->bottom, y);
+}
+
+/* the pen handed out is the first member of its blend_mask */
+static void mask_span(Uint8 *pixel, int count, const draw_pen *pen)
+{
+    mask_mark((blend_mask*)pen, pixel, count);
+}
+
+static void mask_stride(Uint8 *pixel, int count, int step, const draw_pen *pen)
+{
+    for(; count > 0; --count, pixel += step)
+        mask_mark((blend_mask*)pen, pixel, 1);
+}
+
+/* Returns the pen to draw the pieces of a shape inside x, y, w, h with.
+   That is pen itself when it does not blend, or when there is no memory
+   for the mask, so the shape is still drawn. */
+static const draw_pen *blend_mask_begin(blend_mask *mask, SDL_Surface *surf, const draw_pen *pen,
+                                        int x, int y, int w, int h)
+{
+    SDL_Rect *clip = &surf->clip_rect;
+    int right = MIN(x + w, clip->x + clip->w);
+    int bottom = MIN(y + h, clip->y + clip->h);
+
+    mask->mask = NULL;
+    if(!pen->blend)
+        return pen;
+    mask->x = MAX(x, clip->x);
+    mask->y = MAX(y, clip->y);
+    mask->w = right - mask->x;
+    mask->h = bottom - mask->y;
+    if(mask->w <= 0 || mask->h <= 0)
+        return pen;
+    mask->mask = (Uint8*)calloc((size_t)mask->w * mask->h, 1);
+    if(!mask->mask)
+        return pen;
+
+    mask->pen = *pen;
+    mask->pen.span = mask_span;
+    mask->pen.stride = mask_stride;
+    mask->pen.blend = 0;
+    mask->surf = surf;
+    mask->top = INT_MAX;
+    mask->bottom = INT_MIN;
+    return &mask->pen;
+}
+
+/* Blends each run of marked pixels with pen, the one given to
+   blend_mask_begin. */
+static void blend_mask_end(blend_mask *mask, const draw_pen *pen)
+{
+    Uint8 *row;
+    int x, y, start;
+
+    if(!mask->mask)
+        return;
+    for(y = mask->top; y <= mask->bottom; ++y)
+    {
+        row = mask->mask + (y - mask->y) * mask->w;
+        for(x = 0; x < mask->w; ++x)
+        {
+            if(!row[x])
+                continue;
+            for(start = x; x < mask->w && row[x]; ++x)
+                ;
+            pen->span(PIXEL_AT(mask->surf, mask->x + start, y), x - start, pen);
+        }
+    }
+    free(mask->mask);
+}
+
+
+static int clip_and_draw_aaline(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, float* pts, int blend)
+{
+    if(!clipaaline(pts, rect->x+1, rect->y+1, rect->x+rect->w-2, rect->y+rect->h-2))
+        return 0;
+    drawaaline(surf, pen, pts[0], pts[1], pts[2], pts[3], blend);
+    return 1;
+}
+
+static int clip_and_draw_line(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, int* pts)
+{
+    if(!clipline(pts, rect->x, rect->y, rect->x+rect->w-1, rect->y+rect->h-1))
+        return 0;
+    if(pts[1] == pts[3])
+        drawhorzline(surf, pen, pts[0], pts[1], pts[2]);
+    else if(pts[0] == pts[2])
+        drawvertline(surf, pen, pts[0], pts[1], pts[3]);
+    else
+        drawline(surf, pen, pts[0], pts[1], pts[2], pts[3]);
+    return 1;
+}
+
+/* Finds the steps along the line from pts, as drawline walks it, that
+   put a pixel inside left, top, right and bottom.  At step n the line is
+   n pixels along its long axis and n * dminor / dmajor rounded down
+   across it.  Returns 0 when there are none. */
+static int line_steps(int* pts, int left, int top, int right, int bottom, int* first, int* last)
+{
+    int deltax = abs(pts[2] - pts[0]) + 1, deltay = abs(pts[3] - pts[1]) + 1;
+    int major, majorsign, majorlo, majorhi, dmajor;
+    int minor, minorsign, minorlo, minorhi, dminor;
+    Sint64 a, b;
+
+    if(deltax >= deltay)
+    {
+        major = pts[0]; majorlo = left; majorhi = right; dmajor = deltax;
+        minor = pts[1]; minorlo = top; minorhi = bottom; dminor = deltay;
+        majorsign = (pts[2] < pts[0]) ? -1 : 1;
+        minorsign = (pts[3] < pts[1]) ? -1 : 1;
+    }
+    else
+    {
+        major = pts[1]; majorlo = top; majorhi = bottom; dmajor = deltay;
+        minor = pts[0]; minorlo = left; minorhi = right; dminor = deltax;
+        majorsign = (pts[3] < pts[1]) ? -1 : 1;
+        minorsign = (pts[2] < pts[0]) ? -1 : 1;
+    }
+
+    *first = 0;
+    *last = dmajor - 1;
+    if(majorsign > 0)
+    {
+        *first = MAX(*first, majorlo - major);
+        *last = MIN(*last, majorhi - major);
+    }
+    else
+    {
+        *first = MAX(*first, major - majorhi);
+        *last = MIN(*last, major - majorlo);
+    }
+
+    /* the steps where the offset across the line is from a to b */
+    a = (minorsign > 0) ? minorlo - minor : minor - minorhi;
+    b = (minorsign > 0) ? minorhi - minor : minor - minorlo;
+    if(b < 0)
+        return 0;
+    if(a > 0)
+        *first = (int)MAX(*first, (a * dmajor + dminor - 1) / dminor);
+    *last = (int)MIN(*last, ((b + 1) * dmajor + dminor - 1) / dminor - 1);
+    return *first <= *last;
+}
+
+/* The pixel drawline puts at step n of the line from pts. */
+static void line_step_point(int* pts, int n, int* x, int* y)
+{
+    int deltax = abs(pts[2] - pts[0]) + 1, deltay = abs(pts[3] - pts[1]) + 1;
+    int signx = (pts[2] < pts[0]) ? -1 : 1, signy = (pts[3] < pts[1]) ? -1 : 1;
+
+    if(deltax >= deltay)
+    {
+        *x = pts[0] + signx * n;
+        *y = pts[1] + signy * (int)((Sint64)n * deltay / deltax);
+    }
+    else
+    {
+        *x = pts[0] + signx * (int)((Sint64)n * deltax / deltay);
+        *y = pts[1] + signy * n;
+    }
+}
+
+static int clip_and_draw_line_width(SDL_Surface* surf, SDL_Rect* rect, const draw_pen *pen, int width, int* pts)
+{
+    /* a wide line covers the pixels of width parallel 1 pixel lines,
+       offset lo to hi pixels across its main direction */
+    int lo = -((width - 1) / 2), hi = width / 2;
+    int xlo = 0, xhi = 0, ylo = 0, yhi = 0;
+    int first, last;
+    int newpts[4];
+
+    if(width <= 1)
+    {
+        if(!clip_and_draw_line(surf, rect, pen, pts))
+            return 0;
+        memcpy(newpts, pts, sizeof(int)*4);
+    }
+    else
+    {
+        if(abs(pts[0]-pts[2]) > abs(pts[1]-pts[3]))
+        {
+            ylo = lo; yhi = hi;
+        }
+        else
+        {
+            xlo = lo; xhi = hi;
+        }
+
+        /* only walk the steps where one of the offset lines is seen, so
+           the pixels stay where they are on the whole line */
+        if(!line_steps(pts, rect->x - xhi, rect->y - yhi,
+                       rect->x + rect->w - 1 - xlo, rect->y + rect->h - 1 - ylo, &first, &last))
+            return 0;
+        drawline_runs(surf, rect, pen, pts, first, last, xlo, xhi, ylo, yhi);
+        line_step_point(pts, first, &newpts[0], &newpts[1]);
+        line_step_point(pts, last, &newpts[2], &newpts[3]);
+    }
+
+    pts[0] = MAX(MIN(newpts[0], newpts[2]) + xlo, rect->x);
+    pts[1] = MAX(MIN(newpts[1], newpts[3]) + ylo, rect->y);
+    pts[2] = MIN(MAX(newpts[0], newpts[2]) + xhi, rect->x + rect->w - 1);
+    pts[3] = MIN(MAX(newpts[1], newpts[3]) + yhi, rect->y + rect->h - 1);
+    return 1;
+}
+
+
+/*this line clipping based heavily off of code from
+http://www.ncsa.uiuc.edu/Vis/Graphics/src/clipCohSuth.c */
+#define LEFT_EDGE   0x1
+#define RIGHT_EDGE  0x2
+#define BOTTOM_EDGE 0x4
+#define TOP_EDGE    0x8
+#define INSIDE(a)   (!a)
+#define REJECT(a,b) (a&b)
+#define ACCEPT(a,b) (!(a|b))
+
+static int encode(int x, int y, int left, int top, int right, int bottom)
+{
+    int code = 0;
+    if(x < left)  code |= LEFT_EDGE;
+    if(x > right) code |= RIGHT_EDGE;
+    if(y < top)   code |= TOP_EDGE;
+    if(y > bottom)code |= BOTTOM_EDGE;
+    return code;
+}
+
+static int encodeFloat(float x, float y, int left, int top, int right, int bottom)
+{
+    int code = 0;
+    if(x < left)  code |= LEFT_EDGE;
+    if(x > right) code |= RIGHT_EDGE;
+    if(y < top)   code |= TOP_EDGE;
+    if(y > bottom)code |= BOTTOM_EDGE;
+    return code;
+}
+
+static int clipaaline(float* pts, int left, int top, int right, int bottom)
+{
+    float x1 = pts[0];
+    float y1 = pts[1];
+    float x2 = pts[2];
+    float y2 = pts[3];
+    int code1, code2;
+    int draw = 0;
+    float swaptmp;
+    int intswaptmp;
+    float m; /*slope*/
+
+    while(1) {
+        code1 = encodeFloat(x1, y1, left, top, right, bottom);
+        code2 = encodeFloat(x2, y2, left, top, right, bottom);
+        if(ACCEPT(code1, code2)) {
+            draw = 1;
+            break;
+        }
+        else if(REJECT(code1, code2)) {
+            break;
+        }
+        else {
+            if(INSIDE(code1)) {
+                swaptmp = x2; x2 = x1; x1 = swaptmp;
+                swaptmp = y2; y2 = y1; y1 = swaptmp;
+                intswaptmp = code2; code2 = code1; code1 = intswaptmp;
+            }
+            if(x2 != x1)
+                m = (y2 - y1) / (x2 - x1);
+            else
+                m = 1.0f;
+            if(code1 & LEFT_EDGE) {
+                y1 += ((float)left - x1) * m;
+                x1 = (float)left;
+            }
+            else if(code1 & RIGHT_EDGE) {
+                y1 += ((float)right - x1) * m;
+                x1 = (float)right;
+            }
+            else if(code1 & BOTTOM_EDGE) {
+                if(x2 != x1)
+                    x1 += ((float)bottom - y1) / m;
+                y1 = (float)bottom;
+            }
+            else if(code1 & TOP_EDGE) {
+                if(x2 != x1)
+                    x1 += ((float)top - y1) / m;
+                y1 = (float)top;
+            }
+        }
+    }
+    if(draw) {
+        pts[0] = x1; pts[1] = y1;
+        pts[2] = x2; pts[3] = y2;
+    }
+    return draw;
+}
+
+static int clipline(int* pts, int left, int top, int right, int bottom)
+{
+    int x1 = pts[0];
+    int y1 = pts[1];
+    int x2 = pts[2];
+    int y2 = pts[3];
+    int code1, code2;
+    int draw = 0;
+    int swaptmp;
+    float m; /*slope*/
+
+    while(1)
+    {
+        code1 = encode(x1, y1, left, top, right, bottom);
+        code2 = encode(x2, y2, left, top, right, bottom);
+        if(ACCEPT(code1, code2)) {
+            draw = 1;
+            break;
+        }
+        else if(REJECT(code1, code2))
+            break;
+        else {
+            if(INSIDE(code1)) {
+                swaptmp = x2; x2 = x1; x1 = swaptmp;
+                swaptmp = y2; y2 = y1; y1 = swaptmp;
+                swaptmp = code2; code2 = code1; code1 = swaptmp;
+            }
+            if(x2 != x1)
+                m = (y2 - y1) / (float)(x2 - x1);
+            else
+                m = 1.0f;
+            if(code1 & LEFT_EDGE) {
+                y1 += (int)((left - x1) * m);
+                x1 = left;
+            }
+            else if(code1 & RIGHT_EDGE) {
+                y1 += (int)((right - x1) * m);
+                x1 = right;
+            }
+            else if(code1 & BOTTOM_EDGE) {
+                if(x2 != x1)
+                    x1 += (int)((bottom - y1) / m);
+                y1 = bottom;
+            }
+            else if(code1 & TOP_EDGE) {
+                if(x2 != x1)
+                    x1 += (int)((top - y1) / m);
+                y1 = top;
+            }
+        }
+    }
+    if(draw) {
+        pts[0] = x1; pts[1] = y1;
+        pts[2] = x2; pts[3] = y2;
+    }
+    return draw;
+}
+
+
+
+
+
+
+/* Antialiased drawing works on 24 and 32 bit pixels with an integer
+   coverage from 0 to 256, so no float math is done per pixel. */
+#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define CHANNEL_OFFSET(shift, bpp) ((shift) >> 3)
+#else
+#define CHANNEL_OFFSET(shift, bpp) ((bpp) - 1 - ((shift) >> 3))
+#endif
+
+#define AA_COVER(br) ((Uint32)((br) * 256.0f))
+#define AA_FIXED(v)  ((Sint32)((double)(v) * 65536.0))
+
+typedef struct {
+    int offset[4];   /* byte offsets of r, g, b and a in a pixel */
+    Uint32 value[3]; /* r, g, b of the color */
+    int hasalpha;
+    const draw_pen *pen;
+} aa_color;
+
+static void aa_color_init(aa_color *aa, SDL_PixelFormat *format, const draw_pen *pen)
+{
+    aa->offset[0] = CHANNEL_OFFSET(format->Rshift, format->BytesPerPixel);
+    aa->offset[1] = CHANNEL_OFFSET(format->Gshift, format->BytesPerPixel);
+    aa->offset[2] = CHANNEL_OFFSET(format->Bshift, format->BytesPerPixel);
+    aa->offset[3] = CHANNEL_OFFSET(format->Ashift, format->BytesPerPixel);
+    aa->value[0] = (pen->color >> format->Rshift) & 0xff;
+    aa->value[1] = (pen->color >> format->Gshift) & 0xff;
+    aa->value[2] = (pen->color >> format->Bshift) & 0xff;
+    aa->hasalpha = format->Amask != 0;
+    aa->pen = pen;
+}
+
+/* Mixes the pixel toward what the pen's blend mode makes of it by
+   cover, from 0 to 256. */
+static void aa_blend_pixel(Uint8 *pixel, const draw_pen *pen, Uint32 cover)
+{
+    Uint8 blended[4];
+    int i, bpp = pen->format->BytesPerPixel;
+
+    memcpy(blended, pixel, bpp);
+    blend_pixel(blended, pen);
+    for(i = 0; i < bpp; ++i)
+        pixel[i] = (Uint8)((blended[i] * cover + pixel[i] * (256 - cover)) >> 8);
+}
+
+/* Blending mixes the color over the pixel by the coverage, otherwise the
+   color is scaled by it.  The alpha is the coverage either way.  With a
+   blend mode in the pen the coverage mixes in the blended pixel instead. */
+static void aa_pixel(Uint8 *pixel, const aa_color *aa, Uint32 cover, int blend)
+{
+    Uint32 inv = 256 - cover;
+    Uint8 *p;
+    int i;
+
+    if(aa->pen->blend)
+    {
+        aa_blend_pixel(pixel, aa->pen, cover);
+        return;
+    }
+    for(i = 0; i < 3; ++i)
+    {
+        p = pixel + aa->offset[i];
+        if(blend)
+            *p = (Uint8)((aa->value[i] * cover + *p * inv) >> 8);
+        else
+            *p = (Uint8)((aa->value[i] * cover) >> 8);
+    }
+    if(aa->hasalpha)
+    {
+        p = pixel + aa->offset[3];
+        if(blend)
+            *p = (Uint8)(*p + (((255 - *p) * cover) >> 8));
+        else
+            *p = (Uint8)((255 * cover) >> 8);
+    }
+}
+
+/* Adapted from http://freespace.virgin.net/hugo.elias/graphics/x_wuline.htm */
+static void drawaaline(SDL_Surface* surf, const draw_pen *pen, float x1, float y1, float x2, float y2, int blend) {
+    float grad, xd, yd;
+    float xgap, ygap, xend, yend;
+    float swaptmp;
+    Sint32 pos, step; /* 16.16 fixed point */
+    int x, y, ix1, ix2, iy1, iy2;
+    int pixx, pixy;
+    Uint8* pixel;
+    Uint8* pm = (Uint8*)surf->pixels;
+    aa_color aa;
+
+    pixx = surf->format->BytesPerPixel;
+    pixy = surf->pitch;
+
+    xd = x2-x1;
+    yd = y2-y1;
+
+    if (xd == 0 && yd == 0)
+    {
+        /* Single point. Due to the nature of the aaline clipping, this
+         * is less exact than the normal line. */
+        set_at (surf, x1, y1, pen);
+        return;
+    }
+
+    aa_color_init(&aa, surf->format, pen);
+
+    if(fabs(xd)>fabs(yd)) {
+        if(x1>x2) {
+            swaptmp=x1; x1=x2; x2=swaptmp;
+            swaptmp=y1; y1=y2; y2=swaptmp;
+            xd = (x2-x1);
+            yd = (y2-y1);
+        }
+        grad = yd/xd;
+        xend = trunc(x1)+0.5; /* This makes more sense than trunc(x1+0.5) */
+        yend = y1+grad*(xend-x1);
+        xgap = INVFRAC(x1);
+        ix1 = (int)xend;
+        iy1 = (int)yend;
+        pos = AA_FIXED(yend+grad);
+        step = AA_FIXED(grad);
+        pixel = pm + pixx * ix1 + pixy * iy1;
+        aa_pixel(pixel, &aa, AA_COVER(INVFRAC(yend) * xgap), blend);
+        aa_pixel(pixel + pixy, &aa, AA_COVER(FRAC(yend) * xgap), blend);
+        xend = trunc(x2)+0.5;
+        yend = y2+grad*(xend-x2);
+        xgap =    FRAC(x2); /* this also differs from Hugo's description. */
+        ix2 = (int)xend;
+        iy2 = (int)yend;
+        pixel = pm + pixx * ix2 + pixy * iy2;
+        aa_pixel(pixel, &aa, AA_COVER(INVFRAC(yend) * xgap), blend);
+        aa_pixel(pixel + pixy, &aa, AA_COVER(FRAC(yend) * xgap), blend);
+        for(x=ix1+1; x<ix2; ++x, pos += step) {
+            pixel = pm + pixx * x + pixy * (pos >> 16);
+            aa_pixel(pixel, &aa, 256 - ((pos >> 8) & 0xff), blend);
+            aa_pixel(pixel + pixy, &aa, (pos >> 8) & 0xff, blend);
+        }
+    }
+    else {
+        if(y1>y2) {
+            swaptmp=y1; y1=y2; y2=swaptmp;
+            swaptmp=x1; x1=x2; x2=swaptmp;
+            yd = (y2-y1);
+            xd = (x2-x1);
+        }
+        grad = xd/yd;
+        yend = trunc(y1)+0.5;  /* This makes more sense than trunc(x1+0.5) */
+        xend = x1+grad*(yend-y1);
+        ygap = INVFRAC(y1);
+        iy1 = (int)yend;
+        ix1 = (int)xend;
+        pos = AA_FIXED(xend+grad);
+        step = AA_FIXED(grad);
+        pixel = pm + pixx * ix1 + pixy * iy1;
+        aa_pixel(pixel, &aa, AA_COVER(INVFRAC(xend) * ygap), blend);
+        aa_pixel(pixel + pixx, &aa, AA_COVER(FRAC(xend) * ygap), blend);
+        yend = trunc(y2)+0.5;
+        xend = x2+grad*(yend-y2);
+        ygap = FRAC(y2);
+        iy2 = (int)yend;
+        ix2 = (int)xend;
+        pixel = pm + pixx * ix2 + pixy * iy2;
+        aa_pixel(pixel, &aa, AA_COVER(INVFRAC(xend) * ygap), blend);
+        aa_pixel(pixel + pixx, &aa, AA_COVER(FRAC(xend) * ygap), blend);
+        for(y=iy1+1; y<iy2; ++y, pos += step) {
+            pixel = pm + pixx * (pos >> 16) + pixy * y;
+            aa_pixel(pixel, &aa, 256 - ((pos >> 8) & 0xff), blend);
+            aa_pixel(pixel + pixx, &aa, (pos >> 8) & 0xff, blend);
+        }
+    }
+}
+
+
+/*here's my sdl'ized version of bresenham*/
+static void drawline(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int x2, int y2)
+{
+    int deltax, deltay, signx, signy;
+    int pixx, pixy, bpp;
+    int x = 0, y = 0, run = 0;
+    int swaptmp;
+    Uint8 *pixel, *start;
+    span_writer span;
+    stride_writer stride;
+
+    deltax = x2 - x1;
+    deltay = y2 - y1;
+    signx = (deltax < 0) ? -1 : 1;
+    signy = (deltay < 0) ? -1 : 1;
+    deltax = signx * deltax + 1;
+    deltay = signy * deltay + 1;
+
+    bpp = pixx = surf->format->BytesPerPixel;
+    pixy = surf->pitch;
+    pixel = ((Uint8*)surf->pixels) + pixx * x1 + pixy * y1;
+    span = pen->span;
+    stride = pen->stride;
+
+    pixx *= signx;
+    pixy *= signy;
+    if(deltax < deltay) /*swap axis if rise > run*/
+    {
+        swaptmp = deltax; deltax = deltay; deltay = swaptmp;
+        swaptmp = pixx; pixx = pixy; pixy = swaptmp;
+    }
+
+    /* write a run of pixels each time the line steps across */
+    for(start = pixel; x < deltax; x++, pixel += pixx) {
+        ++run;
+        y += deltay;
+        if(y >= deltax || x == deltax - 1) {
+            if(pixx == bpp)
+                span(start, run, pen);
+            else if(pixx == -bpp)
+                span(pixel, run, pen);
+            else
+                stride(start, run, pixx, pen);
+            if(y >= deltax) {y -= deltax; pixel += pixy;}
+            start = pixel + pixx;
+            run = 0;
+        }
+    }
+}
+
+/* The same pixels as drawline from pts, but only steps first to last
+   along the line are drawn, and each run is widened to a rectangle xlo
+   to xhi and ylo to yhi pixels around it, clipped to clip. */
+static void drawline_runs(SDL_Surface* surf, SDL_Rect* clip, const draw_pen *pen, int* pts,
+                          int first, int last, int xlo, int xhi, int ylo, int yhi)
+{
+    int deltax = abs(pts[2] - pts[0]) + 1, deltay = abs(pts[3] - pts[1]) + 1;
+    int signx = (pts[2] < pts[0]) ? -1 : 1, signy = (pts[3] < pts[1]) ? -1 : 1;
+    int x, y, runx, runy, loop, err;
+
+    if(deltax >= deltay)
+    {
+        err = (int)((Sint64)first * deltay % deltax);
+        x = runx = pts[0] + signx * first;
+        y = pts[1] + signy * (int)((Sint64)first * deltay / deltax);
+        for(loop = first; loop <= last; ++loop, x += signx)
+        {
+            err += deltay;
+            if(err >= deltax || loop == last)
+            {
+                fill_rect_clip(surf, clip, MIN(runx, x) + xlo, y + ylo,
+                               abs(x - runx) + 1 + xhi - xlo, yhi - ylo + 1, pen);
+                if(err >= deltax) {err -= deltax; y += signy;}
+                runx = x + signx;
+            }
+        }
+    }
+    else
+    {
+        err = (int)((Sint64)first * deltax % deltay);
+        y = runy = pts[1] + signy * first;
+        x = pts[0] + signx * (int)((Sint64)first * deltax / deltay);
+        for(loop = first; loop <= last; ++loop, y += signy)
+        {
+            err += deltax;
+            if(err >= deltay || loop == last)
+            {
+                fill_rect_clip(surf, clip, x + xlo, MIN(runy, y) + ylo,
+                               xhi - xlo + 1, abs(y - runy) + 1 + yhi - ylo, pen);
+                if(err >= deltay) {err -= deltay; x += signx;}
+                runy = y + signy;
+            }
+        }
+    }
+}
+
+
+
+static void drawhorzline(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int x2)
+{
+    if(x1 > x2)
+    {
+        int temp = x1;
+        x1 = x2; x2 = temp;
+    }
+    pen->span(PIXEL_AT(surf, x1, y1), x2 - x1 + 1, pen);
+}
+
+static void drawhorzlineclip(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int x2)
+{
+    if(y1 < surf->clip_rect.y || y1 >= surf->clip_rect.y + surf->clip_rect.h)
+        return;
+
+    if( x2 < x1 )
+    {
+        int temp = x1;
+        x1 = x2; x2 = temp;
+    }
+
+    x1 = MAX(x1, surf->clip_rect.x);
+    x2 = MIN(x2, surf->clip_rect.x + surf->clip_rect.w-1);
+
+        if(x2 < surf->clip_rect.x || x1 >= surf->clip_rect.x + surf->clip_rect.w)
+                return;
+
+    if(x1 == x2)
+        set_at(surf, x1, y1, pen);
+    else
+        drawhorzline(surf, pen, x1, y1, x2);
+}
+
+static void drawvertline(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int y2)
+{
+    if(y1 > y2)
+    {
+        int temp = y1;
+        y1 = y2; y2 = temp;
+    }
+    pen->stride(PIXEL_AT(surf, x1, y1), y2 - y1 + 1, surf->pitch, pen);
+}
+
+
+static void drawvertlineclip(SDL_Surface* surf, const draw_pen *pen, int x1, int y1, int y2)
+{
+    if(x1 < surf->clip_rect.x || x1 >= surf->clip_rect.x + surf->clip_rect.w)
+        return;
+    if ( y2 < y1 )
+    {
+        int temp = y1;
+        y1 = y2; y2 = temp;
+    }
+    y1 = MAX(y1, surf->clip_rect.y);
+    y2 = MIN(y2, surf->clip_rect.y + surf->clip_rect.h-1);
+    if(y2 - y1 < 1)
+        set_at( surf, x1, y1, pen);
+    else
+        drawvertline(surf, pen, x1, y1, y2);
+}
+
+static void draw_arc(SDL_Surface *dst, int x, int y, int radius1, int radius2,
+                     double angle_start, double angle_stop, const draw_pen *pen)
+{
+    double aStep;            // Angle Step (rad)
+    double a;                // Current Angle (rad)
+    int x_last, x_next, y_last, y_next;
+
+    // Angle step in rad
+    if (radius1<radius2) {
+        if (radius1<1.0e-4) {
+            aStep=1.0;
+        } else {
+            aStep=asin(2.0/radius1);
+        }
+    } else {
+        if (radius2<1.0e-4) {
+            aStep=1.0;
+        } else {
+            aStep=asin(2.0/radius2);
+        }
+    }
+
+    if(aStep<0.05) {
+        aStep = 0.05;
+    }
+
+    x_last = x+cos(angle_start)*radius1;
+    y_last = y-sin(angle_start)*radius2;
+    for(a=angle_start+aStep; a<=angle_stop; a+=aStep) {
+        int points[4];
+        x_next = x+cos(a)*radius1;
+        y_next = y-sin(a)*radius2;
+        points[0] = x_last; points[1] = y_last;
+        points[2] = x_next; points[3] = y_next;
+        clip_and_draw_line(dst, &dst->clip_rect, pen, points);
+        x_last = x_next;
+        y_last = y_next;
+    }
+}
+
+static void draw_ellipse(SDL_Surface *dst, int x, int y, int rx, int ry, const draw_pen *pen)
+{
+    int ix, iy;
+    int h, i, j, k;
+    int oh, oi, oj, ok;
+    int xmh, xph, ypk, ymk;
+    int xmi, xpi, ymj, ypj;
+    int xmj, xpj, ymi, ypi;
+    int xmk, xpk, ymh, yph;
+
+    if (rx==0 && ry==0) {  /* Special case - draw a single pixel */
+        set_at( dst, x, y, pen);
+        return;
+    }
+    if (rx==0) { /* Special case for rx=0 - draw a vline */
+        drawvertlineclip( dst, pen, x, (Sint16)(y-ry), (Sint16)(y+ry) );
+        return;
+    }
+    if (ry==0) { /* Special case for ry=0 - draw a hline */
+        drawhorzlineclip( dst, pen, (Sint16)(x-rx), y, (Sint16)(x+rx) );
+        return;
+    }
+
+
+    /* Init vars */
+    oh = oi = oj = ok = 0xFFFF;
+    if (rx > ry) {
+        ix = 0;
+        iy = rx * 64;
+        do {
+            h = (ix + 16) >> 6;
+            i = (iy + 16) >> 6;
+            j = (h * ry) / rx;
+            k = (i * ry) / rx;
+
+            if (((ok!=k) && (oj!=k)) || ((oj!=j) && (ok!=j)) || (k!=j)) {
+                xph=x+h-1;
+                xmh=x-h;
+                if (k>0) {
+                    ypk=y+k-1;
+                    ymk=y-k;
+                    if(h > 0) {
+                        set_at(dst, xmh, ypk, pen);
+                        set_at(dst, xmh, ymk, pen);
+                    }
+                    set_at(dst, xph, ypk, pen);
+                    set_at(dst, xph, ymk, pen);
+                }
+                ok=k;
+                xpi=x+i-1;
+                xmi=x-i;
+                if (j>0) {
+                    ypj=y+j-1;
+                    ymj=y-j;
+                    set_at(dst, xmi, ypj, pen);
+                    set_at(dst, xpi, ypj, pen);
+                    set_at(dst, xmi, ymj, pen);
+                    set_at(dst, xpi, ymj, pen);
+                }
+                oj=j;
+            }
+            ix = ix + iy / rx;
+            iy = iy - ix / rx;
+
+        } while (i > h);
+    } else {
+        ix = 0;
+        iy = ry * 64;
+        do {
+            h = (ix + 32) >> 6;
+            i = (iy + 32) >> 6;
+            j = (h * rx) / ry;
+            k = (i * rx) / ry;
+
+            if (((oi!=i) && (oh!=i)) || ((oh!=h) && (oi!=h) && (i!=h))) {
+                xmj=x-j;
+                xpj=x+j-1;
+                if (i>0) {
+                    ypi=y+i-1;
+                    ymi=y-i;
+                    if(j > 0) {
+                        set_at(dst, xmj, ypi, pen);
+                        set_at(dst, xmj, ymi, pen);
+                    }
+                    set_at(dst, xpj, ypi, pen);
+                    set_at(dst, xpj, ymi, pen);
+                }
+                oi=i;
+                xmk=x-k;
+                xpk=x+k-1;
+                if (h>0) {
+                    yph=y+h-1;
+                    ymh=y-h;
+                    set_at(dst, xmk, yph, pen);
+                    set_at(dst, xpk, yph, pen);
+                    set_at(dst, xmk, ymh, pen);
+                    set_at(dst, xpk, ymh, pen);
+                }
+                oh=h;
+            }
+            ix = ix + iy / ry;
+            iy = iy - ix / ry;
+        } while(i > h);
+    }
+}
+
+
+
+
+
+
+
+typedef void (*ellipse_span_func)(void *data, int row, int half);
+
+/* Walks the rows of a filled ellipse, calling func with each span of
+   row, relative to the center, covering x-half to x+half-1.  Rows can
+   be visited more than once, the widest span is the right one. */
+static void ellipse_spans(int rx, int ry, ellipse_span_func func, void *data)
+{
+    int ix, iy;
+    int h, i, j, k;
+    int oh, oi, oj, ok;
+
+    /* Init vars */
+    oh = oi = oj = ok = 0xFFFF;
+
+    /* Draw */
+    if (rx >= ry) {
+        ix = 0;
+        iy = rx * 64;
+
+        do {
+            h = (ix + 8) >> 6;
+            i = (iy + 8) >> 6;
+            j = (h * ry) / rx;
+            k = (i * ry) / rx;
+            if ((ok!=k) && (oj!=k) && (k<ry)) {
+                func(data, -k-1, h);
+                func(data, k, h);
+                ok=k;
+            }
+            if ((oj!=j) && (ok!=j) && (k!=j))  {
+                func(data, j, i);
+                func(data, -j-1, i);
+                oj=j;
+            }
+            ix = ix + iy / rx;
+            iy = iy - ix / rx;
+
+        } while (i > h);
+    } else {
+        ix = 0;
+        iy = ry * 64;
+
+        do {
+            h = (ix + 8) >> 6;
+            i = (iy + 8) >> 6;
+            j = (h * rx) / ry;
+            k = (i * rx) / ry;
+
+            if ((oi!=i) && (oh!=i) && (i<ry)) {
+                func(data, i, j);
+                func(data, -i-1, j);
+                oi=i;
+            }
+            if ((oh!=h) && (oi!=h) && (i!=h)) {
+                func(data, h, k);
+                func(data, -h-1, k);
+                oh=h;
+            }
+
+            ix = ix + iy / ry;
+            iy = iy - ix / ry;
+
+        } while(i > h);
+    }
+}
+
+typedef struct {
+    SDL_Surface *dst;
+    int x, y;
+    const draw_pen *pen;
+} ellipse_fill_t;
+
+static void fill_ellipse_span(void *data, int row, int half)
+{
+    ellipse_fill_t *fill = (ellipse_fill_t*)data;
+
+    drawhorzlineclip(fill->dst, fill->pen, fill->x - half, fill->y + row, fill->x + half - 1);
+}
+
+typedef struct {
+    int *half;
+    int ry;
+} ellipse_rows_t;
+
+static void record_ellipse_span(void *data, int row, int half)
+{
+    ellipse_rows_t *rows = (ellipse_rows_t*)data;
+
+    /* a zero half still draws the two center pixels */
+    half = MAX(half, 1);
+    if(row >= -rows->ry && row < rows->ry)
+        rows->half[row + rows->ry] = MAX(rows->half[row + rows->ry], half);
+}
+
+static void draw_fillellipse(SDL_Surface *dst, int x, int y, int rx, int ry, const draw_pen *pen)
+{
+    ellipse_fill_t fill;
+    blend_mask mask;
+
+    if (rx==0 && ry==0) {  /* Special case - draw a single pixel */
+        set_at( dst, x, y, pen);
+        return;
+    }
+    if (rx==0) { /* Special case for rx=0 - draw a vline */
+        drawvertlineclip( dst, pen, x, (Sint16)(y-ry), (Sint16)(y+ry) );
+        return;
     }
-    if(draw) {
-        pts[0] = x1; pts[1] = y1;
-        pts[2] = x2; pts[3] = y2;
+    if (ry==0) { /* Special case for ry=0 - draw a hline */
+        drawhorzlineclip( dst, pen, (Sint16)(x-rx), y, (Sint16)(x+rx) );
+        return;
     }
-    return draw;
-}
-
 
+    /* rows are visited more than once */
+    fill.pen = blend_mask_begin(&mask, dst, pen, x - rx - 1, y - ry - 1, 2 * rx + 2, 2 * ry + 2);
+    fill.dst = dst;
+    fill.x = x;
+    fill.y = y;
+    ellipse_spans(rx, ry, fill_ellipse_span, &fill);
+    blend_mask_end(&mask, pen);
+}
 
-static int set_at(SDL_Surface* surf, int x, int y, Uint32 color)
+/* Draws an outline width pixels thick as the spans of the filled ellipse
+   that are outside the filled ellipse width pixels smaller, instead of
+   width separate outlines, which leave holes between them. */
+static void draw_ellipse_ring(SDL_Surface *dst, int x, int y, int rx, int ry, int width, const draw_pen *pen)
 {
-    SDL_PixelFormat* format = surf->format;
-    Uint8* pixels = (Uint8*)surf->pixels;
-    Uint8* byte_buf, rgb[4];
+    ellipse_rows_t outer, inner;
+    int loop, row, a, b;
 
-    if(x < surf->clip_rect.x || x >= surf->clip_rect.x + surf->clip_rect.w ||
-       y < surf->clip_rect.y || y >= surf->clip_rect.y + surf->clip_rect.h)
-        return 0;
+    outer.ry = ry;
+    inner.ry = ry - width;
+    outer.half = (width > 1) ? (int*)malloc(sizeof(int) * 2 * (outer.ry + inner.ry)) : NULL;
+    if(!outer.half)
+    {
+        for(loop = 0; loop < width; ++loop)
+            draw_ellipse(dst, x, y, rx - loop, ry - loop, pen);
+        return;
+    }
+    inner.half = outer.half + 2 * outer.ry;
+    for(loop = 0; loop < 2 * (outer.ry + inner.ry); ++loop)
+        outer.half[loop] = -1;
+    ellipse_spans(rx, ry, record_ellipse_span, &outer);
+    ellipse_spans(rx - width, inner.ry, record_ellipse_span, &inner);
 
-    switch(format->BytesPerPixel)
+    for(row = -ry; row < ry; ++row)
     {
-    case 1:
-        *((Uint8*)pixels + y * surf->pitch + x) = (Uint8)color;
-        break;
-    case 2:
-        *((Uint16*)(pixels + y * surf->pitch) + x) = (Uint16)color;
-        break;
-    case 4:
-        *((Uint32*)(pixels + y * surf->pitch) + x) = color;
-/*              *((Uint32*)(pixels + y * surf->pitch) + x) =
-                ~(*((Uint32*)(pixels + y * surf->pitch) + x)) * 31;
-*/              break;
-    default:/*case 3:*/
-        SDL_GetRGB(color, format, rgb, rgb+1, rgb+2);
-        byte_buf = (Uint8*)(pixels + y * surf->pitch) + x * 3;
-#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
-        *(byte_buf + (format->Rshift >> 3)) = rgb[0];
-        *(byte_buf + (format->Gshift >> 3)) = rgb[1];
-        *(byte_buf + (format->Bshift >> 3)) = rgb[2];
-#else
-        *(byte_buf + 2 - (format->Rshift >> 3)) = rgb[0];
-        *(byte_buf + 2 - (format->Gshift >> 3)) = rgb[1];
-        *(byte_buf + 2 - (format->Bshift >> 3)) = rgb[2];
-#endif
-        break;
+        a = outer.half[row + ry];
+        b = (row >= -inner.ry && row < inner.ry) ? inner.half[row + inner.ry] : -1;
+        if(a < 0)
+            continue;
+        if(b < 0)
+            drawhorzlineclip(dst, pen, x - a, y + row, x + a - 1);
+        else if(b < a)
+        {
+            drawhorzlineclip(dst, pen, x - a, y + row, x - b - 1);
+            drawhorzlineclip(dst, pen, x + b, y + row, x + a - 1);
+        }
     }
-    return 1;
+    free(outer.half);
+
+    /* the outlines reach a pixel past the fills in places */
+    draw_ellipse(dst, x, y, rx, ry, pen);
+    draw_ellipse(dst, x, y, rx - width + 1, ry - width + 1, pen);
 }
 
+static void draw_ellipse_width(SDL_Surface *dst, int x, int y, int rx, int ry, int width, const draw_pen *pen)
+{
+    blend_mask mask;
+    const draw_pen *ring;
 
-#define DRAWPIX32(pixel,colorptr,br,blend) \
-    if(SDL_BYTEORDER == SDL_BIG_ENDIAN) color <<= 8; \
-    if(blend) { \
-        int x; \
-        float nbr = 1.0-br; \
-        x = colorptr[0]*br+pixel[0]*nbr; \
-        pixel[0]= (x>254) ? 255: x; \
-        x = colorptr[1]*br+pixel[1]*nbr; \
-        pixel[1]= (x>254) ? 255: x; \
-        x = colorptr[2]*br+pixel[2]*nbr; \
-        pixel[2]= (x>254) ? 255: x; \
-        if(hasalpha) pixel[3] = pixel[0]+(br*255) - (pixel[3]*br); \
-    } else { \
-        pixel[0]=(Uint8)(colorptr[0]*br); \
-        pixel[1]=(Uint8)(colorptr[1]*br); \
-        pixel[2]=(Uint8)(colorptr[2]*br); \
-        if(hasalpha) pixel[3] = br*255; \
+    if(width > 1 && (rx - width <= 0 || ry - width <= 0))
+    {
+        draw_fillellipse(dst, x, y, rx, ry, pen);
+        return;
     }
+    ring = blend_mask_begin(&mask, dst, pen, x - rx, y - ry, 2 * rx + 1, 2 * ry + 1);
+    draw_ellipse_ring(dst, x, y, rx, ry, width, ring);
+    blend_mask_end(&mask, pen);
+}
 
-/* Adapted from http://freespace.virgin.net/hugo.elias/graphics/x_wuline.htm */
-static void drawaaline(SDL_Surface* surf, Uint32 color, float x1, float y1, float x2, float y2, int blend) {
-    float grad, xd, yd;
-    float xgap, ygap, xend, yend, xf, yf;
-    float brightness1, brightness2;
-    float swaptmp;
-    int x, y, ix1, ix2, iy1, iy2;
-    int pixx, pixy;
-    Uint8* pixel;
-    Uint8* pm = (Uint8*)surf->pixels;
-    Uint8* colorptr = (Uint8*)&color;
-    const int hasalpha = surf->format->Amask;
 
-    pixx = surf->format->BytesPerPixel;
-    pixy = surf->pitch;
+/* One polygon edge for the scanline fill.  x steps from x1 by adx / dy
+   per scanline; q and r are the whole and remainder parts of the distance
+   stepped so far, so x matches (y-y1) * (x2-x1) / (y2-y1) + x1 exactly. */
+typedef struct {
+    int y1, y2;
+    int x1, sign, adx, dy;
+    int q, r;
+    int x;
+} poly_edge;
 
-    xd = x2-x1;
-    yd = y2-y1;
+static int compare_edge_y(const void *a, const void *b)
+{
+    return ((const poly_edge *)a)->y1 - ((const poly_edge *)b)->y1;
+}
 
-    if (xd == 0 && yd == 0)
+/* Active edge table fill.  Edges are sorted by their top once, become
+   active when the scanline reaches them, step x incrementally and are
+   kept in x order with an insertion sort, which is close to linear as the
+   order rarely changes between scanlines.  Only the scanlines inside the
+   clip rect are visited.  Returns -1 when out of memory. */
+static int draw_fillpoly(SDL_Surface *dst, int *vx, int *vy, int n, const draw_pen *pen)
+{
+    int i, j, y;
+    int miny, maxy, ystart, yend;
+    int nedges, nactive, next;
+    Sint64 num;
+    poly_edge *edges, *e, **active;
+
+    /* Determine Y maxima */
+    miny = vy[0];
+    maxy = vy[0];
+    for (i=1; (i < n); i++)
     {
-        /* Single point. Due to the nature of the aaline clipping, this
-         * is less exact than the normal line. */
-        set_at (surf, x1, y1, color);
-        return;
+        miny = MIN(miny, vy[i]);
+        maxy = MAX(maxy, vy[i]);
     }
 
-    if(fabs(xd)>fabs(yd)) {
-        if(x1>x2) {
-            swaptmp=x1; x1=x2; x2=swaptmp;
-            swaptmp=y1; y1=y2; y2=swaptmp;
-            xd = (x2-x1);
-            yd = (y2-y1);
+    if (miny == maxy) {
+        /* Special case: polygon only 1 pixel high. */
+        int minx, maxx;
+
+        /* Determine X bounds */
+        minx = vx[0];
+        maxx = vx[0];
+        for (i=1; (i < n); i++) {
+            minx = MIN(minx, vx[i]);
+            maxx = MAX(maxx, vx[i]);
         }
-        grad = yd/xd;
-        xend = trunc(x1)+0.5; /* This makes more sense than trunc(x1+0.5) */
-        yend = y1+grad*(xend-x1);
-        xgap = INVFRAC(x1);
-        ix1 = (int)xend;
-        iy1 = (int)yend;
-        yf = yend+grad;
-        brightness1 = INVFRAC(yend) * xgap;
-        brightness2 =    FRAC(yend) * xgap;
-        pixel = pm + pixx * ix1 + pixy * iy1;
-        DRAWPIX32(pixel, colorptr, brightness1, blend)
-            pixel += pixy;
-        DRAWPIX32(pixel, colorptr, brightness2, blend)
-            xend = trunc(x2)+0.5;
-        yend = y2+grad*(xend-x2);
-        xgap =    FRAC(x2); /* this also differs from Hugo's description. */
-        ix2 = (int)xend;
-        iy2 = (int)yend;
-        brightness1 = INVFRAC(yend) * xgap;
-        brightness2 =    FRAC(yend) * xgap;
-        pixel = pm + pixx * ix2 + pixy * iy2;
-        DRAWPIX32(pixel, colorptr, brightness1, blend)
-            pixel += pixy;
-        DRAWPIX32(pixel, colorptr, brightness2, blend)
-            for(x=ix1+1; x<ix2; ++x) {
-                brightness1=INVFRAC(yf);
-                brightness2=   FRAC(yf);
-                pixel = pm + pixx * x + pixy * (int)yf;
-                DRAWPIX32(pixel, colorptr, brightness1, blend)
-                    pixel += pixy;
-                DRAWPIX32(pixel, colorptr, brightness2, blend)
-                    yf += grad;
-            }
+
+        /* Just a line from minimum to maximum X */
+        drawhorzlineclip(dst, pen, minx, miny, maxx);
+        return 0;
     }
-    else {
-        if(y1>y2) {
-            swaptmp=y1; y1=y2; y2=swaptmp;
-            swaptmp=x1; x1=x2; x2=swaptmp;
-            yd = (y2-y1);
-            xd = (x2-x1);
+
+    ystart = MAX(miny, dst->clip_rect.y);
+    yend = MIN(maxy, dst->clip_rect.y + dst->clip_rect.h - 1);
+    if (ystart > yend)
+        return 0;
+
+    edges = (poly_edge *)malloc(sizeof(poly_edge) * n);
+    active = (poly_edge **)malloc(sizeof(poly_edge *) * n);
+    if (!edges || !active) {
+        free(edges);
+        free(active);
+        return -1;
+    }
+
+    /* Build the edge table, horizontal edges never cross a scanline. */
+    nedges = 0;
+    for (i=0; (i < n); i++) {
+        j = i ? i - 1 : n - 1;
+        if (vy[i] == vy[j])
+            continue;
+        e = &edges[nedges++];
+        if (vy[j] < vy[i]) {
+            e->y1 = vy[j]; e->x1 = vx[j];
+            e->y2 = vy[i]; e->adx = vx[i] - vx[j];
+        } else {
+            e->y1 = vy[i]; e->x1 = vx[i];
+            e->y2 = vy[j]; e->adx = vx[j] - vx[i];
         }
-        grad = xd/yd;
-        yend = trunc(y1)+0.5;  /* This makes more sense than trunc(x1+0.5) */
-        xend = x1+grad*(yend-y1);
-        ygap = INVFRAC(y1);
-        iy1 = (int)yend;
-        ix1 = (int)xend;
-        xf = xend+grad;
-        brightness1 = INVFRAC(xend) * ygap;
-        brightness2 =    FRAC(xend) * ygap;
-        pixel = pm + pixx * ix1 + pixy * iy1;
-        DRAWPIX32(pixel, colorptr, brightness1, blend)
-            pixel += pixx;
-        DRAWPIX32(pixel, colorptr, brightness2, blend)
-            yend = trunc(y2)+0.5;
-        xend = x2+grad*(yend-y2);
-        ygap = FRAC(y2);
-        iy2 = (int)yend;
-        ix2 = (int)xend;
-        brightness1 = INVFRAC(xend) * ygap;
-        brightness2 =    FRAC(xend) * ygap;
-        pixel = pm + pixx * ix2 + pixy * iy2;
-        DRAWPIX32(pixel, colorptr, brightness1, blend)
-            pixel += pixx;
-        DRAWPIX32(pixel, colorptr, brightness2, blend)
-            for(y=iy1+1; y<iy2; ++y) {
-                brightness1=INVFRAC(xf);
-                brightness2=   FRAC(xf);
-                pixel = pm + pixx * (int)xf + pixy * y;
-                DRAWPIX32(pixel, colorptr, brightness1, blend)
-                    pixel += pixx;
-                DRAWPIX32(pixel, colorptr, brightness2, blend)
-                    xf += grad;
+        e->sign = (e->adx < 0) ? -1 : 1;
+        e->adx *= e->sign;
+        e->dy = e->y2 - e->y1;
+    }
+    qsort(edges, nedges, sizeof(poly_edge), compare_edge_y);
+
+    nactive = 0;
+    next = 0;
+    for (y=ystart; (y <= yend); y++) {
+        /* An edge covers y1 <= y < y2, and the last scanline also takes
+           the edges ending on it. */
+        for (i=0, j=0; (i < nactive); i++) {
+            e = active[i];
+            if (y < e->y2 || (y == maxy && y == e->y2))
+                active[j++] = e;
+        }
+        nactive = j;
+
+        for (; (next < nedges) && (edges[next].y1 <= y); next++) {
+            e = &edges[next];
+            if (y > e->y2 || (y == e->y2 && y != maxy))
+                continue;
+            num = (Sint64)(y - e->y1) * e->adx;
+            e->q = (int)(num / e->dy);
+            e->r = (int)(num % e->dy);
+            e->x = e->x1 + e->sign * e->q;
+
+            /* insert keeping x order */
+            for (j=nactive; (j > 0) && (active[j-1]->x > e->x); j--)
+                active[j] = active[j-1];
+            active[j] = e;
+            nactive++;
+        }
+
+        for (i=1; (i < nactive); i++) {
+            e = active[i];
+            for (j=i; (j > 0) && (active[j-1]->x > e->x); j--)
+                active[j] = active[j-1];
+            active[j] = e;
+        }
+
+        for (i=0; (i+1 < nactive); i+=2) {
+            drawhorzlineclip(dst, pen, active[i]->x, y, active[i+1]->x);
+        }
+
+        for (i=0; (i < nactive); i++) {
+            e = active[i];
+            e->q += e->adx / e->dy;
+            e->r += e->adx % e->dy;
+            if (e->r >= e->dy) {
+                e->q++;
+                e->r -= e->dy;
             }
+            e->x = e->x1 + e->sign * e->q;
+        }
     }
+
+    free(edges);
+    free(active);
+    return 0;
 }
 
+typedef struct {
+    SDL_Surface *surf;
+    const draw_pen *pen;
+    Uint32 color;   /* the pen's color, laid out as the pixel's bytes */
+} aa_fill;
 
-/*here's my sdl'ized version of bresenham*/
-static void drawline(SDL_Surface* surf, Uint32 color, int x1, int y1, int x2, int y2)
+/* Fully covered runs go through the pen's span writer, the other pixels
+   mix in the color, or what the pen's blend mode makes of the pixel, by
+   their coverage. */
+static void aa_fill_span(void *data, int x, int y, int count, const Uint8 *cover)
 {
-    int deltax, deltay, signx, signy;
-    int pixx, pixy;
-    int x = 0, y = 0;
-    int swaptmp;
-    Uint8 *pixel;
-    Uint8 *colorptr;
-
-    deltax = x2 - x1;
-    deltay = y2 - y1;
-    signx = (deltax < 0) ? -1 : 1;
-    signy = (deltay < 0) ? -1 : 1;
-    deltax = signx * deltax + 1;
-    deltay = signy * deltay + 1;
+    aa_fill *fill = (aa_fill *)data;
+    const draw_pen *pen = fill->pen;
+    const int bpp = fill->surf->format->BytesPerPixel;
+    Uint8 *pixel = PIXEL_AT(fill->surf, x, y);
+    const Uint8 *colorptr = (const Uint8 *)&fill->color;
+    Uint8 blended[4];
+    int i, run, alpha;
+
+    while (count > 0) {
+        for (run = 0; (run < count) && (cover[run] == 255); run++)
+            ;
+        if (run) {
+            pen->span(pixel, run, pen);
+            pixel += run * bpp;
+            cover += run;
+            count -= run;
+            continue;
+        }
+        alpha = *cover;
+        if (alpha) {
+            if (pen->blend) {
+                memcpy(blended, pixel, bpp);
+                blend_pixel(blended, pen);
+                colorptr = blended;
+            }
+            for (i=0; (i < bpp); i++)
+                pixel[i] = (Uint8)((colorptr[i] * alpha + pixel[i] * (255 - alpha) + 127) / 255);
+        }
+        pixel += bpp;
+        cover++;
+        count--;
+    }
+}
 
-    pixx = surf->format->BytesPerPixel;
-    pixy = surf->pitch;
-    pixel = ((Uint8*)surf->pixels) + pixx * x1 + pixy * y1;
+/* Fills the shapes added to raster into the 24 or 32 bit surface and
+   frees the raster.  Returns -1 when out of memory. */
+static int aa_fill_raster(SDL_Surface *dst, pg_raster *raster, int evenodd, const draw_pen *pen)
+{
+    aa_fill fill;
+    int result;
+
+    fill.surf = dst;
+    fill.pen = pen;
+    fill.color = pen->color;
+    if (SDL_BYTEORDER == SDL_BIG_ENDIAN && dst->format->BytesPerPixel == 3)
+        fill.color <<= 8;
+
+    result = pg_raster_fill(raster, evenodd, aa_fill_span, &fill);
+    pg_raster_free(raster);
+    return result;
+}
 
-    pixx *= signx;
-    pixy *= signy;
-    if(deltax < deltay) /*swap axis if rise > run*/
-    {
-        swaptmp = deltax; deltax = deltay; deltay = swaptmp;
-        swaptmp = pixx; pixx = pixy; pixy = swaptmp;
-    }
+/* Antialiased polygon fill.  Each pixel is the unit square around its
+   integer coordinate, and gets the exact part of it inside the polygon,
+   even-odd filled.  Returns -1 when out of memory. */
+static int draw_aapoly(SDL_Surface *dst, float *vx, float *vy, int n, const draw_pen *pen)
+{
+    pg_raster raster;
+    int i;
 
-    switch(surf->format->BytesPerPixel)
-    {
-    case 1:
-        for(; x < deltax; x++, pixel += pixx) {
-            *pixel = (Uint8)color;
-            y += deltay; if(y >= deltax) {y -= deltax; pixel += pixy;}
-        }break;
-    case 2:
-        for(; x < deltax; x++, pixel += pixx) {
-            *(Uint16*)pixel = (Uint16)color;
-            y += deltay; if(y >= deltax) {y -= deltax; pixel += pixy;}
-        }break;
-    case 3:
-        if(SDL_BYTEORDER == SDL_BIG_ENDIAN) color <<= 8;
-        colorptr = (Uint8*)&color;
-        for(; x < deltax; x++, pixel += pixx) {
-            pixel[0] = colorptr[0];
-            pixel[1] = colorptr[1];
-            pixel[2] = colorptr[2];
-            y += deltay; if(y >= deltax) {y -= deltax; pixel += pixy;}
-        }break;
-    default: /*case 4*/
-        for(; x < deltax; x++, pixel += pixx) {
-            *(Uint32*)pixel = (Uint32)color;
-            y += deltay; if(y >= deltax) {y -= deltax; pixel += pixy;}
-        }break;
-    }
+    pg_raster_init(&raster, &dst->clip_rect);
+    pg_raster_move_to(&raster, vx[0] + 0.5f, vy[0] + 0.5f);
+    for (i=1; (i < n); i++)
+        pg_raster_line_to(&raster, vx[i] + 0.5f, vy[i] + 0.5f);
+    return aa_fill_raster(dst, &raster, 1, pen);
 }
 
 
 
-static void drawhorzline(SDL_Surface* surf, Uint32 color, int x1, int y1, int x2)
+/* Vector paths.  A Path keeps its outlines flattened into points, curves
+   being split up as they are added, and keeps the coverage runs of its
+   last fill and stroke.  Drawing it again with the same settings only
+   blits those runs, at any whole pixel offset. */
+
+#define JOIN_MITER 0
+#define JOIN_ROUND 1
+#define JOIN_BEVEL 2
+
+#define CAP_BUTT   0
+#define CAP_ROUND  1
+#define CAP_SQUARE 2
+
+/* Longest miter before the join is beveled instead, as the distance from
+   the point to the tip in half line widths.  This is the SVG miter limit,
+   which measures the miter from the inner corner, over a whole width. */
+#define PATH_MITER_LIMIT 4.0
+
+/* Most segments a single curve is split into. */
+#define PATH_MAX_CURVE_STEPS 1024
+
+/* A run of pixels with the same coverage, in path coordinates. */
+typedef struct {
+    Sint32 x, y, len;
+    Uint8 cover;
+} path_run;
+
+typedef struct {
+    path_run *runs;
+    int nruns, maxruns;
+    int valid, error;
+    int left, top, right, bottom;  /* bounds of the runs, exclusive */
+} path_spans;
+
+typedef struct {
+    PyObject_HEAD
+    float *pts;              /* flattened points, x and y interleaved */
+    int npts, maxpts;
+    int *starts;             /* first point of each outline */
+    Uint8 *closed;           /* and if it is closed */
+    int nsubs, maxsubs;
+    int open;                /* the last outline takes more points */
+    float penx, peny;        /* the current point */
+    double tolerance;
+    path_spans fill;
+    path_spans stroke;
+    float width;             /* what the stroke runs were made with */
+    int join, cap;
+} PyPathObject;
+
+static PyTypeObject PyPath_Type;
+
+static void path_spans_clear(path_spans *spans)
 {
-    Uint8 *pixel, *end;
-    Uint8 *colorptr;
+    free(spans->runs);
+    spans->runs = NULL;
+    spans->nruns = spans->maxruns = 0;
+    spans->valid = spans->error = 0;
+}
 
-    if(x1 == x2)
-    {
-        set_at(surf, x1, y1, color);
-        return;
-    }
+/* Any change to the outlines makes the cached runs stale. */
+static void path_changed(PyPathObject *self)
+{
+    path_spans_clear(&self->fill);
+    path_spans_clear(&self->stroke);
+}
 
-    pixel = ((Uint8*)surf->pixels) + surf->pitch * y1;
-    if(x1 < x2)
-    {
-        end = pixel + x2 * surf->format->BytesPerPixel;
-        pixel += x1 * surf->format->BytesPerPixel;
-    }
-    else
-    {
-        end = pixel + x1 * surf->format->BytesPerPixel;
-        pixel += x2 * surf->format->BytesPerPixel;
-    }
-    switch(surf->format->BytesPerPixel)
+static int path_add_point(PyPathObject *self, float x, float y)
+{
+    float *pts;
+    int size;
+
+    self->penx = x;
+    self->peny = y;
+    if(self->npts > self->starts[self->nsubs - 1] &&
+       self->pts[self->npts * 2 - 2] == x && self->pts[self->npts * 2 - 1] == y)
+        return 0;
+    if(self->npts == self->maxpts)
     {
-    case 1:
-        for(; pixel <= end; ++pixel) {
-            *pixel = (Uint8)color;
-        }break;
-    case 2:
-        for(; pixel <= end; pixel+=2) {
-            *(Uint16*)pixel = (Uint16)color;
-        }break;
-    case 3:
-        if(SDL_BYTEORDER == SDL_BIG_ENDIAN) color <<= 8;
-        colorptr = (Uint8*)&color;
-        for(; pixel <= end; pixel+=3) {
-            pixel[0] = colorptr[0];
-            pixel[1] = colorptr[1];
-            pixel[2] = colorptr[2];
-        }break;
-    default: /*case 4*/
-        for(; pixel <= end; pixel+=4) {
-            *(Uint32*)pixel = color;
-          }break;
+        size = self->maxpts ? self->maxpts * 2 : 64;
+        pts = (float *)realloc(self->pts, size * 2 * sizeof(float));
+        if(!pts)
+        {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->pts = pts;
+        self->maxpts = size;
     }
+    self->pts[self->npts * 2] = x;
+    self->pts[self->npts * 2 + 1] = y;
+    self->npts++;
+    return 0;
 }
 
-static void drawhorzlineclip(SDL_Surface* surf, Uint32 color, int x1, int y1, int x2)
+/* Starts a new outline at (x, y). */
+static int path_begin(PyPathObject *self, float x, float y)
 {
-    if(y1 < surf->clip_rect.y || y1 >= surf->clip_rect.y + surf->clip_rect.h)
-        return;
+    int *starts, size;
+    Uint8 *closed;
 
-    if( x2 < x1 )
+    /* an outline of one point draws nothing, so it is reused */
+    if(self->nsubs && self->npts - self->starts[self->nsubs - 1] < 2)
+        self->npts = self->starts[--self->nsubs];
+    if(self->nsubs == self->maxsubs)
     {
-        int temp = x1;
-        x1 = x2; x2 = temp;
+        size = self->maxsubs ? self->maxsubs * 2 : 8;
+        starts = (int *)realloc(self->starts, size * sizeof(int));
+        if(!starts)
+        {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->starts = starts;
+        closed = (Uint8 *)realloc(self->closed, size);
+        if(!closed)
+        {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->closed = closed;
+        self->maxsubs = size;
     }
+    self->starts[self->nsubs] = self->npts;
+    self->closed[self->nsubs] = 0;
+    self->nsubs++;
+    self->open = 1;
+    return path_add_point(self, x, y);
+}
 
-    x1 = MAX(x1, surf->clip_rect.x);
-    x2 = MIN(x2, surf->clip_rect.x + surf->clip_rect.w-1);
+/* Makes sure there is an outline to add to.  After close() the next one
+   starts where the closed one did. */
+static int path_continue(PyPathObject *self)
+{
+    if(self->open)
+        return 0;
+    return path_begin(self, self->penx, self->peny);
+}
 
-        if(x2 < surf->clip_rect.x || x1 >= surf->clip_rect.x + surf->clip_rect.w)
-                return;
+/* Segments needed to keep a curve within the tolerance, from the largest
+   second difference of its control points (Wang's formula). */
+static int path_curve_steps(double dd, int degree, double tolerance)
+{
+    double n = sqrt(degree * (degree - 1) * dd / (8 * tolerance));
 
-    if(x1 == x2)
-        set_at(surf, x1, y1, color);
-    else
-        drawhorzline(surf, color, x1, y1, x2);
+    if(n < 1)
+        return 1;
+    if(n > PATH_MAX_CURVE_STEPS)
+        return PATH_MAX_CURVE_STEPS;
+    return (int)ceil(n);
 }
 
-static void drawvertline(SDL_Surface* surf, Uint32 color, int x1, int y1, int y2)
+static PyObject* path_move_to(PyObject* self, PyObject* arg)
 {
-    Uint8   *pixel, *end;
-    Uint8   *colorptr;
-    Uint32  pitch = surf->pitch;
+    PyPathObject *path = (PyPathObject *)self;
+    float x, y;
 
-    if(y1 == y2)
-    {
-        set_at(surf, x1, y1, color);
-        return;
-    }
+    if(!PyArg_ParseTuple(arg, "ff", &x, &y))
+        return NULL;
+    path_changed(path);
+    if(path_begin(path, x, y))
+        return NULL;
+    Py_RETURN_NONE;
+}
 
-    pixel = ((Uint8*)surf->pixels) + x1 * surf->format->BytesPerPixel;
-    if(y1 < y2)
-    {
-        end      = pixel + surf->pitch * y2;
-        pixel += surf->pitch * y1;
-    }
-    else
-    {
-        end      = pixel + surf->pitch * y1;
-        pixel += surf->pitch * y2;
-    }
+static PyObject* path_line_to(PyObject* self, PyObject* arg)
+{
+    PyPathObject *path = (PyPathObject *)self;
+    float x, y;
 
-    switch(surf->format->BytesPerPixel)
+    if(!PyArg_ParseTuple(arg, "ff", &x, &y))
+        return NULL;
+    path_changed(path);
+    if(!path->nsubs)
     {
-    case 1:
-        for(; pixel <= end; pixel+=pitch) {
-            *pixel = (Uint8)color;
-        }break;
-    case 2:
-        for(; pixel <= end; pixel+=pitch) {
-            *(Uint16*)pixel = (Uint16)color;
-        }break;
-    case 3:
-        if(SDL_BYTEORDER == SDL_BIG_ENDIAN) color <<= 8;
-        colorptr = (Uint8*)&color;
-        for(; pixel <= end; pixel+=pitch) {
-            pixel[0] = colorptr[0];
-            pixel[1] = colorptr[1];
-            pixel[2] = colorptr[2];
-        }break;
-    default: /*case 4*/
-        for(; pixel <= end; pixel+=pitch) {
-            *(Uint32*)pixel = color;
-        }break;
+        /* with no current point this only moves there */
+        if(path_begin(path, x, y))
+            return NULL;
+        Py_RETURN_NONE;
     }
+    if(path_continue(path) || path_add_point(path, x, y))
+        return NULL;
+    Py_RETURN_NONE;
 }
 
-
-static void drawvertlineclip(SDL_Surface* surf, Uint32 color, int x1, int y1, int y2)
+static PyObject* path_quad_to(PyObject* self, PyObject* arg)
 {
-    if(x1 < surf->clip_rect.x || x1 >= surf->clip_rect.x + surf->clip_rect.w)
-        return;
-    if ( y2 < y1 )
+    PyPathObject *path = (PyPathObject *)self;
+    float cx, cy, x, y;
+    double x0, y0, ddx, ddy, t, u;
+    int i, n;
+
+    if(!PyArg_ParseTuple(arg, "ffff", &cx, &cy, &x, &y))
+        return NULL;
+    path_changed(path);
+    if(!path->nsubs && path_begin(path, cx, cy))
+        return NULL;
+    if(path_continue(path))
+        return NULL;
+
+    x0 = path->penx;
+    y0 = path->peny;
+    ddx = x0 - 2 * cx + x;
+    ddy = y0 - 2 * cy + y;
+    n = path_curve_steps(sqrt(ddx * ddx + ddy * ddy), 2, path->tolerance);
+    for(i = 1; i <= n; i++)
     {
-        int temp = y1;
-        y1 = y2; y2 = temp;
+        t = (double)i / n;
+        u = 1 - t;
+        if(path_add_point(path, (float)(u * u * x0 + 2 * u * t * cx + t * t * x),
+                          (float)(u * u * y0 + 2 * u * t * cy + t * t * y)))
+            return NULL;
     }
-    y1 = MAX(y1, surf->clip_rect.y);
-    y2 = MIN(y2, surf->clip_rect.y + surf->clip_rect.h-1);
-    if(y2 - y1 < 1)
-        set_at( surf, x1, y1, color);
-    else
-        drawvertline(surf, color, x1, y1, y2);
+    Py_RETURN_NONE;
 }
 
-static void draw_arc(SDL_Surface *dst, int x, int y, int radius1, int radius2,
-                     double angle_start, double angle_stop, Uint32 color)
+static PyObject* path_cubic_to(PyObject* self, PyObject* arg)
 {
-    double aStep;            // Angle Step (rad)
-    double a;                // Current Angle (rad)
-    int x_last, x_next, y_last, y_next;
-
-    // Angle step in rad
-    if (radius1<radius2) {
-        if (radius1<1.0e-4) {
-            aStep=1.0;
-        } else {
-            aStep=asin(2.0/radius1);
-        }
-    } else {
-        if (radius2<1.0e-4) {
-            aStep=1.0;
-        } else {
-            aStep=asin(2.0/radius2);
-        }
-    }
+    PyPathObject *path = (PyPathObject *)self;
+    float c1x, c1y, c2x, c2y, x, y;
+    double x0, y0, ddx, ddy, dd, t, u;
+    int i, n;
 
-    if(aStep<0.05) {
-        aStep = 0.05;
-    }
-
-    x_last = x+cos(angle_start)*radius1;
-    y_last = y-sin(angle_start)*radius2;
-    for(a=angle_start+aStep; a<=angle_stop; a+=aStep) {
-        int points[4];
-        x_next = x+cos(a)*radius1;
-        y_next = y-sin(a)*radius2;
-        points[0] = x_last; points[1] = y_last;
-        points[2] = x_next; points[3] = y_next;
-        clip_and_draw_line(dst, &dst->clip_rect, color, points);
-        x_last = x_next;
-        y_last = y_next;
+    if(!PyArg_ParseTuple(arg, "ffffff", &c1x, &c1y, &c2x, &c2y, &x, &y))
+        return NULL;
+    path_changed(path);
+    if(!path->nsubs && path_begin(path, c1x, c1y))
+        return NULL;
+    if(path_continue(path))
+        return NULL;
+
+    x0 = path->penx;
+    y0 = path->peny;
+    ddx = x0 - 2 * c1x + c2x;
+    ddy = y0 - 2 * c1y + c2y;
+    dd = sqrt(ddx * ddx + ddy * ddy);
+    ddx = c1x - 2 * c2x + x;
+    ddy = c1y - 2 * c2y + y;
+    dd = MAX(dd, sqrt(ddx * ddx + ddy * ddy));
+    n = path_curve_steps(dd, 3, path->tolerance);
+    for(i = 1; i <= n; i++)
+    {
+        t = (double)i / n;
+        u = 1 - t;
+        if(path_add_point(path,
+               (float)(u * u * u * x0 + 3 * u * t * (u * c1x + t * c2x) + t * t * t * x),
+               (float)(u * u * u * y0 + 3 * u * t * (u * c1y + t * c2y) + t * t * t * y)))
+            return NULL;
     }
+    Py_RETURN_NONE;
 }
 
-static void draw_ellipse(SDL_Surface *dst, int x, int y, int rx, int ry, Uint32 color)
+static PyObject* path_close(PyObject* self, PyObject* arg)
 {
-    int ix, iy;
-    int h, i, j, k;
-    int oh, oi, oj, ok;
-    int xmh, xph, ypk, ymk;
-    int xmi, xpi, ymj, ypj;
-    int xmj, xpj, ymi, ypi;
-    int xmk, xpk, ymh, yph;
+    PyPathObject *path = (PyPathObject *)self;
+    int start;
 
-    if (rx==0 && ry==0) {  /* Special case - draw a single pixel */
-        set_at( dst, x, y, color);
-        return;
-    }
-    if (rx==0) { /* Special case for rx=0 - draw a vline */
-        drawvertlineclip( dst, color, x, (Sint16)(y-ry), (Sint16)(y+ry) );
-        return;
-    }
-    if (ry==0) { /* Special case for ry=0 - draw a hline */
-        drawhorzlineclip( dst, color, (Sint16)(x-rx), y, (Sint16)(x+rx) );
-        return;
+    if(path->open)
+    {
+        path_changed(path);
+        start = path->starts[path->nsubs - 1];
+        path->closed[path->nsubs - 1] = 1;
+        path->penx = path->pts[start * 2];
+        path->peny = path->pts[start * 2 + 1];
+        path->open = 0;
     }
+    Py_RETURN_NONE;
+}
 
+static PyObject* path_clear(PyObject* self, PyObject* arg)
+{
+    PyPathObject *path = (PyPathObject *)self;
 
-    /* Init vars */
-    oh = oi = oj = ok = 0xFFFF;
-    if (rx > ry) {
-        ix = 0;
-        iy = rx * 64;
-        do {
-            h = (ix + 16) >> 6;
-            i = (iy + 16) >> 6;
-            j = (h * ry) / rx;
-            k = (i * ry) / rx;
-
-            if (((ok!=k) && (oj!=k)) || ((oj!=j) && (ok!=j)) || (k!=j)) {
-                xph=x+h-1;
-                xmh=x-h;
-                if (k>0) {
-                    ypk=y+k-1;
-                    ymk=y-k;
-                    if(h > 0) {
-                        set_at(dst, xmh, ypk, color);
-                        set_at(dst, xmh, ymk, color);
-                    }
-                    set_at(dst, xph, ypk, color);
-                    set_at(dst, xph, ymk, color);
-                }
-                ok=k;
-                xpi=x+i-1;
-                xmi=x-i;
-                if (j>0) {
-                    ypj=y+j-1;
-                    ymj=y-j;
-                    set_at(dst, xmi, ypj, color);
-                    set_at(dst, xpi, ypj, color);
-                    set_at(dst, xmi, ymj, color);
-                    set_at(dst, xpi, ymj, color);
-                }
-                oj=j;
-            }
-            ix = ix + iy / rx;
-            iy = iy - ix / rx;
+    path_changed(path);
+    path->npts = path->nsubs = 0;
+    path->open = 0;
+    path->penx = path->peny = 0;
+    Py_RETURN_NONE;
+}
 
-        } while (i > h);
-    } else {
-        ix = 0;
-        iy = ry * 64;
-        do {
-            h = (ix + 32) >> 6;
-            i = (iy + 32) >> 6;
-            j = (h * rx) / ry;
-            k = (i * rx) / ry;
+/* Collects the rasterized coverage as runs of equal value. */
+static void path_collect_span(void *data, int x, int y, int count, const Uint8 *cover)
+{
+    path_spans *spans = (path_spans *)data;
+    path_run *run;
+    int i, len, size;
 
-            if (((oi!=i) && (oh!=i)) || ((oh!=h) && (oi!=h) && (i!=h))) {
-                xmj=x-j;
-                xpj=x+j-1;
-                if (i>0) {
-                    ypi=y+i-1;
-                    ymi=y-i;
-                    if(j > 0) {
-                        set_at(dst, xmj, ypi, color);
-                        set_at(dst, xmj, ymi, color);
-                    }
-                    set_at(dst, xpj, ypi, color);
-                    set_at(dst, xpj, ymi, color);
-                }
-                oi=i;
-                xmk=x-k;
-                xpk=x+k-1;
-                if (h>0) {
-                    yph=y+h-1;
-                    ymh=y-h;
-                    set_at(dst, xmk, yph, color);
-                    set_at(dst, xpk, yph, color);
-                    set_at(dst, xmk, ymh, color);
-                    set_at(dst, xpk, ymh, color);
-                }
-                oh=h;
+    for(i = 0; (i < count); i += len)
+    {
+        for(len = 1; (i + len < count) && (cover[i + len] == cover[i]); len++)
+            ;
+        if(!cover[i])
+            continue;
+        if(spans->nruns == spans->maxruns)
+        {
+            size = spans->maxruns ? spans->maxruns * 2 : 256;
+            run = (path_run *)realloc(spans->runs, size * sizeof(path_run));
+            if(!run)
+            {
+                spans->error = 1;
+                return;
             }
-            ix = ix + iy / ry;
-            iy = iy - ix / ry;
-        } while(i > h);
+            spans->runs = run;
+            spans->maxruns = size;
+        }
+        run = &spans->runs[spans->nruns++];
+        run->x = x + i;
+        run->y = y;
+        run->len = len;
+        run->cover = cover[i];
+        spans->left = MIN(spans->left, x + i);
+        spans->right = MAX(spans->right, x + i + len);
+        spans->top = MIN(spans->top, y);
+        spans->bottom = MAX(spans->bottom, y + 1);
     }
 }
 
+/* Rasterizes into spans everything added to raster, which was set up
+   with path_raster_init.  Returns -1 with an exception set on failure. */
+static int path_rasterize(path_spans *spans, pg_raster *raster, int evenodd)
+{
+    int result;
+
+    path_spans_clear(spans);
+    spans->left = spans->top = INT_MAX;
+    spans->right = spans->bottom = INT_MIN;
+    result = pg_raster_fill(raster, evenodd, path_collect_span, spans);
+    pg_raster_free(raster);
+    if(result || spans->error)
+    {
+        path_spans_clear(spans);
+        PyErr_NoMemory();
+        return -1;
+    }
+    spans->valid = 1;
+    return 0;
+}
 
+/* Sets up raster to cover the points, grown by margin on every side.
+   Pixels are squares around their coordinates, as in aapolygon. */
+static void path_raster_init(pg_raster *raster, PyPathObject *self, float margin)
+{
+    float minx = 0, miny = 0, maxx = 0, maxy = 0;
+    SDL_Rect area;
+    int i;
 
+    for(i = 0; (i < self->npts); i++)
+    {
+        if(!i || self->pts[i * 2] < minx)
+            minx = self->pts[i * 2];
+        if(!i || self->pts[i * 2] > maxx)
+            maxx = self->pts[i * 2];
+        if(!i || self->pts[i * 2 + 1] < miny)
+            miny = self->pts[i * 2 + 1];
+        if(!i || self->pts[i * 2 + 1] > maxy)
+            maxy = self->pts[i * 2 + 1];
+    }
+    /* kept to what an SDL_Rect holds, surfaces are no bigger */
+    minx = MAX(minx - margin, -16384);
+    miny = MAX(miny - margin, -16384);
+    maxx = MIN(maxx + margin, 16383);
+    maxy = MIN(maxy + margin, 16383);
+    area.x = (Sint16)floor(minx);
+    area.y = (Sint16)floor(miny);
+    area.w = (Uint16)MAX(ceil(maxx) - area.x + 1, 0);
+    area.h = (Uint16)MAX(ceil(maxy) - area.y + 1, 0);
+    pg_raster_init(raster, &area);
+}
 
+/* Adds the closed polygon of n points the same way around as every other
+   stroke piece, so that where they overlap their windings add up. */
+static void path_add_piece(pg_raster *raster, const float *pts, int n)
+{
+    float area = 0;
+    int i, j;
 
+    for(i = 0, j = n - 1; (i < n); j = i++)
+        area += pts[j * 2] * pts[i * 2 + 1] - pts[i * 2] * pts[j * 2 + 1];
+    if(area > 0)
+    {
+        pg_raster_move_to(raster, pts[0] + 0.5f, pts[1] + 0.5f);
+        for(i = 1; (i < n); i++)
+            pg_raster_line_to(raster, pts[i * 2] + 0.5f, pts[i * 2 + 1] + 0.5f);
+    }
+    else if(area < 0)
+    {
+        pg_raster_move_to(raster, pts[(n - 1) * 2] + 0.5f, pts[(n - 1) * 2 + 1] + 0.5f);
+        for(i = n - 2; (i >= 0); i--)
+            pg_raster_line_to(raster, pts[i * 2] + 0.5f, pts[i * 2 + 1] + 0.5f);
+    }
+}
 
+/* The pie slice around (x, y) from angle a0 to a0 + sweep, which must
+   be positive, so that it goes the same way around as the other pieces. */
+static void path_add_sector(pg_raster *raster, float x, float y, float radius,
+                            double a0, double sweep)
+{
+    x += 0.5f;
+    y += 0.5f;
+    pg_raster_move_to(raster, x, y);
+    pg_raster_line_to(raster, (float)(x + radius * cos(a0)), (float)(y + radius * sin(a0)));
+    pg_raster_arc_to(raster, x, y, radius, radius, a0, a0 + sweep);
+}
 
-static void draw_fillellipse(SDL_Surface *dst, int x, int y, int rx, int ry, Uint32 color)
+/* The cap at (x, y) of a line going from it in direction (dx, dy), which
+   is half the line width long.  Like the joins, caps only cover what the
+   line itself does not, as pieces that overlap would add up their
+   coverage along the edge. */
+static void path_add_cap(pg_raster *raster, float x, float y, float dx, float dy, int cap)
 {
-    int ix, iy;
-    int h, i, j, k;
-    int oh, oi, oj, ok;
+    float piece[8];
 
-    if (rx==0 && ry==0) {  /* Special case - draw a single pixel */
-        set_at( dst, x, y, color);
-        return;
+    if(cap == CAP_ROUND)
+    {
+        path_add_sector(raster, x, y, (float)sqrt(dx * dx + dy * dy),
+                        atan2(dx, -dy), M_PI);
     }
-    if (rx==0) { /* Special case for rx=0 - draw a vline */
-        drawvertlineclip( dst, color, x, (Sint16)(y-ry), (Sint16)(y+ry) );
-        return;
+    else if(cap == CAP_SQUARE)
+    {
+        piece[0] = x - dy;
+        piece[1] = y + dx;
+        piece[2] = x - dy - dx;
+        piece[3] = y + dx - dy;
+        piece[4] = x + dy - dx;
+        piece[5] = y - dx - dy;
+        piece[6] = x + dy;
+        piece[7] = y - dx;
+        path_add_piece(raster, piece, 4);
     }
-    if (ry==0) { /* Special case for ry=0 - draw a hline */
-        drawhorzlineclip( dst, color, (Sint16)(x-rx), y, (Sint16)(x+rx) );
+}
+
+/* The join at (x, y) between a line coming in along (dx0, dy0) and one
+   going out along (dx1, dy1), both half the line width long. */
+static void path_add_join(pg_raster *raster, float x, float y, float dx0, float dy0,
+                          float dx1, float dy1, int join)
+{
+    float half = (float)sqrt(dx0 * dx0 + dy0 * dy0);
+    float cross = dx0 * dy1 - dy0 * dx1;
+    float side = cross > 0 ? -1.0f : 1.0f;
+    float nx0 = -dy0 * side, ny0 = dx0 * side;
+    float nx1 = -dy1 * side, ny1 = dx1 * side;
+    float mx, my, len, scale, piece[8];
+    double a0, sweep;
+
+    if(cross == 0 && dx0 * dx1 + dy0 * dy1 > 0)
+        return;
+    if(join == JOIN_ROUND)
+    {
+        /* the outside of the turn, between the ends of the two lines */
+        a0 = atan2(ny0, nx0);
+        sweep = atan2(ny1, nx1) - a0;
+        if(sweep > M_PI)
+            sweep -= 2 * M_PI;
+        else if(sweep < -M_PI)
+            sweep += 2 * M_PI;
+        if(sweep < 0)
+        {
+            a0 += sweep;
+            sweep = -sweep;
+        }
+        path_add_sector(raster, x, y, half, a0, sweep);
         return;
     }
-
-    /* Init vars */
-    oh = oi = oj = ok = 0xFFFF;
-
-    /* Draw */
-    if (rx >= ry) {
-        ix = 0;
-        iy = rx * 64;
-
-        do {
-            h = (ix + 8) >> 6;
-            i = (iy + 8) >> 6;
-            j = (h * ry) / rx;
-            k = (i * ry) / rx;
-            if ((ok!=k) && (oj!=k) && (k<ry)) {
-                drawhorzlineclip(dst, color, x-h, y-k-1, x+h-1);
-                drawhorzlineclip(dst, color, x-h, y+k, x+h-1);
-                ok=k;
-            }
-            if ((oj!=j) && (ok!=j) && (k!=j))  {
-                drawhorzlineclip(dst, color, x-i, y+j, x+i-1);
-                drawhorzlineclip(dst, color, x-i, y-j-1, x+i-1);
-                oj=j;
+    piece[0] = x;
+    piece[1] = y;
+    piece[2] = x + nx0;
+    piece[3] = y + ny0;
+    piece[4] = x + nx1;
+    piece[5] = y + ny1;
+    if(join == JOIN_MITER)
+    {
+        /* the tip is where the two outer edges meet */
+        mx = nx0 + nx1;
+        my = ny0 + ny1;
+        len = (float)sqrt(mx * mx + my * my);
+        if(len > 0)
+        {
+            scale = half * half * len / (mx * nx0 + my * ny0);
+            if(scale <= PATH_MITER_LIMIT * half)
+            {
+                piece[4] = x + mx * scale / len;
+                piece[5] = y + my * scale / len;
+                piece[6] = x + nx1;
+                piece[7] = y + ny1;
+                path_add_piece(raster, piece, 4);
+                return;
             }
-            ix = ix + iy / rx;
-            iy = iy - ix / rx;
-
-        } while (i > h);
-    } else {
-        ix = 0;
-        iy = ry * 64;
+        }
+    }
+    path_add_piece(raster, piece, 3);
+}
 
-        do {
-            h = (ix + 8) >> 6;
-            i = (iy + 8) >> 6;
-            j = (h * rx) / ry;
-            k = (i * rx) / ry;
+/* Adds the outline of each line of the path, width wide, with its joins
+   and caps, as pieces filled by any winding. */
+static void path_add_stroke(pg_raster *raster, PyPathObject *self, float width, int join, int cap)
+{
+    float half = width / 2, piece[8];
+    float *pts, dx, dy, len, pdx = 0, pdy = 0, fdx = 0, fdy = 0;
+    int sub, n, i, closed, count;
 
-            if ((oi!=i) && (oh!=i) && (i<ry)) {
-                drawhorzlineclip(dst, color, x-j, y+i, x+j-1);
-                drawhorzlineclip(dst, color, x-j, y-i-1, x+j-1);
-                oi=i;
-            }
-            if ((oh!=h) && (oi!=h) && (i!=h)) {
-                drawhorzlineclip(dst, color, x-k, y+h, x+k-1);
-                drawhorzlineclip(dst, color, x-k, y-h-1, x+k-1);
-                oh=h;
+    for(sub = 0; (sub < self->nsubs); sub++)
+    {
+        pts = self->pts + self->starts[sub] * 2;
+        n = (sub + 1 < self->nsubs ? self->starts[sub + 1] : self->npts) - self->starts[sub];
+        closed = self->closed[sub];
+        /* the closing point is dropped if it repeats the first */
+        if(closed && n > 1 && pts[0] == pts[n * 2 - 2] && pts[1] == pts[n * 2 - 1])
+            n--;
+        if(n < 2)
+            continue;
+        count = closed ? n : n - 1;
+        for(i = 0; (i < count); i++)
+        {
+            float *p0 = pts + i * 2, *p1 = pts + ((i + 1) % n) * 2;
+
+            dx = p1[0] - p0[0];
+            dy = p1[1] - p0[1];
+            len = (float)sqrt(dx * dx + dy * dy);
+            dx *= half / len;
+            dy *= half / len;
+            piece[0] = p0[0] - dy;
+            piece[1] = p0[1] + dx;
+            piece[2] = p1[0] - dy;
+            piece[3] = p1[1] + dx;
+            piece[4] = p1[0] + dy;
+            piece[5] = p1[1] - dx;
+            piece[6] = p0[0] + dy;
+            piece[7] = p0[1] - dx;
+            path_add_piece(raster, piece, 4);
+            if(i)
+                path_add_join(raster, p0[0], p0[1], pdx, pdy, dx, dy, join);
+            else
+            {
+                fdx = dx;
+                fdy = dy;
             }
+            pdx = dx;
+            pdy = dy;
+        }
+        if(closed)
+            path_add_join(raster, pts[0], pts[1], pdx, pdy, fdx, fdy, join);
+        else
+        {
+            path_add_cap(raster, pts[0], pts[1], fdx, fdy, cap);
+            path_add_cap(raster, pts[(n - 1) * 2], pts[(n - 1) * 2 + 1], -pdx, -pdy, cap);
+        }
+    }
+}
 
-            ix = ix + iy / ry;
-            iy = iy - ix / ry;
+/* Blits the runs into the 24 or 32 bit surf moved by (dx, dy), and
+   returns their bounds there, clipped. */
+static PyObject* path_blit(PyObject *surfobj, const path_spans *spans, const draw_pen *pen,
+                           int dx, int dy)
+{
+    SDL_Surface *surf = PySurface_AsSurface(surfobj);
+    SDL_Rect *clip = &surf->clip_rect;
+    Uint8 cover[64];
+    aa_fill fill;
+    path_run *run;
+    int i, x, y, x0, x1, n, l, t, r, b;
+
+    if(!spans->nruns)
+        return PyRect_New4(dx, dy, 0, 0);
+
+    fill.surf = surf;
+    fill.pen = pen;
+    fill.color = pen->color;
+    if (SDL_BYTEORDER == SDL_BIG_ENDIAN && surf->format->BytesPerPixel == 3)
+        fill.color <<= 8;
 
-        } while(i > h);
+    if(!PySurface_Lock(surfobj))
+        return NULL;
+    for(i = 0; (i < spans->nruns); i++)
+    {
+        run = &spans->runs[i];
+        y = run->y + dy;
+        if(y < clip->y || y >= clip->y + clip->h)
+            continue;
+        x0 = MAX(run->x + dx, clip->x);
+        x1 = MIN(run->x + dx + run->len, clip->x + clip->w);
+        if(x0 >= x1)
+            continue;
+        if(run->cover == 255)
+        {
+            pen->span(PIXEL_AT(surf, x0, y), x1 - x0, pen);
+            continue;
+        }
+        memset(cover, run->cover, sizeof(cover));
+        for(x = x0; (x < x1); x += n)
+        {
+            n = MIN(x1 - x, (int)sizeof(cover));
+            aa_fill_span(&fill, x, y, n, cover);
+        }
     }
-}
+    if(!PySurface_Unlock(surfobj))
+        return NULL;
 
+    l = MAX(spans->left + dx, clip->x);
+    t = MAX(spans->top + dy, clip->y);
+    r = MIN(spans->right + dx, clip->x + clip->w);
+    b = MIN(spans->bottom + dy, clip->y + clip->h);
+    return PyRect_New4(l, t, MAX(r-l, 0), MAX(b-t, 0));
+}
 
-static int compare_int(const void *a, const void *b)
+/* Reads the Surface and pen for Path.fill and Path.stroke. */
+static SDL_Surface* path_target(PyObject *surfobj, PyObject *colorobj, int special_flags,
+                                draw_pen *pen, const char *what)
 {
-    return (*(const int *)a) - (*(const int *)b);
+    SDL_Surface *surf = PySurface_AsSurface(surfobj);
+    char msg[80];
+
+    if(surf->format->BytesPerPixel !=3 && surf->format->BytesPerPixel != 4)
+    {
+        PyOS_snprintf(msg, sizeof(msg),
+                      "unsupported bit depth for Path.%s (supports 32 & 24 bit)", what);
+        PyErr_SetString(PyExc_ValueError, msg);
+        return NULL;
+    }
+    if(pen_from_obj(pen, surf, colorobj, special_flags))
+        return NULL;
+    return surf;
 }
 
-static void draw_fillpoly(SDL_Surface *dst, int *vx, int *vy, int n, Uint32 color)
+static PyObject* path_fill(PyObject* self, PyObject* arg)
 {
-    int i;
-    int y;
-    int miny, maxy;
-    int x1, y1;
-    int x2, y2;
-    int ind1, ind2;
-    int ints;
-    int *polyints = PyMem_New(int, n);
-    if (polyints == NULL) {
-        PyErr_NoMemory();
-        return;
+    PyPathObject *path = (PyPathObject *)self;
+    PyObject *surfobj, *colorobj;
+    draw_pen pen;
+    pg_raster raster;
+    int dx = 0, dy = 0, special_flags = 0, sub;
+
+    if(!PyArg_ParseTuple(arg, "O!O|(ii)i", &PySurface_Type, &surfobj, &colorobj, &dx, &dy,
+                         &special_flags))
+        return NULL;
+    if(!path_target(surfobj, colorobj, special_flags, &pen, "fill"))
+        return NULL;
+
+    if(!path->fill.valid)
+    {
+        path_raster_init(&raster, path, 1);
+        for(sub = 0; (sub < path->nsubs); sub++)
+        {
+            int i = path->starts[sub];
+            int end = sub + 1 < path->nsubs ? path->starts[sub + 1] : path->npts;
+
+            pg_raster_move_to(&raster, path->pts[i * 2] + 0.5f, path->pts[i * 2 + 1] + 0.5f);
+            for(i++; (i < end); i++)
+                pg_raster_line_to(&raster, path->pts[i * 2] + 0.5f, path->pts[i * 2 + 1] + 0.5f);
+        }
+        if(path_rasterize(&path->fill, &raster, 1))
+            return NULL;
     }
+    return path_blit(surfobj, &path->fill, &pen, dx, dy);
+}
 
+static PyObject* path_stroke(PyObject* self, PyObject* arg)
+{
+    PyPathObject *path = (PyPathObject *)self;
+    PyObject *surfobj, *colorobj;
+    draw_pen pen;
+    pg_raster raster;
+    float width = 1;
+    int join = JOIN_MITER, cap = CAP_BUTT;
+    int dx = 0, dy = 0, special_flags = 0;
+
+    if(!PyArg_ParseTuple(arg, "O!O|fii(ii)i", &PySurface_Type, &surfobj, &colorobj, &width,
+                         &join, &cap, &dx, &dy, &special_flags))
+        return NULL;
+    if(width <= 0)
+        return RAISE(PyExc_ValueError, "width must be positive");
+    if(join < JOIN_MITER || join > JOIN_BEVEL)
+        return RAISE(PyExc_ValueError, "invalid join");
+    if(cap < CAP_BUTT || cap > CAP_SQUARE)
+        return RAISE(PyExc_ValueError, "invalid cap");
+    if(!path_target(surfobj, colorobj, special_flags, &pen, "stroke"))
+        return NULL;
 
-    /* Determine Y maxima */
-    miny = vy[0];
-    maxy = vy[0];
-    for (i=1; (i < n); i++)
+    if(!path->stroke.valid || path->width != width || path->join != join || path->cap != cap)
     {
-        miny = MIN(miny, vy[i]);
-        maxy = MAX(maxy, vy[i]);
+        /* a miter reaches furthest out from the points */
+        path_raster_init(&raster, path, width * (float)PATH_MITER_LIMIT / 2 + 1);
+        path_add_stroke(&raster, path, width, join, cap);
+        if(path_rasterize(&path->stroke, &raster, 0))
+            return NULL;
+        path->width = width;
+        path->join = join;
+        path->cap = cap;
     }
+    return path_blit(surfobj, &path->stroke, &pen, dx, dy);
+}
 
-    /* Draw, scanning y */
-    for(y=miny; (y <= maxy); y++) {
-        ints = 0;
-        for (i=0; (i < n); i++) {
-            if (!i) {
-                ind1 = n-1;
-                ind2 = 0;
-            } else {
-                ind1 = i-1;
-                ind2 = i;
-            }
-            y1 = vy[ind1];
-            y2 = vy[ind2];
-            if (y1 < y2) {
-                x1 = vx[ind1];
-                x2 = vx[ind2];
-            } else if (y1 > y2) {
-                y2 = vy[ind1];
-                y1 = vy[ind2];
-                x2 = vx[ind1];
-                x1 = vx[ind2];
-            } else if (miny == maxy) {
-                /* Special case: polygon only 1 pixel high. */
-                int j;
-                int minx, maxx;
-                
-                /* Determine X bounds */
-                minx = vx[0];
-                maxx = vx[0];
-                for (j=1; (j < n); j++) {
-                    minx = MIN(minx, vx[j]);
-                    maxx = MAX(maxx, vx[j]);
-                }
+static PyObject* path_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    PyPathObject *path;
+    float tolerance = 0.1f;
 
-                /* Just a line from minimum to maximum X */
-                polyints[ints++] = minx;
-                polyints[ints++] = maxx;
-                break;
-            } else {
-                continue;
-            }
-            if ((y >= y1) && (y < y2)) {
-                polyints[ints++] = (y-y1) * (x2-x1) / (y2-y1) + x1;
-            } else if ((y == maxy) && (y > y1) && (y <= y2)) {
-                polyints[ints++] = (y-y1) * (x2-x1) / (y2-y1) + x1;
-            }
-        }
-        qsort(polyints, ints, sizeof(int), compare_int);
+    if(!PyArg_ParseTuple(args, "|f", &tolerance))
+        return NULL;
+    if(tolerance <= 0)
+        return RAISE(PyExc_ValueError, "tolerance must be positive");
 
-        for (i=0; (i<ints); i+=2) {
-            drawhorzlineclip(dst, color, polyints[i], y, polyints[i+1]);
-        }
-    }
-    PyMem_Free(polyints);
+    path = (PyPathObject *)type->tp_alloc(type, 0);
+    if(!path)
+        return NULL;
+    path->pts = NULL;
+    path->npts = path->maxpts = 0;
+    path->starts = NULL;
+    path->closed = NULL;
+    path->nsubs = path->maxsubs = 0;
+    path->open = 0;
+    path->penx = path->peny = 0;
+    path->tolerance = tolerance;
+    memset(&path->fill, 0, sizeof(path_spans));
+    memset(&path->stroke, 0, sizeof(path_spans));
+    path->width = 0;
+    path->join = path->cap = 0;
+    return (PyObject *)path;
+}
+
+static void path_dealloc(PyObject *self)
+{
+    PyPathObject *path = (PyPathObject *)self;
+
+    path_changed(path);
+    free(path->pts);
+    free(path->starts);
+    free(path->closed);
+    Py_TYPE(self)->tp_free(self);
 }
 
+static PyMethodDef path_methods[] =
+{
+    { "move_to", path_move_to, METH_VARARGS, DOC_PATHMOVETO },
+    { "line_to", path_line_to, METH_VARARGS, DOC_PATHLINETO },
+    { "quad_to", path_quad_to, METH_VARARGS, DOC_PATHQUADTO },
+    { "cubic_to", path_cubic_to, METH_VARARGS, DOC_PATHCUBICTO },
+    { "close", path_close, METH_NOARGS, DOC_PATHCLOSE },
+    { "clear", path_clear, METH_NOARGS, DOC_PATHCLEAR },
+    { "fill", path_fill, METH_VARARGS, DOC_PATHFILL },
+    { "stroke", path_stroke, METH_VARARGS, DOC_PATHSTROKE },
+
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject PyPath_Type =
+{
+    TYPE_HEAD (NULL, 0)
+    "pygame.draw.Path",         /* tp_name */
+    sizeof (PyPathObject),      /* tp_basicsize */
+    0,                          /* tp_itemsize */
+    path_dealloc,               /* tp_dealloc */
+    0,                          /* tp_print */
+    0,                          /* tp_getattr */
+    0,                          /* tp_setattr */
+    0,                          /* tp_compare */
+    0,                          /* tp_repr */
+    0,                          /* tp_as_number */
+    0,                          /* tp_as_sequence */
+    0,                          /* tp_as_mapping */
+    0,                          /* tp_hash */
+    0,                          /* tp_call */
+    0,                          /* tp_str */
+    0,                          /* tp_getattro */
+    0,                          /* tp_setattro */
+    0,                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,         /* tp_flags */
+    DOC_PYGAMEDRAWPATH,         /* tp_doc */
+    0,                          /* tp_traverse */
+    0,                          /* tp_clear */
+    0,                          /* tp_richcompare */
+    0,                          /* tp_weaklistoffset */
+    0,                          /* tp_iter */
+    0,                          /* tp_iternext */
+    path_methods,               /* tp_methods */
+    0,                          /* tp_members */
+    0,                          /* tp_getset */
+    0,                          /* tp_base */
+    0,                          /* tp_dict */
+    0,                          /* tp_descr_get */
+    0,                          /* tp_descr_set */
+    0,                          /* tp_dictoffset */
+    0,                          /* tp_init */
+    0,                          /* tp_alloc */
+    path_new,                   /* tp_new */
+};
 
 
 static PyMethodDef _draw_methods[] =
@@ -1578,7 +3842,13 @@ static PyMethodDef _draw_methods[] =
     { "arc", arc, METH_VARARGS, DOC_PYGAMEDRAWARC },
     { "circle", circle, METH_VARARGS, DOC_PYGAMEDRAWCIRCLE },
     { "polygon", polygon, METH_VARARGS, DOC_PYGAMEDRAWPOLYGON },
+    { "aapolygon", aapolygon, METH_VARARGS, DOC_PYGAMEDRAWAAPOLYGON },
+    { "aacircle", aacircle, METH_VARARGS, DOC_PYGAMEDRAWAACIRCLE },
+    { "aaellipse", aaellipse, METH_VARARGS, DOC_PYGAMEDRAWAAELLIPSE },
+    { "aarect", aarect, METH_VARARGS, DOC_PYGAMEDRAWAARECT },
+    { "polygons", polygons, METH_VARARGS, DOC_PYGAMEDRAWPOLYGONS },
     { "rect", rect, METH_VARARGS, DOC_PYGAMEDRAWRECT },
+    { "batch", batch, METH_VARARGS, DOC_PYGAMEDRAWBATCH },
 
     { NULL, NULL, 0, NULL }
 };
@@ -1586,6 +3856,8 @@ static PyMethodDef _draw_methods[] =
 
 MODINIT_DEFINE (draw)
 {
+    PyObject *module;
+
 #if PY3
     static struct PyModuleDef _module = {
         PyModuleDef_HEAD_INIT,
@@ -1617,12 +3889,46 @@ MODINIT_DEFINE (draw)
         MODINIT_ERROR;
     }
 
+    if (PyType_Ready (&PyPath_Type) < 0) {
+        MODINIT_ERROR;
+    }
+
     /* create the module */
 #if PY3
-    return PyModule_Create (&_module);
+    module = PyModule_Create (&_module);
 #else
-    Py_InitModule3(MODPREFIX "draw", _draw_methods, DOC_PYGAMEDRAW);
+    module = Py_InitModule3(MODPREFIX "draw", _draw_methods, DOC_PYGAMEDRAW);
 #endif
+    if (module == NULL) {
+        MODINIT_ERROR;
+    }
+
+#define DEC_CONST(x) \
+    if (PyModule_AddIntConstant (module, #x, x)) { \
+        DECREF_MOD (module); \
+        MODINIT_ERROR; \
+    }
+
+    DEC_CONST (BATCH_POINT);
+    DEC_CONST (BATCH_LINE);
+    DEC_CONST (BATCH_RECT);
+    DEC_CONST (BATCH_CIRCLE);
+    DEC_CONST (BATCH_ELLIPSE);
+    DEC_CONST (JOIN_MITER);
+    DEC_CONST (JOIN_ROUND);
+    DEC_CONST (JOIN_BEVEL);
+    DEC_CONST (CAP_BUTT);
+    DEC_CONST (CAP_ROUND);
+    DEC_CONST (CAP_SQUARE);
+
+    Py_INCREF ((PyObject *)&PyPath_Type);
+    if (PyModule_AddObject (module, "Path", (PyObject *)&PyPath_Type)) {
+        Py_DECREF ((PyObject *)&PyPath_Type);
+        DECREF_MOD (module);
+        MODINIT_ERROR;
+    }
+
+    MODINIT_RETURN (module);
 }
 
 
@@ -310,6 +310,265 @@ font_set_underline (PyObject* self, PyObject* args)
     Py_RETURN_NONE;
 }
 
+/* Render cache: Font.render results, looked up by text, antialias,
+ * colors and font style. The least recently used surfaces are dropped
+ * first to stay within the byte limit. Only exact str, bytes and unicode
+ * text is cached, as subclasses may compare unpredictably.
+ */
+typedef struct {
+    PyObject *text;
+    long hash;
+    int flags;          /* antialias, background and TTF style bits */
+    Uint8 fg[4];
+    Uint8 bg[4];
+} RenderCacheKey;
+
+typedef struct rendercacheentry_ {
+    RenderCacheKey key;
+    PyObject *surface;
+    size_t size;
+    struct rendercacheentry_ *next;
+    struct rendercacheentry_ *lru_prev;
+    struct rendercacheentry_ *lru_next;
+} RenderCacheEntry;
+
+typedef struct fontrendercache_ {
+    RenderCacheEntry **buckets;
+    Uint32 mask;
+    int count;
+    RenderCacheEntry *lru_head;
+    RenderCacheEntry *lru_tail;
+    size_t limit;
+    size_t bytes;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} RenderCache;
+
+#define RENDER_CACHE_MIN_BUCKETS 64
+#define RENDER_FLAG_AA 1
+#define RENDER_FLAG_BG 2
+#define RENDER_FLAG_STYLE_SHIFT 2
+
+static void
+render_cache_unlink (RenderCache *cache, RenderCacheEntry *entry)
+{
+    RenderCacheEntry **link = &cache->buckets[entry->key.hash & cache->mask];
+
+    while (*link != entry)
+        link = &(*link)->next;
+    *link = entry->next;
+
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+
+    --cache->count;
+    cache->bytes -= entry->size;
+}
+
+static void
+render_cache_free_entry (RenderCacheEntry *entry)
+{
+    Py_DECREF (entry->key.text);
+    Py_DECREF (entry->surface);
+    PyMem_Free (entry);
+}
+
+static void
+render_cache_trim (RenderCache *cache)
+{
+    RenderCacheEntry *entry;
+
+    while (cache->bytes > cache->limit && cache->lru_tail) {
+        entry = cache->lru_tail;
+        render_cache_unlink (cache, entry);
+        ++cache->evictions;
+        render_cache_free_entry (entry);
+    }
+}
+
+static void
+render_cache_clear (RenderCache *cache)
+{
+    RenderCacheEntry *entry, *next;
+
+    for (entry = cache->lru_head; entry; entry = next) {
+        next = entry->lru_next;
+        render_cache_free_entry (entry);
+    }
+    memset (cache->buckets, 0, (cache->mask + 1) * sizeof (RenderCacheEntry*));
+    cache->lru_head = cache->lru_tail = NULL;
+    cache->count = 0;
+    cache->bytes = 0;
+}
+
+static void
+render_cache_free (RenderCache *cache)
+{
+    if (!cache)
+        return;
+    render_cache_clear (cache);
+    PyMem_Free (cache->buckets);
+    PyMem_Free (cache);
+}
+
+static int
+render_cache_key_equal (const RenderCacheKey *a, const RenderCacheKey *b)
+{
+    if (a->hash != b->hash || a->flags != b->flags ||
+        Py_TYPE (a->text) != Py_TYPE (b->text) ||
+        memcmp (a->fg, b->fg, 4) != 0 || memcmp (a->bg, b->bg, 4) != 0)
+        return 0;
+    if (a->text == b->text)
+        return 1;
+    /* Exact str and unicode compare without raising */
+    return PyObject_RichCompareBool (a->text, b->text, Py_EQ) == 1;
+}
+
+static RenderCacheEntry*
+render_cache_find (RenderCache *cache, const RenderCacheKey *key)
+{
+    RenderCacheEntry *entry = cache->buckets[key->hash & cache->mask];
+
+    for (; entry; entry = entry->next) {
+        if (render_cache_key_equal (&entry->key, key)) {
+            if (entry != cache->lru_head) {
+                /* move to the front of the LRU list */
+                entry->lru_prev->lru_next = entry->lru_next;
+                if (entry->lru_next)
+                    entry->lru_next->lru_prev = entry->lru_prev;
+                else
+                    cache->lru_tail = entry->lru_prev;
+                entry->lru_prev = NULL;
+                entry->lru_next = cache->lru_head;
+                cache->lru_head->lru_prev = entry;
+                cache->lru_head = entry;
+            }
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void
+render_cache_grow (RenderCache *cache)
+{
+    Uint32 mask = cache->mask * 2 + 1;
+    RenderCacheEntry **buckets;
+    RenderCacheEntry *entry;
+
+    buckets = PyMem_Malloc ((mask + 1) * sizeof (RenderCacheEntry*));
+    if (!buckets)
+        return; /* keep the longer chains */
+    memset (buckets, 0, (mask + 1) * sizeof (RenderCacheEntry*));
+    for (entry = cache->lru_head; entry; entry = entry->lru_next) {
+        entry->next = buckets[entry->key.hash & mask];
+        buckets[entry->key.hash & mask] = entry;
+    }
+    PyMem_Free (cache->buckets);
+    cache->buckets = buckets;
+    cache->mask = mask;
+}
+
+/* Takes new references to the key text and the surface. A surface larger
+ * than the whole limit is not kept. Failing to add is not an error.
+ */
+static void
+render_cache_add (RenderCache *cache, const RenderCacheKey *key,
+                  PyObject *surfobj)
+{
+    SDL_Surface *surf = PySurface_AsSurface (surfobj);
+    RenderCacheEntry *entry;
+    size_t size;
+
+    size = (sizeof (RenderCacheEntry) + sizeof (SDL_Surface) +
+            (size_t)surf->pitch * surf->h);
+    if (size > cache->limit)
+        return;
+    entry = PyMem_Malloc (sizeof (RenderCacheEntry));
+    if (!entry)
+        return;
+
+    if ((Uint32)cache->count > cache->mask)
+        render_cache_grow (cache);
+
+    entry->key = *key;
+    Py_INCREF (entry->key.text);
+    entry->surface = surfobj;
+    Py_INCREF (surfobj);
+    entry->size = size;
+    entry->next = cache->buckets[key->hash & cache->mask];
+    cache->buckets[key->hash & cache->mask] = entry;
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = entry;
+    else
+        cache->lru_tail = entry;
+    cache->lru_head = entry;
+    ++cache->count;
+    cache->bytes += size;
+
+    render_cache_trim (cache);
+}
+
+static PyObject*
+font_set_render_cache (PyObject* self, PyObject* args)
+{
+    PyFontObject *fontobj = (PyFontObject*)self;
+    RenderCache *cache = fontobj->render_cache;
+    Py_ssize_t limit;
+
+    if (!PyArg_ParseTuple (args, "n", &limit))
+        return NULL;
+    if (limit < 0)
+        return RAISE (PyExc_ValueError, "cache limit must not be negative");
+
+    if (limit == 0) {
+        render_cache_free (cache);
+        fontobj->render_cache = NULL;
+        Py_RETURN_NONE;
+    }
+    if (!cache) {
+        cache = PyMem_Malloc (sizeof (RenderCache));
+        if (!cache)
+            return PyErr_NoMemory ();
+        memset (cache, 0, sizeof (RenderCache));
+        cache->buckets = PyMem_Malloc (RENDER_CACHE_MIN_BUCKETS *
+                                       sizeof (RenderCacheEntry*));
+        if (!cache->buckets) {
+            PyMem_Free (cache);
+            return PyErr_NoMemory ();
+        }
+        memset (cache->buckets, 0,
+                RENDER_CACHE_MIN_BUCKETS * sizeof (RenderCacheEntry*));
+        cache->mask = RENDER_CACHE_MIN_BUCKETS - 1;
+        fontobj->render_cache = cache;
+    }
+    cache->limit = (size_t)limit;
+    render_cache_trim (cache);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+font_get_render_cache_stats (PyObject* self)
+{
+    RenderCache *cache = ((PyFontObject*)self)->render_cache;
+
+    if (!cache)
+        return Py_BuildValue ("(kkkin)", 0UL, 0UL, 0UL, 0, (Py_ssize_t)0);
+    return Py_BuildValue ("(kkkin)", cache->hits, cache->misses,
+                          cache->evictions, cache->count,
+                          (Py_ssize_t)cache->bytes);
+}
+
 static PyObject*
 font_render(PyObject* self, PyObject* args)
 {
@@ -321,6 +580,9 @@ font_render(PyObject* self, PyObject* args)
     SDL_Surface* surf;
     SDL_Color foreg, backg;
     int just_return;
+    RenderCache *cache = ((PyFontObject*)self)->render_cache;
+    RenderCacheKey key;
+    RenderCacheEntry *entry;
 
     if (!PyArg_ParseTuple(args, "OiO|O", &text, &aa, &fg_rgba_obj,
                           &bg_rgba_obj)) {
@@ -357,6 +619,35 @@ font_render(PyObject* self, PyObject* args)
         backg.unused = 0;
     }
 
+    if (cache && (PyUnicode_CheckExact(text) || Bytes_CheckExact(text))) {
+        key.text = text;
+        key.hash = (long)PyObject_Hash(text);
+        if (key.hash == -1) {
+            return NULL;
+        }
+        key.flags = ((aa ? RENDER_FLAG_AA : 0) |
+                     (bg_rgba_obj != NULL ? RENDER_FLAG_BG : 0) |
+                     (TTF_GetFontStyle(font) << RENDER_FLAG_STYLE_SHIFT));
+        key.fg[0] = foreg.r;
+        key.fg[1] = foreg.g;
+        key.fg[2] = foreg.b;
+        key.fg[3] = 0;
+        key.bg[0] = backg.r;
+        key.bg[1] = backg.g;
+        key.bg[2] = backg.b;
+        key.bg[3] = 0;
+        entry = render_cache_find(cache, &key);
+        if (entry) {
+            ++cache->hits;
+            Py_INCREF(entry->surface);
+            return entry->surface;
+        }
+        ++cache->misses;
+    }
+    else {
+        cache = NULL;
+    }
+
     just_return = PyObject_Not(text);
     if (just_return) {
         int height = TTF_FontHeight(font);
@@ -447,6 +738,9 @@ font_render(PyObject* self, PyObject* args)
     if (final == NULL) {
         SDL_FreeSurface(surf);
     }
+    else if (cache) {
+        render_cache_add(cache, &key, final);
+    }
     return final;
 }
 
@@ -584,6 +878,10 @@ static PyMethodDef font_methods[] =
     { "metrics", font_metrics, METH_VARARGS, DOC_FONTMETRICS },
     { "render", font_render, METH_VARARGS, DOC_FONTRENDER },
     { "size", font_size, METH_VARARGS, DOC_FONTSIZE },
+    { "set_render_cache", font_set_render_cache, METH_VARARGS,
+      DOC_FONTSETRENDERCACHE },
+    { "get_render_cache_stats", (PyCFunction) font_get_render_cache_stats,
+      METH_NOARGS, DOC_FONTGETRENDERCACHESTATS },
 
     { NULL, NULL, 0, NULL }
 };
@@ -596,6 +894,7 @@ font_dealloc (PyFontObject* self)
 
     if (font && font_initialized)
         TTF_CloseFont (font);
+    render_cache_free (self->render_cache);
 
     if (self->weakreflist)
         PyObject_ClearWeakRefs ((PyObject*) self);
@@ -611,6 +910,10 @@ font_init(PyFontObject *self, PyObject *args, PyObject *kwds)
     PyObject *oencoded;
 
     self->font = NULL;
+    if (self->render_cache) {
+        /* The cached surfaces are of the previous font */
+        render_cache_clear(self->render_cache);
+    }
     if (!PyArg_ParseTuple(args, "Oi", &obj, &fontsize)) {
         return -1;
     }
@@ -36,10 +36,13 @@
 
 #define PYGAMEAPI_FONT_FIRSTSLOT 0
 #define PYGAMEAPI_FONT_NUMSLOTS 3
+struct fontrendercache_;
+
 typedef struct {
   PyObject_HEAD
   TTF_Font* font;
   PyObject* weakreflist;
+  struct fontrendercache_* render_cache;
 } PyFontObject;
 #define PyFont_AsFont(x) (((PyFontObject*)x)->font)
 
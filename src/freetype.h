@@ -49,6 +49,12 @@
 #define FT_STYLE_WIDE       0x08
 #define FT_STYLE_DEFAULT    0xFF
 
+/* Paragraph alignments */
+#define FT_ALIGN_LEFT       0
+#define FT_ALIGN_CENTER     1
+#define FT_ALIGN_RIGHT      2
+#define FT_ALIGN_JUSTIFY    3
+
 /* Bounding box modes */
 #define FT_BBOX_EXACT           FT_GLYPH_BBOX_SUBPIXELS
 #define FT_BBOX_EXACT_GRIDFIT   FT_GLYPH_BBOX_GRIDFIT
@@ -67,6 +73,7 @@
 #define FT_RFLAG_ORIGIN                (1 << 7)
 #define FT_RFLAG_UCS4                  (1 << 8)
 #define FT_RFLAG_USE_BITMAP_STRIKES    (1 << 9)
+#define FT_RFLAG_USE_ATLAS             (1 << 10)
 #define FT_RFLAG_DEFAULTS              (FT_RFLAG_HINTED | \
                                         FT_RFLAG_USE_BITMAP_STRIKES | \
                                         FT_RFLAG_ANTIALIAS)
@@ -0,0 +1,317 @@
+/*
+  pygame - Python Game Library
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+/*
+ * Glyph atlas: cached glyphs are copied, in the color they are drawn in,
+ * into large RGBA surfaces shared by all fonts. Drawing text to a
+ * surface is then one SDL blit per glyph. Pages are packed with shelves:
+ * a glyph goes on the lowest shelf it fits, or on a new shelf at the
+ * bottom of a page. When every page is full the whole atlas is emptied.
+ */
+
+#define PYGAME_FREETYPE_INTERNAL
+
+#include "ft_wrap.h"
+
+typedef struct atlasentry_ {
+    struct atlasentry_ *next;
+    FontColor color;
+    FT_UInt32 generation;
+    int page;
+    SDL_Rect rect;
+} AtlasEntry;
+
+void
+_PGFT_Atlas_Init(GlyphAtlas *atlas)
+{
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+void
+_PGFT_Atlas_Destroy(GlyphAtlas *atlas)
+{
+    int i;
+
+    for (i = 0; i < atlas->num_pages; ++i) {
+#ifdef HAVE_PYGAME_SDL_VIDEO
+        SDL_FreeSurface(atlas->pages[i].surface);
+#endif
+        _PGFT_free(atlas->pages[i].shelves);
+    }
+    atlas->num_pages = 0;
+}
+
+void
+_PGFT_Atlas_FreeEntries(FontGlyph *glyph)
+{
+    AtlasEntry *entry = glyph->atlas;
+    AtlasEntry *next;
+
+    while (entry) {
+        next = entry->next;
+        _PGFT_free(entry);
+        entry = next;
+    }
+    glyph->atlas = 0;
+}
+
+#ifdef HAVE_PYGAME_SDL_VIDEO
+static AtlasEntry *
+find_entry(FontGlyph *glyph, const FontColor *color, FT_UInt32 generation)
+{
+    AtlasEntry **link = &glyph->atlas;
+    AtlasEntry *entry;
+
+    while ((entry = *link)) {
+        if (entry->generation != generation) {
+            /* Its page space was handed out again */
+            *link = entry->next;
+            _PGFT_free(entry);
+            continue;
+        }
+        if (entry->color.r == color->r && entry->color.g == color->g &&
+            entry->color.b == color->b && entry->color.a == color->a) {
+            return entry;
+        }
+        link = &entry->next;
+    }
+    return 0;
+}
+
+static int
+add_page(GlyphAtlas *atlas)
+{
+    AtlasPage *page = &atlas->pages[atlas->num_pages];
+
+    page->surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
+                                         PGFT_ATLAS_PAGE_SIZE,
+                                         PGFT_ATLAS_PAGE_SIZE, 32,
+                                         0x00ff0000, 0x0000ff00,
+                                         0x000000ff, 0xff000000);
+    if (!page->surface) {
+        PyErr_SetString(PyExc_SDLError, SDL_GetError());
+        return -1;
+    }
+    SDL_SetAlpha(page->surface, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+    page->shelves = _PGFT_malloc(PGFT_ATLAS_PAGE_SIZE * sizeof(AtlasShelf));
+    if (!page->shelves) {
+        SDL_FreeSurface(page->surface);
+        page->surface = 0;
+        PyErr_NoMemory();
+        return -1;
+    }
+    page->bottom = 0;
+    page->num_shelves = 0;
+    ++atlas->num_pages;
+    return 0;
+}
+
+static int
+pack_glyph(AtlasPage *page, int w, int h, SDL_Rect *rect)
+{
+    AtlasShelf *best = 0;
+    AtlasShelf *shelf;
+    int i;
+
+    for (i = 0; i < page->num_shelves; ++i) {
+        shelf = &page->shelves[i];
+        if (shelf->height >= h && PGFT_ATLAS_PAGE_SIZE - shelf->x >= w &&
+            (!best || shelf->height < best->height)) {
+            best = shelf;
+        }
+    }
+    if (!best) {
+        if (PGFT_ATLAS_PAGE_SIZE - page->bottom < h) {
+            return 0;
+        }
+        best = &page->shelves[page->num_shelves++];
+        best->y = page->bottom;
+        best->height = h;
+        best->x = 0;
+        page->bottom += h;
+    }
+    rect->x = (Sint16)best->x;
+    rect->y = (Sint16)best->y;
+    rect->w = (Uint16)w;
+    rect->h = (Uint16)h;
+    best->x += w;
+    return 1;
+}
+
+static int
+place_glyph(GlyphAtlas *atlas, int w, int h, AtlasEntry *entry)
+{
+    int i;
+
+    for (i = 0; i < atlas->num_pages; ++i) {
+        if (pack_glyph(&atlas->pages[i], w, h, &entry->rect)) {
+            entry->page = i;
+            return 0;
+        }
+    }
+    if (atlas->num_pages < PGFT_ATLAS_MAX_PAGES) {
+        if (add_page(atlas)) {
+            return -1;
+        }
+    }
+    else {
+        /* Full: start over, invalidating all entries */
+        for (i = 0; i < atlas->num_pages; ++i) {
+            atlas->pages[i].bottom = 0;
+            atlas->pages[i].num_shelves = 0;
+        }
+        ++atlas->generation;
+        i = 0;
+    }
+    pack_glyph(&atlas->pages[i], w, h, &entry->rect);
+    entry->page = i;
+    return 0;
+}
+
+static void
+copy_glyph(SDL_Surface *surface, int x, int y,
+           const FT_Bitmap *bitmap, const FontColor *color)
+{
+    FT_UInt32 rgb = SDL_MapRGBA(surface->format,
+                                color->r, color->g, color->b, 0);
+    FT_UInt32 ashift = surface->format->Ashift;
+    FT_UInt32 opaque = rgb | ((FT_UInt32)color->a << ashift);
+    const FT_Byte *src = bitmap->buffer;
+    FT_Byte *dst = ((FT_Byte *)surface->pixels +
+                    y * surface->pitch + x * 4);
+    FT_UInt32 *row;
+    FT_UInt32 alpha;
+    int i, j;
+
+    for (j = 0; j < (int)bitmap->rows; ++j) {
+        row = (FT_UInt32 *)dst;
+        if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
+            for (i = 0; i < (int)bitmap->width; ++i) {
+                row[i] = (src[i >> 3] & (0x80 >> (i & 7))) ? opaque : rgb;
+            }
+        }
+        else {
+            for (i = 0; i < (int)bitmap->width; ++i) {
+                alpha = ((FT_UInt32)src[i] * color->a + 127) / 255;
+                row[i] = rgb | (alpha << ashift);
+            }
+        }
+        src += bitmap->pitch;
+        dst += surface->pitch;
+    }
+}
+
+/* A glyph too big for a page is drawn through a throwaway surface. */
+static int
+blit_oversized(const FT_Bitmap *bitmap, const FontColor *color,
+               SDL_Surface *surface, SDL_Rect *dst)
+{
+    SDL_Surface *glyph_surf;
+    int rval;
+
+    glyph_surf = SDL_CreateRGBSurface(SDL_SWSURFACE,
+                                      bitmap->width, bitmap->rows, 32,
+                                      0x00ff0000, 0x0000ff00,
+                                      0x000000ff, 0xff000000);
+    if (!glyph_surf) {
+        PyErr_SetString(PyExc_SDLError, SDL_GetError());
+        return -1;
+    }
+    copy_glyph(glyph_surf, 0, 0, bitmap, color);
+    rval = SDL_BlitSurface(glyph_surf, 0, surface, dst);
+    SDL_FreeSurface(glyph_surf);
+    if (rval < 0) {
+        PyErr_SetString(PyExc_SDLError, SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Blit the glyphs of a layout, which must be loaded, to an unlocked
+ * surface. Glyphs missing from the atlas in this color are added first.
+ */
+int
+_PGFT_Atlas_Render(FreeTypeInstance *ft, Layout *text,
+                   const FontColor *fg_color, SDL_Surface *surface,
+                   const FT_Vector *offset)
+{
+    GlyphAtlas *atlas = &ft->atlas;
+    GlyphSlot *slots = text->glyphs;
+    FontGlyph *glyph;
+    FT_Bitmap *bitmap;
+    AtlasEntry *entry;
+    SDL_Rect src;
+    SDL_Rect dst;
+    int x;
+    int y;
+    int n;
+
+    for (n = 0; n < text->length; ++n) {
+        glyph = slots[n].glyph;
+        bitmap = &glyph->image->bitmap;
+        if (bitmap->width == 0 || bitmap->rows == 0) {
+            continue;
+        }
+        x = FX6_TRUNC(FX6_CEIL(offset->x + slots[n].posn.x));
+        y = FX6_TRUNC(FX6_CEIL(offset->y + slots[n].posn.y));
+        if (x >= surface->w || y >= surface->h ||
+            x + (int)bitmap->width <= 0 || y + (int)bitmap->rows <= 0) {
+            continue;
+        }
+        dst.x = (Sint16)x;
+        dst.y = (Sint16)y;
+
+        if (bitmap->width > PGFT_ATLAS_PAGE_SIZE ||
+            bitmap->rows > PGFT_ATLAS_PAGE_SIZE) {
+            if (blit_oversized(bitmap, fg_color, surface, &dst)) {
+                return -1;
+            }
+            continue;
+        }
+
+        entry = find_entry(glyph, fg_color, atlas->generation);
+        if (!entry) {
+            entry = _PGFT_malloc(sizeof(AtlasEntry));
+            if (!entry) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            if (place_glyph(atlas, bitmap->width, bitmap->rows, entry)) {
+                _PGFT_free(entry);
+                return -1;
+            }
+            copy_glyph(atlas->pages[entry->page].surface,
+                       entry->rect.x, entry->rect.y, bitmap, fg_color);
+            entry->color = *fg_color;
+            entry->generation = atlas->generation;
+            entry->next = glyph->atlas;
+            glyph->atlas = entry;
+        }
+
+        src = entry->rect;
+        if (SDL_BlitSurface(atlas->pages[entry->page].surface, &src,
+                            surface, &dst) < 0) {
+            PyErr_SetString(PyExc_SDLError, SDL_GetError());
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif  /* #ifdef HAVE_PYGAME_SDL_VIDEO */
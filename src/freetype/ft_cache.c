@@ -41,10 +41,19 @@ typedef union cachenodekey_ {
 typedef struct cachenode_ {
     FontGlyph glyph;
     struct cachenode_ *next;
+    struct cachenode_ *lru_prev;
+    struct cachenode_ *lru_next;
+    FontCache *owner;
+    size_t size;
     NodeKey key;
     FT_UInt32 hash;
 } CacheNode;
 
+/* A bucket chain may grow to this many nodes on average before the
+ * hash table of a font is doubled in size.
+ */
+#define MAX_LOAD_FACTOR 2
+
 static FT_UInt32 get_hash(const NodeKey *);
 static CacheNode *allocate_node(FontCache *,
                                 const FontRenderMode *,
@@ -52,6 +61,11 @@ static CacheNode *allocate_node(FontCache *,
 static void free_node(FontCache *, CacheNode *);
 static void set_node_key(NodeKey *, GlyphIndex_t, const FontRenderMode *);
 static int equal_node_keys(const NodeKey *, const NodeKey *);
+static void lru_link(FreeTypeInstance *, CacheNode *);
+static void lru_unlink(FreeTypeInstance *, CacheNode *);
+static void evict_node(CacheNode *);
+static void trim_cache(FreeTypeInstance *);
+static void grow_table(FontCache *);
 
 const int render_flags_mask = (FT_RFLAG_ANTIALIAS |
                                FT_RFLAG_HINTED |
@@ -62,7 +76,8 @@ set_node_key(NodeKey *key, GlyphIndex_t id, const FontRenderMode *mode)
 {
     KeyFields *fields = &key->fields;
     const FT_UInt16 style_mask = ~(FT_STYLE_UNDERLINE);
-    const FT_UInt16 rflag_mask = ~(FT_RFLAG_VERTICAL | FT_RFLAG_KERNING);
+    const FT_UInt16 rflag_mask = ~(FT_RFLAG_VERTICAL | FT_RFLAG_KERNING |
+                                   FT_RFLAG_USE_ATLAS);
     unsigned short rot = (unsigned short)FX6_TRUNC(mode->rotation_angle);
 
     memset(key, 0, sizeof(*key));
@@ -144,28 +159,18 @@ _PGFT_Cache_Init(FreeTypeInstance *ft, FontCache *cache)
 
     cache_size = cache_size + 1;
 
-    cache->nodes = _PGFT_malloc((size_t)cache_size * sizeof(FontGlyph *));
+    cache->nodes = _PGFT_malloc((size_t)cache_size * sizeof(CacheNode *));
     if (!cache->nodes)
         return -1;
     for (i=0; i < cache_size; ++i)
         cache->nodes[i] = 0;
-    cache->depths = _PGFT_malloc((size_t)cache_size);
-    if (!cache->depths) {
-        _PGFT_free(cache->nodes);
-        cache->nodes = 0;
-        return -1;
-    }
-    memset(cache->depths, 0, cache_size);
-    cache->free_nodes = 0;
+    cache->ft = ft;
     cache->size_mask = (FT_UInt32)(cache_size - 1);
+    cache->count = 0;
+    cache->memory = 0;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    cache->releases = 0;
 
-#ifdef PGFT_DEBUG_CACHE
-    cache->_debug_count = 0;
-    cache->_debug_delete_count = 0;
-    cache->_debug_access = 0;
-    cache->_debug_hit = 0;
-    cache->_debug_miss = 0;
-#endif
     return 0;
 }
 
@@ -179,10 +184,6 @@ _PGFT_Cache_Destroy(FontCache *cache)
         return;
     }
 
-    /* PGFT_DEBUG_CACHE - Here is a good place to set a breakpoint
-     * to examine _debug fields.
-     */
-
     if (cache->nodes) {
         for (i = 0; i <= cache->size_mask; ++i) {
             node = cache->nodes[i];
@@ -196,44 +197,34 @@ _PGFT_Cache_Destroy(FontCache *cache)
         _PGFT_free(cache->nodes);
         cache->nodes = 0;
     }
-    _PGFT_free(cache->depths);
-    cache->depths = 0;
 }
 
+/*
+ * Bring the glyph memory of all fonts back under the instance limit by
+ * releasing the least recently used glyphs, whichever font owns them.
+ * Glyphs found while laying out a string are never released before the
+ * layout is done with them, so the limit may be exceeded by one string's
+ * worth of glyphs until the next cleanup. A font whose glyphs are
+ * released has its releases count bumped, so its kept layouts reload.
+ */
 void
 _PGFT_Cache_Cleanup(FontCache *cache)
 {
-    const FT_Byte MAX_BUCKET_DEPTH = 2;
-    CacheNode *node, *prev;
-    FT_UInt32 i;
-
-    for (i = 0; i <= cache->size_mask; ++i) {
-        while (cache->depths[i] > MAX_BUCKET_DEPTH) {
-            node = cache->nodes[i];
-            prev = 0;
-
-            for (;;) {
-                if (!node->next) {
-#ifdef PGFT_DEBUG_CACHE
-                    cache->_debug_delete_count++;
-#endif
-
-                    prev->next = 0;
-                    free_node(cache, node);
-                    break;
-                }
+    trim_cache(cache->ft);
+}
 
-                prev = node;
-                node = node->next;
-            }
-        }
-    }
+void
+_PGFT_Cache_SetLimit(FreeTypeInstance *ft, size_t limit)
+{
+    ft->cache_limit = limit;
+    trim_cache(ft);
 }
 
 FontGlyph *
 _PGFT_Cache_FindGlyph(GlyphIndex_t id, const FontRenderMode *render,
                       FontCache *cache, void *internal)
 {
+    FreeTypeInstance *ft = cache->ft;
     CacheNode **nodes = cache->nodes;
     CacheNode *node, *prev;
     NodeKey key;
@@ -247,21 +238,19 @@ _PGFT_Cache_FindGlyph(GlyphIndex_t id, const FontRenderMode *render,
     node = nodes[bucket];
     prev = 0;
 
-#ifdef PGFT_DEBUG_CACHE
-    cache->_debug_access++;
-#endif
-
     while (node) {
-        if (equal_node_keys(&node->key, &key)) {
+        if (node->hash == hash && equal_node_keys(&node->key, &key)) {
             if (prev) {
                 prev->next = node->next;
                 node->next = nodes[bucket];
                 nodes[bucket] = node;
             }
-
-#ifdef PGFT_DEBUG_CACHE
-            cache->_debug_hit++;
-#endif
+            if (ft->cache_lru != node) {
+                lru_unlink(ft, node);
+                lru_link(ft, node);
+            }
+            cache->stats.hits++;
+            ft->cache_stats.hits++;
 
             return &node->glyph;
         }
@@ -270,15 +259,105 @@ _PGFT_Cache_FindGlyph(GlyphIndex_t id, const FontRenderMode *render,
         node = node->next;
     }
 
+    cache->stats.misses++;
+    ft->cache_stats.misses++;
     node = allocate_node(cache, render, id, internal);
 
-#ifdef PGFT_DEBUG_CACHE
-    cache->_debug_miss++;
-#endif
-
     return node ? &node->glyph : 0;
 }
 
+static void
+lru_link(FreeTypeInstance *ft, CacheNode *node)
+{
+    node->lru_prev = 0;
+    node->lru_next = ft->cache_lru;
+    if (ft->cache_lru) {
+        ft->cache_lru->lru_prev = node;
+    }
+    else {
+        ft->cache_lru_tail = node;
+    }
+    ft->cache_lru = node;
+}
+
+static void
+lru_unlink(FreeTypeInstance *ft, CacheNode *node)
+{
+    if (node->lru_prev) {
+        node->lru_prev->lru_next = node->lru_next;
+    }
+    else {
+        ft->cache_lru = node->lru_next;
+    }
+    if (node->lru_next) {
+        node->lru_next->lru_prev = node->lru_prev;
+    }
+    else {
+        ft->cache_lru_tail = node->lru_prev;
+    }
+    node->lru_prev = 0;
+    node->lru_next = 0;
+}
+
+static void
+evict_node(CacheNode *node)
+{
+    FontCache *cache = node->owner;
+    CacheNode **link = &cache->nodes[node->hash & cache->size_mask];
+
+    while (*link != node) {
+        link = &(*link)->next;
+    }
+    *link = node->next;
+
+    cache->stats.evictions++;
+    cache->ft->cache_stats.evictions++;
+    cache->releases++;
+    free_node(cache, node);
+}
+
+static void
+trim_cache(FreeTypeInstance *ft)
+{
+    while (ft->cache_memory > ft->cache_limit && ft->cache_lru_tail) {
+        evict_node(ft->cache_lru_tail);
+    }
+}
+
+static void
+grow_table(FontCache *cache)
+{
+    FT_UInt32 old_size = cache->size_mask + 1;
+    FT_UInt32 new_mask = old_size * 2 - 1;
+    CacheNode **nodes;
+    CacheNode *node, *next;
+    FT_UInt32 i;
+
+    if (old_size > 0x40000000) {
+        return;
+    }
+    nodes = _PGFT_malloc((size_t)(new_mask + 1) * sizeof(CacheNode *));
+    if (!nodes) {
+        /* Not fatal: the chains just get longer. */
+        return;
+    }
+    for (i = 0; i <= new_mask; ++i) {
+        nodes[i] = 0;
+    }
+
+    for (i = 0; i < old_size; ++i) {
+        for (node = cache->nodes[i]; node; node = next) {
+            next = node->next;
+            node->next = nodes[node->hash & new_mask];
+            nodes[node->hash & new_mask] = node;
+        }
+    }
+
+    _PGFT_free(cache->nodes);
+    cache->nodes = nodes;
+    cache->size_mask = new_mask;
+}
+
 static void
 free_node(FontCache *cache, CacheNode *node)
 {
@@ -286,11 +365,11 @@ free_node(FontCache *cache, CacheNode *node)
         return;
     }
 
-#ifdef PGFT_DEBUG_CACHE
-    cache->_debug_count--;
-#endif
-
-    cache->depths[node->hash & cache->size_mask]--;
+    lru_unlink(cache->ft, node);
+    _PGFT_Atlas_FreeEntries(&node->glyph);
+    cache->count--;
+    cache->memory -= node->size;
+    cache->ft->cache_memory -= node->size;
 
     FT_Done_Glyph((FT_Glyph)(node->glyph.image));
     _PGFT_free(node);
@@ -301,6 +380,7 @@ allocate_node(FontCache *cache, const FontRenderMode *render,
               GlyphIndex_t id, void *internal)
 {
     CacheNode *node = _PGFT_malloc(sizeof(CacheNode));
+    FT_Bitmap *bitmap;
     FT_UInt32 bucket;
 
     if (!node) {
@@ -312,17 +392,28 @@ allocate_node(FontCache *cache, const FontRenderMode *render,
         goto cleanup;
     }
 
+    /* Charge the node, the bitmap glyph record and its pixels */
+    bitmap = &node->glyph.image->bitmap;
+    node->size = (sizeof(CacheNode) + sizeof(FT_BitmapGlyphRec) +
+                  (size_t)(bitmap->pitch < 0 ? -bitmap->pitch :
+                                               bitmap->pitch) *
+                  bitmap->rows);
+
+    if (cache->count >= MAX_LOAD_FACTOR * (cache->size_mask + 1)) {
+        grow_table(cache);
+    }
+
     set_node_key(&node->key, id, render);
     node->hash = get_hash(&node->key);
+    node->owner = cache;
     bucket = node->hash & cache->size_mask;
     node->next = cache->nodes[bucket];
     cache->nodes[bucket] = node;
 
-    cache->depths[bucket]++;
-
-#ifdef PGFT_DEBUG_CACHE
-    cache->_debug_count++;
-#endif
+    lru_link(cache->ft, node);
+    cache->count++;
+    cache->memory += node->size;
+    cache->ft->cache_memory += node->size;
 
     return node;
 
@@ -60,6 +60,10 @@ typedef struct textcontext_ {
 #endif
 #define FX16_BOLD_FACTOR (FX16_ONE / 36)
 #define UNICODE_SPACE ((PGFT_char)' ')
+#define IS_BREAK_SPACE(ch) ((ch) == UNICODE_SPACE || \
+                            (ch) == (PGFT_char)'\t' || \
+                            (ch) == (PGFT_char)'\r')
+#define IS_LINE_BREAK(ch) ((ch) == (PGFT_char)'\n')
 
 typedef enum {
     UPDATE_NONE,
@@ -104,18 +108,30 @@ static UpdateLevel_t mode_compare(const FontRenderMode *,
 static int same_sizes(const Scale_t *, const Scale_t * );
 static int same_transforms(const FT_Matrix *, const FT_Matrix *);
 static void copy_mode(FontRenderMode *, const FontRenderMode *);
+static void free_layouts(FontInternals *);
+static FT_UInt32 get_text_hash(const PGFT_String *);
+static Layout *find_layout(FontInternals *, const FontRenderMode *,
+                           const PGFT_String *);
+static void set_layout_key(Layout *, const PGFT_String *);
+static FT_Pos get_pen_x(const GlyphSlot *);
+static FT_Pos get_line_width(const GlyphSlot *, int, int);
 
 
 int
 _PGFT_LayoutInit(FreeTypeInstance *ft, PgFontObject *fontobj)
 {
-    Layout *ftext = &fontobj->_internals->active_text;
-    FontCache *cache = &fontobj->_internals->glyph_cache;
+    FontInternals *internals = fontobj->_internals;
+    FontCache *cache = &internals->glyph_cache;
 
-    ftext->buffer_size = 0;
-    ftext->glyphs = 0;
+    internals->layouts = 0;
+    internals->active_text = 0;
+    internals->layout_clock = 0;
+    if (_PGFT_SetLayoutCacheSize(fontobj, PGFT_DEFAULT_LAYOUT_CACHE_SIZE)) {
+        return -1;
+    }
 
     if (_PGFT_Cache_Init(ft, cache)) {
+        free_layouts(internals);
         PyErr_NoMemory();
         return -1;
     }
@@ -126,27 +142,63 @@ _PGFT_LayoutInit(FreeTypeInstance *ft, PgFontObject *fontobj)
 void
 _PGFT_LayoutFree(PgFontObject *fontobj)
 {
-    Layout *ftext = &(fontobj->_internals->active_text);
-    FontCache *cache = &fontobj->_internals->glyph_cache;
+    FontInternals *internals = fontobj->_internals;
+    FontCache *cache = &internals->glyph_cache;
 
-    if (ftext->buffer_size > 0) {
-        _PGFT_free(ftext->glyphs);
-        ftext->glyphs = 0;
-    }
+    free_layouts(internals);
     _PGFT_Cache_Destroy(cache);
 }
 
+int
+_PGFT_SetLayoutCacheSize(PgFontObject *fontobj, int size)
+{
+    FontInternals *internals = fontobj->_internals;
+    Layout *layouts;
+
+    assert(size > 0);
+    layouts = _PGFT_malloc((size_t)size * sizeof(Layout));
+    if (!layouts) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memset(layouts, 0, (size_t)size * sizeof(Layout));
+
+    free_layouts(internals);
+    internals->layouts = layouts;
+    internals->layout_cache_size = size;
+    internals->active_text = layouts;
+    return 0;
+}
+
 Layout *
 _PGFT_LoadLayout(FreeTypeInstance *ft, PgFontObject *fontobj,
                  const FontRenderMode *mode, PGFT_String *text)
 {
-    Layout *ftext = &fontobj->_internals->active_text;
-    FontCache *cache = &fontobj->_internals->glyph_cache;
-    UpdateLevel_t level = (text ?
-                           UPDATE_GLYPHS : mode_compare(&ftext->mode, mode));
+    FontInternals *internals = fontobj->_internals;
+    FontCache *cache = &internals->glyph_cache;
+    Layout *ftext;
+    UpdateLevel_t level;
     FT_Face font = 0;
     TextContext context;
 
+    if (text) {
+        ftext = find_layout(internals, mode, text);
+        level = ftext->has_key ? UPDATE_NONE : UPDATE_GLYPHS;
+    }
+    else {
+        ftext = internals->active_text;
+        level = mode_compare(&ftext->mode, mode);
+        if (level == UPDATE_GLYPHS) {
+            /* Text metrics are not redone: keep it out of the cache */
+            ftext->has_key = 0;
+        }
+    }
+    if (ftext->releases != cache->releases) {
+        level = UPDATE_GLYPHS;
+    }
+    ftext->last_use = ++internals->layout_clock;
+    internals->active_text = ftext;
+
     if (level != UPDATE_NONE) {
         copy_mode(&ftext->mode, mode);
         font = _PGFT_GetFontSized(ft, fontobj, mode->face_size);
@@ -169,6 +221,7 @@ _PGFT_LoadLayout(FreeTypeInstance *ft, PgFontObject *fontobj,
         if (load_glyphs(ftext, &context, cache)) {
             return 0;
         }
+        ftext->releases = cache->releases;
         /* fall through */
 
     case UPDATE_LAYOUT:
@@ -180,9 +233,317 @@ _PGFT_LoadLayout(FreeTypeInstance *ft, PgFontObject *fontobj,
         break;
     }
 
+    if (text && !ftext->has_key) {
+        set_layout_key(ftext, text);
+    }
+
     return ftext;
 }
 
+/*
+ * Break text into lines no wider than max_width, or only at newlines if
+ * max_width is 0, and align them. Lines break after the last space that
+ * fits, or within a word wider than a line. Glyphs are loaded once, by
+ * the layout of the whole text, and then moved to their lines.
+ */
+int
+_PGFT_LoadParagraph(FreeTypeInstance *ft, PgFontObject *fontobj,
+                    const FontRenderMode *mode, PGFT_String *text,
+                    FT_Pos max_width, int align, FT_Fixed line_spacing,
+                    Paragraph *para)
+{
+    const PGFT_char *chars = PGFT_String_GET_DATA(text);
+    Layout *ftext;
+    GlyphSlot *slots;
+    GlyphSlot *dst;
+    ParagraphLine *line;
+    FT_Pos width = 0;
+    FT_Pos line_height;
+    FT_Pos slack;
+    FT_Pos extra;
+    FT_Pos shift;
+    int num_spaces;
+    int length;
+    int start;
+    int end;
+    int next;
+    int brk;
+    int i;
+    int k;
+
+    memset(para, 0, sizeof(Paragraph));
+    if (mode->render_flags & FT_RFLAG_VERTICAL) {
+        PyErr_SetString(PyExc_ValueError,
+                        "paragraphs are unsupported for vertical text");
+        return -1;
+    }
+    if (mode->rotation_angle != 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "paragraphs are unsupported for rotated text");
+        return -1;
+    }
+
+    ftext = _PGFT_LoadLayout(ft, fontobj, mode, text);
+    if (!ftext) {
+        return -1;
+    }
+    length = ftext->length;
+    slots = ftext->glyphs;
+
+    /* The layout is copied, as it stays in the layout cache */
+    para->layout = *ftext;
+    para->layout.glyphs = 0;
+    para->layout.buffer_size = 0;
+    para->layout.has_key = 0;
+    para->layout.text = 0;
+    para->layout.text_size = 0;
+    para->lines = _PGFT_malloc((size_t)(length + 1) * sizeof(ParagraphLine));
+    if (length > 0) {
+        para->layout.glyphs =
+            _PGFT_malloc((size_t)length * sizeof(GlyphSlot));
+        para->layout.buffer_size = length;
+    }
+    if (!para->lines || (length > 0 && !para->layout.glyphs)) {
+        _PGFT_FreeParagraph(para);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    /* Break lines */
+    start = 0;
+    while (start <= length) {
+        brk = start;
+        end = length;
+        next = length + 1;
+        line = &para->lines[para->num_lines++];
+        line->last = 1;
+        for (i = start; i < length; ++i) {
+            if (IS_LINE_BREAK(chars[i])) {
+                end = i;
+                next = i + 1;
+                break;
+            }
+            if (IS_BREAK_SPACE(chars[i])) {
+                if (i > start && !IS_BREAK_SPACE(chars[i - 1])) {
+                    brk = i;
+                }
+            }
+            else if (max_width > 0 && i > start &&
+                     get_line_width(slots, start, i + 1) > max_width) {
+                line->last = 0;
+                if (brk > start) {
+                    end = brk;
+                    next = brk;
+                    while (next < length && IS_BREAK_SPACE(chars[next])) {
+                        ++next;
+                    }
+                }
+                else {
+                    end = i;
+                    next = i;
+                }
+                break;
+            }
+        }
+        while (end > start && IS_BREAK_SPACE(chars[end - 1])) {
+            --end;
+        }
+        line->start = start;
+        line->end = end;
+        line->width = get_line_width(slots, start, end);
+        if (line->width > width) {
+            width = line->width;
+        }
+        start = next;
+    }
+    if (max_width > 0) {
+        width = max_width;
+    }
+
+    /* Align lines and move their glyphs into place */
+    line_height = FT_MulFix(ftext->height, line_spacing);
+    dst = para->layout.glyphs;
+    for (k = 0; k < para->num_lines; ++k) {
+        line = &para->lines[k];
+        line->baseline = ftext->ascender + k * line_height;
+        slack = width - line->width;
+        line->left = 0;
+        extra = 0;
+        switch (align) {
+
+        case FT_ALIGN_CENTER:
+            line->left = FX6_ROUND(slack / 2);
+            break;
+        case FT_ALIGN_RIGHT:
+            line->left = FX6_ROUND(slack);
+            break;
+        case FT_ALIGN_JUSTIFY:
+            if (line->last || slack <= 0) {
+                break;
+            }
+            num_spaces = 0;
+            for (i = line->start; i < line->end; ++i) {
+                if (IS_BREAK_SPACE(chars[i])) {
+                    ++num_spaces;
+                }
+            }
+            if (num_spaces > 0) {
+                extra = slack / num_spaces;
+                line->width = width;
+            }
+            break;
+        }
+        if (line->end == line->start) {
+            continue;
+        }
+        shift = line->left - get_pen_x(&slots[line->start]);
+        for (i = line->start; i < line->end; ++i) {
+            if (IS_BREAK_SPACE(chars[i])) {
+                shift += extra;
+                continue;
+            }
+            if (chars[i] < UNICODE_SPACE) {
+                /* Control characters have no glyph worth drawing */
+                continue;
+            }
+            *dst = slots[i];
+            dst->posn.x += shift;
+            dst->posn.y += line->baseline;
+            ++dst;
+        }
+    }
+    para->layout.length = (int)(dst - para->layout.glyphs);
+    para->width = width;
+    para->height = (ftext->ascender - ftext->descender +
+                    (para->num_lines - 1) * line_height);
+    para->layout.min_x = 0;
+    para->layout.max_x = para->width;
+    para->layout.min_y = 0;
+    para->layout.max_y = para->height;
+
+    return 0;
+}
+
+void
+_PGFT_FreeParagraph(Paragraph *para)
+{
+    _PGFT_free(para->layout.glyphs);
+    para->layout.glyphs = 0;
+    _PGFT_free(para->lines);
+    para->lines = 0;
+}
+
+static FT_Pos
+get_pen_x(const GlyphSlot *slot)
+{
+    return slot->posn.x - slot->glyph->h_metrics.bearing_rotated.x;
+}
+
+/* The advance width of glyphs start up to end, kerning included */
+static FT_Pos
+get_line_width(const GlyphSlot *slots, int start, int end)
+{
+    if (end <= start) {
+        return 0;
+    }
+    return (get_pen_x(&slots[end - 1]) +
+            slots[end - 1].glyph->h_metrics.advance_rotated.x -
+            get_pen_x(&slots[start]));
+}
+
+static void
+free_layouts(FontInternals *internals)
+{
+    Layout *ftext;
+    int i;
+
+    if (!internals->layouts) {
+        return;
+    }
+    for (i = 0; i < internals->layout_cache_size; ++i) {
+        ftext = &internals->layouts[i];
+        _PGFT_free(ftext->glyphs);
+        _PGFT_free(ftext->text);
+    }
+    _PGFT_free(internals->layouts);
+    internals->layouts = 0;
+    internals->active_text = 0;
+}
+
+static FT_UInt32
+get_text_hash(const PGFT_String *text)
+{
+    /* 32 bit FNV-1a over the characters */
+    const PGFT_char *chars = PGFT_String_GET_DATA(text);
+    Py_ssize_t length = PGFT_String_GET_LENGTH(text);
+    FT_UInt32 hash = 2166136261U;
+    Py_ssize_t i;
+
+    for (i = 0; i < length; ++i) {
+        hash = (hash ^ (FT_UInt32)chars[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/*
+ * Return the cached layout of text in this mode, or else the least
+ * recently used layout, its key cleared, to be loaded again. A cached
+ * layout matches when mode_compare finds nothing to update; glyph
+ * strength is also checked, as it sizes the underline.
+ */
+static Layout *
+find_layout(FontInternals *internals, const FontRenderMode *mode,
+            const PGFT_String *text)
+{
+    FT_UInt32 hash = get_text_hash(text);
+    Py_ssize_t length = PGFT_String_GET_LENGTH(text);
+    Layout *layouts = internals->layouts;
+    Layout *oldest = layouts;
+    Layout *ftext;
+    int i;
+
+    for (i = 0; i < internals->layout_cache_size; ++i) {
+        ftext = &layouts[i];
+        if (ftext->has_key && ftext->text_hash == hash &&
+            ftext->text_length == length &&
+            mode_compare(&ftext->mode, mode) == UPDATE_NONE &&
+            ftext->mode.strength == mode->strength &&
+            !memcmp(ftext->text, PGFT_String_GET_DATA(text),
+                    (size_t)length * sizeof(PGFT_char))) {
+            return ftext;
+        }
+        if (ftext->last_use < oldest->last_use) {
+            oldest = ftext;
+        }
+    }
+    oldest->has_key = 0;
+    return oldest;
+}
+
+static void
+set_layout_key(Layout *ftext, const PGFT_String *text)
+{
+    Py_ssize_t length = PGFT_String_GET_LENGTH(text);
+
+    if (length > ftext->text_size) {
+        _PGFT_free(ftext->text);
+        ftext->text_size = 0;
+        ftext->text = _PGFT_malloc((size_t)length * sizeof(PGFT_char));
+        if (!ftext->text) {
+            /* Not fatal: the layout just won't be found again */
+            return;
+        }
+        ftext->text_size = length;
+    }
+    if (length > 0) {
+        memcpy(ftext->text, PGFT_String_GET_DATA(text),
+               (size_t)length * sizeof(PGFT_char));
+    }
+    ftext->text_length = length;
+    ftext->text_hash = get_text_hash(text);
+    ftext->has_key = 1;
+}
+
 static int
 size_text(Layout *ftext,
           FreeTypeInstance *ft,
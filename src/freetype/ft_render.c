@@ -30,6 +30,8 @@ static const FontColor mono_transparent = {0, 0, 0, SDL_ALPHA_TRANSPARENT};
 static void render(FreeTypeInstance *, Layout *, const FontRenderMode *,
                    const FontColor *, FontSurface *, unsigned, unsigned,
                    FT_Vector *, FT_Pos, FT_Fixed);
+static void render_underline(Layout *, const FontColor *, FontSurface *,
+                             unsigned, FT_Vector *, FT_Pos, FT_Fixed, int);
 
 static int
 _validate_view_format(const char *format)
@@ -388,8 +390,34 @@ _PGFT_Render_ExistingSurface(FreeTypeInstance *ft, PgFontObject *fontobj,
     /*
      * Render!
      */
-    render(ft, font_text, mode, fgcolor, &font_surf,
-           width, height, &surf_offset, underline_top, underline_size);
+    if (mode->render_flags & FT_RFLAG_USE_ATLAS) {
+        /* Glyphs are blitted from the atlas; SDL locks for itself */
+        if (locked) {
+            SDL_UnlockSurface(surface);
+        }
+        if (_PGFT_Atlas_Render(ft, font_text, fgcolor, surface,
+                               &surf_offset)) {
+            return -1;
+        }
+        if (underline_size > 0) {
+            if (locked && SDL_LockSurface(surface) == -1) {
+                PyErr_SetString(PyExc_SDLError, SDL_GetError());
+                return -1;
+            }
+            /* relocking may move the pixels, RLE surfaces for one */
+            font_surf.buffer = surface->pixels;
+            render_underline(font_text, fgcolor, &font_surf, width,
+                             &surf_offset, underline_top, underline_size,
+                             mode->render_flags & FT_RFLAG_ANTIALIAS);
+        }
+        else {
+            locked = 0;
+        }
+    }
+    else {
+        render(ft, font_text, mode, fgcolor, &font_surf,
+               width, height, &surf_offset, underline_top, underline_size);
+    }
 
     r->x = -(Sint16)FX6_TRUNC(FX6_FLOOR(offset.x));
     r->y = (Sint16)FX6_TRUNC(FX6_CEIL(offset.y));
@@ -403,12 +431,15 @@ _PGFT_Render_ExistingSurface(FreeTypeInstance *ft, PgFontObject *fontobj,
     return 0;
 }
 
-SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
-                                     PgFontObject *fontobj,
-                                     const FontRenderMode *mode,
-                                     PGFT_String *text,
-                                     FontColor *fgcolor, FontColor *bgcolor,
-                                     SDL_Rect *r)
+/* Create a surface for rendering text, filled with the background color,
+ * and set up font_surf to render on it. An 8 bit surface is used for
+ * monochrome text without a background; its palette holds the colors, so
+ * *fgcolor is replaced with the palette index.
+ */
+static SDL_Surface *
+new_text_surface(const FontRenderMode *mode, unsigned width, unsigned height,
+                 const FontColor **fgcolor, const FontColor *bgcolor,
+                 FontSurface *font_surf, int *locked)
 {
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
     FT_UInt32 rmask = 0xff000000;
@@ -421,40 +452,14 @@ SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
     FT_UInt32 bmask = 0x00ff0000;
     FT_UInt32 amask = 0xff000000;
 #endif
-    int locked = 0;
+    static const FontColor mono_fgcolor = {0, 0, 0, 1};
     FT_UInt32 fillcolor;
     SDL_Surface *surface = 0;
     int bits_per_pixel =
         (bgcolor || mode->render_flags & FT_RFLAG_ANTIALIAS) ? 32 : 8;
     FT_UInt32 surface_flags = SDL_SWSURFACE;
 
-    FontSurface font_surf;
-    Layout *font_text;
-    unsigned width;
-    unsigned height;
-    FT_Vector offset;
-    FT_Pos underline_top;
-    FT_Fixed underline_size;
-    FontColor mono_fgcolor = {0, 0, 0, 1};
-    FontColor mono_bgcolor = {0, 0, 0, 0};
-
-    /* build font text */
-    font_text = _PGFT_LoadLayout(ft, fontobj, mode, text);
-    if (!font_text) {
-        return 0;
-    }
-
-    if (font_text->length > 0) {
-        _PGFT_GetRenderMetrics(mode, font_text, &width, &height, &offset,
-                               &underline_top, &underline_size);
-    }
-    else {
-        width = 1;
-        height = _PGFT_Font_GetHeightSized(ft, fontobj, mode->face_size);
-        offset.x = -font_text->min_x;
-        offset.y = -font_text->min_y;
-    }
-
+    *locked = 0;
     surface = SDL_CreateRGBSurface(surface_flags, width, height,
                    bits_per_pixel, rmask, gmask, bmask,
                    bits_per_pixel == 32 ? amask : 0);
@@ -469,18 +474,18 @@ SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
             SDL_FreeSurface(surface);
             return 0;
         }
-        locked = 1;
+        *locked = 1;
     }
 
-    font_surf.buffer = surface->pixels;
-    font_surf.width = surface->w;
-    font_surf.height = surface->h;
-    font_surf.pitch = surface->pitch;
-    font_surf.format = surface->format;
+    font_surf->buffer = surface->pixels;
+    font_surf->width = surface->w;
+    font_surf->height = surface->h;
+    font_surf->pitch = surface->pitch;
+    font_surf->format = surface->format;
     if (bits_per_pixel == 32) {
-        font_surf.render_gray = __render_glyph_RGB4;
-        font_surf.render_mono = __render_glyph_MONO4;
-        font_surf.fill = __fill_glyph_RGB4;
+        font_surf->render_gray = __render_glyph_RGB4;
+        font_surf->render_mono = __render_glyph_MONO4;
+        font_surf->fill = __fill_glyph_RGB4;
         /*
          * Fill our texture with the required bg color
          */
@@ -498,9 +503,9 @@ SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
     else {
         SDL_Color colors[2];
 
-        colors[1].r = fgcolor->r;  /* Foreground */
-        colors[1].g = fgcolor->g;
-        colors[1].b = fgcolor->b;
+        colors[1].r = (*fgcolor)->r;  /* Foreground */
+        colors[1].g = (*fgcolor)->g;
+        colors[1].b = (*fgcolor)->b;
         colors[0].r = ~colors[1].r;  /* Background */
         colors[0].g = ~colors[1].g;
         colors[0].b = ~colors[1].b;
@@ -508,28 +513,75 @@ SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
             PyErr_SetString(PyExc_SystemError,
                             "Pygame bug in _PGFT_Render_NewSurface: "
                             "SDL_SetColors failed");
+            if (*locked) {
+                SDL_UnlockSurface(surface);
+            }
             SDL_FreeSurface(surface);
             return 0;
         }
         SDL_SetColorKey(surface, SDL_SRCCOLORKEY, (FT_UInt32)0);
-        if (fgcolor->a != SDL_ALPHA_OPAQUE) {
-            SDL_SetAlpha(surface, SDL_SRCALPHA, fgcolor->a);
-        }
-        fgcolor = &mono_fgcolor;
-        bgcolor = &mono_bgcolor;
-        font_surf.render_gray = __render_glyph_GRAY_as_MONO1;
-        font_surf.render_mono = __render_glyph_MONO_as_GRAY1;
-        font_surf.fill = __fill_glyph_GRAY1;
+        if ((*fgcolor)->a != SDL_ALPHA_OPAQUE) {
+            SDL_SetAlpha(surface, SDL_SRCALPHA, (*fgcolor)->a);
+        }
+        *fgcolor = &mono_fgcolor;
+        font_surf->render_gray = __render_glyph_GRAY_as_MONO1;
+        font_surf->render_mono = __render_glyph_MONO_as_GRAY1;
+        font_surf->fill = __fill_glyph_GRAY1;
         /*
          * Fill our texture with the required bg color
          */
         SDL_FillRect(surface, 0, 0);
     }
 
+    return surface;
+}
+
+SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
+                                     PgFontObject *fontobj,
+                                     const FontRenderMode *mode,
+                                     PGFT_String *text,
+                                     FontColor *fgcolor, FontColor *bgcolor,
+                                     SDL_Rect *r)
+{
+    int locked = 0;
+    SDL_Surface *surface = 0;
+    const FontColor *render_color = fgcolor;
+
+    FontSurface font_surf;
+    Layout *font_text;
+    unsigned width;
+    unsigned height;
+    FT_Vector offset;
+    FT_Pos underline_top = 0;
+    FT_Fixed underline_size = 0;
+
+    /* build font text */
+    font_text = _PGFT_LoadLayout(ft, fontobj, mode, text);
+    if (!font_text) {
+        return 0;
+    }
+
+    if (font_text->length > 0) {
+        _PGFT_GetRenderMetrics(mode, font_text, &width, &height, &offset,
+                               &underline_top, &underline_size);
+    }
+    else {
+        width = 1;
+        height = _PGFT_Font_GetHeightSized(ft, fontobj, mode->face_size);
+        offset.x = -font_text->min_x;
+        offset.y = -font_text->min_y;
+    }
+
+    surface = new_text_surface(mode, width, height, &render_color, bgcolor,
+                               &font_surf, &locked);
+    if (!surface) {
+        return 0;
+    }
+
     /*
      * Render the text!
      */
-    render(ft, font_text, mode, fgcolor, &font_surf,
+    render(ft, font_text, mode, render_color, &font_surf,
            width, height, &offset, underline_top, underline_size);
 
     r->x = -(Sint16)FX6_TRUNC(FX6_FLOOR(offset.x));
@@ -543,6 +595,83 @@ SDL_Surface *_PGFT_Render_NewSurface(FreeTypeInstance *ft,
 
     return surface;
 }
+
+SDL_Surface *
+_PGFT_Render_Paragraph(FreeTypeInstance *ft, PgFontObject *fontobj,
+                       const FontRenderMode *mode, PGFT_String *text,
+                       int max_width, int align, FT_Fixed line_spacing,
+                       FontColor *fgcolor, FontColor *bgcolor, SDL_Rect *r)
+{
+    int locked = 0;
+    SDL_Surface *surface = 0;
+    const FontColor *render_color = fgcolor;
+    int is_underline_gray = mode->render_flags & FT_RFLAG_ANTIALIAS;
+
+    FontSurface font_surf;
+    Paragraph para;
+    ParagraphLine *line;
+    unsigned width;
+    unsigned height;
+    FT_Vector offset;
+    FT_Pos underline_top;
+    FT_Fixed underline_size;
+    int k;
+
+    if (_PGFT_LoadParagraph(ft, fontobj, mode, text, INT_TO_FX6(max_width),
+                            align, line_spacing, &para)) {
+        return 0;
+    }
+
+    /* Only the underline placement is wanted here */
+    _PGFT_GetRenderMetrics(mode, &para.layout, &width, &height, &offset,
+                           &underline_top, &underline_size);
+    width = (unsigned)FX6_TRUNC(FX6_CEIL(para.width));
+    height = (unsigned)FX6_TRUNC(FX6_CEIL(para.height));
+    if (width == 0) {
+        width = 1;
+    }
+
+    surface = new_text_surface(mode, width, height, &render_color, bgcolor,
+                               &font_surf, &locked);
+    if (!surface) {
+        _PGFT_FreeParagraph(&para);
+        return 0;
+    }
+
+    offset.x = 0;
+    offset.y = 0;
+    render(ft, &para.layout, mode, render_color, &font_surf,
+           width, height, &offset, 0, 0);
+    for (k = 0; k < para.num_lines && underline_size > 0; ++k) {
+        line = &para.lines[k];
+        if (line->width <= 0) {
+            continue;
+        }
+        if (is_underline_gray) {
+            font_surf.fill(line->left, line->baseline + underline_top,
+                           line->width, underline_size,
+                           &font_surf, render_color);
+        }
+        else {
+            font_surf.fill(FX6_CEIL(line->left),
+                           FX6_CEIL(line->baseline + underline_top),
+                           FX6_CEIL(line->width), FX6_CEIL(underline_size),
+                           &font_surf, render_color);
+        }
+    }
+
+    r->x = 0;
+    r->y = (Sint16)FX6_TRUNC(FX6_CEIL(para.layout.ascender));
+    r->w = (Uint16)width;
+    r->h = (Uint16)height;
+
+    _PGFT_FreeParagraph(&para);
+    if (locked) {
+        SDL_UnlockSurface(surface);
+    }
+
+    return surface;
+}
 #endif  /* #ifdef HAVE_PYGAME_SDL_VIDEO */
 
 
@@ -792,16 +921,29 @@ render(FreeTypeInstance *ft, Layout *text, const FontRenderMode *mode,
     }
 
     if (underline_size > 0) {
-        if (is_underline_gray) {
-            surface->fill(left + text->min_x, top + underline_top,
-                          INT_TO_FX6(width), underline_size,
-                          surface, fg_color);
-        }
-        else {
-            surface->fill(FX6_CEIL(left + text->min_x),
-                          FX6_CEIL(top + underline_top),
-                          INT_TO_FX6(width), FX6_CEIL(underline_size),
-                          surface, fg_color);
-        }
+        render_underline(text, fg_color, surface, width, offset,
+                         underline_top, underline_size, is_underline_gray);
+    }
+}
+
+static void
+render_underline(Layout *text, const FontColor *fg_color,
+                 FontSurface *surface, unsigned width, FT_Vector *offset,
+                 FT_Pos underline_top, FT_Fixed underline_size,
+                 int is_underline_gray)
+{
+    FT_Pos top = offset->y;
+    FT_Pos left = offset->x;
+
+    if (is_underline_gray) {
+        surface->fill(left + text->min_x, top + underline_top,
+                      INT_TO_FX6(width), underline_size,
+                      surface, fg_color);
+    }
+    else {
+        surface->fill(FX6_CEIL(left + text->min_x),
+                      FX6_CEIL(top + underline_top),
+                      INT_TO_FX6(width), FX6_CEIL(underline_size),
+                      surface, fg_color);
     }
 }
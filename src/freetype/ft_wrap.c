@@ -536,6 +536,12 @@ _PGFT_Init(FreeTypeInstance **_instance, int cache_size)
     inst->cache_manager = 0;
     inst->library = 0;
     inst->cache_size = cache_size;
+    inst->cache_lru = 0;
+    inst->cache_lru_tail = 0;
+    inst->cache_memory = 0;
+    inst->cache_limit = PGFT_DEFAULT_CACHE_LIMIT;
+    memset(&inst->cache_stats, 0, sizeof(inst->cache_stats));
+    _PGFT_Atlas_Init(&inst->atlas);
 
     error = FT_Init_FreeType(&inst->library);
     if (error) {
@@ -578,6 +584,8 @@ _PGFT_Quit(FreeTypeInstance *ft)
     if (--ft->ref_count != 0)
         return;
 
+    _PGFT_Atlas_Destroy(&ft->atlas);
+
     if (ft->cache_manager)
         FTC_Manager_Done(ft->cache_manager);
 
@@ -52,9 +52,10 @@
 /* Internal configuration variables */
 #define PGFT_DEFAULT_CACHE_SIZE 64
 #define PGFT_MIN_CACHE_SIZE 32
-#if defined(PGFT_DEBUG_CACHE)
-#undef  PGFT_DEBUG_CACHE
-#endif
+#define PGFT_DEFAULT_CACHE_LIMIT (4 * 1024 * 1024) /* bytes, all fonts */
+#define PGFT_DEFAULT_LAYOUT_CACHE_SIZE 16
+#define PGFT_ATLAS_PAGE_SIZE 512 /* pixels, width and height */
+#define PGFT_ATLAS_MAX_PAGES 4
 #define PGFT_DEFAULT_RESOLUTION 72 /* dots per inch */
 
 #define PGFT_DBL_DEFAULT_STRENGTH (1.0 / 36.0)
@@ -74,6 +75,40 @@ typedef FT_UInt GlyphIndex_t;
  * Internal data structures
  **********************************************************/
  
+/* Glyph cache lookup counters, kept per font and per instance. */
+typedef struct cachestats_ {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} CacheStats;
+
+struct cachenode_;
+struct atlasentry_;
+
+/* A horizontal strip of an atlas page, filled left to right. */
+typedef struct atlasshelf_ {
+    int y;
+    int height;
+    int x;
+} AtlasShelf;
+
+typedef struct atlaspage_ {
+    SDL_Surface *surface;
+    int bottom;             /* top of the space below the last shelf */
+    int num_shelves;
+    AtlasShelf *shelves;    /* PGFT_ATLAS_PAGE_SIZE entries */
+} AtlasPage;
+
+/* GlyphAtlas: glyphs rendered in a color, packed into shared RGBA
+ * surfaces for blitting. When all pages are full they are emptied and
+ * the generation is bumped, which invalidates every atlas entry.
+ */
+typedef struct glyphatlas_ {
+    int num_pages;
+    FT_UInt32 generation;
+    AtlasPage pages[PGFT_ATLAS_MAX_PAGES];
+} GlyphAtlas;
+
 /* FreeTypeInstance: the global freetype 2 library state.
  *
  * Instances of this struct are created by _PGFT_Init, and
@@ -93,6 +128,18 @@ typedef struct freetypeinstance_ {
     FTC_CMapCache cache_charmap;
 
     int cache_size;
+
+    /* Glyph cache memory shared by all fonts, in least recently used
+     * order: cache_lru is the most recently used glyph.
+     */
+    struct cachenode_ *cache_lru;
+    struct cachenode_ *cache_lru_tail;
+    size_t cache_memory;
+    size_t cache_limit;
+    CacheStats cache_stats;
+
+    GlyphAtlas atlas;
+
     char _error_msg[1024];
 } FreeTypeInstance;
 
@@ -115,27 +162,19 @@ typedef struct rendermode_ {
     FT_Matrix transform;
 } FontRenderMode;
 
-#if defined(Py_DEBUG) && !defined(PGFT_DEBUG_CACHE)
-#define PGFT_DEBUG_CACHE 1
-#endif
-
-struct cachenode_;
-
 typedef struct fontcache_ {
     struct cachenode_ **nodes;
-    struct cachenode_ *free_nodes;
-
-    FT_Byte *depths;
-
-#ifdef PGFT_DEBUG_CACHE
-    FT_UInt32 _debug_count;
-    FT_UInt32 _debug_delete_count;
-    FT_UInt32 _debug_access;
-    FT_UInt32 _debug_hit;
-    FT_UInt32 _debug_miss;
-#endif
+    FreeTypeInstance *ft;
 
     FT_UInt32 size_mask;
+    FT_UInt32 count;
+    size_t memory;
+    CacheStats stats;
+
+    /* Counts glyph releases, so a layout kept for reuse knows to reload
+     * its glyph pointers.
+     */
+    FT_UInt32 releases;
 } FontCache;
 
 typedef struct fontmetrics_ {
@@ -148,6 +187,7 @@ typedef struct fontmetrics_ {
 
 typedef struct fontglyph_ {
     FT_BitmapGlyph image;
+    struct atlasentry_ *atlas;  /* atlas copies, one per color */
 
     FT_Pos width;         /* 26.6 */
     FT_Pos height;        /* 26.6 */
@@ -185,8 +225,40 @@ typedef struct layout_ {
 
     int buffer_size;
     GlyphSlot *glyphs;
+
+    /* Layout cache key: the characters laid out, if has_key is set */
+    int has_key;
+    FT_UInt32 text_hash;
+    Py_ssize_t text_length;
+    Py_ssize_t text_size;
+    PGFT_char *text;
+    FT_UInt32 releases;         /* glyph cache releases when loaded */
+    unsigned long last_use;
 } Layout;
 
+/* A line of a paragraph. Positions are 26.6, from the paragraph's top
+ * left; start and end index the characters of the line.
+ */
+typedef struct paragraphline_ {
+    int start;
+    int end;
+    int last;           /* ends the text or a hard line break */
+    FT_Pos left;
+    FT_Pos width;
+    FT_Pos baseline;
+} ParagraphLine;
+
+/* Paragraph: text broken into aligned lines. The layout holds the glyphs
+ * of all lines, positioned within the paragraph, in its own slot array.
+ */
+typedef struct paragraph_ {
+    Layout layout;
+    int num_lines;
+    ParagraphLine *lines;
+    FT_Pos width;
+    FT_Pos height;
+} Paragraph;
+
 struct fontsurface_;
 
 typedef void (* FontRenderPtr)(int, int, struct fontsurface_ *,
@@ -210,8 +282,15 @@ typedef struct fontsurface_ {
 
 } FontSurface;
 
+/* FontInternals: layouts of recently used strings, least recently used
+ * replaced first, and the glyph cache. active_text is the layout last
+ * loaded, reused when no text is given.
+ */
 typedef struct fontinternals_ {
-    Layout active_text;
+    Layout *active_text;
+    Layout *layouts;
+    int layout_cache_size;
+    unsigned long layout_clock;
     FontCache glyph_cache;
 } FontInternals;
 
@@ -220,16 +299,13 @@ typedef struct PGFT_String_ {
     PGFT_char data[1];
 } PGFT_String;
 
-#if defined(PGFT_DEBUG_CACHE)
-#define PGFT_FONT_CACHE(f) ((f)->_internals->glyph_cache)
-#endif
-
 /**********************************************************
  * Module state
  **********************************************************/
 typedef struct {
     FreeTypeInstance *freetype;
     int cache_size;
+    size_t cache_limit;
     FT_UInt resolution;
 } _FreeTypeState;
 
@@ -315,6 +391,10 @@ int _PGFT_Render_ExistingSurface(FreeTypeInstance *, PgFontObject *,
 int _PGFT_Render_Array(FreeTypeInstance *, PgFontObject *,
                        const FontRenderMode *, PyObject *,
                        PGFT_String *, int, int, int, SDL_Rect *);
+SDL_Surface *_PGFT_Render_Paragraph(FreeTypeInstance *, PgFontObject *,
+                                    const FontRenderMode *, PGFT_String *,
+                                    int, int, FT_Fixed,
+                                    FontColor *, FontColor *, SDL_Rect *);
 int _PGFT_BuildRenderMode(FreeTypeInstance *, PgFontObject *,
                           FontRenderMode *, Scale_t, int, Angle_t);
 int _PGFT_CheckStyle(FT_UInt32);
@@ -372,6 +452,11 @@ int _PGFT_LayoutInit(FreeTypeInstance *, PgFontObject *);
 void _PGFT_LayoutFree(PgFontObject *);
 Layout *_PGFT_LoadLayout(FreeTypeInstance *, PgFontObject *,
                          const FontRenderMode *, PGFT_String *);
+int _PGFT_SetLayoutCacheSize(PgFontObject *, int);
+int _PGFT_LoadParagraph(FreeTypeInstance *, PgFontObject *,
+                        const FontRenderMode *, PGFT_String *,
+                        FT_Pos, int, FT_Fixed, Paragraph *);
+void _PGFT_FreeParagraph(Paragraph *);
 int _PGFT_LoadGlyph(FontGlyph *, GlyphIndex_t, const FontRenderMode *, void *);
 
 
@@ -379,10 +464,21 @@ int _PGFT_LoadGlyph(FontGlyph *, GlyphIndex_t, const FontRenderMode *, void *);
 int _PGFT_Cache_Init(FreeTypeInstance *, FontCache *);
 void _PGFT_Cache_Destroy(FontCache *);
 void _PGFT_Cache_Cleanup(FontCache *);
+void _PGFT_Cache_SetLimit(FreeTypeInstance *, size_t);
 FontGlyph *_PGFT_Cache_FindGlyph(FT_UInt32, const FontRenderMode *,
                                  FontCache *, void *);
 
 
+/**************************************** Glyph atlas ************************/
+void _PGFT_Atlas_Init(GlyphAtlas *);
+void _PGFT_Atlas_Destroy(GlyphAtlas *);
+void _PGFT_Atlas_FreeEntries(FontGlyph *);
+#ifdef HAVE_PYGAME_SDL_VIDEO
+int _PGFT_Atlas_Render(FreeTypeInstance *, Layout *, const FontColor *,
+                       SDL_Surface *, const FT_Vector *);
+#endif
+
+
 /**************************************** Unicode ****************************/
 PGFT_String *_PGFT_EncodePyString(PyObject *, int);
 #define PGFT_String_GET_DATA(s) ((s)->data)
@@ -35,6 +35,7 @@
 #include "surface.h"
 #include "pgcompat.h"
 #include "SDL_gfx/SDL_gfxPrimitives.h"
+#include "pgraster.h"
 
 
 static PyObject* _gfx_pixelcolor (PyObject *self, PyObject* args);
@@ -42,22 +43,28 @@ static PyObject* _gfx_hlinecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_vlinecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_rectanglecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_boxcolor (PyObject *self, PyObject* args);
+static PyObject* _gfx_aaboxcolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_linecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_circlecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_arccolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_aacirclecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_filledcirclecolor (PyObject *self, PyObject* args);
+static PyObject* _gfx_filledaacirclecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_ellipsecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_aaellipsecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_filledellipsecolor (PyObject *self, PyObject* args);
+static PyObject* _gfx_filledaaellipsecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_piecolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_trigoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_aatrigoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_filledtrigoncolor (PyObject *self, PyObject* args);
+static PyObject* _gfx_filledaatrigoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_polygoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_aapolygoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_filledpolygoncolor (PyObject *self, PyObject* args);
+static PyObject* _gfx_filledaapolygoncolor (PyObject *self, PyObject* args);
 static PyObject* _gfx_texturedpolygon (PyObject *self, PyObject* args);
+static PyObject* _gfx_texturedtriangles (PyObject *self, PyObject* args);
 static PyObject* _gfx_beziercolor (PyObject *self, PyObject* args);
 
 static PyMethodDef _gfxdraw_methods[] = {
@@ -66,22 +73,28 @@ static PyMethodDef _gfxdraw_methods[] = {
     { "vline", _gfx_vlinecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWVLINE },
     { "rectangle", _gfx_rectanglecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWRECTANGLE },
     { "box", _gfx_boxcolor, METH_VARARGS, DOC_PYGAMEGFXDRAWRECTANGLE },
+    { "aabox", _gfx_aaboxcolor, METH_VARARGS, DOC_PYGAMEGFXDRAWAABOX },
     { "line", _gfx_linecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWLINE },
     { "circle", _gfx_circlecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWCIRCLE },
     { "arc", _gfx_arccolor, METH_VARARGS, DOC_PYGAMEGFXDRAWARC },
     { "aacircle", _gfx_aacirclecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWAACIRCLE },
     { "filled_circle", _gfx_filledcirclecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDCIRCLE },
+    { "filled_aacircle", _gfx_filledaacirclecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDAACIRCLE },
     { "ellipse", _gfx_ellipsecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWELLIPSE },
     { "aaellipse", _gfx_aaellipsecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWAAELLIPSE },
     { "filled_ellipse", _gfx_filledellipsecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDELLIPSE },
+    { "filled_aaellipse", _gfx_filledaaellipsecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDAAELLIPSE },
     { "pie", _gfx_piecolor, METH_VARARGS, DOC_PYGAMEGFXDRAWPIE },
     { "trigon", _gfx_trigoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWTRIGON },
     { "aatrigon", _gfx_aatrigoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWAATRIGON },
     { "filled_trigon", _gfx_filledtrigoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDTRIGON },
+    { "filled_aatrigon", _gfx_filledaatrigoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDAATRIGON },
     { "polygon", _gfx_polygoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWPOLYGON },
     { "aapolygon", _gfx_aapolygoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWAAPOLYGON },
     { "filled_polygon", _gfx_filledpolygoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDPOLYGON },
+    { "filled_aapolygon", _gfx_filledaapolygoncolor, METH_VARARGS, DOC_PYGAMEGFXDRAWFILLEDAAPOLYGON },
     { "textured_polygon", _gfx_texturedpolygon, METH_VARARGS, DOC_PYGAMEGFXDRAWTEXTUREDPOLYGON },
+    { "textured_triangles", _gfx_texturedtriangles, METH_VARARGS, DOC_PYGAMEGFXDRAWTEXTUREDTRIANGLES },
     { "bezier", _gfx_beziercolor, METH_VARARGS, DOC_PYGAMEGFXDRAWBEZIER },
     { NULL, NULL, 0, NULL },
 };
@@ -1058,6 +1071,198 @@ _gfx_texturedpolygon (PyObject *self, PyObject* args)
     Py_RETURN_NONE;
 }
 
+/* Floats for each vertex passed to texturedTriangles: x, y, u, v and z. */
+#define TEXTURED_VERTEX_FIELDS 5
+
+/* Copies floats already packed in buf into a new array of vertices,
+ * returning the number of vertices, or -1 with an exception set.
+ */
+static Py_ssize_t
+_gfx_verticesfrombuf (const void *buf, Py_ssize_t buflen, float **verts)
+{
+    Py_ssize_t count;
+
+    if (buflen % (TEXTURED_VERTEX_FIELDS * sizeof (float)))
+    {
+        PyErr_Format (PyExc_ValueError,
+            "vertices buffer length must be a multiple of %d bytes",
+            (int) (TEXTURED_VERTEX_FIELDS * sizeof (float)));
+        return -1;
+    }
+    count = buflen / (TEXTURED_VERTEX_FIELDS * sizeof (float));
+    *verts = PyMem_New (float, count * TEXTURED_VERTEX_FIELDS + 1);
+    if (!*verts)
+    {
+        PyErr_NoMemory ();
+        return -1;
+    }
+    memcpy (*verts, buf, buflen);
+    return count;
+}
+
+/* Reads the vertices argument of textured_triangles into a new array,
+ * returning the number of vertices, or -1 with an exception set.  A
+ * buffer holds the floats already packed, a sequence holds (x, y, u, v)
+ * or (x, y, u, v, z) sequences, z being 1 if left out.
+ */
+static Py_ssize_t
+_gfx_verticesfromobj (PyObject *vertices, float **verts)
+{
+    PyObject *item;
+    Py_ssize_t count, i, length;
+    int field;
+    float *vert;
+
+    *verts = NULL;
+#if PG_ENABLE_NEWBUF
+    if (PyObject_CheckBuffer (vertices))
+    {
+        Py_buffer view;
+
+        view.obj = 0;
+        if (PyObject_GetBuffer (vertices, &view, PyBUF_SIMPLE))
+            return -1;
+        count = _gfx_verticesfrombuf (view.buf, view.len, verts);
+        PyBuffer_Release (&view);
+        return count;
+    }
+#endif
+#if PY2
+    if (PyObject_CheckReadBuffer (vertices))
+    {
+        const void *buf;
+        Py_ssize_t buflen;
+
+        if (PyObject_AsReadBuffer (vertices, &buf, &buflen))
+            return -1;
+        return _gfx_verticesfrombuf (buf, buflen, verts);
+    }
+#endif
+
+    if (!PySequence_Check (vertices))
+    {
+        PyErr_SetString (PyExc_TypeError,
+            "vertices must be a buffer or a sequence");
+        return -1;
+    }
+    count = PySequence_Size (vertices);
+    if (count < 0)
+        return -1;
+    *verts = PyMem_New (float, count * TEXTURED_VERTEX_FIELDS + 1);
+    if (!*verts)
+    {
+        PyErr_NoMemory ();
+        return -1;
+    }
+    for (i = 0; i < count; i++)
+    {
+        vert = *verts + i * TEXTURED_VERTEX_FIELDS;
+        vert[4] = 1;
+        item = PySequence_GetItem (vertices, i);
+        if (!item)
+            goto fail;
+        length = PySequence_Check (item) ? PySequence_Size (item) : -1;
+        if (length != 4 && length != 5)
+        {
+            Py_DECREF (item);
+            PyErr_SetString (PyExc_TypeError,
+                "vertices must be sequences of 4 or 5 numbers");
+            goto fail;
+        }
+        for (field = 0; field < length; field++)
+        {
+            if (!FloatFromObjIndex (item, field, vert + field))
+            {
+                Py_DECREF (item);
+                PyErr_SetString (PyExc_TypeError,
+                    "vertices must be sequences of 4 or 5 numbers");
+                goto fail;
+            }
+        }
+        Py_DECREF (item);
+    }
+    return count;
+
+fail:
+    PyMem_Free (*verts);
+    *verts = NULL;
+    return -1;
+}
+
+static PyObject*
+_gfx_texturedtriangles (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *texture, *vertices;
+    SDL_Surface *s_surface, *s_texture;
+    Py_ssize_t count, i;
+    int perspective = 0, ret;
+    float *verts;
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OOO|i:textured_triangles", &surface,
+            &texture, &vertices, &perspective))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    s_surface = PySurface_AsSurface (surface);
+    if (!PySurface_Check (texture))
+    {
+        PyErr_SetString (PyExc_TypeError, "texture must be a Surface");
+        return NULL;
+    }
+    s_texture = PySurface_AsSurface (texture);
+    if (s_surface->format->BytesPerPixel == 1 &&
+        (s_texture->format->Amask || s_texture->flags & SDL_SRCALPHA)) {
+        PyErr_SetString (PyExc_ValueError,
+                           "Per-byte alpha texture unsupported "
+                           "for 8 bit surfaces");
+        return NULL;
+    }
+
+    count = _gfx_verticesfromobj (vertices, &verts);
+    if (count < 0)
+        return NULL;
+    if (count % 3)
+    {
+        PyMem_Free (verts);
+        PyErr_SetString (PyExc_ValueError,
+            "vertices must come in threes, one triangle each");
+        return NULL;
+    }
+    if (perspective)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (!(verts[i * TEXTURED_VERTEX_FIELDS + 4] > 0))
+            {
+                PyMem_Free (verts);
+                PyErr_SetString (PyExc_ValueError,
+                    "perspective needs positive depths");
+                return NULL;
+            }
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    ret = texturedTriangles (s_surface, verts, (int) (count / 3), s_texture,
+                             perspective);
+    Py_END_ALLOW_THREADS;
+
+    PyMem_Free (verts);
+
+    if (ret == -1)
+    {
+        PyErr_SetString (PyExc_SDLError, SDL_GetError ());
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
 
 static PyObject*
 _gfx_beziercolor (PyObject *self, PyObject* args)
@@ -1148,6 +1353,255 @@ _gfx_beziercolor (PyObject *self, PyObject* args)
     Py_RETURN_NONE;
 }
 
+typedef struct
+{
+    SDL_Surface *surface;
+    Uint8 rgba[4];
+    int error;
+} _gfx_aafilldata;
+
+/* Draws each run of equal coverage from the rasterizer as an hline, with
+ * the color's alpha scaled by the coverage, so the edges are blended the
+ * same way as the inside of the shape.
+ */
+static void
+_gfx_aafillspan (void *data, int x, int y, int count, const Uint8 *cover)
+{
+    _gfx_aafilldata *fill = (_gfx_aafilldata *) data;
+    Uint8 *rgba = fill->rgba;
+    Uint8 a;
+    int i, run;
+
+    for (i = 0; i < count; i += run)
+    {
+        for (run = 1; i + run < count && cover[i + run] == cover[i]; run++)
+            ;
+        a = (Uint8) ((rgba[3] * cover[i] + 127) / 255);
+        if (a && hlineRGBA (fill->surface, (Sint16) (x + i),
+                (Sint16) (x + i + run - 1), (Sint16) y,
+                rgba[0], rgba[1], rgba[2], a) == -1)
+            fill->error = 1;
+    }
+}
+
+/* Fills the shapes added to raster without the GIL, and frees it. */
+static PyObject*
+_gfx_aafill (PyObject *surface, pg_raster *raster, int evenodd, Uint8 *rgba)
+{
+    _gfx_aafilldata fill;
+    int ret;
+
+    fill.surface = PySurface_AsSurface (surface);
+    memcpy (fill.rgba, rgba, 4);
+    fill.error = 0;
+
+    Py_BEGIN_ALLOW_THREADS;
+    ret = pg_raster_fill (raster, evenodd, _gfx_aafillspan, &fill);
+    Py_END_ALLOW_THREADS;
+    pg_raster_free (raster);
+
+    if (ret == -1)
+        return PyErr_NoMemory ();
+    if (fill.error)
+    {
+        PyErr_SetString (PyExc_SDLError, SDL_GetError ());
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+_gfx_aaboxcolor (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *color, *rect;
+    GAME_Rect temprect, *sdlrect;
+    pg_raster raster;
+    float rad;
+    Uint8 rgba[4];
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OOfO:aabox", &surface, &rect, &rad, &color))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    sdlrect = GameRect_FromObject (rect, &temprect);
+    if (sdlrect == NULL)
+        return NULL;
+    if (!RGBAFromObj (color, rgba))
+    {
+        PyErr_SetString (PyExc_TypeError, "invalid color argument");
+        return NULL;
+    }
+
+    pg_raster_init (&raster, &PySurface_AsSurface (surface)->clip_rect);
+    pg_raster_rounded_rect (&raster, (float) sdlrect->x, (float) sdlrect->y,
+        (float) sdlrect->w, (float) sdlrect->h, rad);
+    return _gfx_aafill (surface, &raster, 0, rgba);
+}
+
+static PyObject*
+_gfx_filledaacirclecolor (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *color;
+    pg_raster raster;
+    float x, y, r;
+    Uint8 rgba[4];
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OfffO:filled_aacircle", &surface, &x, &y,
+            &r, &color))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    if (!RGBAFromObj (color, rgba))
+    {
+        PyErr_SetString (PyExc_TypeError, "invalid color argument");
+        return NULL;
+    }
+
+    /* centered on the middle of pixel (x, y) */
+    pg_raster_init (&raster, &PySurface_AsSurface (surface)->clip_rect);
+    pg_raster_ellipse (&raster, x + 0.5f, y + 0.5f, r, r);
+    return _gfx_aafill (surface, &raster, 0, rgba);
+}
+
+static PyObject*
+_gfx_filledaaellipsecolor (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *color;
+    pg_raster raster;
+    float x, y, rx, ry;
+    Uint8 rgba[4];
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OffffO:filled_aaellipse", &surface, &x, &y,
+            &rx, &ry, &color))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    if (!RGBAFromObj (color, rgba))
+    {
+        PyErr_SetString (PyExc_TypeError, "invalid color argument");
+        return NULL;
+    }
+
+    pg_raster_init (&raster, &PySurface_AsSurface (surface)->clip_rect);
+    pg_raster_ellipse (&raster, x + 0.5f, y + 0.5f, rx, ry);
+    return _gfx_aafill (surface, &raster, 0, rgba);
+}
+
+static PyObject*
+_gfx_filledaatrigoncolor (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *color;
+    pg_raster raster;
+    float x1, x2, x3, _y1, y2, y3;
+    Uint8 rgba[4];
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OffffffO:filled_aatrigon", &surface, &x1,
+            &_y1, &x2, &y2, &x3, &y3, &color))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    if (!RGBAFromObj (color, rgba))
+    {
+        PyErr_SetString (PyExc_TypeError, "invalid color argument");
+        return NULL;
+    }
+
+    pg_raster_init (&raster, &PySurface_AsSurface (surface)->clip_rect);
+    pg_raster_move_to (&raster, x1 + 0.5f, _y1 + 0.5f);
+    pg_raster_line_to (&raster, x2 + 0.5f, y2 + 0.5f);
+    pg_raster_line_to (&raster, x3 + 0.5f, y3 + 0.5f);
+    return _gfx_aafill (surface, &raster, 1, rgba);
+}
+
+static PyObject*
+_gfx_filledaapolygoncolor (PyObject *self, PyObject* args)
+{
+    PyObject *surface, *color, *points, *item;
+    pg_raster raster;
+    Py_ssize_t count, i;
+    float x, y;
+    int ret;
+    Uint8 rgba[4];
+
+    ASSERT_VIDEO_INIT (NULL);
+
+    if (!PyArg_ParseTuple (args, "OOO:filled_aapolygon", &surface, &points,
+            &color))
+        return NULL;
+
+    if (!PySurface_Check (surface))
+    {
+        PyErr_SetString (PyExc_TypeError, "surface must be a Surface");
+        return NULL;
+    }
+    if (!RGBAFromObj (color, rgba))
+    {
+        PyErr_SetString (PyExc_TypeError, "invalid color argument");
+        return NULL;
+    }
+    if (!PySequence_Check (points))
+    {
+        PyErr_SetString (PyExc_TypeError, "points must be a sequence");
+        return NULL;
+    }
+
+    count = PySequence_Size (points);
+    if (count < 3)
+    {
+        PyErr_SetString (PyExc_ValueError,
+            "points must contain more than 2 points");
+        return NULL;
+    }
+
+    pg_raster_init (&raster, &PySurface_AsSurface (surface)->clip_rect);
+    for (i = 0; i < count; i++)
+    {
+        item = PySequence_GetItem (points, i);
+        if (!item)
+        {
+            pg_raster_free (&raster);
+            return NULL;
+        }
+        ret = TwoFloatsFromObj (item, &x, &y);
+        Py_DECREF (item);
+        if (!ret)
+        {
+            pg_raster_free (&raster);
+            PyErr_SetString (PyExc_TypeError, "points must be number pairs");
+            return NULL;
+        }
+        if (i == 0)
+            pg_raster_move_to (&raster, x + 0.5f, y + 0.5f);
+        else
+            pg_raster_line_to (&raster, x + 0.5f, y + 0.5f);
+    }
+    return _gfx_aafill (surface, &raster, 1, rgba);
+}
+
 MODINIT_DEFINE(gfxdraw)
 {
     PyObject *module;
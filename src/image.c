@@ -28,9 +28,28 @@
 #include "pgcompat.h"
 #include "doc/image_doc.h"
 #include "pgopengl.h"
+#include "pgparallel.h"
+#include "pgimage.h"
+#include "mask.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_SSE2
+#endif
+
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 struct _module_state {
     int is_extended;
+    pg_load_file_func load_file;
+    pg_save_file_func save_file;
+    pg_load_rw_func load_rw;
+    pg_load_png_into_func load_png_into;
 };
 
 #if PY3
@@ -42,6 +61,9 @@ static struct _module_state _state = { 0 };
 
 static int SaveTGA (SDL_Surface *surface, const char *file, int rle);
 static int SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle);
+static int SaveQOI (SDL_Surface *surface, const char *file);
+static SDL_Surface* LoadTGA_RW (SDL_RWops *src, int freesrc);
+static SDL_Surface* LoadQOI_RW (SDL_RWops *src, int freesrc);
 static SDL_Surface* opengltosdl (void);
 
 #define DATAROW(data, row, width, height, flipped)               \
@@ -66,40 +88,1663 @@ image_load_basic(PyObject *self, PyObject *arg)
     if (oencoded == NULL) {
         return NULL;
     }
-    if (oencoded != Py_None) {
-        Py_BEGIN_ALLOW_THREADS;
-        surf = SDL_LoadBMP(Bytes_AS_STRING(oencoded));
-        Py_END_ALLOW_THREADS;
+    if (oencoded != Py_None) {
+        Py_BEGIN_ALLOW_THREADS;
+        surf = SDL_LoadBMP(Bytes_AS_STRING(oencoded));
+        Py_END_ALLOW_THREADS;
+        Py_DECREF(oencoded);
+    }
+    else {
+        Py_DECREF(oencoded);
+        rw = RWopsFromFileObject(obj);
+        if (rw == NULL) {
+            return NULL;
+        }
+        if (RWopsCheckObject(rw)) {
+            surf = SDL_LoadBMP_RW (rw, 1);
+        }
+        else {
+            Py_BEGIN_ALLOW_THREADS;
+            surf = SDL_LoadBMP_RW(rw, 1);
+            Py_END_ALLOW_THREADS;
+        }
+    }
+
+    if (surf == NULL) {
+        return RAISE(PyExc_SDLError, SDL_GetError());
+    }
+
+    final = PySurface_New(surf);
+    if (final == NULL) {
+        SDL_FreeSurface(surf);
+    }
+    return final;
+}
+
+
+static SDL_Surface*
+load_bmp_file(const char *path)
+{
+    return SDL_LoadBMP(path);
+}
+
+/* Case insensitive test for a file name ending in ext */
+static int
+has_extension(const char *name, const char *ext)
+{
+    size_t namelen = strlen(name);
+    size_t extlen = strlen(ext);
+    size_t i;
+
+    if (namelen <= extlen) {
+        return 0;
+    }
+    name += namelen - extlen;
+    for (i = 0; i < extlen; ++i) {
+        if (tolower((unsigned char)name[i]) != ext[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef SDL_Surface* (*builtin_load_func) (SDL_RWops *src, int freesrc);
+
+/* The decoder built in here for a file name, or NULL.  QOI is always
+ * decoded here; TGA only when SDL_image is not there to do it.
+ */
+static builtin_load_func
+builtin_loader(const char *name, int is_extended)
+{
+    if (has_extension(name, "qoi")) {
+        return LoadQOI_RW;
+    }
+    if (!is_extended && has_extension(name, "tga")) {
+        return LoadTGA_RW;
+    }
+    return NULL;
+}
+
+/* Load by file name with the built in decoders, or else load, which is
+ * load_bmp_file without SDL_image.  Needs no GIL.
+ */
+static SDL_Surface*
+load_file(pg_load_file_func load, const char *path)
+{
+    builtin_load_func builtin = builtin_loader(path, load != load_bmp_file);
+    SDL_RWops *rw;
+
+    if (builtin == NULL) {
+        return load(path);
+    }
+    rw = SDL_RWFromFile(path, "rb");
+    if (rw == NULL) {
+        return NULL;
+    }
+    return builtin(rw, 1);
+}
+
+/* A pixel format loaded images are converted to, as Surface.convert or
+ * Surface.convert_alpha would. It is set up while holding the GIL; the
+ * conversion itself can then run on any thread.
+ */
+typedef struct {
+    SDL_PixelFormat *format;    /* NULL for no conversion */
+    Uint32 flags;
+    Uint32 keep_flags;          /* flags of the loaded image to keep */
+    SDL_Surface *owner;         /* owns format, if not NULL */
+} convert_target;
+
+static int
+get_convert_target(PyObject *convert, int convert_alpha,
+                   convert_target *target)
+{
+    SDL_Surface *video;
+    SDL_PixelFormat *vf;
+    Uint32 rmask = 0x00ff0000;
+    Uint32 gmask = 0x0000ff00;
+    Uint32 bmask = 0x000000ff;
+    Uint32 amask = 0xff000000;
+    int truth = 0;
+
+    memset(target, 0, sizeof(convert_target));
+    if (convert != NULL && !PySurface_Check(convert)) {
+        truth = PyObject_IsTrue(convert);
+        if (truth == -1) {
+            return -1;
+        }
+    }
+    if (!convert_alpha && !truth) {
+        if (convert != NULL && PySurface_Check(convert)) {
+            SDL_Surface *src = PySurface_AsSurface(convert);
+
+            if (src == NULL) {
+                RAISE(PyExc_SDLError, "display Surface quit");
+                return -1;
+            }
+            target->format = src->format;
+            target->flags = src->flags & ~SDL_HWSURFACE;
+            target->keep_flags = SDL_SRCCOLORKEY | SDL_SRCALPHA;
+        }
+        return 0;
+    }
+
+    if (!SDL_WasInit(SDL_INIT_VIDEO)) {
+        RAISE(PyExc_SDLError,
+              "cannot convert without pygame.display initialized");
+        return -1;
+    }
+    video = SDL_GetVideoSurface();
+    if (video == NULL) {
+        RAISE(PyExc_SDLError, "No video mode has been set");
+        return -1;
+    }
+    if (video->flags & SDL_OPENGL) {
+        RAISE(PyExc_SDLError, "Cannot convert opengl display");
+        return -1;
+    }
+    if (!convert_alpha) {
+        target->format = video->format;
+        target->keep_flags = SDL_SRCCOLORKEY | SDL_SRCALPHA | SDL_RLEACCELOK;
+        return 0;
+    }
+
+    /* The format SDL_DisplayFormatAlpha picks: ARGB, or ABGR to match
+     * the channel order of the display.
+     */
+    vf = video->format;
+    switch (vf->BytesPerPixel) {
+
+    case 2:
+        if (vf->Rmask == 0x1f &&
+            (vf->Bmask == 0xf800 || vf->Bmask == 0x7c00)) {
+            rmask = 0xff;
+            bmask = 0xff0000;
+        }
+        break;
+    case 3:
+    case 4:
+        if (vf->Rmask == 0xff && vf->Bmask == 0xff0000) {
+            rmask = 0xff;
+            bmask = 0xff0000;
+        }
+        break;
+    }
+    target->owner = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32,
+                                            rmask, gmask, bmask, amask);
+    if (target->owner == NULL) {
+        RAISE(PyExc_SDLError, SDL_GetError());
+        return -1;
+    }
+    target->format = target->owner->format;
+    target->keep_flags = SDL_SRCALPHA | SDL_RLEACCELOK;
+    return 0;
+}
+
+static void
+free_convert_target(convert_target *target)
+{
+    if (target->owner != NULL) {
+        SDL_FreeSurface(target->owner);
+        target->owner = NULL;
+    }
+    target->format = NULL;
+}
+
+/* Convert a loaded surface, freeing it. Needs no GIL. */
+static SDL_Surface*
+convert_loaded(SDL_Surface *surf, const convert_target *target)
+{
+    SDL_Surface *converted;
+
+    if (surf == NULL || target->format == NULL) {
+        return surf;
+    }
+    converted = SDL_ConvertSurface(surf, target->format,
+                                   target->flags |
+                                   (surf->flags & target->keep_flags));
+    SDL_FreeSurface(surf);
+    return converted;
+}
+
+static SDL_Surface* load_qoi (SDL_RWops *src, int freesrc,
+                              const convert_target *target);
+
+/* Load from src, closing it, and convert to target: decoded straight into
+ * the target format where the decoder can do that, converted afterwards
+ * otherwise. name, which may be NULL, picks the decoder. Needs no GIL.
+ */
+static SDL_Surface*
+load_rw_converted(const struct _module_state *st, SDL_RWops *src,
+                  const char *name, const convert_target *target)
+{
+    builtin_load_func builtin = NULL;
+    SDL_Surface *surf = NULL;
+    const char *dot;
+
+    if (name != NULL) {
+        builtin = builtin_loader(name, st->is_extended);
+    }
+    if (builtin == LoadQOI_RW) {
+        return load_qoi(src, 1, target);
+    }
+    if (builtin == NULL && st->load_png_into != NULL &&
+        target->format != NULL) {
+        switch (st->load_png_into(src, target->format, target->flags,
+                                  target->keep_flags, &surf)) {
+        case 0:
+            SDL_RWclose(src);
+            return surf;
+        case -1:
+            SDL_RWclose(src);
+            return NULL;
+        }
+    }
+
+    if (builtin != NULL) {
+        surf = builtin(src, 1);
+    }
+    else if (st->load_rw != NULL) {
+        dot = name != NULL ? strrchr(name, '.') : NULL;
+        surf = st->load_rw(src, 1, dot != NULL ? (char *)dot + 1 : NULL);
+    }
+    else {
+        surf = SDL_LoadBMP_RW(src, 1);
+    }
+    return convert_loaded(surf, target);
+}
+
+/* image.load: the built in decoders, then SDL_image or SDL_LoadBMP */
+static PyObject*
+image_load(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {
+        "file", "namehint", "convert", "convert_alpha", NULL
+    };
+    struct _module_state *st = GETSTATE(self);
+    PyObject *obj;
+    PyObject *final;
+    PyObject *oencoded;
+    PyObject *convert = NULL;
+    int convert_alpha = 0;
+    const char *namehint = NULL;
+    const char *name;
+    convert_target target;
+    builtin_load_func builtin;
+    SDL_Surface *surf;
+    SDL_RWops *rw;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|zOi", kwlist, &obj,
+                                     &namehint, &convert, &convert_alpha)) {
+        return NULL;
+    }
+    if (get_convert_target(convert, convert_alpha, &target)) {
+        return NULL;
+    }
+
+    oencoded = RWopsEncodeFilePath(obj, PyExc_SDLError);
+    if (oencoded == NULL) {
+        free_convert_target(&target);
+        return NULL;
+    }
+    name = oencoded != Py_None ? Bytes_AS_STRING(oencoded) : namehint;
+    builtin = name != NULL ? builtin_loader(name, st->is_extended) : NULL;
+
+    if (builtin == NULL && target.format == NULL) {
+        /* load_extended or load_basic, as before */
+        PyObject *load = NULL;
+        PyObject *loadargs;
+
+        Py_DECREF(oencoded);
+        if (namehint != NULL) {
+            loadargs = Py_BuildValue("(Os)", obj, namehint);
+        }
+        else {
+            loadargs = PyTuple_Pack(1, obj);
+        }
+        if (loadargs == NULL) {
+            return NULL;
+        }
+        if (st->is_extended) {
+            PyObject *imgext = PyImport_ImportModule(IMPPREFIX "imageext");
+
+            if (imgext != NULL) {
+                load = PyObject_GetAttrString(imgext, "load_extended");
+                Py_DECREF(imgext);
+            }
+            final = load != NULL ? PyObject_Call(load, loadargs, NULL) : NULL;
+            Py_XDECREF(load);
+        }
+        else {
+            final = image_load_basic(self, loadargs);
+        }
+        Py_DECREF(loadargs);
+        return final;
+    }
+
+    if (oencoded != Py_None) {
+        Py_BEGIN_ALLOW_THREADS;
+        rw = SDL_RWFromFile(name, "rb");
+        if (rw == NULL) {
+            surf = NULL;
+        }
+        else if (target.format != NULL) {
+            surf = load_rw_converted(st, rw, name, &target);
+        }
+        else {
+            surf = builtin(rw, 1);
+        }
+        Py_END_ALLOW_THREADS;
+        Py_DECREF(oencoded);
+    }
+    else {
+        Py_DECREF(oencoded);
+        rw = RWopsFromFileObject(obj);
+        if (rw == NULL) {
+            free_convert_target(&target);
+            return NULL;
+        }
+        if (RWopsCheckObject(rw)) {
+            surf = target.format != NULL ?
+                load_rw_converted(st, rw, name, &target) : builtin(rw, 1);
+        }
+        else {
+            Py_BEGIN_ALLOW_THREADS;
+            surf = target.format != NULL ?
+                load_rw_converted(st, rw, name, &target) : builtin(rw, 1);
+            Py_END_ALLOW_THREADS;
+        }
+    }
+    free_convert_target(&target);
+
+    if (surf == NULL) {
+        return RAISE(PyExc_SDLError, SDL_GetError());
+    }
+
+    final = PySurface_New(surf);
+    if (final == NULL) {
+        SDL_FreeSurface(surf);
+    }
+    return final;
+}
+
+typedef struct {
+    PyObject *encoded;
+    SDL_Surface *surf;
+    char error[128];
+} load_many_item;
+
+typedef struct {
+    struct _module_state loaders;
+    convert_target target;
+    load_many_item *items;
+    int failed;             /* lowest failed task, or -1 */
+    SDL_mutex *lock;        /* guards failed, NULL with one worker */
+} load_many_job;
+
+/* Records task as failed, if it is not -1, and returns the lowest
+ * failed task so far, or -1.
+ */
+static int
+load_many_fail(load_many_job *job, int task)
+{
+    int failed;
+
+    if (job->lock != NULL) {
+        SDL_mutexP(job->lock);
+    }
+    if (task >= 0 && (job->failed < 0 || task < job->failed)) {
+        job->failed = task;
+    }
+    failed = job->failed;
+    if (job->lock != NULL) {
+        SDL_mutexV(job->lock);
+    }
+    return failed;
+}
+
+static void
+load_many_task(void *data, int task)
+{
+    load_many_job *job = (load_many_job *)data;
+    load_many_item *item = &job->items[task];
+    const char *path;
+    SDL_RWops *rw;
+
+    if (load_many_fail(job, -1) >= 0) {
+        /* The whole call fails anyway */
+        return;
+    }
+    path = Bytes_AS_STRING(item->encoded);
+    if (job->target.format == NULL) {
+        item->surf = load_file(job->loaders.load_file, path);
+    }
+    else {
+        rw = SDL_RWFromFile(path, "rb");
+        item->surf = rw != NULL ?
+            load_rw_converted(&job->loaders, rw, path, &job->target) : NULL;
+    }
+    if (item->surf == NULL) {
+        strncpy(item->error, SDL_GetError(), sizeof(item->error) - 1);
+        load_many_fail(job, task);
+    }
+}
+
+static PyObject*
+image_load_many(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {
+        "paths", "convert", "convert_alpha", "workers", NULL
+    };
+    PyObject *paths;
+    PyObject *convert = NULL;
+    int convert_alpha = 0;
+    int workers = 0;
+    PyObject *seq = NULL;
+    PyObject *list = NULL;
+    PyObject *surfobj;
+    load_many_job job;
+    load_many_item *item;
+    Py_ssize_t count;
+    Py_ssize_t i;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Oii", kwlist, &paths,
+                                     &convert, &convert_alpha, &workers)) {
+        return NULL;
+    }
+    if (workers < 0) {
+        return RAISE(PyExc_ValueError, "workers must not be negative");
+    }
+    if (workers == 0) {
+        workers = pg_cpu_count();
+    }
+    seq = PySequence_Fast(paths, "paths must be a sequence of file paths");
+    if (seq == NULL) {
+        return NULL;
+    }
+    count = PySequence_Fast_GET_SIZE(seq);
+    if (count > INT_MAX) {
+        Py_DECREF(seq);
+        return RAISE(PyExc_ValueError, "too many paths");
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.loaders = *GETSTATE(self);
+    job.items = PyMem_New(load_many_item, count ? count : 1);
+    if (job.items == NULL) {
+        Py_DECREF(seq);
+        return PyErr_NoMemory();
+    }
+    memset(job.items, 0, sizeof(load_many_item) * count);
+    for (i = 0; i < count; ++i) {
+        item = &job.items[i];
+        item->encoded = RWopsEncodeFilePath(
+            PySequence_Fast_GET_ITEM(seq, i), PyExc_SDLError);
+        if (item->encoded == NULL) {
+            goto error;
+        }
+        if (item->encoded == Py_None) {
+            PyErr_SetString(PyExc_TypeError,
+                            "paths must be a sequence of file paths");
+            goto error;
+        }
+    }
+    if (get_convert_target(convert, convert_alpha, &job.target)) {
+        goto error;
+    }
+
+    job.failed = -1;
+    job.lock = workers > 1 && count > 1 ? SDL_CreateMutex() : NULL;
+    if (job.lock == NULL) {
+        workers = 1;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    pg_run_tasks(load_many_task, &job, (int)count, workers);
+    Py_END_ALLOW_THREADS;
+    if (job.lock != NULL) {
+        SDL_DestroyMutex(job.lock);
+    }
+
+    if (job.failed >= 0) {
+        /* SDL keeps the error string per thread, and workers finish in
+         * any order, so each task copied its own error on its worker.
+         */
+        item = &job.items[job.failed];
+        PyErr_SetString(PyExc_SDLError, item->error[0] != '\0' ?
+                        item->error : "Unable to load image");
+        goto error;
+    }
+    list = PyList_New(count);
+    if (list == NULL) {
+        goto error;
+    }
+    for (i = 0; i < count; ++i) {
+        item = &job.items[i];
+        surfobj = PySurface_New(item->surf);
+        if (surfobj == NULL) {
+            goto error;
+        }
+        item->surf = NULL;
+        PyList_SET_ITEM(list, i, surfobj);
+    }
+
+    free_convert_target(&job.target);
+    for (i = 0; i < count; ++i) {
+        Py_DECREF(job.items[i].encoded);
+    }
+    PyMem_Del(job.items);
+    Py_DECREF(seq);
+    return list;
+
+error:
+    free_convert_target(&job.target);
+    for (i = 0; i < count; ++i) {
+        item = &job.items[i];
+        Py_XDECREF(item->encoded);
+        if (item->surf != NULL) {
+            SDL_FreeSurface(item->surf);
+        }
+    }
+    PyMem_Del(job.items);
+    Py_XDECREF(list);
+    Py_DECREF(seq);
+    return NULL;
+}
+
+/* Save by file name, as image.save does.  Needs no GIL. */
+static int
+save_file(SDL_Surface *surf, const char *name,
+          const pg_save_options *options, pg_save_file_func save_ext)
+{
+    int result;
+
+    if (has_extension(name, "bmp")) {
+        return SDL_SaveBMP(surf, name);
+    }
+    if (has_extension(name, "qoi")) {
+        return SaveQOI(surf, name);
+    }
+    if (has_extension(name, "png") || has_extension(name, "jpg") ||
+        has_extension(name, "jpeg")) {
+        if (save_ext == NULL) {
+            SDL_SetError("No support for png or jpg without imageext");
+            return -1;
+        }
+        result = save_ext(surf, name, options);
+        if (result != 1) {
+            return result;
+        }
+    }
+    return SaveTGA(surf, name, 1);
+}
+
+#ifdef WITH_THREAD
+/* image.load_async and image.save_async: one background thread works
+ * through a queue of requests, posting a user event as each finishes.
+ * The Python objects in a request are only touched with the GIL held;
+ * a buffer object is read through a memory RWops, which only takes the
+ * GIL to release the buffer when it is closed.
+ */
+typedef struct async_request {
+    struct async_request *next;
+    pg_load_file_func load_file;
+    pg_save_file_func save_ext;
+    SDL_Surface *save_surf;     /* The snapshot to save, or NULL to load */
+    SDL_RWops *rw;              /* The buffer object to load, or NULL */
+    struct _module_state state; /* Picks the decoder for rw */
+    pg_save_options options;
+    PyObject *encoded;          /* The path, or for rw the name hint */
+    PyObject *path;
+    PyObject *tag;
+    int type;
+} async_request;
+
+static SDL_mutex *async_lock = NULL;
+static SDL_sem *async_sem = NULL;
+static SDL_Thread *async_thread = NULL;
+static async_request *async_head = NULL;
+static async_request *async_tail = NULL;
+static int async_stop = 0;
+
+static void
+free_async_request(async_request *req)
+{
+    if (req->save_surf != NULL) {
+        SDL_FreeSurface(req->save_surf);
+    }
+    if (req->rw != NULL) {
+        SDL_RWclose(req->rw);
+    }
+    Py_DECREF(req->encoded);
+    Py_DECREF(req->path);
+    Py_DECREF(req->tag);
+    PyMem_Del(req);
+}
+
+/* Post the result of a request as a user event.  Needs the GIL. */
+static void
+post_async_result(async_request *req, SDL_Surface *surf, const char *error)
+{
+    PyObject *obj = NULL;
+    PyObject *dict = NULL;
+    PyObject *event = NULL;
+    SDL_Event sdlevent;
+
+    dict = Py_BuildValue("{sOsO}", "tag", req->tag, "path", req->path);
+    if (dict == NULL) {
+        goto error;
+    }
+    if (req->save_surf == NULL) {
+        if (surf != NULL) {
+            obj = PySurface_New(surf);
+            if (obj == NULL) {
+                SDL_FreeSurface(surf);
+                goto error;
+            }
+        }
+        else {
+            obj = Py_None;
+            Py_INCREF(obj);
+        }
+        if (PyDict_SetItemString(dict, "surface", obj)) {
+            goto error;
+        }
+        Py_DECREF(obj);
+    }
+    if (error != NULL) {
+        obj = Text_FromUTF8(error);
+        if (obj == NULL) {
+            goto error;
+        }
+    }
+    else {
+        obj = Py_None;
+        Py_INCREF(obj);
+    }
+    if (PyDict_SetItemString(dict, "error", obj)) {
+        goto error;
+    }
+    Py_DECREF(obj);
+    obj = NULL;
+
+    event = PyEvent_New2(req->type, dict);
+    if (event == NULL) {
+        goto error;
+    }
+    if (SDL_EventState(req->type, SDL_QUERY) == SDL_IGNORE) {
+        /* Blocked, like pygame.event.post */
+        goto error;
+    }
+    if (PyEvent_FillUserEvent((PyEventObject *)event, &sdlevent)) {
+        goto error;
+    }
+    /* The queue holds few events; wait for room rather than lose one. */
+    while (SDL_PushEvent(&sdlevent) == -1 &&
+           !async_stop && SDL_WasInit(SDL_INIT_VIDEO)) {
+        Py_BEGIN_ALLOW_THREADS;
+        SDL_Delay(5);
+        Py_END_ALLOW_THREADS;
+    }
+
+error:
+    if (PyErr_Occurred()) {
+        PyErr_Print();
+    }
+    Py_XDECREF(event);
+    Py_XDECREF(dict);
+    Py_XDECREF(obj);
+}
+
+static int
+async_worker(void *arg)
+{
+    async_request *req;
+    SDL_Surface *surf;
+    convert_target no_conversion = { NULL, 0, 0, NULL };
+    const char *name;
+    char error[128];
+    int failed;
+    PyGILState_STATE state;
+
+    for (;;) {
+        SDL_SemWait(async_sem);
+        SDL_mutexP(async_lock);
+        if (async_stop) {
+            SDL_mutexV(async_lock);
+            break;
+        }
+        req = async_head;
+        if (req != NULL) {
+            async_head = req->next;
+            if (async_head == NULL) {
+                async_tail = NULL;
+            }
+        }
+        SDL_mutexV(async_lock);
+        if (req == NULL) {
+            continue;
+        }
+
+        surf = NULL;
+        if (req->save_surf != NULL) {
+            failed = save_file(req->save_surf, Bytes_AS_STRING(req->encoded),
+                               &req->options, req->save_ext) != 0;
+        }
+        else if (req->rw != NULL) {
+            name = Bytes_AS_STRING(req->encoded);
+            surf = load_rw_converted(&req->state, req->rw,
+                                     name[0] ? name : NULL, &no_conversion);
+            req->rw = NULL;     /* Closed by the decoder */
+            failed = surf == NULL;
+        }
+        else {
+            surf = load_file(req->load_file, Bytes_AS_STRING(req->encoded));
+            failed = surf == NULL;
+        }
+        if (failed) {
+            strncpy(error, SDL_GetError(), sizeof(error) - 1);
+            error[sizeof(error) - 1] = '\0';
+        }
+
+        state = PyGILState_Ensure();
+        if (async_stop) {
+            if (surf != NULL) {
+                SDL_FreeSurface(surf);
+            }
+        }
+        else {
+            post_async_result(req, surf, failed ? error : NULL);
+        }
+        free_async_request(req);
+        PyGILState_Release(state);
+    }
+    return 0;
+}
+
+/* Registered with pygame.quit: stops the thread and drops what is left
+ * in the queue.  Called with the GIL held.
+ */
+static void
+async_quit(void)
+{
+    async_request *req;
+
+    if (async_thread != NULL) {
+        SDL_mutexP(async_lock);
+        async_stop = 1;
+        SDL_mutexV(async_lock);
+        SDL_SemPost(async_sem);
+        Py_BEGIN_ALLOW_THREADS;
+        SDL_WaitThread(async_thread, NULL);
+        Py_END_ALLOW_THREADS;
+        async_thread = NULL;
+    }
+    while (async_head != NULL) {
+        req = async_head;
+        async_head = req->next;
+        free_async_request(req);
+    }
+    async_tail = NULL;
+    if (async_sem != NULL) {
+        SDL_DestroySemaphore(async_sem);
+        async_sem = NULL;
+    }
+    if (async_lock != NULL) {
+        SDL_DestroyMutex(async_lock);
+        async_lock = NULL;
+    }
+    async_stop = 0;
+}
+
+/* Make a request for path, or to load a buffer object with the name
+ * hint namehint; steals save_surf, even on failure.
+ */
+static async_request*
+new_async_request(PyObject *self, PyObject *path, PyObject *tag, int type,
+                  SDL_Surface *save_surf, const char *namehint)
+{
+    PyObject *encoded;
+    SDL_RWops *rw = NULL;
+    async_request *req;
+
+    if (type < SDL_USEREVENT || type >= SDL_NUMEVENTS) {
+        RAISE(PyExc_ValueError,
+              "type must be a user event, from USEREVENT up to "
+              "NUMEVENTS - 1");
+        goto error;
+    }
+    if (!SDL_WasInit(SDL_INIT_VIDEO)) {
+        RAISE(PyExc_SDLError, "video system not initialized");
+        goto error;
+    }
+    encoded = RWopsEncodeFilePath(path, PyExc_SDLError);
+    if (encoded == NULL) {
+        goto error;
+    }
+    if (encoded == Py_None) {
+        Py_DECREF(encoded);
+        encoded = NULL;
+#if PG_ENABLE_NEWBUF
+        if (save_surf == NULL && PyObject_CheckBuffer(path)) {
+            rw = RWopsFromFileObject(path);
+            if (rw == NULL) {
+                goto error;
+            }
+            encoded = Bytes_FromFormat("%s", namehint != NULL ? namehint : "");
+            if (encoded == NULL) {
+                goto error;
+            }
+        }
+#endif
+        if (encoded == NULL) {
+            RAISE(PyExc_TypeError, save_surf == NULL ?
+                  "path must be a file path or a buffer object" :
+                  "path must be a file path");
+            goto error;
+        }
+    }
+    req = PyMem_New(async_request, 1);
+    if (req == NULL) {
+        Py_DECREF(encoded);
+        PyErr_NoMemory();
+        goto error;
+    }
+    req->next = NULL;
+    req->load_file = GETSTATE(self)->load_file;
+    req->save_ext = GETSTATE(self)->save_file;
+    req->save_surf = save_surf;
+    req->rw = rw;
+    req->state = *GETSTATE(self);
+    req->encoded = encoded;
+    req->path = path;
+    Py_INCREF(path);
+    req->tag = tag;
+    Py_INCREF(tag);
+    req->type = type;
+    return req;
+
+error:
+    if (rw != NULL) {
+        SDL_RWclose(rw);
+    }
+    if (save_surf != NULL) {
+        SDL_FreeSurface(save_surf);
+    }
+    return NULL;
+}
+
+/* Queue a request, starting the thread on first use */
+static int
+queue_async_request(async_request *req)
+{
+    if (async_thread == NULL) {
+        PyEval_InitThreads();
+        async_lock = SDL_CreateMutex();
+        async_sem = SDL_CreateSemaphore(0);
+        if (async_lock != NULL && async_sem != NULL) {
+            async_thread = SDL_CreateThread(async_worker, NULL);
+        }
+        if (async_thread == NULL) {
+            RAISE(PyExc_SDLError, SDL_GetError());
+            async_quit();
+            free_async_request(req);
+            return -1;
+        }
+        PyGame_RegisterQuit(async_quit);
+    }
+    SDL_mutexP(async_lock);
+    if (async_tail != NULL) {
+        async_tail->next = req;
+    }
+    else {
+        async_head = req;
+    }
+    async_tail = req;
+    SDL_mutexV(async_lock);
+    SDL_SemPost(async_sem);
+    return 0;
+}
+#endif /* WITH_THREAD */
+
+static PyObject*
+image_load_async(PyObject *self, PyObject *args, PyObject *kwds)
+{
+#ifdef WITH_THREAD
+    static char *kwlist[] = {"path", "tag", "type", "namehint", NULL};
+    PyObject *path;
+    PyObject *tag = Py_None;
+    int type = SDL_USEREVENT;
+    const char *namehint = NULL;
+    async_request *req;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Oiz", kwlist,
+                                     &path, &tag, &type, &namehint)) {
+        return NULL;
+    }
+    req = new_async_request(self, path, tag, type, NULL, namehint);
+    if (req == NULL || queue_async_request(req)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+#else
+    return RAISE(PyExc_NotImplementedError,
+                 "load_async needs Python built with thread support");
+#endif
+}
+
+static PyObject*
+image_save_async(PyObject *self, PyObject *args, PyObject *kwds)
+{
+#ifdef WITH_THREAD
+    static char *kwlist[] = {"surface", "filename", "tag", "type", "quality",
+                             "compression", "filters", NULL};
+    PyObject *surfobj;
+    PyObject *path;
+    PyObject *tag = Py_None;
+    int type = SDL_USEREVENT;
+    pg_save_options options = PG_SAVE_OPTIONS_DEFAULT;
+    SDL_Surface *surf;
+    SDL_Surface *snapshot;
+    async_request *req;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O|Oiiii", kwlist,
+                                     &PySurface_Type, &surfobj, &path, &tag,
+                                     &type, &options.quality,
+                                     &options.compression, &options.filters)) {
+        return NULL;
+    }
+    if (pg_check_save_options(&options)) {
+        return NULL;
+    }
+
+    /* Copy the pixels now; the thread encodes the copy. */
+    surf = PySurface_AsSurface(surfobj);
+    if (surf->flags & SDL_OPENGL) {
+        snapshot = opengltosdl();
+        if (snapshot == NULL) {
+            return NULL;
+        }
+    }
+    else {
+        PySurface_Prep(surfobj);
+        snapshot = SDL_ConvertSurface(surf, surf->format,
+                                      SDL_SWSURFACE | (surf->flags &
+                                      (SDL_SRCCOLORKEY | SDL_SRCALPHA)));
+        PySurface_Unprep(surfobj);
+        if (snapshot == NULL) {
+            return RAISE(PyExc_SDLError, SDL_GetError());
+        }
+    }
+
+    req = new_async_request(self, path, tag, type, snapshot, NULL);
+    if (req == NULL || queue_async_request(req)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+#else
+    return RAISE(PyExc_NotImplementedError,
+                 "save_async needs Python built with thread support");
+#endif
+}
+
+/* Texture packs: one file holding many images, each stored in the pixel
+ * format of its Surface so it can be used straight from a memory
+ * mapping.  All fields are native Uint32s; a pack is only readable on a
+ * machine of the byte order that wrote it.
+ *
+ *   header:  "PGPK", version, byte order mark, image count
+ *   index:   one pack_entry per image
+ *   names:   UTF-8 names, not terminated
+ *   data:    per image, pixel rows (pitch bytes each, 64 byte aligned),
+ *            then palette (RGBx quads), then mask rows, one bit per
+ *            pixel, least significant bit first.
+ */
+#define PACK_VERSION 1
+#define PACK_BYTEORDER 0x01020304
+#define PACK_ALIGN 64
+#define PACK_COLORKEY 0x1
+#define PACK_ALPHA 0x2
+#define PACK_CAPSULE_NAME "pygame.image.pack"
+
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 byteorder;
+    Uint32 count;
+} pack_header;
+
+typedef struct {
+    Uint32 name;
+    Uint32 name_length;
+    Uint32 width;
+    Uint32 height;
+    Uint32 pitch;
+    Uint32 bitsize;
+    Uint32 masks[4];
+    Uint32 flags;
+    Uint32 colorkey;
+    Uint32 alpha;
+    Uint32 pixels;
+    Uint32 palette;
+    Uint32 ncolors;
+    Uint32 mask;
+    Uint32 reserved;
+} pack_entry;
+
+typedef struct {
+    void *base;
+    size_t size;
+} pack_map;
+
+#define PACK_MASK_PITCH(w) (((w) + 7) / 8)
+
+static int
+pack_write_zeros(FILE *fp, Uint32 count)
+{
+    static const char zeros[PACK_ALIGN] = {0};
+    Uint32 n;
+
+    while (count > 0) {
+        n = count < PACK_ALIGN ? count : PACK_ALIGN;
+        if (fwrite(zeros, 1, n, fp) != n) {
+            return -1;
+        }
+        count -= n;
+    }
+    return 0;
+}
+
+static int
+pack_write_image(FILE *fp, const pack_entry *entry, SDL_Surface *surf,
+                 PyObject *maskobj)
+{
+    Uint8 *row;
+    Uint8 *bits = NULL;
+    Uint32 rowbytes = entry->width * surf->format->BytesPerPixel;
+    Uint32 maskpitch = PACK_MASK_PITCH(entry->width);
+    Uint32 x, y;
+    int i;
+    Uint8 quad[4];
+    bitmask_t *mask;
+
+    for (y = 0; y < entry->height; ++y) {
+        row = (Uint8 *)surf->pixels + y * surf->pitch;
+        if (fwrite(row, 1, rowbytes, fp) != rowbytes ||
+            pack_write_zeros(fp, entry->pitch - rowbytes)) {
+            return -1;
+        }
+    }
+    for (i = 0; i < (int)entry->ncolors; ++i) {
+        quad[0] = surf->format->palette->colors[i].r;
+        quad[1] = surf->format->palette->colors[i].g;
+        quad[2] = surf->format->palette->colors[i].b;
+        quad[3] = 0;
+        if (fwrite(quad, 1, 4, fp) != 4) {
+            return -1;
+        }
+    }
+    if (maskobj != NULL) {
+        mask = PyMask_AsBitmap(maskobj);
+        bits = (Uint8 *)malloc(maskpitch ? maskpitch : 1);
+        if (bits == NULL) {
+            return -1;
+        }
+        for (y = 0; y < entry->height; ++y) {
+            memset(bits, 0, maskpitch);
+            for (x = 0; x < entry->width; ++x) {
+                if (bitmask_getbit(mask, x, y)) {
+                    bits[x >> 3] |= 1 << (x & 7);
+                }
+            }
+            if (fwrite(bits, 1, maskpitch, fp) != maskpitch) {
+                free(bits);
+                return -1;
+            }
+        }
+        free(bits);
+    }
+    return 0;
+}
+
+static PyObject*
+image_save_pack(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"filename", "surfaces", "masks", NULL};
+    PyObject *filename;
+    PyObject *surfaces;
+    PyObject *masks = Py_None;
+    PyObject *oencoded = NULL;
+    PyObject *key;
+    PyObject *value;
+    PyObject *maskobj;
+    PyObject **names = NULL;
+    PyObject **surfobjs = NULL;
+    PyObject **maskobjs = NULL;
+    pack_header header;
+    pack_entry *entries = NULL;
+    pack_entry *entry;
+    SDL_Surface *surf;
+    bitmask_t *mask;
+    Py_ssize_t count;
+    Py_ssize_t pos = 0;
+    Py_ssize_t i;
+    Py_ssize_t j;
+    size_t offset;
+    FILE *fp = NULL;
+    int failed = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO!|O", kwlist, &filename,
+                                     &PyDict_Type, &surfaces, &masks)) {
+        return NULL;
+    }
+    if (masks != Py_None && !PyDict_Check(masks)) {
+        return RAISE(PyExc_TypeError, "masks must be a dict or None");
+    }
+    count = PyDict_Size(surfaces);
+    if (count > 0xffff) {
+        return RAISE(PyExc_ValueError, "too many images for one pack");
+    }
+
+    entries = PyMem_New(pack_entry, count ? count : 1);
+    names = PyMem_New(PyObject *, count ? count : 1);
+    surfobjs = PyMem_New(PyObject *, count ? count : 1);
+    maskobjs = PyMem_New(PyObject *, count ? count : 1);
+    if (entries == NULL || names == NULL ||
+        surfobjs == NULL || maskobjs == NULL) {
+        PyErr_NoMemory();
+        goto end;
+    }
+    memset(entries, 0, sizeof(pack_entry) * count);
+    for (i = 0; i < count; ++i) {
+        names[i] = NULL;
+    }
+
+    /* Lay out the file: header, index, names, then the image data */
+    offset = sizeof(pack_header) + sizeof(pack_entry) * count;
+    i = 0;
+    while (PyDict_Next(surfaces, &pos, &key, &value)) {
+        entry = &entries[i];
+        if (PyUnicode_Check(key)) {
+            names[i] = PyUnicode_AsUTF8String(key);
+            if (names[i] == NULL) {
+                goto end;
+            }
+        }
+        else if (Bytes_Check(key)) {
+            names[i] = key;
+            Py_INCREF(key);
+        }
+        else {
+            PyErr_SetString(PyExc_TypeError, "image names must be strings");
+            goto end;
+        }
+        if (!PySurface_Check(value)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "surfaces must map names to Surfaces");
+            goto end;
+        }
+        surfobjs[i] = value;
+        surf = PySurface_AsSurface(value);
+        maskobj = NULL;
+        if (masks != Py_None) {
+            maskobj = PyDict_GetItem(masks, key);
+        }
+        if (maskobj != NULL) {
+            if (!PyMask_Check(maskobj)) {
+                PyErr_SetString(PyExc_TypeError,
+                                "masks must map names to Masks");
+                goto end;
+            }
+            mask = PyMask_AsBitmap(maskobj);
+            if (mask->w != surf->w || mask->h != surf->h) {
+                PyErr_SetString(PyExc_ValueError,
+                                "mask size does not match its Surface");
+                goto end;
+            }
+        }
+        maskobjs[i] = maskobj;
+        ++i;
+
+        entry->name = (Uint32)offset;
+        entry->name_length = (Uint32)Bytes_GET_SIZE(names[i - 1]);
+        offset += entry->name_length;
+    }
+
+    for (i = 0; i < count; ++i) {
+        entry = &entries[i];
+        surf = PySurface_AsSurface(surfobjs[i]);
+        offset = (offset + PACK_ALIGN - 1) & ~(size_t)(PACK_ALIGN - 1);
+        entry->width = surf->w;
+        entry->height = surf->h;
+        /* 4 byte aligned, as SDL pitches are */
+        entry->pitch = (surf->w * surf->format->BytesPerPixel + 3) & ~3;
+        entry->bitsize = surf->format->BitsPerPixel;
+        entry->masks[0] = surf->format->Rmask;
+        entry->masks[1] = surf->format->Gmask;
+        entry->masks[2] = surf->format->Bmask;
+        entry->masks[3] = surf->format->Amask;
+        if (surf->flags & SDL_SRCCOLORKEY) {
+            entry->flags |= PACK_COLORKEY;
+            entry->colorkey = surf->format->colorkey;
+        }
+        if (surf->flags & SDL_SRCALPHA) {
+            entry->flags |= PACK_ALPHA;
+        }
+        entry->alpha = surf->format->alpha;
+        entry->pixels = (Uint32)offset;
+        offset += (size_t)entry->pitch * entry->height;
+        if (surf->format->palette != NULL) {
+            entry->palette = (Uint32)offset;
+            entry->ncolors = surf->format->palette->ncolors;
+            offset += 4 * entry->ncolors;
+        }
+        if (maskobjs[i] != NULL) {
+            entry->mask = (Uint32)offset;
+            offset += (size_t)PACK_MASK_PITCH(entry->width) * entry->height;
+        }
+        if (offset > 0xffffffffUL) {
+            PyErr_SetString(PyExc_ValueError,
+                            "images too large for one pack");
+            goto end;
+        }
+    }
+
+    oencoded = RWopsEncodeFilePath(filename, PyExc_SDLError);
+    if (oencoded == NULL) {
+        goto end;
+    }
+    if (oencoded == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "filename must be a file path");
+        goto end;
+    }
+    fp = fopen(Bytes_AS_STRING(oencoded), "wb");
+    if (fp == NULL) {
+        PyErr_Format(PyExc_SDLError, "Couldn't open %s for writing",
+                     Bytes_AS_STRING(oencoded));
+        goto end;
+    }
+
+    memcpy(header.magic, "PGPK", 4);
+    header.version = PACK_VERSION;
+    header.byteorder = PACK_BYTEORDER;
+    header.count = (Uint32)count;
+    offset = sizeof(pack_header) + sizeof(pack_entry) * count;
+    failed = fwrite(&header, sizeof(header), 1, fp) != 1 ||
+             (count > 0 &&
+              fwrite(entries, sizeof(pack_entry), count, fp) != (size_t)count);
+    for (i = 0; i < count && !failed; ++i) {
+        failed = fwrite(Bytes_AS_STRING(names[i]), 1,
+                        entries[i].name_length, fp) != entries[i].name_length;
+        offset += entries[i].name_length;
+    }
+    for (i = 0; i < count && !failed; ++i) {
+        failed = pack_write_zeros(fp, (Uint32)(entries[i].pixels - offset));
+        if (failed) {
+            break;
+        }
+        PySurface_Lock(surfobjs[i]);
+        failed = pack_write_image(fp, &entries[i],
+                                  PySurface_AsSurface(surfobjs[i]),
+                                  maskobjs[i]);
+        PySurface_Unlock(surfobjs[i]);
+        offset = entries[i].pixels +
+                 (size_t)entries[i].pitch * entries[i].height +
+                 4 * entries[i].ncolors;
+        if (entries[i].mask) {
+            offset = entries[i].mask + (size_t)entries[i].height *
+                     PACK_MASK_PITCH(entries[i].width);
+        }
+    }
+    if (fclose(fp) != 0) {
+        failed = 1;
+    }
+    fp = NULL;
+    if (failed) {
+        PyErr_Format(PyExc_SDLError, "Error writing to %s",
+                     Bytes_AS_STRING(oencoded));
+    }
+
+end:
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    if (names != NULL) {
+        for (j = 0; j < count; ++j) {
+            Py_XDECREF(names[j]);
+        }
+    }
+    Py_XDECREF(oencoded);
+    PyMem_Del(entries);
+    PyMem_Del(names);
+    PyMem_Del(surfobjs);
+    PyMem_Del(maskobjs);
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static void
+pack_unmap(PyObject *capsule)
+{
+    pack_map *map = (pack_map *)PyCapsule_GetPointer(capsule,
+                                                     PACK_CAPSULE_NAME);
+
+    if (map == NULL) {
+        return;
+    }
+#if defined(WIN32)
+    UnmapViewOfFile(map->base);
+#else
+    munmap(map->base, map->size);
+#endif
+    PyMem_Del(map);
+}
+
+/* Map a whole file copy-on-write: writes to the pixels of a Surface go
+ * to private pages and never reach the file.
+ */
+static PyObject*
+pack_map_file(const char *path)
+{
+    pack_map *map;
+    PyObject *capsule;
+    void *base = NULL;
+    size_t size = 0;
+#if defined(WIN32)
+    HANDLE file;
+    HANDLE mapping;
+    LARGE_INTEGER filesize;
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return PyErr_Format(PyExc_SDLError, "Couldn't open %s", path);
+    }
+    if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0 &&
+        (ULONGLONG)filesize.QuadPart <= (size_t)-1) {
+        size = (size_t)filesize.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping != NULL) {
+            base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd;
+    struct stat st;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return PyErr_Format(PyExc_SDLError, "Couldn't open %s", path);
+    }
+    if (fstat(fd, &st) == 0 && st.st_size > 0 &&
+        (unsigned long long)st.st_size <= (size_t)-1) {
+        size = (size_t)st.st_size;
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+        }
+    }
+    close(fd);
+#endif
+    if (base == NULL) {
+        return PyErr_Format(PyExc_SDLError, "Couldn't map %s", path);
+    }
+
+    map = PyMem_New(pack_map, 1);
+    if (map == NULL) {
+        capsule = NULL;
+    }
+    else {
+        map->base = base;
+        map->size = size;
+        capsule = PyCapsule_New(map, PACK_CAPSULE_NAME, pack_unmap);
+    }
+    if (capsule == NULL) {
+#if defined(WIN32)
+        UnmapViewOfFile(base);
+#else
+        munmap(base, size);
+#endif
+        PyMem_Del(map);
+        return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+    }
+    return capsule;
+}
+
+static int
+pack_check_range(const pack_map *map, Uint32 offset, size_t length)
+{
+    return offset <= map->size && length <= map->size - offset;
+}
+
+static int
+pack_check_entry(const pack_map *map, const pack_entry *entry)
+{
+    switch (entry->bitsize) {
+
+    case 8:
+    case 16:
+    case 24:
+    case 32:
+        break;
+    default:
+        return 0;
+    }
+    if (entry->width > 0x7fff || entry->height > 0x7fff ||
+        entry->ncolors > 256 || (entry->bitsize == 8) != (entry->ncolors > 0) ||
+        !pack_check_range(map, entry->name, entry->name_length) ||
+        !pack_check_range(map, entry->palette, 4 * entry->ncolors)) {
+        return 0;
+    }
+    if (entry->width == 0 || entry->height == 0) {
+        /* No pixels or mask are read */
+        return 1;
+    }
+    return entry->pitch >= entry->width * (entry->bitsize / 8) &&
+           entry->pitch <= 0x3fffc &&
+           pack_check_range(map, entry->pixels,
+                            (size_t)entry->pitch * entry->height) &&
+           (entry->mask == 0 ||
+            pack_check_range(map, entry->mask,
+                             (size_t)PACK_MASK_PITCH(entry->width) *
+                             entry->height));
+}
+
+static SDL_Surface*
+pack_new_surface(const pack_map *map, const pack_entry *entry)
+{
+    SDL_Surface *surf;
+    Uint8 *base = (Uint8 *)map->base;
+    SDL_Color colors[256];
+    Uint32 i;
+
+    if (entry->width == 0 || entry->height == 0) {
+        /* Nothing to map; an owned empty surface will do */
+        surf = SDL_CreateRGBSurface(SDL_SWSURFACE, entry->width,
+                                    entry->height, entry->bitsize,
+                                    entry->masks[0], entry->masks[1],
+                                    entry->masks[2], entry->masks[3]);
+    }
+    else {
+        surf = SDL_CreateRGBSurfaceFrom(base + entry->pixels, entry->width,
+                                        entry->height, entry->bitsize,
+                                        entry->pitch, entry->masks[0],
+                                        entry->masks[1], entry->masks[2],
+                                        entry->masks[3]);
+    }
+    if (surf == NULL) {
+        return NULL;
+    }
+    if (entry->palette != 0 && surf->format->palette != NULL) {
+        for (i = 0; i < entry->ncolors; ++i) {
+            colors[i].r = base[entry->palette + 4 * i];
+            colors[i].g = base[entry->palette + 4 * i + 1];
+            colors[i].b = base[entry->palette + 4 * i + 2];
+            colors[i].unused = 0;
+        }
+        SDL_SetColors(surf, colors, 0, entry->ncolors);
+    }
+    if (entry->flags & PACK_COLORKEY) {
+        SDL_SetColorKey(surf, SDL_SRCCOLORKEY, entry->colorkey);
+    }
+    SDL_SetAlpha(surf, (entry->flags & PACK_ALPHA) ? SDL_SRCALPHA : 0,
+                 (Uint8)entry->alpha);
+    return surf;
+}
+
+static PyObject*
+pack_new_mask(PyObject *maskmodule, const pack_map *map,
+              const pack_entry *entry)
+{
+    PyObject *maskobj;
+    bitmask_t *mask;
+    const Uint8 *row;
+    Uint32 x, y;
+
+    maskobj = PyObject_CallMethod(maskmodule, "Mask", "((ii))",
+                                  (int)entry->width, (int)entry->height);
+    if (maskobj == NULL) {
+        return NULL;
+    }
+    mask = PyMask_AsBitmap(maskobj);
+    row = (const Uint8 *)map->base + entry->mask;
+    for (y = 0; y < entry->height; ++y) {
+        for (x = 0; x < entry->width; ++x) {
+            if (row[x >> 3] & (1 << (x & 7))) {
+                bitmask_setbit(mask, x, y);
+            }
+        }
+        row += PACK_MASK_PITCH(entry->width);
+    }
+    return maskobj;
+}
+
+static PyObject*
+image_load_pack(PyObject *self, PyObject *arg)
+{
+    PyObject *oencoded;
+    PyObject *capsule = NULL;
+    PyObject *surfaces = NULL;
+    PyObject *masks = NULL;
+    PyObject *maskmodule = NULL;
+    PyObject *name;
+    PyObject *obj;
+    pack_map *map;
+    pack_header *header;
+    pack_entry *entry;
+    SDL_Surface *surf;
+    Uint32 i;
+
+    oencoded = RWopsEncodeFilePath(arg, PyExc_SDLError);
+    if (oencoded == NULL) {
+        return NULL;
+    }
+    if (oencoded == Py_None) {
         Py_DECREF(oencoded);
+        return RAISE(PyExc_TypeError, "filename must be a file path");
     }
-    else {
-        Py_DECREF(oencoded);
-        rw = RWopsFromFileObject(obj);
-        if (rw == NULL) {
-            return NULL;
+    capsule = pack_map_file(Bytes_AS_STRING(oencoded));
+    Py_DECREF(oencoded);
+    if (capsule == NULL) {
+        return NULL;
+    }
+    map = (pack_map *)PyCapsule_GetPointer(capsule, PACK_CAPSULE_NAME);
+    header = (pack_header *)map->base;
+    if (map->size < sizeof(pack_header) ||
+        memcmp(header->magic, "PGPK", 4) != 0) {
+        PyErr_SetString(PyExc_SDLError, "not a texture pack");
+        goto error;
+    }
+    if (header->version != PACK_VERSION ||
+        header->byteorder != PACK_BYTEORDER) {
+        PyErr_SetString(PyExc_SDLError,
+                        "texture pack of another version or byte order");
+        goto error;
+    }
+    if (!pack_check_range(map, sizeof(pack_header),
+                          (size_t)header->count * sizeof(pack_entry))) {
+        PyErr_SetString(PyExc_SDLError, "corrupt texture pack");
+        goto error;
+    }
+
+    surfaces = PyDict_New();
+    masks = PyDict_New();
+    if (surfaces == NULL || masks == NULL) {
+        goto error;
+    }
+    entry = (pack_entry *)(header + 1);
+    for (i = 0; i < header->count; ++i, ++entry) {
+        if (!pack_check_entry(map, entry)) {
+            PyErr_SetString(PyExc_SDLError, "corrupt texture pack");
+            goto error;
         }
-        if (RWopsCheckObject(rw)) {
-            surf = SDL_LoadBMP_RW (rw, 1);
+        name = Text_FromUTF8AndSize((char *)map->base + entry->name,
+                                    entry->name_length);
+        if (name == NULL) {
+            goto error;
         }
-        else {
-            Py_BEGIN_ALLOW_THREADS;
-            surf = SDL_LoadBMP_RW(rw, 1);
-            Py_END_ALLOW_THREADS;
+
+        surf = pack_new_surface(map, entry);
+        if (surf == NULL) {
+            Py_DECREF(name);
+            PyErr_SetString(PyExc_SDLError, SDL_GetError());
+            goto error;
+        }
+        obj = PySurface_New(surf);
+        if (obj == NULL) {
+            SDL_FreeSurface(surf);
+            Py_DECREF(name);
+            goto error;
+        }
+        if (surf->flags & SDL_PREALLOC) {
+            /* The pixels live in the mapping */
+            ((PySurfaceObject *)obj)->dependency = capsule;
+            Py_INCREF(capsule);
+        }
+        if (PyDict_SetItem(surfaces, name, obj)) {
+            Py_DECREF(obj);
+            Py_DECREF(name);
+            goto error;
+        }
+        Py_DECREF(obj);
+
+        if (entry->mask != 0 && entry->width > 0 && entry->height > 0) {
+            if (maskmodule == NULL) {
+                maskmodule = PyImport_ImportModule(IMPPREFIX "mask");
+                if (maskmodule == NULL) {
+                    Py_DECREF(name);
+                    goto error;
+                }
+            }
+            obj = pack_new_mask(maskmodule, map, entry);
+            if (obj == NULL || PyDict_SetItem(masks, name, obj)) {
+                Py_XDECREF(obj);
+                Py_DECREF(name);
+                goto error;
+            }
+            Py_DECREF(obj);
         }
+        Py_DECREF(name);
     }
 
-    if (surf == NULL) {
-        return RAISE(PyExc_SDLError, SDL_GetError());
-    }
+    Py_XDECREF(maskmodule);
+    Py_DECREF(capsule);
+    obj = Py_BuildValue("(OO)", surfaces, masks);
+    Py_DECREF(surfaces);
+    Py_DECREF(masks);
+    return obj;
 
-    final = PySurface_New(surf);
-    if (final == NULL) {
-        SDL_FreeSurface(surf);
-    }
-    return final;
+error:
+    Py_XDECREF(maskmodule);
+    Py_XDECREF(surfaces);
+    Py_XDECREF(masks);
+    Py_DECREF(capsule);
+    return NULL;
 }
 
-
 static SDL_Surface*
 opengltosdl ()
 {
@@ -170,17 +1815,26 @@ opengltosdl ()
 }
 
 PyObject*
-image_save(PyObject *self, PyObject *arg)
+image_save(PyObject *self, PyObject *arg, PyObject *kwds)
 {
+    static char *kwlist[] = {"surface", "filename", "quality",
+                             "compression", "filters", NULL};
     PyObject *surfobj;
     PyObject *obj;
     PyObject *oencoded;
     PyObject *imgext = NULL;
     SDL_Surface *surf;
     SDL_Surface *temp = NULL;
+    pg_save_options options = PG_SAVE_OPTIONS_DEFAULT;
     int result = 1;
 
-    if (!PyArg_ParseTuple(arg, "O!O", &PySurface_Type, &surfobj, &obj)) {
+    if (!PyArg_ParseTupleAndKeywords(arg, kwds, "O!O|iii", kwlist,
+                                     &PySurface_Type, &surfobj, &obj,
+                                     &options.quality, &options.compression,
+                                     &options.filters)) {
+        return NULL;
+    }
+    if (pg_check_save_options(&options)) {
         return NULL;
     }
 
@@ -240,7 +1894,7 @@ image_save(PyObject *self, PyObject *arg)
 
                     Py_DECREF(imgext);
                     if (extsave != NULL) {
-                        data = PyObject_CallObject(extsave, arg);
+                        data = PyObject_Call(extsave, arg, kwds);
                         Py_DECREF(extsave);
                         if (data == NULL) {
                             result = -2;
@@ -261,6 +1915,13 @@ image_save(PyObject *self, PyObject *arg)
             }
         }
 
+        if (!written && has_extension(name, "qoi")) {
+            Py_BEGIN_ALLOW_THREADS;
+            result = SaveQOI(surf, name);
+            Py_END_ALLOW_THREADS;
+            written = 1;
+        }
+
         if (!written) {
             Py_BEGIN_ALLOW_THREADS;
             result = SaveTGA(surf, name, 1);
@@ -302,30 +1963,189 @@ image_get_extended (PyObject* self, PyObject* arg)
     return PyInt_FromLong (GETSTATE (self)->is_extended);
 }
 
-PyObject*
-image_tostring (PyObject* self, PyObject* arg)
+/* Bytes per pixel written by a tostring format, or 0 with a Python error
+ * set if the format is unknown or does not suit the surface.
+ */
+static int
+tostring_pixel_size (SDL_Surface *surf, const char *format)
 {
-    PyObject *surfobj, *string = NULL;
-    char *format, *data, *pixels;
-    SDL_Surface *surf, *temp = NULL;
-    int w, h, color, flipped = 0;
-    Py_ssize_t len;
+    if (!strcmp (format, "P"))
+    {
+        if (surf->format->BytesPerPixel != 1)
+        {
+            RAISE (PyExc_ValueError,
+                   "Can only create \"P\" format data with 8bit Surfaces");
+            return 0;
+        }
+        return 1;
+    }
+    if (!strcmp (format, "RGB"))
+        return 3;
+    if (!strcmp (format, "RGBX") || !strcmp (format, "RGBA") ||
+        !strcmp (format, "ARGB"))
+        return 4;
+    if (!strcmp (format, "RGBA_PREMULT") || !strcmp (format, "ARGB_PREMULT"))
+    {
+        if (surf->format->BytesPerPixel == 1 || surf->format->Amask == 0)
+        {
+            RAISE (PyExc_ValueError,
+                   "Can only create pre-multiplied alpha strings if the "
+                   "surface has per-pixel alpha");
+            return 0;
+        }
+        return 4;
+    }
+    RAISE (PyExc_ValueError, "Unrecognized type of format");
+    return 0;
+}
+
+#ifdef IMAGE_SSE2
+/* Four pixels at a time, of bpp 3 or 4 bytes, to 4 bytes: output byte i
+ * of each pixel is the 8 bits at shifts[i] in the source pixel, with fill
+ * or'ed in.  A shift of 32 gives 0, leaving just the fill.
+ */
+static int
+shuffle_row_sse2 (const Uint8 *src, Uint8 *dst, int width, int bpp,
+                  const int shifts[4], Uint32 fill)
+{
+    __m128i lowbyte = _mm_set1_epi32 (0xff);
+    __m128i fillv = _mm_set1_epi32 ((int) fill);
+    __m128i s0 = _mm_cvtsi32_si128 (shifts[0]);
+    __m128i s1 = _mm_cvtsi32_si128 (shifts[1]);
+    __m128i s2 = _mm_cvtsi32_si128 (shifts[2]);
+    __m128i s3 = _mm_cvtsi32_si128 (shifts[3]);
+    __m128i px, out;
+    /* 24 bit pixels are read 16 bytes at a time, 4 past the 4 pixels, so
+     * stop 2 pixels early to stay in the row */
+    int end = bpp == 4 ? width : width - 2;
+    int x;
+
+    for (x = 0; x + 4 <= end; x += 4)
+    {
+        if (bpp == 4)
+            px = _mm_loadu_si128 ((const __m128i*) (src + 4 * x));
+        else
+        {
+            /* move pixel k to bits 32k, its high byte unused */
+            px = _mm_loadu_si128 ((const __m128i*) (src + 3 * x));
+            px = _mm_unpacklo_epi64 (
+                _mm_unpacklo_epi32 (px, _mm_srli_si128 (px, 3)),
+                _mm_unpacklo_epi32 (_mm_srli_si128 (px, 6),
+                                    _mm_srli_si128 (px, 9)));
+        }
+        out = _mm_or_si128 (
+            fillv, _mm_and_si128 (_mm_srl_epi32 (px, s0), lowbyte));
+        out = _mm_or_si128 (out, _mm_slli_epi32 (
+            _mm_and_si128 (_mm_srl_epi32 (px, s1), lowbyte), 8));
+        out = _mm_or_si128 (out, _mm_slli_epi32 (
+            _mm_and_si128 (_mm_srl_epi32 (px, s2), lowbyte), 16));
+        out = _mm_or_si128 (out, _mm_slli_epi32 (_mm_srl_epi32 (px, s3), 24));
+        _mm_storeu_si128 ((__m128i*) (dst + 4 * x), out);
+    }
+    return x;
+}
+#endif /* IMAGE_SSE2 */
+
+/* The tostring fast path, for 24 and 32 bit surfaces whose channels are
+ * whole bytes: each output byte is copied from a fixed byte of the pixel,
+ * with no per channel shifting and masking.  Returns 0, doing nothing, if
+ * the surface or format does not suit.
+ */
+static int
+tostring_bytes (SDL_Surface *surf, const char *format, int flipped,
+                char *data, int hascolorkey)
+{
+    int bpp = surf->format->BytesPerPixel;
+    int bytes[4];
+    int order[4];
+    int n, x, y, i;
+    const Uint8 *src;
+    Uint8 *dst = (Uint8*) data;
+#ifdef IMAGE_SSE2
+    int shifts[4];
+    Uint32 fill = 0;
+#endif
+
+    if (pg_channel_bytes (surf->format, bytes) < 0)
+        return 0;
+
+    /* no alpha channel, a byte of -1, means write 255 */
+    if (!strcmp (format, "RGB"))
+    {
+        n = 3;
+        order[0] = bytes[0];
+        order[1] = bytes[1];
+        order[2] = bytes[2];
+    }
+    else if ((!strcmp (format, "RGBA") && !hascolorkey) ||
+             !strcmp (format, "RGBX"))
+    {
+        n = 4;
+        order[0] = bytes[0];
+        order[1] = bytes[1];
+        order[2] = bytes[2];
+        order[3] = bytes[3];
+    }
+    else if (!strcmp (format, "ARGB"))
+    {
+        n = 4;
+        order[0] = bytes[3];
+        order[1] = bytes[0];
+        order[2] = bytes[1];
+        order[3] = bytes[2];
+    }
+    else
+        return 0;
+
+#ifdef IMAGE_SSE2
+    if (n == 4)
+    {
+        for (i = 0; i < 4; ++i)
+        {
+            shifts[i] = order[i] < 0 ? 32 : 8 * order[i];
+            if (order[i] < 0)
+                fill |= (Uint32) 0xff << (8 * i);
+        }
+    }
+#endif
+
+    for (y = 0; y < surf->h; ++y)
+    {
+        src = (const Uint8*) DATAROW (surf->pixels, y, surf->pitch, surf->h,
+                                      flipped);
+        x = 0;
+#ifdef IMAGE_SSE2
+        if (n == 4)
+        {
+            x = shuffle_row_sse2 (src, dst, surf->w, bpp, shifts, fill);
+            src += bpp * x;
+            dst += 4 * x;
+        }
+#endif
+        for (; x < surf->w; ++x)
+        {
+            for (i = 0; i < n; ++i)
+                dst[i] = order[i] < 0 ? 255 : src[order[i]];
+            src += bpp;
+            dst += n;
+        }
+    }
+    return 1;
+}
+
+/* Write the pixels of a locked surface to data in a tostring format.
+ * Needs no GIL.
+ */
+static void
+tostring_pixels (SDL_Surface *surf, const char *format, int flipped,
+                 char *data)
+{
+    int w, h, color;
     Uint32 Rmask, Gmask, Bmask, Amask, Rshift, Gshift, Bshift, Ashift, Rloss,
         Gloss, Bloss, Aloss;
     int hascolorkey, colorkey;
     Uint32 alpha;
 
-    if (!PyArg_ParseTuple (arg, "O!s|i", &PySurface_Type, &surfobj, &format,
-                           &flipped))
-        return NULL;
-    surf = PySurface_AsSurface (surfobj);
-    if (surf->flags & SDL_OPENGL)
-    {
-        temp = surf = opengltosdl ();
-        if (!surf)
-            return NULL;
-    }
-
     Rmask = surf->format->Rmask;
     Gmask = surf->format->Gmask;
     Bmask = surf->format->Bmask;
@@ -341,34 +2161,17 @@ image_tostring (PyObject* self, PyObject* arg)
     hascolorkey = (surf->flags & SDL_SRCCOLORKEY) && !Amask;
     colorkey = surf->format->colorkey;
 
+    if (tostring_bytes (surf, format, flipped, data, hascolorkey))
+        return;
+
     if (!strcmp (format, "P"))
     {
-        if (surf->format->BytesPerPixel != 1)
-            return RAISE
-                (PyExc_ValueError,
-                 "Can only create \"P\" format data with 8bit Surfaces");
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         for (h = 0; h < surf->h; ++h)
             memcpy (DATAROW (data, h, surf->w, surf->h, flipped),
-                    pixels + (h * surf->pitch), surf->w);
-        PySurface_Unlock (surfobj);
+                    (char*) surf->pixels + (h * surf->pitch), surf->w);
     }
     else if (!strcmp (format, "RGB"))
     {
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h * 3);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        if (!temp)
-            PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         switch (surf->format->BytesPerPixel)
         {
         case 1:
@@ -437,21 +2240,12 @@ image_tostring (PyObject* self, PyObject* arg)
             }
             break;
         }
-        if (!temp)
-            PySurface_Unlock (surfobj);
     }
     else if (!strcmp (format, "RGBX") || !strcmp (format, "RGBA"))
     {
         if (strcmp (format, "RGBA"))
             hascolorkey = 0;
 
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h * 4);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         switch (surf->format->BytesPerPixel)
         {
         case 1:
@@ -531,19 +2325,11 @@ image_tostring (PyObject* self, PyObject* arg)
             }
             break;
         }
-        PySurface_Unlock (surfobj);
     }
     else if (!strcmp (format, "ARGB"))
     {
         hascolorkey = 0;
 
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h * 4);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         switch (surf->format->BytesPerPixel)
         {
         case 1:
@@ -623,24 +2409,11 @@ image_tostring (PyObject* self, PyObject* arg)
             }
             break;
         }
-        PySurface_Unlock (surfobj);
     }
     else if (!strcmp (format, "RGBA_PREMULT"))
     {
-        if (surf->format->BytesPerPixel == 1 || surf->format->Amask == 0)
-            return RAISE
-                (PyExc_ValueError,
-                 "Can only create pre-multiplied alpha strings if the surface has per-pixel alpha");
-
         hascolorkey = 0;
 
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h * 4);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         switch (surf->format->BytesPerPixel)
         {
         case 2:
@@ -707,24 +2480,11 @@ image_tostring (PyObject* self, PyObject* arg)
             }
             break;
         }
-        PySurface_Unlock (surfobj);
     }
     else if (!strcmp (format, "ARGB_PREMULT"))
     {
-        if (surf->format->BytesPerPixel == 1 || surf->format->Amask == 0)
-            return RAISE
-                (PyExc_ValueError,
-                 "Can only create pre-multiplied alpha strings if the surface has per-pixel alpha");
-
         hascolorkey = 0;
 
-        string = Bytes_FromStringAndSize (NULL, surf->w * surf->h * 4);
-        if (!string)
-            return NULL;
-        Bytes_AsStringAndSize (string, &data, &len);
-
-        PySurface_Lock (surfobj);
-        pixels = (char*) surf->pixels;
         switch (surf->format->BytesPerPixel)
         {
         case 2:
@@ -791,18 +2551,112 @@ image_tostring (PyObject* self, PyObject* arg)
             }
             break;
         }
-        PySurface_Unlock (surfobj);
     }
-    else
+}
+
+PyObject*
+image_tostring (PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *string = NULL;
+    char *format;
+    SDL_Surface *surf, *temp = NULL;
+    int flipped = 0;
+    int size;
+
+    if (!PyArg_ParseTuple (arg, "O!s|i", &PySurface_Type, &surfobj, &format,
+                           &flipped))
+        return NULL;
+    surf = PySurface_AsSurface (surfobj);
+    if (surf->flags & SDL_OPENGL)
+    {
+        temp = surf = opengltosdl ();
+        if (!surf)
+            return NULL;
+    }
+
+    size = tostring_pixel_size (surf, format);
+    if (size)
+        string = Bytes_FromStringAndSize (NULL,
+                                          (Py_ssize_t) surf->w * surf->h * size);
+    if (string)
+    {
+        char *data = Bytes_AS_STRING (string);
+
+        if (!temp)
+            PySurface_Lock (surfobj);
+        Py_BEGIN_ALLOW_THREADS;
+        tostring_pixels (surf, format, flipped, data);
+        Py_END_ALLOW_THREADS;
+        if (!temp)
+            PySurface_Unlock (surfobj);
+    }
+
+    if (temp)
+        SDL_FreeSurface (temp);
+    return string;
+}
+
+static PyObject*
+image_tobuffer (PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *buffer;
+    char *format;
+    SDL_Surface *surf, *temp = NULL;
+    int flipped = 0;
+    int size;
+    Pg_buffer pg_view;
+    Py_buffer *view_p = (Py_buffer*) &pg_view;
+    Py_ssize_t needed;
+
+    if (!PyArg_ParseTuple (arg, "O!sO|i", &PySurface_Type, &surfobj, &format,
+                           &buffer, &flipped))
+        return NULL;
+    surf = PySurface_AsSurface (surfobj);
+    if (surf->flags & SDL_OPENGL)
+    {
+        temp = surf = opengltosdl ();
+        if (!surf)
+            return NULL;
+    }
+
+    size = tostring_pixel_size (surf, format);
+    if (!size)
     {
         if (temp)
             SDL_FreeSurface (temp);
-        return RAISE (PyExc_ValueError, "Unrecognized type of format");
+        return NULL;
+    }
+    needed = (Py_ssize_t) surf->w * surf->h * size;
+
+    view_p->obj = 0;
+    if (PgObject_GetBuffer (buffer, &pg_view, PyBUF_WRITABLE))
+    {
+        if (temp)
+            SDL_FreeSurface (temp);
+        return NULL;
+    }
+    if (view_p->len < needed)
+    {
+        PgBuffer_Release (&pg_view);
+        if (temp)
+            SDL_FreeSurface (temp);
+        return PyErr_Format (PyExc_ValueError,
+                             "buffer too small: %ld bytes needed, got %ld",
+                             (long) needed, (long) view_p->len);
     }
 
+    if (!temp)
+        PySurface_Lock (surfobj);
+    Py_BEGIN_ALLOW_THREADS;
+    tostring_pixels (surf, format, flipped, (char*) view_p->buf);
+    Py_END_ALLOW_THREADS;
+    if (!temp)
+        PySurface_Unlock (surfobj);
+
+    PgBuffer_Release (&pg_view);
     if (temp)
         SDL_FreeSurface (temp);
-    return string;
+    Py_RETURN_NONE;
 }
 
 PyObject*
@@ -891,13 +2745,9 @@ image_fromstring (PyObject* self, PyObject* arg)
         SDL_LockSurface (surf);
         for (looph = 0; looph < h; ++looph)
         {
-            Uint32* pix = (Uint32*) DATAROW (surf->pixels, looph, surf->pitch,
-                                             h, flipped);
-            for (loopw = 0; loopw < w; ++loopw)
-            {
-                *pix++ = *((Uint32*) data);
-                data += 4;
-            }
+            memcpy (DATAROW (surf->pixels, looph, surf->pitch, h, flipped),
+                    data, (size_t) w * 4);
+            data += w * 4;
         }
         SDL_UnlockSurface (surf);
     }
@@ -918,13 +2768,9 @@ image_fromstring (PyObject* self, PyObject* arg)
         SDL_LockSurface (surf);
         for (looph = 0; looph < h; ++looph)
         {
-            Uint32* pix = (Uint32*) DATAROW (surf->pixels, looph, surf->pitch,
-                                             h, flipped);
-            for (loopw = 0; loopw < w; ++loopw)
-            {
-                *pix++ = *((Uint32*) data);
-                data += 4;
-            }
+            memcpy (DATAROW (surf->pixels, looph, surf->pitch, h, flipped),
+                    data, (size_t) w * 4);
+            data += w * 4;
         }
         SDL_UnlockSurface (surf);
     }
@@ -1076,7 +2922,63 @@ enum tga_type
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
-#define TGA_RLE_MAX 128                /* max length of a TGA RLE chunk */
+#define TGA_RLE_MAX 128                /* max length of a TGA RLE chunk */
+#define TGA_BAND_ROWS 64        /* rows converted by each blit when saving */
+
+/* return the number of pixels from x on, up to TGA_RLE_MAX, that equal
+   the pixel at x */
+static int
+rle_run (const Uint8 *src, int x, int w, int bpp)
+{
+    int end = MIN (w, x + TGA_RLE_MAX);
+    int n = x + 1;
+
+    if (bpp == 4)
+    {
+        Uint32 pix, next;
+
+        memcpy (&pix, src + 4 * x, 4);
+#ifdef IMAGE_SSE2
+        {
+            /* compare four pixels at a time */
+            __m128i ref = _mm_set1_epi32 ((int) pix);
+            int m;
+
+            for (; n + 4 <= end; n += 4)
+            {
+                m = _mm_movemask_epi8 (_mm_cmpeq_epi32 (
+                    _mm_loadu_si128 ((const __m128i*) (src + 4 * n)), ref));
+                if (m != 0xffff)
+                {
+                    for (; (m & 0xf) == 0xf; m >>= 4)
+                        n++;
+                    return n - x;
+                }
+            }
+        }
+#endif
+        for (; n < end; n++)
+        {
+            memcpy (&next, src + 4 * n, 4);
+            if (next != pix)
+                break;
+        }
+    }
+    else
+    {
+        const Uint8 *pix = src + x * bpp;
+
+        for (; n < end; n++)
+        {
+            const Uint8 *next = src + n * bpp;
+            if (next[0] != pix[0] ||
+                (bpp == 3 && (next[1] != pix[1] || next[2] != pix[2])))
+                break;
+        }
+    }
+    return n - x;
+}
+
 /* return the number of bytes in the resulting buffer after RLE-encoding
    a line of TGA data */
 static int
@@ -1087,17 +2989,17 @@ rle_line (Uint8 *src, Uint8 *dst, int w, int bpp)
     int raw = 0;
     while (x < w)
     {
-        Uint32 pix;
         int x0 = x;
-        memcpy (&pix, src + x * bpp, bpp);
-        x++;
-        while (x < w && memcmp (&pix, src + x * bpp, bpp) == 0
-               && x - x0 < TGA_RLE_MAX)
-            x++;
+        x += rle_run (src, x, w, bpp);
         /* use a repetition chunk iff the repeated pixels would consume
            two bytes or more */
         if ((x - x0 - 1) * bpp >= 2 || x == w)
         {
+            /* at the end of the line, a short run goes out raw, keeping
+               the output within w * bpp + 1 + w / TGA_RLE_MAX bytes */
+            if ((x - x0 - 1) * bpp < 2)
+                x0 = x;
+
             /* output previous raw chunks */
             while (raw < x0)
             {
@@ -1112,7 +3014,7 @@ rle_line (Uint8 *src, Uint8 *dst, int w, int bpp)
             {
                 /* output new repetition chunk */
                 dst[out++] = 0x7f + x - x0;
-                memcpy (dst + out, &pix, bpp);
+                memcpy (dst + out, src + x0 * bpp, bpp);
                 out += bpp;
             }
             raw = x;
@@ -1121,6 +3023,28 @@ rle_line (Uint8 *src, Uint8 *dst, int w, int bpp)
     return out;
 }
 
+/* the masks of 24 and 32 bit TGA pixels, stored blue first */
+static void
+tga_masks (int bytes, int alpha, Uint32 *rmask, Uint32 *gmask, Uint32 *bmask,
+           Uint32 *amask)
+{
+    if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+    {
+        int s = bytes == 4 ? 0 : 8;
+        *amask = alpha ? 0x000000ff : 0;
+        *rmask = 0x0000ff00 >> s;
+        *gmask = 0x00ff0000 >> s;
+        *bmask = 0xff000000 >> s;
+    }
+    else
+    {
+        *amask = alpha ? 0xff000000 : 0;
+        *rmask = 0x00ff0000;
+        *gmask = 0x0000ff00;
+        *bmask = 0x000000ff;
+    }
+}
+
 /*
  * Save a surface to an output stream in TGA format.
  * 8bpp surfaces are saved as indexed images with 24bpp palette, or with
@@ -1128,7 +3052,8 @@ rle_line (Uint8 *src, Uint8 *dst, int w, int bpp)
  * 15, 16, 24 and 32bpp surfaces are saved as 24bpp RGB images,
  * or as 32bpp RGBA images if alpha channel is used.
  *
- * RLE compression is not used in the output file.
+ * The surface is converted TGA_BAND_ROWS rows at a time, and each band is
+ * written with a single call.
  *
  * Returns -1 upon error, 0 if success
  */
@@ -1145,6 +3070,9 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
     Uint32 rmask, gmask, bmask, amask;
     SDL_Rect r;
     int bpp;
+    int band;
+    int y;
+    int result = -1;
     Uint8 *rlebuf = NULL;
 
     h.infolen = 0;
@@ -1185,21 +3113,7 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
         }
         else
             h.pixel_bits = 24;
-        if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-        {
-            int s = alpha ? 0 : 8;
-            amask = 0x000000ff >> s;
-            rmask = 0x0000ff00 >> s;
-            gmask = 0x00ff0000 >> s;
-            bmask = 0xff000000 >> s;
-        }
-        else
-        {
-            amask = alpha ? 0xff000000 : 0;
-            rmask = 0x00ff0000;
-            gmask = 0x0000ff00;
-            bmask = 0x000000ff;
-        }
+        tga_masks (h.pixel_bits >> 3, alpha, &rmask, &gmask, &bmask, &amask);
     }
     bpp = h.pixel_bits >> 3;
     if (rle)
@@ -1230,8 +3144,11 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
         }
     }
 
-    linebuf = SDL_CreateRGBSurface (SDL_SWSURFACE, surface->w, 1, h.pixel_bits,
-                                    rmask, gmask, bmask, amask);
+    band = MIN (TGA_BAND_ROWS, surface->h);
+    if (band < 1)
+        return 0;
+    linebuf = SDL_CreateRGBSurface (SDL_SWSURFACE, surface->w, band,
+                                    h.pixel_bits, rmask, gmask, bmask, amask);
     if (!linebuf)
         return -1;
     if (h.has_cmap)
@@ -1239,7 +3156,8 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
                        surface->format->palette->ncolors);
     if (rle)
     {
-        rlebuf = malloc (bpp * surface->w + 1 + surface->w / TGA_RLE_MAX);
+        rlebuf = malloc ((size_t) band *
+                         (bpp * surface->w + 1 + surface->w / TGA_RLE_MAX));
         if (!rlebuf)
         {
             SDL_SetError ("out of memory");
@@ -1258,26 +3176,42 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
 
     r.x = 0;
     r.w = surface->w;
-    r.h = 1;
-    for (r.y = 0; r.y < surface->h; r.y++)
+    for (y = 0; y < surface->h; y += band)
     {
-        int n;
-        void *buf;
+        int rows = MIN (band, surface->h - y);
+        int i;
+        int n = 0;
+        Uint8 *pixels = linebuf->pixels;
+
+        r.y = y;
+        r.h = rows;
         if (SDL_BlitSurface (surface, &r, linebuf, NULL) < 0)
             break;
         if (rle)
         {
-            buf = rlebuf;
-            n = rle_line (linebuf->pixels, rlebuf, surface->w, bpp);
+            for (i = 0; i < rows; i++)
+                n += rle_line (pixels + i * linebuf->pitch, rlebuf + n,
+                               surface->w, bpp);
+            if (!SDL_RWwrite (out, rlebuf, n, 1))
+                break;
+        }
+        else if (linebuf->pitch == surface->w * bpp)
+        {
+            if (!SDL_RWwrite (out, pixels, surface->w * bpp * rows, 1))
+                break;
         }
         else
         {
-            buf = linebuf->pixels;
-            n = surface->w * bpp;
+            for (i = 0; i < rows; i++)
+                if (!SDL_RWwrite (out, pixels + i * linebuf->pitch,
+                                  surface->w * bpp, 1))
+                    break;
+            if (i < rows)
+                break;
         }
-        if (!SDL_RWwrite (out, buf, n, 1))
-            break;
     }
+    if (y >= surface->h)
+        result = 0;
 
     /* restore flags */
     if (surf_flags & SDL_SRCALPHA)
@@ -1288,7 +3222,7 @@ SaveTGA_RW (SDL_Surface *surface, SDL_RWops *out, int rle)
 error:
     free (rlebuf);
     SDL_FreeSurface (linebuf);
-    return 0;
+    return result;
 }
 
 static int
@@ -1303,14 +3237,681 @@ SaveTGA (SDL_Surface *surface, const char *file, int rle)
     return ret;
 }
 
+/* buffered reading for the decoders below */
+#define READER_BUFSIZE 65536
+
+typedef struct
+{
+    SDL_RWops *rw;
+    size_t pos;
+    size_t len;
+    Uint8 buf[READER_BUFSIZE];
+} image_reader;
+
+/* make at least n bytes available at buf + pos, n <= READER_BUFSIZE, and
+   return the number available; fewer than n only at the end of the data */
+static size_t
+reader_fill (image_reader *reader, size_t n)
+{
+    int got;
+
+    if (reader->len - reader->pos >= n)
+        return reader->len - reader->pos;
+    memmove (reader->buf, reader->buf + reader->pos, reader->len - reader->pos);
+    reader->len -= reader->pos;
+    reader->pos = 0;
+    while (reader->len < n)
+    {
+        got = SDL_RWread (reader->rw, reader->buf + reader->len, 1,
+                          (int) (READER_BUFSIZE - reader->len));
+        if (got <= 0)
+            break;
+        reader->len += got;
+    }
+    return reader->len;
+}
+
+/* copy the next n bytes to dst, or skip them if dst is NULL; returns -1
+   with an SDL error at the end of the data */
+static int
+reader_read (image_reader *reader, void *dst, size_t n)
+{
+    Uint8 *out = dst;
+    size_t chunk;
+
+    while (n > 0)
+    {
+        if (reader->pos == reader->len && !reader_fill (reader, 1))
+        {
+            SDL_SetError ("premature end of image data");
+            return -1;
+        }
+        chunk = MIN (n, reader->len - reader->pos);
+        if (out)
+        {
+            memcpy (out, reader->buf + reader->pos, chunk);
+            out += chunk;
+        }
+        reader->pos += chunk;
+        n -= chunk;
+    }
+    return 0;
+}
+
+static image_reader*
+new_reader (SDL_RWops *rw)
+{
+    image_reader *reader = malloc (sizeof (image_reader));
+
+    if (!reader)
+    {
+        SDL_SetError ("out of memory");
+        return NULL;
+    }
+    reader->rw = rw;
+    reader->pos = reader->len = 0;
+    return reader;
+}
+
+/* create a surface for a decoder, refusing sizes SDL's 16 bit pitch
+   cannot describe */
+static SDL_Surface*
+new_image_surface (Uint32 flags, Uint32 w, Uint32 h, int depth, Uint32 rmask,
+                   Uint32 gmask, Uint32 bmask, Uint32 amask)
+{
+    Uint32 bytes = (depth + 7) / 8;
+
+    if (w == 0 || h == 0 || w > 0xffff || h > 0xffff ||
+        ((w * bytes + 3) & ~3) > 0xffff)
+    {
+        SDL_SetError ("unsupported image size %lux%lu", (unsigned long) w,
+                      (unsigned long) h);
+        return NULL;
+    }
+    return SDL_CreateRGBSurface (SDL_SWSURFACE | flags, (int) w, (int) h,
+                                 depth, rmask, gmask, bmask, amask);
+}
+
+/*
+ * Load a TGA image: uncompressed or RLE, 8 bit indexed with a 24 or 32 bit
+ * colormap, 8 bit greyscale, or 15, 16, 24 and 32 bit RGB.  Used when
+ * SDL_image is not available.
+ */
+static SDL_Surface*
+LoadTGA_RW (SDL_RWops *src, int freesrc)
+{
+    struct TGAheader h;
+    image_reader *reader;
+    SDL_Surface *surf = NULL;
+    SDL_Color colors[256];
+    Uint32 rmask = 0, gmask = 0, bmask = 0, amask = 0;
+    int type, rle, w, height, bpp, alpha;
+    int cmap_start, cmap_len, cmap_bytes;
+    int count = 0, repeat = 0;
+    Uint8 pix[4];
+    int i, x, y;
+
+    reader = new_reader (src);
+    if (!reader)
+        goto done;
+    if (reader_read (reader, &h, sizeof (h)) < 0 ||
+        reader_read (reader, NULL, h.infolen) < 0)
+        goto done;
+
+    type = h.type & ~TGA_TYPE_RLE;
+    rle = h.type & TGA_TYPE_RLE;
+    w = LE16 (h.width);
+    height = LE16 (h.height);
+    bpp = (h.pixel_bits + 7) >> 3;
+    alpha = (h.flags & 0x0f) != 0;
+    cmap_start = LE16 (h.cmap_start);
+    cmap_len = LE16 (h.cmap_len);
+    cmap_bytes = (h.cmap_bits + 7) >> 3;
+
+    if ((h.flags & (TGA_INTERLEAVE_MASK | TGA_ORIGIN_RIGHT)) ||
+        !((type == TGA_TYPE_INDEXED && h.pixel_bits == 8 && h.has_cmap &&
+           (h.cmap_bits == 24 || h.cmap_bits == 32) &&
+           cmap_start + cmap_len <= 256) ||
+          (type == TGA_TYPE_RGB &&
+           (h.pixel_bits == 15 || h.pixel_bits == 16 ||
+            h.pixel_bits == 24 || h.pixel_bits == 32)) ||
+          (type == TGA_TYPE_BW && h.pixel_bits == 8)))
+    {
+        SDL_SetError ("unsupported TGA image");
+        goto done;
+    }
+
+    if (type == TGA_TYPE_INDEXED)
+    {
+        memset (colors, 0, sizeof (colors));
+        for (i = cmap_start; i < cmap_start + cmap_len; i++)
+        {
+            if (reader_read (reader, pix, cmap_bytes) < 0)
+                goto done;
+            colors[i].b = pix[0];
+            colors[i].g = pix[1];
+            colors[i].r = pix[2];
+            colors[i].unused = cmap_bytes == 4 ? pix[3] : 0xff;
+        }
+    }
+    else if (h.has_cmap &&
+             reader_read (reader, NULL, (size_t) cmap_len * cmap_bytes) < 0)
+        goto done;
+
+    if (type != TGA_TYPE_RGB)
+        surf = new_image_surface (0, w, height, 8, 0, 0, 0, 0);
+    else if (bpp == 2)
+        surf = new_image_surface (0, w, height, h.pixel_bits, 0x7c00, 0x03e0,
+                                  0x001f, alpha ? 0x8000 : 0);
+    else
+    {
+        tga_masks (bpp, alpha && bpp == 4, &rmask, &gmask, &bmask, &amask);
+        surf = new_image_surface (amask ? SDL_SRCALPHA : 0, w, height,
+                                  h.pixel_bits, rmask, gmask, bmask, amask);
+    }
+    if (!surf)
+        goto done;
+
+    if (type == TGA_TYPE_BW)
+    {
+        for (i = 0; i < 256; i++)
+            colors[i].r = colors[i].g = colors[i].b = i;
+        SDL_SetColors (surf, colors, 0, 256);
+    }
+    else if (type == TGA_TYPE_INDEXED)
+    {
+        SDL_SetColors (surf, colors, 0, 256);
+        for (i = cmap_start; i < cmap_start + cmap_len; i++)
+        {
+            if (colors[i].unused == 0)
+            {
+                SDL_SetColorKey (surf, SDL_SRCCOLORKEY, i);
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < height; i++)
+    {
+        Uint8 *row;
+
+        y = (h.flags & TGA_ORIGIN_UPPER) ? i : height - 1 - i;
+        row = (Uint8*) surf->pixels + y * surf->pitch;
+        if (!rle)
+        {
+            if (reader_read (reader, row, (size_t) w * bpp) < 0)
+                goto error;
+        }
+        else
+        {
+            /* RLE packets may run on from one row to the next */
+            for (x = 0; x < w;)
+            {
+                int n;
+
+                if (count == 0)
+                {
+                    Uint8 packet;
+
+                    if (reader_read (reader, &packet, 1) < 0)
+                        goto error;
+                    count = (packet & 0x7f) + 1;
+                    repeat = packet & 0x80;
+                    if (repeat && reader_read (reader, pix, bpp) < 0)
+                        goto error;
+                }
+                n = MIN (count, w - x);
+                if (!repeat)
+                {
+                    if (reader_read (reader, row + x * bpp, (size_t) n * bpp)
+                        < 0)
+                        goto error;
+                }
+                else if (bpp == 1)
+                    memset (row + x, pix[0], n);
+                else
+                {
+                    Uint8 *dst = row + x * bpp;
+                    int k;
+
+                    for (k = 0; k < n; k++, dst += bpp)
+                        memcpy (dst, pix, bpp);
+                }
+                count -= n;
+                x += n;
+            }
+        }
+        if (SDL_BYTEORDER == SDL_BIG_ENDIAN && bpp == 2)
+        {
+            Uint16 *p = (Uint16*) row;
+
+            for (x = 0; x < w; x++)
+                p[x] = SDL_SwapLE16 (p[x]);
+        }
+    }
+    goto done;
+
+error:
+    SDL_FreeSurface (surf);
+    surf = NULL;
+done:
+    free (reader);
+    if (freesrc)
+        SDL_RWclose (src);
+    return surf;
+}
+
+/*
+ * QOI, the "Quite OK Image" format from https://qoiformat.org: lossless
+ * and much faster to encode and decode than PNG, for a similar size.
+ */
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+#define QOI_HEADER_SIZE 14
+#define QOI_RUN_MAX 62
+#define QOI_BUFSIZE 65536
+#define QOI_HASH(p) \
+    (((p)[0] * 3 + (p)[1] * 5 + (p)[2] * 7 + (p)[3] * 11) & 63)
+
+/* surfaces hold QOI pixels as R, G, B, A bytes */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define QOI_RMASK 0x000000ff
+#define QOI_GMASK 0x0000ff00
+#define QOI_BMASK 0x00ff0000
+#define QOI_AMASK 0xff000000
+#else
+#define QOI_RMASK 0xff000000
+#define QOI_GMASK 0x00ff0000
+#define QOI_BMASK 0x0000ff00
+#define QOI_AMASK 0x000000ff
+#endif
+
+static const Uint8 qoi_end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+#define SETBE32(p, v)                                           \
+    ((p)[0] = (Uint8) ((v) >> 24), (p)[1] = (Uint8) ((v) >> 16), \
+     (p)[2] = (Uint8) ((v) >> 8), (p)[3] = (Uint8) (v))
+#define BE32(p)                                                     \
+    (((Uint32) (p)[0] << 24) | ((Uint32) (p)[1] << 16) |            \
+     ((Uint32) (p)[2] << 8) | (Uint32) (p)[3])
+
+/* Read row y of a locked surface as R, G, B, A bytes.  order holds the
+   byte of each channel within a pixel, when all are whole bytes. */
+static void
+qoi_read_row (SDL_Surface *surf, int y, Uint8 *rgba, const int *order,
+              int ckey)
+{
+    SDL_PixelFormat *fmt = surf->format;
+    int bpp = fmt->BytesPerPixel;
+    Uint8 *src = (Uint8*) surf->pixels + y * surf->pitch;
+    Uint32 color = 0;
+    int x;
+
+    if (order)
+    {
+        for (x = 0; x < surf->w; x++, src += bpp, rgba += 4)
+        {
+            rgba[0] = src[order[0]];
+            rgba[1] = src[order[1]];
+            rgba[2] = src[order[2]];
+            rgba[3] = order[3] < 0 ? 255 : src[order[3]];
+        }
+        return;
+    }
+
+    for (x = 0; x < surf->w; x++, src += bpp, rgba += 4)
+    {
+        switch (bpp)
+        {
+        case 1:
+            color = *src;
+            break;
+        case 2:
+            color = *(Uint16*) src;
+            break;
+        case 3:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+            color = src[0] + (src[1] << 8) + (src[2] << 16);
+#else
+            color = src[2] + (src[1] << 8) + (src[0] << 16);
+#endif
+            break;
+        default:
+            color = *(Uint32*) src;
+            break;
+        }
+        SDL_GetRGBA (color, fmt, rgba, rgba + 1, rgba + 2, rgba + 3);
+        if (ckey && color == fmt->colorkey)
+            rgba[3] = 0;
+    }
+}
+
+/*
+ * Save a surface to an output stream in QOI format, with an alpha channel
+ * if the surface has per pixel alpha or a colorkey.
+ *
+ * Returns -1 upon error, 0 if success
+ */
+static int
+SaveQOI_RW (SDL_Surface *surface, SDL_RWops *out)
+{
+    SDL_PixelFormat *fmt = surface->format;
+    int ckey = (surface->flags & SDL_SRCCOLORKEY) && !fmt->Amask;
+    int order[4];
+    int *byte_order = NULL;
+    Uint8 index[64 * 4];
+    Uint8 prev[4] = { 0, 0, 0, 255 };
+    Uint8 *row = NULL;
+    Uint8 *buf = NULL;
+    size_t pos = 0;
+    int run = 0;
+    int result = -1;
+    int x, y;
+
+    if (!ckey && pg_channel_bytes (fmt, order) == 0)
+        byte_order = order;
+
+    row = malloc ((size_t) surface->w * 4);
+    buf = malloc (QOI_BUFSIZE);
+    if (!row || !buf)
+    {
+        SDL_SetError ("out of memory");
+        goto done;
+    }
+
+    memcpy (buf, "qoif", 4);
+    SETBE32 (buf + 4, (Uint32) surface->w);
+    SETBE32 (buf + 8, (Uint32) surface->h);
+    buf[12] = (fmt->Amask || ckey) ? 4 : 3;
+    buf[13] = 0;                /* sRGB with linear alpha */
+    pos = QOI_HEADER_SIZE;
+    memset (index, 0, sizeof (index));
+
+    if (SDL_LockSurface (surface) < 0)
+        goto done;
+    for (y = 0; y < surface->h; y++)
+    {
+        const Uint8 *px = row;
+
+        qoi_read_row (surface, y, row, byte_order, ckey);
+        for (x = 0; x < surface->w; x++, px += 4)
+        {
+            /* room for a run ending and the longest chunk, QOI_OP_RGBA */
+            if (pos > QOI_BUFSIZE - 6)
+            {
+                if (!SDL_RWwrite (out, buf, pos, 1))
+                    goto unlock;
+                pos = 0;
+            }
+            if (memcmp (px, prev, 4) == 0)
+            {
+                if (++run == QOI_RUN_MAX)
+                {
+                    buf[pos++] = QOI_OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0)
+            {
+                buf[pos++] = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            {
+                int hash = QOI_HASH (px);
+
+                if (memcmp (index + hash * 4, px, 4) == 0)
+                    buf[pos++] = QOI_OP_INDEX | hash;
+                else
+                {
+                    memcpy (index + hash * 4, px, 4);
+                    if (px[3] == prev[3])
+                    {
+                        signed char vr = (signed char) (px[0] - prev[0]);
+                        signed char vg = (signed char) (px[1] - prev[1]);
+                        signed char vb = (signed char) (px[2] - prev[2]);
+                        signed char vg_r = vr - vg;
+                        signed char vg_b = vb - vg;
+
+                        if (vr > -3 && vr < 2 && vg > -3 && vg < 2 &&
+                            vb > -3 && vb < 2)
+                            buf[pos++] = QOI_OP_DIFF | (vr + 2) << 4 |
+                                (vg + 2) << 2 | (vb + 2);
+                        else if (vg_r > -9 && vg_r < 8 && vg > -33 &&
+                                 vg < 32 && vg_b > -9 && vg_b < 8)
+                        {
+                            buf[pos++] = QOI_OP_LUMA | (vg + 32);
+                            buf[pos++] = (vg_r + 8) << 4 | (vg_b + 8);
+                        }
+                        else
+                        {
+                            buf[pos++] = QOI_OP_RGB;
+                            buf[pos++] = px[0];
+                            buf[pos++] = px[1];
+                            buf[pos++] = px[2];
+                        }
+                    }
+                    else
+                    {
+                        buf[pos++] = QOI_OP_RGBA;
+                        memcpy (buf + pos, px, 4);
+                        pos += 4;
+                    }
+                }
+            }
+            memcpy (prev, px, 4);
+        }
+    }
+    if (pos > QOI_BUFSIZE - 1 - sizeof (qoi_end))
+    {
+        if (!SDL_RWwrite (out, buf, pos, 1))
+            goto unlock;
+        pos = 0;
+    }
+    if (run > 0)
+        buf[pos++] = QOI_OP_RUN | (run - 1);
+    memcpy (buf + pos, qoi_end, sizeof (qoi_end));
+    pos += sizeof (qoi_end);
+    if (SDL_RWwrite (out, buf, pos, 1))
+        result = 0;
+
+unlock:
+    SDL_UnlockSurface (surface);
+done:
+    free (buf);
+    free (row);
+    return result;
+}
+
+static int
+SaveQOI (SDL_Surface *surface, const char *file)
+{
+    SDL_RWops *out = SDL_RWFromFile (file, "wb");
+    int ret;
+    if (!out)
+        return -1;
+    ret = SaveQOI_RW (surface, out);
+    SDL_RWclose (out);
+    return ret;
+}
+
+/* Load a QOI image.  Without a target, or one that is not 32 bit with
+   byte channels, it is a 32 bit surface with per pixel alpha if it has an
+   alpha channel.  Otherwise it is decoded straight into the target
+   format. */
+static SDL_Surface*
+load_qoi (SDL_RWops *src, int freesrc, const convert_target *target)
+{
+    image_reader *reader;
+    SDL_Surface *surf = NULL;
+    Uint8 header[QOI_HEADER_SIZE];
+    Uint8 index[64 * 4];
+    Uint8 px[4] = { 0, 0, 0, 255 };
+    int order[4];
+    const SDL_PixelFormat *fmt = NULL;
+    const convert_target *convert_after = NULL;
+    int alpha;
+    int run = 0;
+    int x, y;
+
+    reader = new_reader (src);
+    if (!reader)
+        goto done;
+    if (reader_read (reader, header, QOI_HEADER_SIZE) < 0)
+        goto done;
+    if (memcmp (header, "qoif", 4) != 0 ||
+        (header[12] != 3 && header[12] != 4) || header[13] > 1)
+    {
+        SDL_SetError ("not a QOI image");
+        goto done;
+    }
+    alpha = header[12] == 4;
+
+    if (target && target->format)
+    {
+        if (target->format->BytesPerPixel == 4 &&
+            pg_channel_bytes (target->format, order) == 0 &&
+            (!alpha || target->format->Amask))
+            fmt = target->format;
+        else
+            convert_after = target;     /* decode, then convert */
+    }
+    if (fmt)
+    {
+        if (order[3] < 0)
+            order[3] = 6 - order[0] - order[1] - order[2];
+        surf = new_image_surface (target->flags |
+                                  (alpha ? target->keep_flags & SDL_SRCALPHA
+                                   : 0),
+                                  BE32 (header + 4), BE32 (header + 8), 32,
+                                  fmt->Rmask, fmt->Gmask, fmt->Bmask,
+                                  fmt->Amask);
+    }
+    else
+    {
+        for (x = 0; x < 4; x++)
+            order[x] = x;
+        surf = new_image_surface (alpha ? SDL_SRCALPHA : 0,
+                                  BE32 (header + 4), BE32 (header + 8), 32,
+                                  QOI_RMASK, QOI_GMASK, QOI_BMASK,
+                                  alpha ? QOI_AMASK : 0);
+    }
+    if (!surf)
+        goto done;
+    memset (index, 0, sizeof (index));
+
+    for (y = 0; y < surf->h; y++)
+    {
+        Uint8 *dst = (Uint8*) surf->pixels + y * surf->pitch;
+
+        for (x = 0; x < surf->w; x++, dst += 4)
+        {
+            if (run > 0)
+                run--;
+            else
+            {
+                const Uint8 *b;
+                int b1;
+
+                /* the 8 byte end marker follows the last chunk, so a
+                   valid stream always has 5 bytes here */
+                if (reader_fill (reader, 5) < 5)
+                {
+                    SDL_SetError ("premature end of image data");
+                    goto error;
+                }
+                b = reader->buf + reader->pos;
+                b1 = b[0];
+                if (b1 == QOI_OP_RGB)
+                {
+                    memcpy (px, b + 1, 3);
+                    reader->pos += 4;
+                }
+                else if (b1 == QOI_OP_RGBA)
+                {
+                    memcpy (px, b + 1, 4);
+                    reader->pos += 5;
+                }
+                else
+                {
+                    int vg;
+
+                    switch (b1 & QOI_MASK_2)
+                    {
+                    case QOI_OP_INDEX:
+                        memcpy (px, index + b1 * 4, 4);
+                        break;
+                    case QOI_OP_DIFF:
+                        px[0] += ((b1 >> 4) & 0x03) - 2;
+                        px[1] += ((b1 >> 2) & 0x03) - 2;
+                        px[2] += (b1 & 0x03) - 2;
+                        break;
+                    case QOI_OP_LUMA:
+                        vg = (b1 & 0x3f) - 32;
+                        px[0] += vg - 8 + ((b[1] >> 4) & 0x0f);
+                        px[1] += vg;
+                        px[2] += vg - 8 + (b[1] & 0x0f);
+                        reader->pos++;
+                        break;
+                    default:
+                        run = b1 & 0x3f;
+                        break;
+                    }
+                    reader->pos++;
+                }
+                memcpy (index + QOI_HASH (px) * 4, px, 4);
+            }
+            dst[order[0]] = px[0];
+            dst[order[1]] = px[1];
+            dst[order[2]] = px[2];
+            dst[order[3]] = alpha ? px[3] : 255;
+        }
+    }
+    goto done;
+
+error:
+    SDL_FreeSurface (surf);
+    surf = NULL;
+done:
+    free (reader);
+    if (freesrc)
+        SDL_RWclose (src);
+    return convert_after ? convert_loaded (surf, convert_after) : surf;
+}
+
+static SDL_Surface*
+LoadQOI_RW (SDL_RWops *src, int freesrc)
+{
+    return load_qoi (src, freesrc, NULL);
+}
+
 static PyMethodDef _image_methods[] =
 {
+    { "load", (PyCFunction) image_load, METH_VARARGS | METH_KEYWORDS,
+      DOC_PYGAMEIMAGELOAD },
     { "load_basic", image_load_basic, METH_VARARGS, DOC_PYGAMEIMAGELOAD },
-    { "save", image_save, METH_VARARGS, DOC_PYGAMEIMAGESAVE },
+    { "load_many", (PyCFunction) image_load_many,
+      METH_VARARGS | METH_KEYWORDS, DOC_PYGAMEIMAGELOADMANY },
+    { "load_async", (PyCFunction) image_load_async,
+      METH_VARARGS | METH_KEYWORDS, DOC_PYGAMEIMAGELOADASYNC },
+    { "load_pack", image_load_pack, METH_O, DOC_PYGAMEIMAGELOADPACK },
+    { "save_pack", (PyCFunction) image_save_pack,
+      METH_VARARGS | METH_KEYWORDS, DOC_PYGAMEIMAGESAVEPACK },
+    { "save", (PyCFunction) image_save, METH_VARARGS | METH_KEYWORDS,
+      DOC_PYGAMEIMAGESAVE },
+    { "save_async", (PyCFunction) image_save_async,
+      METH_VARARGS | METH_KEYWORDS, DOC_PYGAMEIMAGESAVEASYNC },
     { "get_extended", (PyCFunction) image_get_extended, METH_NOARGS,
       DOC_PYGAMEIMAGEGETEXTENDED },
 
     { "tostring", image_tostring, METH_VARARGS, DOC_PYGAMEIMAGETOSTRING },
+    { "tobuffer", image_tobuffer, METH_VARARGS, DOC_PYGAMEIMAGETOBUFFER },
     { "fromstring", image_fromstring, METH_VARARGS, DOC_PYGAMEIMAGEFROMSTRING },
     { "frombuffer", image_frombuffer, METH_VARARGS, DOC_PYGAMEIMAGEFROMBUFFER },
 
@@ -1322,6 +3923,7 @@ MODINIT_DEFINE (image)
 {
     PyObject *module;
     PyObject *extmodule;
+    PyObject *apiobj;
     struct _module_state *st;
 
 #if PY3
@@ -1353,6 +3955,16 @@ MODINIT_DEFINE (image)
     {
         MODINIT_ERROR;
     }
+    import_pygame_event ();
+    if (PyErr_Occurred ())
+    {
+        MODINIT_ERROR;
+    }
+    import_pygame_mask ();
+    if (PyErr_Occurred ())
+    {
+        MODINIT_ERROR;
+    }
 
     /* create the module */
 #if PY3
@@ -1365,6 +3977,27 @@ MODINIT_DEFINE (image)
         MODINIT_ERROR;
     }
     st = GETSTATE (module);
+    st->load_file = load_bmp_file;
+    st->save_file = NULL;
+    st->load_rw = NULL;
+    st->load_png_into = NULL;
+
+    if (PyModule_AddIntConstant (module, "PNG_FILTER_NONE",
+                                 PG_PNG_FILTER_NONE) ||
+        PyModule_AddIntConstant (module, "PNG_FILTER_SUB",
+                                 PG_PNG_FILTER_SUB) ||
+        PyModule_AddIntConstant (module, "PNG_FILTER_UP",
+                                 PG_PNG_FILTER_UP) ||
+        PyModule_AddIntConstant (module, "PNG_FILTER_AVG",
+                                 PG_PNG_FILTER_AVG) ||
+        PyModule_AddIntConstant (module, "PNG_FILTER_PAETH",
+                                 PG_PNG_FILTER_PAETH) ||
+        PyModule_AddIntConstant (module, "PNG_ALL_FILTERS",
+                                 PG_PNG_ALL_FILTERS))
+    {
+        DECREF_MOD (module);
+        MODINIT_ERROR;
+    }
 
 
     /* try to get extended formats */
@@ -1400,23 +4033,33 @@ MODINIT_DEFINE (image)
             Py_DECREF(extmodule);
             MODINIT_ERROR;
         }
-        Py_INCREF (extload);
-        if (PyModule_AddObject (module, "load", extload))
+        apiobj = PyObject_GetAttrString (extmodule, PYGAMEAPI_LOCAL_ENTRY);
+        if (apiobj && PyCapsule_CheckExact (apiobj))
         {
-            Py_DECREF (extload);
-            Py_DECREF (extmodule);
-            MODINIT_ERROR;
+            void **api = (void **) PyCapsule_GetPointer (
+                apiobj, PG_CAPSULE_NAME ("imageext"));
+
+            if (api)
+            {
+                st->load_file =
+                    (pg_load_file_func) api[PG_IMAGEEXT_LOAD_FILE];
+                st->save_file =
+                    (pg_save_file_func) api[PG_IMAGEEXT_SAVE_FILE];
+                st->load_rw = (pg_load_rw_func) api[PG_IMAGEEXT_LOAD_RW];
+                st->load_png_into =
+                    (pg_load_png_into_func) api[PG_IMAGEEXT_LOAD_PNG_INTO];
+            }
         }
+        Py_XDECREF (apiobj);
+        PyErr_Clear ();
         Py_DECREF (extmodule);
         st->is_extended = 1;
     }
     else
     {
-        PyObject* basicload = PyObject_GetAttrString (module, "load_basic");
         PyErr_Clear ();
         PyModule_AddObject (module, "load_extended", Py_None);
         PyModule_AddObject (module, "save_extended", Py_None);
-        PyModule_AddObject (module, "load", basicload);
         st->is_extended = 0;
     }
     MODINIT_RETURN (module);
@@ -50,7 +50,12 @@
 #include "pgcompat.h"
 #include "doc/image_doc.h"
 #include "pgopengl.h"
+#include "pgparallel.h"
+#include "pgimage.h"
 #include <SDL_image.h>
+#ifdef PNG_H
+#include <zlib.h>
+#endif
 
 static const char*
 find_extension(const char *fullname)
@@ -184,19 +189,506 @@ png_flush_fn (png_structp png_ptr)
     }
 }
 
+/* Decoding straight into a converted surface, for image.load's convert
+ * and convert_alpha: libpng's transformations put the channels in the
+ * order of the target format, so no intermediate surface is needed.
+ */
+static void
+png_read_fn (png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    SDL_RWops *src = (SDL_RWops *)png_get_io_ptr(png_ptr);
+    if (SDL_RWread(src, data, (int)length, 1) != 1) {
+        png_error(png_ptr, "premature end of PNG data");
+    }
+}
+
+static void
+png_error_fn (png_structp png_ptr, png_const_charp message)
+{
+    SDL_SetError("PNG error: %s", message);
+    longjmp(png_jmpbuf(png_ptr), 1);
+}
+
+static void
+png_warning_fn (png_structp png_ptr, png_const_charp message)
+{
+}
+
+static int
+load_png_into (SDL_RWops *src, const SDL_PixelFormat *format, Uint32 flags,
+               Uint32 keep_flags, SDL_Surface **surfp)
+{
+    png_structp png_ptr = NULL;
+    png_infop info_ptr = NULL;
+    SDL_Surface *volatile surf = NULL;
+    png_bytep *volatile rows = NULL;
+    volatile int result = -1;
+    int start = SDL_RWtell(src);
+    int order[4];
+    int bpp = format->BytesPerPixel;
+    int first, spare, has_alpha, i;
+    png_byte sig[8];
+    png_uint_32 w, h;
+    int bitdepth, colortype, interlace;
+
+    /* The target must be R, G, B or B, G, R bytes, with any alpha or
+     * spare byte first or last.
+     */
+    if (pg_channel_bytes(format, order) < 0) {
+        return 1;
+    }
+    spare = bpp == 4 ? 6 - order[0] - order[1] - order[2] : -1;
+    first = spare == 0 ? 1 : 0;
+    if (order[1] != first + 1 ||
+        !((order[0] == first && order[2] == first + 2) ||
+          (order[2] == first && order[0] == first + 2))) {
+        return 1;
+    }
+
+    if (SDL_RWread(src, sig, sizeof(sig), 1) != 1 ||
+        png_sig_cmp(sig, 0, sizeof(sig)) != 0) {
+        SDL_RWseek(src, start, RW_SEEK_SET);
+        return 1;
+    }
+
+    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL,
+                                     png_error_fn, png_warning_fn);
+    if (png_ptr == NULL || (info_ptr = png_create_info_struct(png_ptr)) ==
+        NULL) {
+        SDL_SetError("PNG error: out of memory");
+        goto done;
+    }
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        goto done;
+    }
+    png_set_read_fn(png_ptr, src, png_read_fn);
+    png_set_sig_bytes(png_ptr, sizeof(sig));
+    png_read_info(png_ptr, info_ptr);
+    png_get_IHDR(png_ptr, info_ptr, &w, &h, &bitdepth, &colortype,
+                 &interlace, NULL, NULL);
+
+    has_alpha = (colortype & PNG_COLOR_MASK_ALPHA) ||
+        png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
+    /* SDL_image gives transparent images a colorkey or alpha, which only
+     * a target with alpha keeps the same way; leave the rest to it.
+     */
+    if ((has_alpha && !format->Amask) || w == 0 || h == 0 ||
+        w > 0xffff || h > 0xffff || ((w * bpp + 3) & ~3) > 0xffff) {
+        result = 1;
+        goto done;
+    }
+
+    if (bitdepth == 16) {
+        png_set_strip_16(png_ptr);
+    }
+    if (colortype == PNG_COLOR_TYPE_PALETTE || bitdepth < 8 ||
+        png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_set_expand(png_ptr);
+    }
+    if (!(colortype & PNG_COLOR_MASK_COLOR)) {
+        png_set_gray_to_rgb(png_ptr);
+    }
+    if (order[2] == first) {
+        png_set_bgr(png_ptr);
+    }
+    if (bpp == 4) {
+        if (has_alpha) {
+            if (spare == 0) {
+                png_set_swap_alpha(png_ptr);
+            }
+        }
+        else {
+            png_set_filler(png_ptr, format->Amask ? 0xff : 0,
+                           spare == 0 ? PNG_FILLER_BEFORE : PNG_FILLER_AFTER);
+        }
+    }
+    png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+    if (png_get_rowbytes(png_ptr, info_ptr) != (png_size_t)w * bpp) {
+        png_error(png_ptr, "unexpected row size");
+    }
+
+    surf = SDL_CreateRGBSurface(SDL_SWSURFACE | flags |
+                                (has_alpha ? keep_flags & SDL_SRCALPHA : 0),
+                                (int)w, (int)h, format->BitsPerPixel,
+                                format->Rmask, format->Gmask, format->Bmask,
+                                format->Amask);
+    rows = (png_bytep *)malloc(sizeof(png_bytep) * h);
+    if (surf == NULL || rows == NULL) {
+        png_error(png_ptr, "out of memory");
+    }
+    for (i = 0; i < (int)h; i++) {
+        rows[i] = (png_bytep)surf->pixels + i * surf->pitch;
+    }
+    png_read_image(png_ptr, rows);
+    *surfp = surf;
+    surf = NULL;
+    result = 0;
+
+done:
+    if (result == 1) {
+        SDL_RWseek(src, start, RW_SEEK_SET);
+    }
+    if (png_ptr != NULL) {
+        png_destroy_read_struct(&png_ptr, info_ptr ? &info_ptr : NULL, NULL);
+    }
+    free(rows);
+    if (surf != NULL) {
+        SDL_FreeSurface(surf);
+    }
+    return result;
+}
+
+/* Large images are encoded by hand rather than through libpng, so the
+ * deflate can be split over threads: the filtered rows are cut into
+ * blocks, each block is compressed as raw deflate data primed with the
+ * 32K before it, and the pieces are joined with sync flushes into one
+ * zlib stream.
+ */
+#define PNG_PARALLEL_MIN_BYTES (1 << 20)
+#define PNG_BLOCK_BYTES (1 << 18)
+#define PNG_WINDOW_BYTES 32768
+
+typedef struct {
+    png_bytep *rows;
+    int h;
+    int bpp;                    /* bytes per pixel */
+    size_t rowbytes;
+    int filters;
+    int level;
+    Uint8 *filtered;            /* h rows of a filter byte and rowbytes */
+    size_t size;
+    int nblocks;
+    Uint8 **out;
+    size_t *outlen;
+    uLong *adler;
+    int failed;
+} png_parallel_job;
+
+static int
+png_paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/* Filter one row with filter type into dst, returning the sum of the
+ * absolute values of the result as signed bytes: libpng's heuristic for
+ * picking a filter.
+ */
+static unsigned long
+png_filter_row(Uint8 *dst, const Uint8 *row, const Uint8 *prior,
+               size_t rowbytes, int bpp, int type)
+{
+    unsigned long sum = 0;
+    size_t i;
+    int a, b, c;
+    Uint8 v;
+
+    for (i = 0; i < rowbytes; ++i) {
+        a = i >= (size_t)bpp ? row[i - bpp] : 0;
+        b = prior[i];
+        c = i >= (size_t)bpp ? prior[i - bpp] : 0;
+        switch (type) {
+
+        case 1:
+            v = (Uint8)(row[i] - a);
+            break;
+        case 2:
+            v = (Uint8)(row[i] - b);
+            break;
+        case 3:
+            v = (Uint8)(row[i] - ((a + b) >> 1));
+            break;
+        case 4:
+            v = (Uint8)(row[i] - png_paeth(a, b, c));
+            break;
+        default:
+            v = row[i];
+            break;
+        }
+        dst[i] = v;
+        sum += v < 128 ? v : 256 - v;
+    }
+    return sum;
+}
+
+static void
+png_filter_band(void *data, int band, int start, int end)
+{
+    png_parallel_job *job = (png_parallel_job *)data;
+    Uint8 *zeros = NULL;
+    Uint8 *scratch = NULL;
+    Uint8 *dst;
+    const Uint8 *prior;
+    unsigned long sum, best;
+    int y, type, besttype;
+
+    zeros = (Uint8 *)calloc(1, job->rowbytes);
+    scratch = (Uint8 *)malloc(job->rowbytes);
+    if (zeros == NULL || scratch == NULL) {
+        job->failed = 1;
+        goto end;
+    }
+    for (y = start; y < end; ++y) {
+        dst = job->filtered + y * (job->rowbytes + 1);
+        prior = y > 0 ? job->rows[y - 1] : zeros;
+        best = 0;
+        besttype = -1;
+        for (type = 0; type < 5; ++type) {
+            if (!(job->filters & (PG_PNG_FILTER_NONE << type))) {
+                continue;
+            }
+            sum = png_filter_row(besttype < 0 ? dst + 1 : scratch,
+                                 job->rows[y], prior, job->rowbytes,
+                                 job->bpp, type);
+            if (besttype < 0) {
+                best = sum;
+                besttype = type;
+            }
+            else if (sum < best) {
+                best = sum;
+                besttype = type;
+                memcpy(dst + 1, scratch, job->rowbytes);
+            }
+        }
+        dst[0] = (Uint8)besttype;
+    }
+
+end:
+    free(zeros);
+    free(scratch);
+}
+
+static void
+png_deflate_task(void *data, int task)
+{
+    png_parallel_job *job = (png_parallel_job *)data;
+    size_t start = (size_t)task * PNG_BLOCK_BYTES;
+    size_t len = job->size - start;
+    size_t dictlen;
+    int last = task == job->nblocks - 1;
+    /* Room for the zlib header before the first block and the adler32
+     * after the last.
+     */
+    size_t head = task == 0 ? 2 : 0;
+    size_t bound;
+    z_stream strm;
+    int result;
+
+    if (len > PNG_BLOCK_BYTES) {
+        len = PNG_BLOCK_BYTES;
+    }
+    job->adler[task] = adler32(adler32(0L, Z_NULL, 0),
+                               job->filtered + start, (uInt)len);
+
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, job->level, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        job->failed = 1;
+        return;
+    }
+    if (start > 0) {
+        dictlen = start < PNG_WINDOW_BYTES ? start : PNG_WINDOW_BYTES;
+        deflateSetDictionary(&strm, job->filtered + start - dictlen,
+                             (uInt)dictlen);
+    }
+    bound = deflateBound(&strm, len) + 16;
+    job->out[task] = (Uint8 *)malloc(head + bound + 4);
+    if (job->out[task] == NULL) {
+        deflateEnd(&strm);
+        job->failed = 1;
+        return;
+    }
+    strm.next_in = job->filtered + start;
+    strm.avail_in = (uInt)len;
+    strm.next_out = job->out[task] + head;
+    strm.avail_out = (uInt)bound;
+    result = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((last && result != Z_STREAM_END) ||
+        (!last && (result != Z_OK || strm.avail_in != 0 ||
+                   strm.avail_out == 0))) {
+        job->failed = 1;
+    }
+    job->outlen[task] = head + bound - strm.avail_out;
+    deflateEnd(&strm);
+}
+
+static int
+png_write_chunk_raw(FILE *fp, const char *type, const Uint8 *data,
+                    size_t len)
+{
+    Uint8 buf[4];
+    uLong crc;
+
+    buf[0] = (Uint8)(len >> 24);
+    buf[1] = (Uint8)(len >> 16);
+    buf[2] = (Uint8)(len >> 8);
+    buf[3] = (Uint8)len;
+    crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)type, 4);
+    if (len > 0) {
+        crc = crc32(crc, data, (uInt)len);
+    }
+    if (fwrite(buf, 1, 4, fp) != 4 || fwrite(type, 1, 4, fp) != 4 ||
+        (len > 0 && fwrite(data, 1, len, fp) != len)) {
+        return -1;
+    }
+    buf[0] = (Uint8)(crc >> 24);
+    buf[1] = (Uint8)(crc >> 16);
+    buf[2] = (Uint8)(crc >> 8);
+    buf[3] = (Uint8)crc;
+    return fwrite(buf, 1, 4, fp) == 4 ? 0 : -1;
+}
+
+static int
+write_png_parallel(const char *file_name, png_bytep *rows, int w, int h,
+                   int colortype, const pg_save_options *options)
+{
+    static const Uint8 signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    png_parallel_job job;
+    Uint8 ihdr[13];
+    uLong adler;
+    size_t len;
+    int flevel;
+    int i;
+    FILE *fp = NULL;
+    int result = -1;
+
+    memset(&job, 0, sizeof(job));
+    job.rows = rows;
+    job.h = h;
+    job.bpp = colortype == PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 3;
+    job.rowbytes = (size_t)w * job.bpp;
+    job.filters = options->filters == -1 ? PG_PNG_ALL_FILTERS :
+                                           options->filters;
+    job.level = options->compression == -1 ? Z_DEFAULT_COMPRESSION :
+                                              options->compression;
+    job.size = (job.rowbytes + 1) * h;
+    job.nblocks = (int)((job.size + PNG_BLOCK_BYTES - 1) / PNG_BLOCK_BYTES);
+    job.filtered = (Uint8 *)malloc(job.size);
+    job.out = (Uint8 **)calloc(job.nblocks, sizeof(Uint8 *));
+    job.outlen = (size_t *)calloc(job.nblocks, sizeof(size_t));
+    job.adler = (uLong *)calloc(job.nblocks, sizeof(uLong));
+    if (job.filtered == NULL || job.out == NULL ||
+        job.outlen == NULL || job.adler == NULL) {
+        SDL_SetError("SavePNG: out of memory");
+        goto end;
+    }
+
+    pg_run_bands(png_filter_band, &job, h, 64);
+    if (!job.failed) {
+        pg_run_tasks(png_deflate_task, &job, job.nblocks, pg_cpu_count());
+    }
+    if (job.failed) {
+        SDL_SetError("SavePNG: could not compress the image");
+        goto end;
+    }
+
+    /* zlib header for a 32K window, then the adler32 of all blocks */
+    flevel = job.level == Z_DEFAULT_COMPRESSION ? 2 :
+             job.level < 2 ? 0 : job.level < 6 ? 1 : job.level == 6 ? 2 : 3;
+    job.out[0][0] = 0x78;
+    job.out[0][1] = (Uint8)(flevel << 6);
+    job.out[0][1] += 31 - ((0x78 << 8) + job.out[0][1]) % 31;
+    adler = job.adler[0];
+    for (i = 1; i < job.nblocks; ++i) {
+        len = PNG_BLOCK_BYTES;
+        if (i == job.nblocks - 1) {
+            len = job.size - (size_t)i * PNG_BLOCK_BYTES;
+        }
+        adler = adler32_combine(adler, job.adler[i], (z_off_t)len);
+    }
+    len = job.outlen[job.nblocks - 1];
+    job.out[job.nblocks - 1][len] = (Uint8)(adler >> 24);
+    job.out[job.nblocks - 1][len + 1] = (Uint8)(adler >> 16);
+    job.out[job.nblocks - 1][len + 2] = (Uint8)(adler >> 8);
+    job.out[job.nblocks - 1][len + 3] = (Uint8)adler;
+    job.outlen[job.nblocks - 1] += 4;
+
+    ihdr[0] = (Uint8)(w >> 24);
+    ihdr[1] = (Uint8)(w >> 16);
+    ihdr[2] = (Uint8)(w >> 8);
+    ihdr[3] = (Uint8)w;
+    ihdr[4] = (Uint8)(h >> 24);
+    ihdr[5] = (Uint8)(h >> 16);
+    ihdr[6] = (Uint8)(h >> 8);
+    ihdr[7] = (Uint8)h;
+    ihdr[8] = 8;
+    ihdr[9] = (Uint8)colortype;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+
+    fp = fopen(file_name, "wb");
+    if (fp == NULL) {
+        SDL_SetError("SavePNG: could not open for writing");
+        goto end;
+    }
+    if (fwrite(signature, 1, 8, fp) != 8 ||
+        png_write_chunk_raw(fp, "IHDR", ihdr, 13)) {
+        goto write_error;
+    }
+    for (i = 0; i < job.nblocks; ++i) {
+        if (png_write_chunk_raw(fp, "IDAT", job.out[i], job.outlen[i])) {
+            goto write_error;
+        }
+    }
+    if (png_write_chunk_raw(fp, "IEND", NULL, 0)) {
+        goto write_error;
+    }
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        goto write_error;
+    }
+    fp = NULL;
+    result = 0;
+    goto end;
+
+write_error:
+    SDL_SetError("SavePNG: could not write image");
+
+end:
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    if (job.out != NULL) {
+        for (i = 0; i < job.nblocks; ++i) {
+            free(job.out[i]);
+        }
+    }
+    free(job.out);
+    free(job.outlen);
+    free(job.adler);
+    free(job.filtered);
+    return result;
+}
+
 static int
 write_png (const char *file_name,
            png_bytep *rows,
            int w,
            int h,
            int colortype,
-           int bitdepth)
+           int bitdepth,
+           const pg_save_options *options)
 {
     png_structp png_ptr = NULL;
     png_infop info_ptr =  NULL;
     FILE *fp = NULL;
     char *doing = "open for writing";
 
+    if (bitdepth == 8 && pg_cpu_count () > 1 &&
+        (size_t)w * h * (colortype == PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 3) >=
+        PNG_PARALLEL_MIN_BYTES)
+        return write_png_parallel (file_name, rows, w, h, colortype, options);
+
     if (!(fp = fopen (file_name, "wb")))
         goto fail;
 
@@ -218,6 +710,10 @@ write_png (const char *file_name,
     png_set_IHDR (png_ptr, info_ptr, w, h, bitdepth, colortype,
                   PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
                   PNG_FILTER_TYPE_BASE);
+    if (options->compression != -1)
+        png_set_compression_level (png_ptr, options->compression);
+    if (options->filters != -1)
+        png_set_filter (png_ptr, PNG_FILTER_TYPE_BASE, options->filters);
 
     doing = "write info";
     png_write_info (png_ptr, info_ptr);
@@ -250,11 +746,12 @@ fail:
 }
 
 static int
-SavePNG (SDL_Surface *surface, const char *file)
+SavePNG (SDL_Surface *surface, const char *file,
+         const pg_save_options *options)
 {
-    static unsigned char** ss_rows;
-    static int ss_size;
-    static int ss_w, ss_h;
+    unsigned char** ss_rows;
+    int ss_size;
+    int ss_w, ss_h;
     SDL_Surface *ss_surface;
     SDL_Rect ss_rect;
     int r, i;
@@ -334,12 +831,12 @@ SavePNG (SDL_Surface *surface, const char *file)
     if (alpha)
     {
         r = write_png (file, ss_rows, surface->w, surface->h,
-                       PNG_COLOR_TYPE_RGB_ALPHA, 8);
+                       PNG_COLOR_TYPE_RGB_ALPHA, 8, options);
     }
     else
     {
         r = write_png (file, ss_rows, surface->w, surface->h,
-                       PNG_COLOR_TYPE_RGB, 8);
+                       PNG_COLOR_TYPE_RGB, 8, options);
     }
 
     free (ss_rows);
@@ -504,7 +1001,7 @@ int write_jpeg (const char *file_name, unsigned char** image_buffer,
 
 
 
-int SaveJPEG (SDL_Surface *surface, const char *file) {
+int SaveJPEG (SDL_Surface *surface, const char *file, int quality) {
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 #define RED_MASK 0xff0000
@@ -516,9 +1013,9 @@ int SaveJPEG (SDL_Surface *surface, const char *file) {
 #define BLUE_MASK 0xff0000
 #endif
 
-    static unsigned char** ss_rows;
-    static int ss_size;
-    static int ss_w, ss_h;
+    unsigned char** ss_rows;
+    int ss_size;
+    int ss_w, ss_h;
     SDL_Surface *ss_surface;
     SDL_Rect ss_rect;
     int r, i;
@@ -593,7 +1090,7 @@ int SaveJPEG (SDL_Surface *surface, const char *file) {
         ss_rows[i] = ((unsigned char*)ss_surface->pixels) +
             i * ss_surface->pitch;
     }
-    r = write_jpeg (file, ss_rows, surface->w, surface->h, 85);
+    r = write_jpeg (file, ss_rows, surface->w, surface->h, quality);
 
 
     free (ss_rows);
@@ -675,17 +1172,62 @@ opengltosdl (void)
 }
 
 
+/* Save a png or jpeg by file name.  Needs no GIL. */
+static int
+save_ext_file(SDL_Surface *surf, const char *name,
+              const pg_save_options *options)
+{
+    size_t namelen = strlen(name);
+
+    if ((namelen >= 4) &&
+        (((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
+          (name[namelen - 2]=='e' || name[namelen - 2]=='E') &&
+          (name[namelen - 3]=='p' || name[namelen - 3]=='P') &&
+          (name[namelen - 4]=='j' || name[namelen - 4]=='J')) ||
+         ((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
+          (name[namelen - 2]=='p' || name[namelen - 2]=='P') &&
+          (name[namelen - 3]=='j' || name[namelen - 3]=='J'))))  {
+#ifdef JPEGLIB_H
+        return SaveJPEG(surf, name, options->quality);
+#else
+        SDL_SetError("No support for jpg compiled in.");
+        return -1;
+#endif
+    }
+    if ((namelen >= 3) &&
+        ((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
+         (name[namelen - 2]=='n' || name[namelen - 2]=='N') &&
+         (name[namelen - 3]=='p' || name[namelen - 3]=='P')))  {
+#ifdef PNG_H
+        return SavePNG(surf, name, options);
+#else
+        SDL_SetError("No support for png compiled in.");
+        return -1;
+#endif
+    }
+    return 1;
+}
+
 static PyObject*
-image_save_ext(PyObject *self, PyObject *arg)
+image_save_ext(PyObject *self, PyObject *arg, PyObject *kwds)
 {
+    static char *kwlist[] = {"surface", "filename", "quality",
+                             "compression", "filters", NULL};
     PyObject *surfobj;
     PyObject *obj;
     PyObject *oencoded = NULL;
     SDL_Surface *surf;
     SDL_Surface *temp = NULL;
+    pg_save_options options = PG_SAVE_OPTIONS_DEFAULT;
     int result = 1;
 
-    if (!PyArg_ParseTuple(arg, "O!O", &PySurface_Type, &surfobj, &obj)) {
+    if (!PyArg_ParseTupleAndKeywords(arg, kwds, "O!O|iii", kwlist,
+                                     &PySurface_Type, &surfobj, &obj,
+                                     &options.quality, &options.compression,
+                                     &options.filters)) {
+        return NULL;
+    }
+    if (pg_check_save_options(&options)) {
         return NULL;
     }
 
@@ -708,45 +1250,10 @@ image_save_ext(PyObject *self, PyObject *arg)
         result = -2;
     }
     else if (oencoded != NULL) {
-        const char *name = Bytes_AS_STRING(oencoded);
-        Py_ssize_t namelen = Bytes_GET_SIZE(oencoded);
-
-        if ((namelen >= 4) &&
-            (((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
-              (name[namelen - 2]=='e' || name[namelen - 2]=='E') &&
-              (name[namelen - 3]=='p' || name[namelen - 3]=='P') &&
-              (name[namelen - 4]=='j' || name[namelen - 4]=='J')) ||
-             ((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
-              (name[namelen - 2]=='p' || name[namelen - 2]=='P') &&
-              (name[namelen - 3]=='j' || name[namelen - 3]=='J'))))  {
-#ifdef JPEGLIB_H
-            /* jpg save functions seem *NOT* thread safe at least on windows. */
-            /*
-            Py_BEGIN_ALLOW_THREADS;
-            */
-            result = SaveJPEG(surf, name);
-            /*
-            Py_END_ALLOW_THREADS;
-            */
-#else
-            RAISE(PyExc_SDLError, "No support for jpg compiled in.");
-            result = -2;
-#endif
-
-        }
-        else if ((namelen >= 3) &&
-                 ((name[namelen - 1]=='g' || name[namelen - 1]=='G') &&
-                  (name[namelen - 2]=='n' || name[namelen - 2]=='N') &&
-                  (name[namelen - 3]=='p' || name[namelen - 3]=='P')))  {
-#ifdef PNG_H
-            /*Py_BEGIN_ALLOW_THREADS; */
-            result = SavePNG(surf, name);
-            /*Py_END_ALLOW_THREADS; */
-#else
-            RAISE(PyExc_SDLError, "No support for png compiled in.");
-            result = -2;
-#endif
-        }
+        /* The encoders keep no shared state, as save_async runs them too */
+        Py_BEGIN_ALLOW_THREADS;
+        result = save_ext_file(surf, Bytes_AS_STRING(oencoded), &options);
+        Py_END_ALLOW_THREADS;
     }
     else {
         result = -2;
@@ -778,7 +1285,8 @@ image_save_ext(PyObject *self, PyObject *arg)
 static PyMethodDef _imageext_methods[] =
 {
     { "load_extended", image_load_ext, METH_VARARGS, DOC_PYGAMEIMAGE },
-    { "save_extended", image_save_ext, METH_VARARGS, DOC_PYGAMEIMAGE },
+    { "save_extended", (PyCFunction) image_save_ext,
+      METH_VARARGS | METH_KEYWORDS, DOC_PYGAMEIMAGE },
     { NULL, NULL, 0, NULL }
 };
 
@@ -788,6 +1296,10 @@ static PyMethodDef _imageext_methods[] =
 
 MODINIT_DEFINE (imageext)
 {
+    PyObject *module;
+    PyObject *apiobj;
+    static void* c_api[PG_IMAGEEXT_NUMSLOTS];
+
 #if PY3
     static struct PyModuleDef _module = {
         PyModuleDef_HEAD_INIT,
@@ -819,10 +1331,34 @@ MODINIT_DEFINE (imageext)
 
     /* create the module */
 #if PY3
-    return PyModule_Create (&_module);
+    module = PyModule_Create (&_module);
 #else
-    Py_InitModule3(MODPREFIX "imageext",
-                   _imageext_methods,
-                   _imageext_doc);
+    module = Py_InitModule3(MODPREFIX "imageext",
+                            _imageext_methods,
+                            _imageext_doc);
 #endif
+    if (module == NULL) {
+        MODINIT_ERROR;
+    }
+
+    /* export the loaders and saver for the image module */
+    c_api[PG_IMAGEEXT_LOAD_FILE] = IMG_Load;
+    c_api[PG_IMAGEEXT_SAVE_FILE] = save_ext_file;
+    c_api[PG_IMAGEEXT_LOAD_RW] = IMG_LoadTyped_RW;
+#ifdef PNG_H
+    c_api[PG_IMAGEEXT_LOAD_PNG_INTO] = load_png_into;
+#else
+    c_api[PG_IMAGEEXT_LOAD_PNG_INTO] = NULL;
+#endif
+    apiobj = encapsulate_api(c_api, "imageext");
+    if (apiobj == NULL) {
+        DECREF_MOD(module);
+        MODINIT_ERROR;
+    }
+    if (PyModule_AddObject(module, PYGAMEAPI_LOCAL_ENTRY, apiobj) == -1) {
+        Py_DECREF(apiobj);
+        DECREF_MOD(module);
+        MODINIT_ERROR;
+    }
+    MODINIT_RETURN(module);
 }
@@ -45,6 +45,7 @@
 /* Binary interface. Use bytes. */
 #define Bytes_Type PyBytes_Type
 #define Bytes_Check PyBytes_Check
+#define Bytes_CheckExact PyBytes_CheckExact
 #define Bytes_Size PyBytes_Size
 #define Bytes_AsString PyBytes_AsString
 #define Bytes_AsStringAndSize PyBytes_AsStringAndSize
@@ -97,6 +98,7 @@
 /* Binary interface. Use ascii strings. */
 #define Bytes_Type PyString_Type
 #define Bytes_Check PyString_Check
+#define Bytes_CheckExact PyString_CheckExact
 #define Bytes_Size PyString_Size
 #define Bytes_AsString PyString_AsString
 #define Bytes_AsStringAndSize PyString_AsStringAndSize
@@ -0,0 +1,140 @@
+/*
+  pygame - Python Game Library
+  Copyright (C) 2000-2001  Pete Shinners
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Pete Shinners
+  pete@shinners.org
+*/
+
+/*
+ * Shared between the image and imageext modules: the C functions
+ * imageext exports, and the options image.save passes to its encoders.
+ */
+#if !defined(PGIMAGE_H)
+#define PGIMAGE_H
+
+/* The libpng filter flags, PNG_FILTER_NONE and so on */
+#define PG_PNG_FILTER_NONE 0x08
+#define PG_PNG_FILTER_SUB 0x10
+#define PG_PNG_FILTER_UP 0x20
+#define PG_PNG_FILTER_AVG 0x40
+#define PG_PNG_FILTER_PAETH 0x80
+#define PG_PNG_ALL_FILTERS 0xf8
+
+typedef struct {
+    int quality;        /* JPEG quality, 1 to 100 */
+    int compression;    /* PNG zlib level, 0 to 9, or -1 for the default */
+    int filters;        /* PNG_FILTER_ flags, or -1 for the default */
+} pg_save_options;
+
+#define PG_SAVE_OPTIONS_DEFAULT {85, -1, -1}
+
+/* Decodes an image file; called without the GIL */
+typedef SDL_Surface* (*pg_load_file_func) (const char *path);
+
+/* Encodes a surface by file name; called without the GIL.  Returns 0 on
+ * success, -1 with an SDL error set, or 1 if the type is not handled.
+ */
+typedef int (*pg_save_file_func) (SDL_Surface *surf, const char *path,
+                                  const pg_save_options *options);
+
+/* Decodes an image stream, IMG_LoadTyped_RW; called without the GIL */
+typedef SDL_Surface* (*pg_load_rw_func) (SDL_RWops *src, int freesrc,
+                                         char *type);
+
+/* Decodes a PNG stream straight into a new surface of format, created
+ * with flags, plus SDL_SRCALPHA if the image has alpha and keep_flags has
+ * it; called without the GIL.  Returns 0 with *surf set, -1 with an SDL
+ * error set, or 1, with src rewound, if src is not a PNG or cannot be
+ * decoded into format directly.
+ */
+typedef int (*pg_load_png_into_func) (SDL_RWops *src,
+                                      const SDL_PixelFormat *format,
+                                      Uint32 flags, Uint32 keep_flags,
+                                      SDL_Surface **surf);
+
+/* imageext's _PYGAME_C_API slots */
+#define PG_IMAGEEXT_LOAD_FILE 0
+#define PG_IMAGEEXT_SAVE_FILE 1
+#define PG_IMAGEEXT_LOAD_RW 2
+#define PG_IMAGEEXT_LOAD_PNG_INTO 3
+#define PG_IMAGEEXT_NUMSLOTS 4
+
+/* Offset of the byte holding a channel within a 24 or 32 bit pixel, or -1
+ * if the channel is not a whole byte.
+ */
+static int
+pg_channel_byte (Uint32 mask, Uint8 shift, Uint8 loss, int bpp)
+{
+    if (loss != 0 || (shift & 7) || mask != (Uint32) 0xff << shift)
+        return -1;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    return shift >> 3;
+#else
+    return bpp - 1 - (shift >> 3);
+#endif
+}
+
+/* Fill order with the bytes of R, G, B and A in the pixels of a 24 or 32
+ * bit format, A being -1 if there is no alpha.  Returns -1 if the format
+ * has other sizes, or channels that are not whole bytes.
+ */
+static int
+pg_channel_bytes (const SDL_PixelFormat *fmt, int order[4])
+{
+    int bpp = fmt->BytesPerPixel;
+
+    if (fmt->palette || (bpp != 3 && bpp != 4))
+        return -1;
+    order[0] = pg_channel_byte (fmt->Rmask, fmt->Rshift, fmt->Rloss, bpp);
+    order[1] = pg_channel_byte (fmt->Gmask, fmt->Gshift, fmt->Gloss, bpp);
+    order[2] = pg_channel_byte (fmt->Bmask, fmt->Bshift, fmt->Bloss, bpp);
+    order[3] = -1;
+    if (order[0] < 0 || order[1] < 0 || order[2] < 0)
+        return -1;
+    if (fmt->Amask)
+    {
+        order[3] = pg_channel_byte (fmt->Amask, fmt->Ashift, fmt->Aloss, bpp);
+        if (order[3] < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int
+pg_check_save_options (const pg_save_options *options)
+{
+    if (options->quality < 1 || options->quality > 100) {
+        PyErr_SetString (PyExc_ValueError,
+                         "quality must be between 1 and 100");
+        return -1;
+    }
+    if (options->compression < -1 || options->compression > 9) {
+        PyErr_SetString (PyExc_ValueError,
+                         "compression must be between 0 and 9, or -1");
+        return -1;
+    }
+    if (options->filters != -1 &&
+        (options->filters == 0 || (options->filters & ~PG_PNG_ALL_FILTERS))) {
+        PyErr_SetString (PyExc_ValueError,
+                         "filters must be PNG_FILTER_ flags, or -1");
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* #if !defined(PGIMAGE_H) */
@@ -0,0 +1,209 @@
+/*
+  pygame - Python Game Library
+  Copyright (C) 2000-2001  Pete Shinners
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Pete Shinners
+  pete@shinners.org
+*/
+
+/* Split pixel work into row bands and run them on SDL threads.
+ *
+ * The band function must only touch rows in [start, end) of any
+ * destination, and must not call into Python: bands run with the GIL
+ * released.  The calling thread always runs band 0 itself, so a failed
+ * SDL_CreateThread just means the band is run serially instead.
+ */
+#if !defined(PGPARALLEL_H)
+#define PGPARALLEL_H
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/* The helpers below are inline so that a file using only some of them
+ * gets no unused function warnings for the rest.
+ */
+#ifndef PG_INLINE
+#if defined(__GNUC__)
+#define PG_INLINE inline
+#elif defined(_MSC_VER)
+#define PG_INLINE __inline
+#else
+#define PG_INLINE
+#endif
+#endif
+
+/* Upper limit on the number of bands any one call is split into. */
+#define PG_MAX_BANDS 16
+
+typedef void (*pg_band_func) (void *data, int band, int start, int end);
+
+typedef struct {
+    pg_band_func func;
+    void *data;
+    int band;
+    int start;
+    int end;
+} pg_band_t;
+
+static PG_INLINE int
+pg_cpu_count (void)
+{
+    static int count = 0;
+
+    if (count == 0) {
+#if defined(WIN32)
+        SYSTEM_INFO info;
+
+        GetSystemInfo (&info);
+        count = (int) info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+        count = (int) sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+        if (count < 1)
+            count = 1;
+    }
+    return count;
+}
+
+static PG_INLINE int
+pg_band_thread (void *arg)
+{
+    pg_band_t *band = (pg_band_t *) arg;
+
+    band->func (band->data, band->band, band->start, band->end);
+    return 0;
+}
+
+/* Run func over rows [0, nrows).  Each band gets at least min_rows rows.
+ * Returns the number of bands used, always between 1 and PG_MAX_BANDS,
+ * so callers can keep per band results in a PG_MAX_BANDS sized array.
+ */
+static PG_INLINE int
+pg_run_bands (pg_band_func func, void *data, int nrows, int min_rows)
+{
+    pg_band_t bands[PG_MAX_BANDS];
+    SDL_Thread *threads[PG_MAX_BANDS];
+    int nbands = pg_cpu_count ();
+    int i, start;
+
+    if (min_rows < 1)
+        min_rows = 1;
+    if (nbands > PG_MAX_BANDS)
+        nbands = PG_MAX_BANDS;
+    if (nbands > nrows / min_rows)
+        nbands = nrows / min_rows;
+    if (nbands <= 1) {
+        func (data, 0, 0, nrows);
+        return 1;
+    }
+
+    for (i = 0, start = 0; i < nbands; ++i) {
+        bands[i].func = func;
+        bands[i].data = data;
+        bands[i].band = i;
+        bands[i].start = start;
+        start += nrows / nbands + (i < nrows % nbands);
+        bands[i].end = start;
+    }
+    for (i = 1; i < nbands; ++i) {
+        threads[i] = SDL_CreateThread (pg_band_thread, &bands[i]);
+    }
+    pg_band_thread (&bands[0]);
+    for (i = 1; i < nbands; ++i) {
+        if (threads[i])
+            SDL_WaitThread (threads[i], NULL);
+        else
+            pg_band_thread (&bands[i]);
+    }
+    return nbands;
+}
+
+/* Upper limit on the threads any one pg_run_tasks call starts. */
+#define PG_MAX_TASK_THREADS 32
+
+typedef void (*pg_task_func) (void *data, int task);
+
+typedef struct {
+    pg_task_func func;
+    void *data;
+    int ntasks;
+    int next;
+    SDL_mutex *lock;
+} pg_tasks_t;
+
+static PG_INLINE int
+pg_task_thread (void *arg)
+{
+    pg_tasks_t *tasks = (pg_tasks_t *) arg;
+    int task;
+
+    for (;;) {
+        SDL_LockMutex (tasks->lock);
+        task = tasks->next++;
+        SDL_UnlockMutex (tasks->lock);
+        if (task >= tasks->ntasks)
+            break;
+        tasks->func (tasks->data, task);
+    }
+    return 0;
+}
+
+/* Run func for each task in [0, ntasks) on up to nthreads threads, the
+ * calling thread included.  Unlike bands, tasks are handed out one at a
+ * time as threads come free, which suits work of uneven cost.  The same
+ * rules as for band functions apply.
+ */
+static PG_INLINE void
+pg_run_tasks (pg_task_func func, void *data, int ntasks, int nthreads)
+{
+    pg_tasks_t tasks;
+    SDL_Thread *threads[PG_MAX_TASK_THREADS];
+    int i;
+
+    if (nthreads > PG_MAX_TASK_THREADS)
+        nthreads = PG_MAX_TASK_THREADS;
+    if (nthreads > ntasks)
+        nthreads = ntasks;
+    tasks.lock = nthreads > 1 ? SDL_CreateMutex () : NULL;
+    if (!tasks.lock) {
+        for (i = 0; i < ntasks; ++i)
+            func (data, i);
+        return;
+    }
+
+    tasks.func = func;
+    tasks.data = data;
+    tasks.ntasks = ntasks;
+    tasks.next = 0;
+    for (i = 1; i < nthreads; ++i) {
+        threads[i] = SDL_CreateThread (pg_task_thread, &tasks);
+    }
+    pg_task_thread (&tasks);
+    for (i = 1; i < nthreads; ++i) {
+        if (threads[i])
+            SDL_WaitThread (threads[i], NULL);
+    }
+    SDL_DestroyMutex (tasks.lock);
+}
+
+#endif /* #if !defined(PGPARALLEL_H) */
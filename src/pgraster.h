@@ -0,0 +1,424 @@
+/*
+  pygame - Python Game Library
+  Copyright (C) 2000-2001  Pete Shinners
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Pete Shinners
+  pete@shinners.org
+*/
+
+/* Antialiased shape filling by exact area coverage.
+ *
+ * A shape is a path of closed outlines made of line segments; circles,
+ * ellipses and rounded corners are flattened into short chords first.
+ * Every segment adds its signed area to accumulation cells, the way font
+ * rasterizers do it, and a running sum along each row then gives the
+ * exact covered fraction of every pixel.  So a shape is filled in one
+ * pass, with no supersampling, and each pixel is handed out once.
+ *
+ * Coordinates are in pixels, pixel (x, y) being the unit square from
+ * (x, y) to (x + 1, y + 1).  Rows are accumulated in bands, which keeps
+ * the cell buffer small however big the shape is.  Nothing here calls
+ * into Python, so filling may run with the GIL released.
+ */
+#if !defined(PGRASTER_H)
+#define PGRASTER_H
+
+#include <SDL.h>
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+/* Rows accumulated at a time. */
+#define PG_RASTER_BAND 32
+
+/* Largest gap, in pixels, between a flattened curve and its chords. */
+#define PG_RASTER_TOLERANCE 0.02
+
+typedef struct {
+    float x0, y0, x1, y1;
+} pg_raster_seg;
+
+/* Receives the coverage, from 0 to 255, of count pixels from (x, y)
+ * rightward.  The first and last of them are never 0.
+ */
+typedef void (*pg_raster_func) (void *data, int x, int y, int count,
+                                const Uint8 *cover);
+
+typedef struct {
+    int left, top, width, height;   /* the clip area */
+    pg_raster_seg *segs;
+    int nsegs, maxsegs;
+    float minx, maxx, miny, maxy;   /* extent of segs, clip relative */
+    float startx, starty, penx, peny;
+    int error;
+} pg_raster;
+
+static void
+pg_raster_init (pg_raster *r, const SDL_Rect *clip)
+{
+    r->left = clip->x;
+    r->top = clip->y;
+    r->width = clip->w > 0 ? clip->w : 0;
+    r->height = clip->h > 0 ? clip->h : 0;
+    r->segs = NULL;
+    r->nsegs = r->maxsegs = 0;
+    r->minx = r->miny = 1e30f;
+    r->maxx = r->maxy = -1e30f;
+    r->startx = r->starty = r->penx = r->peny = 0;
+    r->error = 0;
+}
+
+static void
+pg_raster_free (pg_raster *r)
+{
+    free (r->segs);
+    r->segs = NULL;
+    r->nsegs = r->maxsegs = 0;
+}
+
+static void
+pg_raster_push (pg_raster *r, float x0, float y0, float x1, float y1)
+{
+    pg_raster_seg *seg;
+
+    if (y0 == y1 || r->error)
+        return;
+    if (r->nsegs == r->maxsegs) {
+        int size = r->maxsegs ? r->maxsegs * 2 : 64;
+
+        seg = (pg_raster_seg *) realloc (r->segs, size * sizeof (pg_raster_seg));
+        if (!seg) {
+            r->error = 1;
+            return;
+        }
+        r->segs = seg;
+        r->maxsegs = size;
+    }
+    seg = &r->segs[r->nsegs++];
+    seg->x0 = x0;
+    seg->y0 = y0;
+    seg->x1 = x1;
+    seg->y1 = y1;
+    r->minx = MIN (r->minx, MIN (x0, x1));
+    r->maxx = MAX (r->maxx, MAX (x0, x1));
+    r->miny = MIN (r->miny, MIN (y0, y1));
+    r->maxy = MAX (r->maxy, MAX (y0, y1));
+}
+
+/* Adds one edge.  A pixel's coverage only depends on what lies left of
+ * its right side, so the part of an edge right of the clip is dropped,
+ * and the part left of it is moved onto the clip's left side, where it
+ * still covers whole pixels.
+ */
+static void
+pg_raster_line (pg_raster *r, float x0, float y0, float x1, float y1)
+{
+    float w = (float) r->width;
+    float t;
+
+    x0 -= r->left;
+    x1 -= r->left;
+    y0 -= r->top;
+    y1 -= r->top;
+    if (y0 == y1 || (y0 <= 0 && y1 <= 0) ||
+        (y0 >= r->height && y1 >= r->height) || (x0 >= w && x1 >= w))
+        return;
+
+    if (x0 > w || x1 > w) {
+        t = y0 + (w - x0) * (y1 - y0) / (x1 - x0);
+        if (x0 > w) {
+            x0 = w;
+            y0 = t;
+        }
+        else {
+            x1 = w;
+            y1 = t;
+        }
+    }
+    if (x0 < 0 && x1 < 0) {
+        x0 = x1 = 0;
+    }
+    else if (x0 < 0 || x1 < 0) {
+        t = y0 + (0 - x0) * (y1 - y0) / (x1 - x0);
+        if (x0 < 0) {
+            pg_raster_push (r, 0, y0, 0, t);
+            x0 = 0;
+            y0 = t;
+        }
+        else {
+            pg_raster_push (r, 0, t, 0, y1);
+            x1 = 0;
+            y1 = t;
+        }
+    }
+    pg_raster_push (r, x0, y0, x1, y1);
+}
+
+/* Starts a new outline, closing the one before. */
+static void
+pg_raster_move_to (pg_raster *r, float x, float y)
+{
+    pg_raster_line (r, r->penx, r->peny, r->startx, r->starty);
+    r->startx = r->penx = x;
+    r->starty = r->peny = y;
+}
+
+static void
+pg_raster_line_to (pg_raster *r, float x, float y)
+{
+    pg_raster_line (r, r->penx, r->peny, x, y);
+    r->penx = x;
+    r->peny = y;
+}
+
+/* Chords needed for an arc of the given radius and sweep. */
+static int
+pg_raster_arc_steps (float radius, double sweep)
+{
+    double step = 2 * M_PI;
+    int n;
+
+    if (radius > PG_RASTER_TOLERANCE)
+        step = 2 * acos (1 - PG_RASTER_TOLERANCE / radius);
+    n = (int) ceil (fabs (sweep) / step);
+    return MAX (n, 2);
+}
+
+/* Continues the outline along an elliptic arc from angle a0 to a1, in
+ * radians, growing clockwise on screen.  The points between the ends are
+ * pushed out a little, so the chords enclose about the same area as the
+ * arc rather than less.
+ */
+static void
+pg_raster_arc_to (pg_raster *r, float cx, float cy, float rx, float ry,
+                  double a0, double a1)
+{
+    int i, n = pg_raster_arc_steps (MAX (rx, ry), a1 - a0);
+    double step = fabs (a1 - a0) / n;
+    double grow = sqrt (step / sin (step));
+    double a, k;
+
+    for (i = 0; i <= n; ++i) {
+        a = a0 + (a1 - a0) * i / n;
+        k = (i == 0 || i == n) ? 1.0 : grow;
+        pg_raster_line_to (r, (float) (cx + k * rx * cos (a)),
+                           (float) (cy + k * ry * sin (a)));
+    }
+}
+
+static void
+pg_raster_ellipse (pg_raster *r, float cx, float cy, float rx, float ry)
+{
+    if (rx <= 0 || ry <= 0)
+        return;
+    pg_raster_move_to (r, cx + rx, cy);
+    pg_raster_arc_to (r, cx, cy, rx, ry, 0, 2 * M_PI);
+}
+
+/* A w by h rectangle with corners rounded by radius, which is limited
+ * to half the shorter side.
+ */
+static void
+pg_raster_rounded_rect (pg_raster *r, float x, float y, float w, float h,
+                        float radius)
+{
+    float right = x + w, bottom = y + h;
+
+    if (w <= 0 || h <= 0)
+        return;
+    radius = MIN (radius, MIN (w, h) / 2);
+    if (radius <= 0) {
+        pg_raster_move_to (r, x, y);
+        pg_raster_line_to (r, right, y);
+        pg_raster_line_to (r, right, bottom);
+        pg_raster_line_to (r, x, bottom);
+        return;
+    }
+    pg_raster_move_to (r, x + radius, y);
+    pg_raster_arc_to (r, right - radius, y + radius, radius, radius,
+                      -M_PI / 2, 0);
+    pg_raster_arc_to (r, right - radius, bottom - radius, radius, radius,
+                      0, M_PI / 2);
+    pg_raster_arc_to (r, x + radius, bottom - radius, radius, radius,
+                      M_PI / 2, M_PI);
+    pg_raster_arc_to (r, x + radius, y + radius, radius, radius,
+                      M_PI, 3 * M_PI / 2);
+}
+
+/* Adds the signed area of seg in rows [b0, b1) to the cells of the band,
+ * stride cells a row.  Within a row the edge is straight, so its area
+ * spreads over the cells it crosses as a linear ramp.
+ */
+static void
+pg_raster_accumulate (float *acc, int stride, int b0, int b1,
+                      const pg_raster_seg *seg)
+{
+    float width = (float) (stride - 2);
+    float x0, y0, x1, y1, dir, dxdy, top, bottom;
+    float xa, xb, d, xmf, s, x0f, x1f, a0, a1, a2, am;
+    float *cell;
+    int y, ystart, yend, x0i, x1i, i;
+
+    if (seg->y0 < seg->y1) {
+        dir = 1;
+        x0 = seg->x0; y0 = seg->y0; x1 = seg->x1; y1 = seg->y1;
+    }
+    else {
+        dir = -1;
+        x0 = seg->x1; y0 = seg->y1; x1 = seg->x0; y1 = seg->y0;
+    }
+    dxdy = (x1 - x0) / (y1 - y0);
+    ystart = MAX ((int) floor (y0), b0);
+    yend = MIN ((int) ceil (y1), b1);
+
+    for (y = ystart; y < yend; ++y) {
+        top = MAX ((float) y, y0);
+        bottom = MIN ((float) (y + 1), y1);
+        if (bottom <= top)
+            continue;
+        d = (bottom - top) * dir;
+        xa = x0 + (top - y0) * dxdy;
+        xb = x0 + (bottom - y0) * dxdy;
+        if (xa > xb) {
+            s = xa;
+            xa = xb;
+            xb = s;
+        }
+        xa = MIN (MAX (xa, 0), width);
+        xb = MIN (MAX (xb, xa), width);
+        cell = acc + (y - b0) * stride;
+        x0i = (int) floor (xa);
+        x1i = (int) ceil (xb);
+
+        if (x1i <= x0i + 1) {
+            xmf = 0.5f * (xa + xb) - x0i;
+            cell[x0i] += d - d * xmf;
+            cell[x0i + 1] += d * xmf;
+        }
+        else {
+            s = 1 / (xb - xa);
+            x0f = xa - x0i;
+            a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+            x1f = xb - x1i + 1;
+            am = 0.5f * s * x1f * x1f;
+            cell[x0i] += d * a0;
+            if (x1i == x0i + 2) {
+                cell[x0i + 1] += d * (1 - a0 - am);
+            }
+            else {
+                a1 = s * (1.5f - x0f);
+                cell[x0i + 1] += d * (a1 - a0);
+                for (i = x0i + 2; i < x1i - 1; ++i)
+                    cell[i] += d * s;
+                a2 = a1 + (x1i - x0i - 3) * s;
+                cell[x1i - 1] += d * (1 - a2 - am);
+            }
+            cell[x1i] += d * am;
+        }
+    }
+}
+
+/* Fills the path, closing its last outline, and hands each row's covered
+ * pixels to func.  With evenodd set, overlapping outlines cancel in
+ * pairs, otherwise any winding fills.  Returns -1 when out of memory.
+ */
+static int
+pg_raster_fill (pg_raster *r, int evenodd, pg_raster_func func, void *data)
+{
+    int stride = r->width + 2;
+    int ystart, yend, xstart, xend, b0, b1, x, y, lo, hi, i;
+    float *acc, *cell, sum, c;
+    pg_raster_seg *seg;
+    Uint8 *cover;
+
+    pg_raster_move_to (r, r->startx, r->starty);
+    if (r->error)
+        return -1;
+    if (!r->nsegs)
+        return 0;
+
+    ystart = MAX ((int) floor (r->miny), 0);
+    yend = MIN ((int) ceil (r->maxy), r->height);
+    xstart = MAX ((int) floor (r->minx), 0);
+    xend = MIN ((int) ceil (r->maxx) + 1, r->width);
+    acc = (float *) calloc (stride * PG_RASTER_BAND, sizeof (float));
+    cover = (Uint8 *) malloc (stride);
+    if (!acc || !cover) {
+        free (acc);
+        free (cover);
+        return -1;
+    }
+
+    for (b0 = ystart; b0 < yend; b0 += PG_RASTER_BAND) {
+        b1 = MIN (b0 + PG_RASTER_BAND, yend);
+        for (i = 0; i < r->nsegs; ++i) {
+            seg = &r->segs[i];
+            if (MIN (seg->y0, seg->y1) < b1 && MAX (seg->y0, seg->y1) > b0)
+                pg_raster_accumulate (acc, stride, b0, b1, seg);
+        }
+
+        for (y = b0; y < b1; ++y) {
+            cell = acc + (y - b0) * stride;
+            sum = 0;
+            lo = hi = -1;
+            for (x = xstart; x < xend; ++x) {
+                sum += cell[x];
+                cell[x] = 0;
+                c = (float) fabs (sum);
+                if (evenodd) {
+                    c = (float) fmod (c, 2);
+                    if (c > 1)
+                        c = 2 - c;
+                }
+                else if (c > 1) {
+                    c = 1;
+                }
+                cover[x] = (Uint8) (c * 255 + 0.5f);
+                if (cover[x]) {
+                    if (lo < 0)
+                        lo = x;
+                    hi = x;
+                }
+            }
+            for (; x < stride; ++x)
+                cell[x] = 0;
+            /* right of the last edge the coverage stays the same */
+            if (xend > xstart && cover[xend - 1]) {
+                for (x = xend; x < r->width; ++x)
+                    cover[x] = cover[xend - 1];
+                hi = r->width - 1;
+            }
+            if (lo >= 0)
+                func (data, r->left + lo, r->top + y, hi - lo + 1, cover + lo);
+        }
+    }
+
+    free (acc);
+    free (cover);
+    return 0;
+}
+
+#endif /* #if !defined(PGRASTER_H) */
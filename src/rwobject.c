@@ -247,6 +247,155 @@ RWopsEncodeFilePath(PyObject *obj, PyObject *eclass)
     return result;
 }
 
+#if PG_ENABLE_NEWBUF
+/* An RWops reading straight from the memory of a buffer object, so no
+ * Python code runs, nor is the GIL needed, until it is closed.
+ */
+typedef struct
+{
+    Py_buffer view;
+    Py_ssize_t pos;
+} RWBuffer;
+
+static int
+rw_seek_buf (SDL_RWops* context, int offset, int whence)
+{
+    RWBuffer* buffer = (RWBuffer*) context->hidden.unknown.data1;
+    Py_ssize_t pos;
+
+    switch (whence)
+    {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = buffer->pos + offset;
+        break;
+    case SEEK_END:
+        pos = buffer->view.len + offset;
+        break;
+    default:
+        SDL_SetError ("Unknown value for 'whence'");
+        return -1;
+    }
+    if (pos < 0)
+        pos = 0;
+    if (pos > buffer->view.len)
+        pos = buffer->view.len;
+    buffer->pos = pos;
+    return (int) pos;
+}
+
+static int
+rw_read_buf (SDL_RWops* context, void* ptr, int size, int maxnum)
+{
+    RWBuffer* buffer = (RWBuffer*) context->hidden.unknown.data1;
+    Py_ssize_t total;
+
+    if (size <= 0 || maxnum <= 0)
+        return 0;
+
+    total = (Py_ssize_t) size * maxnum;
+    if (total > buffer->view.len - buffer->pos)
+        total = buffer->view.len - buffer->pos;
+    memcpy (ptr, (char *) buffer->view.buf + buffer->pos, total);
+    buffer->pos += total;
+    return (int) (total / size);
+}
+
+static int
+rw_write_buf (SDL_RWops* context, const void* ptr, int size, int num)
+{
+    SDL_SetError ("Can't write to a buffer object");
+    return -1;
+}
+
+static int
+rw_close_buf (SDL_RWops* context)
+{
+    RWBuffer* buffer = (RWBuffer*) context->hidden.unknown.data1;
+#ifdef WITH_THREAD
+    PyGILState_STATE state = PyGILState_Ensure();
+#endif
+
+    PyBuffer_Release (&buffer->view);
+    PyMem_Del (buffer);
+
+#ifdef WITH_THREAD
+    PyGILState_Release(state);
+#endif
+
+    SDL_FreeRW (context);
+    return 0;
+}
+
+/* Whether obj is in memory and can be read without calling into Python.
+ * Bytes with no null characters are left to the file object path, since
+ * they are a file name that could not be opened.
+ */
+static int
+is_buffer_object (PyObject *obj)
+{
+    if (PyUnicode_Check (obj) || !PyObject_CheckBuffer (obj))
+        return 0;
+    if (Bytes_Check (obj) &&
+        (size_t) Bytes_GET_SIZE (obj) == strlen (Bytes_AS_STRING (obj)))
+        return 0;
+    return 1;
+}
+
+static SDL_RWops*
+RWopsFromBufferObject(PyObject *obj)
+{
+    SDL_RWops *rw;
+    RWBuffer *buffer;
+    PyObject *result;
+    Py_ssize_t pos = 0;
+
+    /* Start where a file-like buffer, such as mmap, is positioned */
+    if (PyObject_HasAttrString(obj, "tell")) {
+        result = PyObject_CallMethod(obj, "tell", NULL);
+        if (result == NULL) {
+            return NULL;
+        }
+        pos = PyInt_AsSsize_t(result);
+        Py_DECREF(result);
+        if (pos == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+    }
+
+    buffer = PyMem_New(RWBuffer, 1);
+    if (buffer == NULL) {
+        return (SDL_RWops *)PyErr_NoMemory();
+    }
+    if (PyObject_GetBuffer(obj, &buffer->view, PyBUF_SIMPLE)) {
+        PyMem_Del(buffer);
+        return NULL;
+    }
+    rw = SDL_AllocRW();
+    if (rw == NULL) {
+        PyBuffer_Release(&buffer->view);
+        PyMem_Del(buffer);
+        return (SDL_RWops *)PyErr_NoMemory();
+    }
+    buffer->pos = pos < 0 ? 0 : pos;
+    if (buffer->pos > buffer->view.len)
+        buffer->pos = buffer->view.len;
+    rw->hidden.unknown.data1 = (void *)buffer;
+    rw->seek = rw_seek_buf;
+    rw->read = rw_read_buf;
+    rw->write = rw_write_buf;
+    rw->close = rw_close_buf;
+
+#ifdef WITH_THREAD
+    PyEval_InitThreads();
+#endif
+
+    return rw;
+}
+#endif /* PG_ENABLE_NEWBUF */
+
 static SDL_RWops*
 RWopsFromFileObject(PyObject *obj)
 {
@@ -256,6 +405,11 @@ RWopsFromFileObject(PyObject *obj)
     if (obj == NULL) {
         return (SDL_RWops *)RAISE(PyExc_TypeError, "Invalid filetype object");
     }
+#if PG_ENABLE_NEWBUF
+    if (is_buffer_object(obj)) {
+        return RWopsFromBufferObject(obj);
+    }
+#endif
     helper = PyMem_New(RWHelper, 1);
     if (helper == NULL) {
         return (SDL_RWops *)PyErr_NoMemory();
@@ -417,6 +571,11 @@ RWopsFromFileObjectThreaded(PyObject *obj)
     return (SDL_RWops *)RAISE(PyExc_NotImplementedError,
                               "Python built without thread support");
 #else
+#if PG_ENABLE_NEWBUF
+    if (is_buffer_object(obj)) {
+        return RWopsFromBufferObject(obj);
+    }
+#endif
     helper = PyMem_New(RWHelper, 1);
     if (helper == NULL) {
         return (SDL_RWops *)PyErr_NoMemory();
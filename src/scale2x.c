@@ -28,129 +28,568 @@
    an astonishing job of doubling game graphic data while interpolating out
    the jaggies. Congrats to the AdvanceMAME team, I'm very impressed and
    surprised with this code!
+
+   Scale3x from the same page is here too, Scale4x is Scale2x done twice,
+   and xBR 2x is Hyllian's edge blending filter.
+
+   All the filters work on rows of Uint32 pixel values. 32 bit surfaces are
+   read and written in place, other depths are converted a row at a time,
+   so nothing the size of the image is ever allocated. Each band of source
+   rows runs on its own thread and keeps the few rows it needs in a small
+   cache.
 */
 
 
 
 #include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pgparallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCALE2X_SSE2
+#endif
+
 #define MAX(a,b)    (((a) > (b)) ? (a) : (b))
 #define MIN(a,b)    (((a) < (b)) ? (a) : (b))
 
+/* Source rows kept converted per band, enough for the 5x5 xBR window. */
+#define SCALE_CACHE_ROWS 5
 
-#define READINT24(x)      ((x)[0]<<16 | (x)[1]<<8 | (x)[2])
-#define WRITEINT24(x, i)  {(x)[0]=i>>16; (x)[1]=(i>>8)&0xff; x[2]=i&0xff; }
+/* Source pixels per band before threads are used. */
+#define SCALE_MIN_BAND_PIXELS 16384
 
-/*
-  this requires a destination surface already setup to be twice as
-  large as the source. oh, and formats must match too. this will just
-  blindly assume you didn't flounder.
-*/
+typedef struct {
+    SDL_Surface *src;
+    SDL_Surface *dst;
+    int factor;                 /* 2, 3 or 4 */
+    int xbr;
+    int rshift, gshift, bshift;
+    int failed;
+} scale_job_t;
+
+typedef struct {
+    Uint32 *rows[SCALE_CACHE_ROWS];
+    Uint32 *bufs[SCALE_CACHE_ROWS];
+    Uint32 *yuv[SCALE_CACHE_ROWS];
+    int tags[SCALE_CACHE_ROWS];
+    Uint32 *out[4];
+    Uint32 *rows2x[3][2];       /* Scale4x, the 2x rows of 3 source rows */
+    int tags2x[3];
+} scale_cache_t;
+
+int scale2x (SDL_Surface *src, SDL_Surface *dst);
+int scale3x (SDL_Surface *src, SDL_Surface *dst);
+int scale4x (SDL_Surface *src, SDL_Surface *dst);
+int xbr2x (SDL_Surface *src, SDL_Surface *dst);
 
-void scale2x(SDL_Surface *src, SDL_Surface *dst)
+static void
+load_row (const Uint8 *pix, int bpp, int w, Uint32 *out)
 {
-    int looph, loopw;
+    int x;
 
-    Uint8* srcpix = (Uint8*)src->pixels;
-    Uint8* dstpix = (Uint8*)dst->pixels;
+    switch (bpp)
+    {
+    case 1:
+        for (x = 0; x < w; ++x)
+            out[x] = pix[x];
+        break;
+    case 2:
+        for (x = 0; x < w; ++x)
+            out[x] = ((const Uint16 *) pix)[x];
+        break;
+    case 3:
+        for (x = 0; x < w; ++x, pix += 3) {
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+            out[x] = pix[0] | (pix[1] << 8) | (pix[2] << 16);
+#else
+            out[x] = (pix[0] << 16) | (pix[1] << 8) | pix[2];
+#endif
+        }
+        break;
+    default:
+        memcpy (out, pix, sizeof (Uint32) * w);
+        break;
+    }
+}
 
-    const int srcpitch = src->pitch;
-    const int dstpitch = dst->pitch;
-    const int width = src->w;
-    const int height = src->h;
+static void
+store_row (const Uint32 *in, int bpp, int w, Uint8 *pix)
+{
+    int x;
 
-    switch(src->format->BytesPerPixel)
+    switch (bpp)
     {
-    case 1: {
-        Uint8 E0, E1, E2, E3, B, D, E, F, H;
-        for(looph = 0; looph < height; ++looph)
-        {
-            for(loopw = 0; loopw < width; ++ loopw)
-            {
-                    B = *(Uint8*)(srcpix + (MAX(0,looph-1)*srcpitch) + (1*loopw));
-                    D = *(Uint8*)(srcpix + (looph*srcpitch) + (1*MAX(0,loopw-1)));
-                    E = *(Uint8*)(srcpix + (looph*srcpitch) + (1*loopw));
-                    F = *(Uint8*)(srcpix + (looph*srcpitch) + (1*MIN(width-1,loopw+1)));
-                    H = *(Uint8*)(srcpix + (MIN(height-1,looph+1)*srcpitch) + (1*loopw));
-
-                E0 = D == B && B != F && D != H ? D : E;
-                                E1 = B == F && B != D && F != H ? F : E;
-                E2 = D == H && D != B && H != F ? D : E;
-                E3 = H == F && D != H && B != F ? F : E;
-
-                *(Uint8*)(dstpix + looph*2*dstpitch + loopw*2*1) = E0;
-                *(Uint8*)(dstpix + looph*2*dstpitch + (loopw*2+1)*1) = E1;
-                *(Uint8*)(dstpix + (looph*2+1)*dstpitch + loopw*2*1) = E2;
-                *(Uint8*)(dstpix + (looph*2+1)*dstpitch + (loopw*2+1)*1) = E3;
-            }
-        }break;}
-    case 2: {
-        Uint16 E0, E1, E2, E3, B, D, E, F, H;
-        for(looph = 0; looph < height; ++looph)
-        {
-            for(loopw = 0; loopw < width; ++ loopw)
-            {
-                    B = *(Uint16*)(srcpix + (MAX(0,looph-1)*srcpitch) + (2*loopw));
-                    D = *(Uint16*)(srcpix + (looph*srcpitch) + (2*MAX(0,loopw-1)));
-                    E = *(Uint16*)(srcpix + (looph*srcpitch) + (2*loopw));
-                    F = *(Uint16*)(srcpix + (looph*srcpitch) + (2*MIN(width-1,loopw+1)));
-                    H = *(Uint16*)(srcpix + (MIN(height-1,looph+1)*srcpitch) + (2*loopw));
-
-                E0 = D == B && B != F && D != H ? D : E;
-                                E1 = B == F && B != D && F != H ? F : E;
-                E2 = D == H && D != B && H != F ? D : E;
-                E3 = H == F && D != H && B != F ? F : E;
-
-                *(Uint16*)(dstpix + looph*2*dstpitch + loopw*2*2) = E0;
-                *(Uint16*)(dstpix + looph*2*dstpitch + (loopw*2+1)*2) = E1;
-                *(Uint16*)(dstpix + (looph*2+1)*dstpitch + loopw*2*2) = E2;
-                *(Uint16*)(dstpix + (looph*2+1)*dstpitch + (loopw*2+1)*2) = E3;
-            }
-        }break;}
-    case 3: {
-        int E0, E1, E2, E3, B, D, E, F, H;
-        for(looph = 0; looph < height; ++looph)
-        {
-            for(loopw = 0; loopw < width; ++ loopw)
-            {
-                    B = READINT24(srcpix + (MAX(0,looph-1)*srcpitch) + (3*loopw));
-                    D = READINT24(srcpix + (looph*srcpitch) + (3*MAX(0,loopw-1)));
-                    E = READINT24(srcpix + (looph*srcpitch) + (3*loopw));
-                    F = READINT24(srcpix + (looph*srcpitch) + (3*MIN(width-1,loopw+1)));
-                    H = READINT24(srcpix + (MIN(height-1,looph+1)*srcpitch) + (3*loopw));
-
-                E0 = D == B && B != F && D != H ? D : E;
-                                E1 = B == F && B != D && F != H ? F : E;
-                E2 = D == H && D != B && H != F ? D : E;
-                E3 = H == F && D != H && B != F ? F : E;
-
-                WRITEINT24((dstpix + looph*2*dstpitch + loopw*2*3), E0);
-                WRITEINT24((dstpix + looph*2*dstpitch + (loopw*2+1)*3), E1);
-                WRITEINT24((dstpix + (looph*2+1)*dstpitch + loopw*2*3), E2);
-                WRITEINT24((dstpix + (looph*2+1)*dstpitch + (loopw*2+1)*3), E3);
-            }
-        }break;}
-    default: { /*case 4:*/
-        Uint32 E0, E1, E2, E3, B, D, E, F, H;
-        for(looph = 0; looph < height; ++looph)
-        {
-            for(loopw = 0; loopw < width; ++ loopw)
-            {
-                    B = *(Uint32*)(srcpix + (MAX(0,looph-1)*srcpitch) + (4*loopw));
-                    D = *(Uint32*)(srcpix + (looph*srcpitch) + (4*MAX(0,loopw-1)));
-                    E = *(Uint32*)(srcpix + (looph*srcpitch) + (4*loopw));
-                    F = *(Uint32*)(srcpix + (looph*srcpitch) + (4*MIN(width-1,loopw+1)));
-                    H = *(Uint32*)(srcpix + (MIN(height-1,looph+1)*srcpitch) + (4*loopw));
-
-                E0 = D == B && B != F && D != H ? D : E;
-                                E1 = B == F && B != D && F != H ? F : E;
-                E2 = D == H && D != B && H != F ? D : E;
-                E3 = H == F && D != H && B != F ? F : E;
-
-                *(Uint32*)(dstpix + looph*2*dstpitch + loopw*2*4) = E0;
-                *(Uint32*)(dstpix + looph*2*dstpitch + (loopw*2+1)*4) = E1;
-                *(Uint32*)(dstpix + (looph*2+1)*dstpitch + loopw*2*4) = E2;
-                *(Uint32*)(dstpix + (looph*2+1)*dstpitch + (loopw*2+1)*4) = E3;
+    case 1:
+        for (x = 0; x < w; ++x)
+            pix[x] = (Uint8) in[x];
+        break;
+    case 2:
+        for (x = 0; x < w; ++x)
+            ((Uint16 *) pix)[x] = (Uint16) in[x];
+        break;
+    case 3:
+        for (x = 0; x < w; ++x, pix += 3) {
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+            pix[0] = (Uint8) in[x];
+            pix[1] = (Uint8) (in[x] >> 8);
+            pix[2] = (Uint8) (in[x] >> 16);
+#else
+            pix[0] = (Uint8) (in[x] >> 16);
+            pix[1] = (Uint8) (in[x] >> 8);
+            pix[2] = (Uint8) in[x];
+#endif
+        }
+        break;
+    default:
+        memcpy (pix, in, sizeof (Uint32) * w);
+        break;
+    }
+}
+
+/* Luma and chroma of a pixel packed as y << 16 | u << 8 | v, used by xBR
+   to measure how different two colors look. */
+static void
+yuv_row (scale_job_t *job, const Uint32 *row, Uint32 *out, int w)
+{
+    int x, r, g, b, y, u, v;
+
+    for (x = 0; x < w; ++x) {
+        r = (row[x] >> job->rshift) & 0xff;
+        g = (row[x] >> job->gshift) & 0xff;
+        b = (row[x] >> job->bshift) & 0xff;
+        y = (299 * r + 587 * g + 114 * b) / 1000;
+        u = (-169 * r - 331 * g + 500 * b) / 1000 + 128;
+        v = (500 * r - 419 * g - 81 * b) / 1000 + 128;
+        out[x] = (y << 16) | (u << 8) | v;
+    }
+}
+
+/* Source row y, clamped to the surface, as Uint32 pixels. */
+static const Uint32*
+src_row (scale_job_t *job, scale_cache_t *cache, int y)
+{
+    SDL_Surface *src = job->src;
+    const Uint8 *pix;
+    int slot;
+
+    y = MAX (0, MIN (src->h - 1, y));
+    slot = y % SCALE_CACHE_ROWS;
+    if (cache->tags[slot] != y) {
+        pix = (const Uint8 *) src->pixels + y * src->pitch;
+        if (src->format->BytesPerPixel == 4) {
+            cache->rows[slot] = (Uint32 *) pix;
+        }
+        else {
+            load_row (pix, src->format->BytesPerPixel, src->w,
+                      cache->bufs[slot]);
+            cache->rows[slot] = cache->bufs[slot];
+        }
+        if (job->xbr)
+            yuv_row (job, cache->rows[slot], cache->yuv[slot], src->w);
+        cache->tags[slot] = y;
+    }
+    return cache->rows[slot];
+}
+
+static const Uint32*
+src_yuv (scale_cache_t *cache, int h, int y)
+{
+    return cache->yuv[MAX (0, MIN (h - 1, y)) % SCALE_CACHE_ROWS];
+}
+
+/* Where to write destination row i of the current source row. */
+static Uint32*
+dst_row (scale_job_t *job, scale_cache_t *cache, int i, int y)
+{
+    SDL_Surface *dst = job->dst;
+
+    if (dst->format->BytesPerPixel == 4)
+        return (Uint32 *) ((Uint8 *) dst->pixels + y * dst->pitch);
+    return cache->out[i];
+}
+
+static void
+dst_flush (scale_job_t *job, scale_cache_t *cache, int i, int y)
+{
+    SDL_Surface *dst = job->dst;
+
+    if (dst->format->BytesPerPixel != 4) {
+        store_row (cache->out[i], dst->format->BytesPerPixel, dst->w,
+                   (Uint8 *) dst->pixels + y * dst->pitch);
+    }
+}
+
+/* One row of Scale2x.  b, e and h are the rows above, at and below,
+   o0 and o1 get 2 * w pixels each. */
+static void
+scale2x_row (const Uint32 *b, const Uint32 *e, const Uint32 *h,
+             Uint32 *o0, Uint32 *o1, int w)
+{
+    Uint32 B, D, E, F, H;
+    int x = 0;
+#if defined(SCALE2X_SSE2)
+    __m128i vB, vD, vE, vF, vH, db, bf, dh, hf, c, e0, e1, e2, e3;
+#endif
+
+    while (x < w) {
+        B = b[x];
+        D = e[MAX (0, x - 1)];
+        E = e[x];
+        F = e[MIN (w - 1, x + 1)];
+        H = h[x];
+
+        o0[2 * x] = D == B && B != F && D != H ? D : E;
+        o0[2 * x + 1] = B == F && B != D && F != H ? F : E;
+        o1[2 * x] = D == H && D != B && H != F ? D : E;
+        o1[2 * x + 1] = H == F && D != H && B != F ? F : E;
+        ++x;
+
+#if defined(SCALE2X_SSE2)
+        /* Four pixels at once while their neighbours are all in the row,
+           the selects are the same rules as above. */
+        for (; x + 4 < w; x += 4) {
+            vB = _mm_loadu_si128 ((const __m128i *) (b + x));
+            vD = _mm_loadu_si128 ((const __m128i *) (e + x - 1));
+            vE = _mm_loadu_si128 ((const __m128i *) (e + x));
+            vF = _mm_loadu_si128 ((const __m128i *) (e + x + 1));
+            vH = _mm_loadu_si128 ((const __m128i *) (h + x));
+            db = _mm_cmpeq_epi32 (vD, vB);
+            bf = _mm_cmpeq_epi32 (vB, vF);
+            dh = _mm_cmpeq_epi32 (vD, vH);
+            hf = _mm_cmpeq_epi32 (vH, vF);
+
+            c = _mm_andnot_si128 (_mm_or_si128 (bf, dh), db);
+            e0 = _mm_or_si128 (_mm_and_si128 (c, vD), _mm_andnot_si128 (c, vE));
+            c = _mm_andnot_si128 (_mm_or_si128 (db, hf), bf);
+            e1 = _mm_or_si128 (_mm_and_si128 (c, vF), _mm_andnot_si128 (c, vE));
+            c = _mm_andnot_si128 (_mm_or_si128 (db, hf), dh);
+            e2 = _mm_or_si128 (_mm_and_si128 (c, vD), _mm_andnot_si128 (c, vE));
+            c = _mm_andnot_si128 (_mm_or_si128 (dh, bf), hf);
+            e3 = _mm_or_si128 (_mm_and_si128 (c, vF), _mm_andnot_si128 (c, vE));
+
+            _mm_storeu_si128 ((__m128i *) (o0 + 2 * x),
+                              _mm_unpacklo_epi32 (e0, e1));
+            _mm_storeu_si128 ((__m128i *) (o0 + 2 * x + 4),
+                              _mm_unpackhi_epi32 (e0, e1));
+            _mm_storeu_si128 ((__m128i *) (o1 + 2 * x),
+                              _mm_unpacklo_epi32 (e2, e3));
+            _mm_storeu_si128 ((__m128i *) (o1 + 2 * x + 4),
+                              _mm_unpackhi_epi32 (e2, e3));
+        }
+#endif
+    }
+}
+
+/* One row of Scale3x, o0, o1 and o2 get 3 * w pixels each. */
+static void
+scale3x_row (const Uint32 *b, const Uint32 *e, const Uint32 *h,
+             Uint32 *o0, Uint32 *o1, Uint32 *o2, int w)
+{
+    Uint32 A, B, C, D, E, F, G, H, I;
+    int db, bf, dh, hf;
+    int x;
+
+    for (x = 0; x < w; ++x) {
+        A = b[MAX (0, x - 1)];
+        B = b[x];
+        C = b[MIN (w - 1, x + 1)];
+        D = e[MAX (0, x - 1)];
+        E = e[x];
+        F = e[MIN (w - 1, x + 1)];
+        G = h[MAX (0, x - 1)];
+        H = h[x];
+        I = h[MIN (w - 1, x + 1)];
+
+        db = D == B && B != F && D != H;
+        bf = B == F && B != D && F != H;
+        dh = D == H && D != B && H != F;
+        hf = H == F && D != H && B != F;
+
+        o0[3 * x] = db ? D : E;
+        o0[3 * x + 1] = (db && E != C) || (bf && E != A) ? B : E;
+        o0[3 * x + 2] = bf ? F : E;
+        o1[3 * x] = (db && E != G) || (dh && E != A) ? D : E;
+        o1[3 * x + 1] = E;
+        o1[3 * x + 2] = (bf && E != I) || (hf && E != C) ? F : E;
+        o2[3 * x] = dh ? D : E;
+        o2[3 * x + 1] = (dh && E != I) || (hf && E != G) ? H : E;
+        o2[3 * x + 2] = hf ? F : E;
+    }
+}
+
+/* The two 2x rows made from source row y, for Scale4x. */
+static Uint32**
+rows2x (scale_job_t *job, scale_cache_t *cache, int y)
+{
+    int slot = y % 3;
+
+    if (cache->tags2x[slot] != y) {
+        scale2x_row (src_row (job, cache, y - 1), src_row (job, cache, y),
+                     src_row (job, cache, y + 1), cache->rows2x[slot][0],
+                     cache->rows2x[slot][1], job->src->w);
+        cache->tags2x[slot] = y;
+    }
+    return cache->rows2x[slot];
+}
+
+/* Each byte of the result is a weighted mix, m / 2^s of b. */
+static Uint32
+xbr_blend (Uint32 a, Uint32 b, int m, int s)
+{
+    Uint32 result = 0;
+    int i, ca, cb;
+
+    for (i = 0; i < 32; i += 8) {
+        ca = (a >> i) & 0xff;
+        cb = (b >> i) & 0xff;
+        result |= (Uint32) ((ca * ((1 << s) - m) + cb * m) >> s) << i;
+    }
+    return result;
+}
+
+static int
+xbr_diff (Uint32 a, Uint32 b)
+{
+    int dy = (int) (a >> 16) - (int) (b >> 16);
+    int du = (int) ((a >> 8) & 0xff) - (int) ((b >> 8) & 0xff);
+    int dv = (int) (a & 0xff) - (int) (b & 0xff);
+
+    return abs (dy) + abs (du) + abs (dv);
+}
+
+#define XBR_EQ(a, b) (xbr_diff (a, b) < 155)
+
+/* Neighbourhood of a source pixel E, stored 5 by 5 with E at 12:
+
+          A1 B1 C1
+       A0 PA PB PC C4
+       D0 PD PE PF F4
+       G0 PG PH PI I4
+          G5 H5 I5
+
+   Each corner of the output is filtered by the same code with the window
+   turned around.  The order is PE, PI, PH, PF, PG, PC, PD, PB, F4, I4, H5,
+   I5 as seen from the bottom right corner, then the four output pixels
+   from the far corner to the filtered one.
+*/
+static const int xbr_turns[4][16] = {
+    { 12, 18, 17, 13, 16, 8, 11, 7, 14, 19, 22, 23, 0, 1, 2, 3 },
+    { 12, 8, 13, 7, 18, 6, 17, 11, 2, 3, 14, 9, 2, 0, 3, 1 },
+    { 12, 6, 7, 11, 8, 16, 13, 17, 10, 5, 2, 1, 3, 2, 1, 0 },
+    { 12, 16, 11, 17, 6, 18, 7, 13, 22, 21, 10, 15, 1, 3, 0, 2 },
+};
+
+static void
+xbr_corner (const Uint32 *p, const Uint32 *q, const int *t, Uint32 *out)
+{
+    const Uint32 PE = p[t[0]], PH = p[t[2]], PF = p[t[3]];
+    const Uint32 PG = p[t[4]], PC = p[t[5]], PD = p[t[6]], PB = p[t[7]];
+    const Uint32 qE = q[t[0]], qI = q[t[1]], qH = q[t[2]], qF = q[t[3]];
+    const Uint32 qG = q[t[4]], qC = q[t[5]], qD = q[t[6]], qB = q[t[7]];
+    const Uint32 qF4 = q[t[8]], qI4 = q[t[9]], qH5 = q[t[10]], qI5 = q[t[11]];
+    Uint32 *n1 = out + t[13], *n2 = out + t[14], *n3 = out + t[15];
+    int e, i, ke, ki, left, up;
+    Uint32 px;
+
+    if (PE == PH || PE == PF)
+        return;
+
+    e = (xbr_diff (qE, qC) + xbr_diff (qE, qG) + xbr_diff (qI, qH5) +
+         xbr_diff (qI, qF4) + (xbr_diff (qH, qF) << 2));
+    i = (xbr_diff (qH, qD) + xbr_diff (qH, qI5) + xbr_diff (qF, qI4) +
+         xbr_diff (qF, qB) + (xbr_diff (qE, qI) << 2));
+    if (e > i)
+        return;
+
+    px = xbr_diff (qE, qF) <= xbr_diff (qE, qH) ? PF : PH;
+    if (e < i && ((!XBR_EQ (qF, qB) && !XBR_EQ (qH, qD)) ||
+                  (XBR_EQ (qE, qI) && !XBR_EQ (qF, qI4) &&
+                   !XBR_EQ (qH, qI5)) ||
+                  XBR_EQ (qE, qG) || XBR_EQ (qE, qC))) {
+        ke = xbr_diff (qF, qG);
+        ki = xbr_diff (qH, qC);
+        left = (ke << 1) <= ki && PE != PG && PD != PG;
+        up = ke >= (ki << 1) && PE != PC && PB != PC;
+        if (left && up) {
+            *n3 = xbr_blend (*n3, px, 7, 3);
+            *n2 = xbr_blend (*n2, px, 1, 2);
+            *n1 = *n2;
+        }
+        else if (left) {
+            *n3 = xbr_blend (*n3, px, 3, 2);
+            *n2 = xbr_blend (*n2, px, 1, 2);
+        }
+        else if (up) {
+            *n3 = xbr_blend (*n3, px, 3, 2);
+            *n1 = xbr_blend (*n1, px, 1, 2);
+        }
+        else {
+            *n3 = xbr_blend (*n3, px, 1, 1);
+        }
+    }
+    else {
+        *n3 = xbr_blend (*n3, px, 1, 1);
+    }
+}
+
+static void
+xbr_row (scale_job_t *job, scale_cache_t *cache, int y,
+         Uint32 *o0, Uint32 *o1)
+{
+    const int w = job->src->w, h = job->src->h;
+    const Uint32 *rows[5], *yuvs[5];
+    Uint32 p[25], q[25], out[4];
+    int x, i, j, k, sx;
+
+    for (j = 0; j < 5; ++j) {
+        rows[j] = src_row (job, cache, y + j - 2);
+        yuvs[j] = src_yuv (cache, h, y + j - 2);
+    }
+    for (x = 0; x < w; ++x) {
+        for (j = 0; j < 5; ++j) {
+            for (i = 0; i < 5; ++i) {
+                sx = MAX (0, MIN (w - 1, x + i - 2));
+                p[j * 5 + i] = rows[j][sx];
+                q[j * 5 + i] = yuvs[j][sx];
             }
-        }break;}
+        }
+        out[0] = out[1] = out[2] = out[3] = p[12];
+        for (k = 0; k < 4; ++k) {
+            xbr_corner (p, q, xbr_turns[k], out);
+        }
+        o0[2 * x] = out[0];
+        o0[2 * x + 1] = out[1];
+        o1[2 * x] = out[2];
+        o1[2 * x + 1] = out[3];
     }
 }
+
+static void
+scale_band (void *data, int band, int start, int end)
+{
+    scale_job_t *job = (scale_job_t *) data;
+    const int w = job->src->w, h = job->src->h, f = job->factor;
+    scale_cache_t cache;
+    Uint32 *mem, *next, **r0, **r1, **r2;
+    const Uint32 *prev, *below;
+    int i, y;
+
+    mem = (Uint32 *) malloc (sizeof (Uint32) *
+                             (2 * SCALE_CACHE_ROWS * w + 16 * w + 12 * w + 1));
+    if (!mem) {
+        job->failed = 1;
+        return;
+    }
+    next = mem;
+    for (i = 0; i < SCALE_CACHE_ROWS; ++i) {
+        cache.bufs[i] = next;
+        cache.yuv[i] = next + w;
+        cache.tags[i] = -1;
+        next += 2 * w;
+    }
+    for (i = 0; i < 4; ++i) {
+        cache.out[i] = next;
+        next += 4 * w;
+    }
+    for (i = 0; i < 3; ++i) {
+        cache.rows2x[i][0] = next;
+        cache.rows2x[i][1] = next + 2 * w;
+        cache.tags2x[i] = -1;
+        next += 4 * w;
+    }
+
+    for (y = start; y < end; ++y) {
+        if (job->xbr) {
+            xbr_row (job, &cache, y, dst_row (job, &cache, 0, 2 * y),
+                     dst_row (job, &cache, 1, 2 * y + 1));
+        }
+        else if (f == 2) {
+            scale2x_row (src_row (job, &cache, y - 1),
+                         src_row (job, &cache, y),
+                         src_row (job, &cache, y + 1),
+                         dst_row (job, &cache, 0, 2 * y),
+                         dst_row (job, &cache, 1, 2 * y + 1), w);
+        }
+        else if (f == 3) {
+            scale3x_row (src_row (job, &cache, y - 1),
+                         src_row (job, &cache, y),
+                         src_row (job, &cache, y + 1),
+                         dst_row (job, &cache, 0, 3 * y),
+                         dst_row (job, &cache, 1, 3 * y + 1),
+                         dst_row (job, &cache, 2, 3 * y + 2), w);
+        }
+        else {
+            /* Scale2x of the 2x rows, which only live in the cache.  The
+               2x image is clamped at its own edges. */
+            r0 = y > 0 ? rows2x (job, &cache, y - 1) : NULL;
+            r1 = rows2x (job, &cache, y);
+            r2 = y < h - 1 ? rows2x (job, &cache, y + 1) : NULL;
+            prev = r0 ? r0[1] : r1[0];
+            below = r2 ? r2[0] : r1[1];
+            scale2x_row (prev, r1[0], r1[1],
+                         dst_row (job, &cache, 0, 4 * y),
+                         dst_row (job, &cache, 1, 4 * y + 1), 2 * w);
+            scale2x_row (r1[0], r1[1], below,
+                         dst_row (job, &cache, 2, 4 * y + 2),
+                         dst_row (job, &cache, 3, 4 * y + 3), 2 * w);
+        }
+        for (i = 0; i < (job->xbr ? 2 : f); ++i) {
+            dst_flush (job, &cache, i, (job->xbr ? 2 : f) * y + i);
+        }
+    }
+    free (mem);
+}
+
+/*
+  these require a destination surface already setup to be the right
+  multiple of the source size. oh, and formats must match too. this will
+  just blindly assume you didn't flounder.  They return -1 when out of
+  memory, 0 otherwise.
+*/
+static int
+scale_run (SDL_Surface *src, SDL_Surface *dst, int factor, int xbr)
+{
+    scale_job_t job;
+
+    if (!src->w || !src->h)
+        return 0;
+    job.src = src;
+    job.dst = dst;
+    job.factor = factor;
+    job.xbr = xbr;
+    job.rshift = src->format->Rshift;
+    job.gshift = src->format->Gshift;
+    job.bshift = src->format->Bshift;
+    job.failed = 0;
+    pg_run_bands (scale_band, &job, src->h,
+                  SCALE_MIN_BAND_PIXELS / src->w);
+    return job.failed ? -1 : 0;
+}
+
+int
+scale2x (SDL_Surface *src, SDL_Surface *dst)
+{
+    return scale_run (src, dst, 2, 0);
+}
+
+int
+scale3x (SDL_Surface *src, SDL_Surface *dst)
+{
+    return scale_run (src, dst, 3, 0);
+}
+
+int
+scale4x (SDL_Surface *src, SDL_Surface *dst)
+{
+    return scale_run (src, dst, 4, 0);
+}
+
+/* xBR needs 8 bits per color channel, so 24 or 32 bit surfaces only. */
+int
+xbr2x (SDL_Surface *src, SDL_Surface *dst)
+{
+    return scale_run (src, dst, 2, 1);
+}
@@ -51,6 +51,9 @@
 #define PYGAME_BLEND_RGBA_MAX  0x10
 #define PYGAME_BLEND_PREMULTIPLIED  0x11
 
+/* pygame.draw only: blend the color over the pixels by its alpha */
+#define PYGAME_BLEND_ALPHA  0x12
+
 
 
 
@@ -30,6 +30,17 @@
 #include <math.h>
 #include <string.h>
 #include "scale.h"
+#include "mask.h"
+#include "pgparallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PG_TRANSFORM_SSE2
+#endif
+
+/* Images smaller than this many pixels per band are not worth a thread. */
+#define THRESHOLD_MIN_BAND_PIXELS 65536
 
 
 typedef void (* SMOOTHSCALE_FILTER_P)(Uint8 *, Uint8 *, int, int, int, int, int);
@@ -70,7 +81,15 @@ static struct _module_state _state = {
 
 #endif /* if defined(SCALE_MMX_SUPPORT) */
 
-void scale2x (SDL_Surface *src, SDL_Surface *dst);
+int scale2x (SDL_Surface *src, SDL_Surface *dst);
+int scale3x (SDL_Surface *src, SDL_Surface *dst);
+int scale4x (SDL_Surface *src, SDL_Surface *dst);
+int xbr2x (SDL_Surface *src, SDL_Surface *dst);
+int blur_box (SDL_Surface *src, SDL_Surface *dst, int radius);
+int blur_gaussian (SDL_Surface *src, SDL_Surface *dst, double radius);
+int blur_convolve (SDL_Surface *src, SDL_Surface *dst,
+                   const float *kernel_x, int nx,
+                   const float *kernel_y, int ny);
 extern SDL_Surface* rotozoomSurface (SDL_Surface *src, double angle,
                                      double zoom, int smooth);
 
@@ -532,13 +551,16 @@ surf_scale (PyObject* self, PyObject* arg)
         return PySurface_New (newsurf);
 }
 
+/* Shared by the pixel art scalers, func writes a copy factor times as
+   big as surf into a surface of the same format. */
 static PyObject*
-surf_scale2x (PyObject* self, PyObject* arg)
+scale_pixelart (PyObject* arg, int factor, int xbr,
+                int (*func) (SDL_Surface*, SDL_Surface*))
 {
     PyObject *surfobj, *surfobj2;
     SDL_Surface *surf;
     SDL_Surface *newsurf;
-    int width, height;
+    int width, height, result;
     surfobj2 = NULL;
 
     /*get all the arguments*/
@@ -548,40 +570,57 @@ surf_scale2x (PyObject* self, PyObject* arg)
 
     surf = PySurface_AsSurface (surfobj);
 
+    if (xbr && ((surf->format->BytesPerPixel != 3 &&
+                 surf->format->BytesPerPixel != 4) ||
+                surf->format->Rloss || surf->format->Gloss ||
+                surf->format->Bloss))
+        return RAISE (PyExc_ValueError,
+                      "Only 24 and 32 bit surfaces can be used with xbr2x.");
+
+    width = surf->w * factor;
+    height = surf->h * factor;
+
     /* if the second surface is not there, then make a new one. */
 
     if (!surfobj2)
     {
-        width = surf->w * 2;
-        height = surf->h * 2;
-
         newsurf = newsurf_fromsurf (surf, width, height);
 
         if (!newsurf)
             return NULL;
     }
     else
+    {
         newsurf = PySurface_AsSurface (surfobj2);
 
-    /* check to see if the size is twice as big. */
-    if (newsurf->w != (surf->w * 2) || newsurf->h != (surf->h * 2))
-        return RAISE (PyExc_ValueError, "Destination surface not 2x bigger.");
+        /* check to see if the size is the right multiple. */
+        if (newsurf->w != width || newsurf->h != height)
+            return PyErr_Format (PyExc_ValueError,
+                                 "Destination surface not %dx bigger.",
+                                 factor);
 
-    /* check to see if the format of the surface is the same. */
-    if (surf->format->BytesPerPixel != newsurf->format->BytesPerPixel)
-        return RAISE (PyExc_ValueError,
+        /* check to see if the format of the surface is the same. */
+        if (surf->format->BytesPerPixel != newsurf->format->BytesPerPixel)
+            return RAISE (PyExc_ValueError,
                       "Source and destination surfaces need the same format.");
+    }
 
     SDL_LockSurface (newsurf);
     SDL_LockSurface (surf);
 
     Py_BEGIN_ALLOW_THREADS;
-    scale2x (surf, newsurf);
+    result = func (surf, newsurf);
     Py_END_ALLOW_THREADS;
 
     SDL_UnlockSurface (surf);
     SDL_UnlockSurface (newsurf);
 
+    if (result)
+    {
+        if (!surfobj2)
+            SDL_FreeSurface (newsurf);
+        return PyErr_NoMemory ();
+    }
     if (surfobj2)
     {
         Py_INCREF (surfobj2);
@@ -591,6 +630,30 @@ surf_scale2x (PyObject* self, PyObject* arg)
         return PySurface_New (newsurf);
 }
 
+static PyObject*
+surf_scale2x (PyObject* self, PyObject* arg)
+{
+    return scale_pixelart (arg, 2, 0, scale2x);
+}
+
+static PyObject*
+surf_scale3x (PyObject* self, PyObject* arg)
+{
+    return scale_pixelart (arg, 3, 0, scale3x);
+}
+
+static PyObject*
+surf_scale4x (PyObject* self, PyObject* arg)
+{
+    return scale_pixelart (arg, 4, 0, scale4x);
+}
+
+static PyObject*
+surf_xbr2x (PyObject* self, PyObject* arg)
+{
+    return scale_pixelart (arg, 2, 1, xbr2x);
+}
+
 static PyObject*
 surf_rotate (PyObject* self, PyObject* arg)
 {
@@ -1514,13 +1577,14 @@ surf_set_smoothscale_backend (PyObject *self, PyObject *args, PyObject *kwds)
 
 
 static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
-                          SDL_Surface *surf2, Uint32 color,  Uint32 threshold,
-                          Uint32 diff_color, int change_return, int inverse)
+                          SDL_Surface *surf2, bitmask_t *mask,
+                          Uint32 color,  Uint32 threshold,
+                          Uint32 diff_color, int change_return, int inverse,
+                          int ystart, int yend)
 {
-    int x, y, result, similar, rshift, gshift, bshift, rshift2, gshift2, bshift2;
+    int x, y, similar, rshift, gshift, bshift, rshift2, gshift2, bshift2;
     int rloss, gloss, bloss, rloss2, gloss2, bloss2;
     Uint8 *pixels, *destpixels, *pixels2;
-    SDL_Rect sdlrect;
     SDL_PixelFormat *format, *destformat, *format2;
     Uint32 the_color, the_color2, rmask, gmask, bmask, rmask2, gmask2, bmask2;
     Uint8 *pix, *byte_buf;
@@ -1542,12 +1606,9 @@ static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
     bloss = format->Bloss;
 
     if(change_return) {
-        sdlrect.x = sdlrect.y = 0;
-        sdlrect.w = destsurf->w;
-        sdlrect.h = destsurf->h;
+        /* the caller has already filled destsurf with diff_color */
         destpixels = (Uint8 *) destsurf->pixels;
         destformat = destsurf->format;
-        result = SDL_FillRect (destsurf, &sdlrect, diff_color);
     } else { /* make gcc stop complaining */
         destpixels = NULL;
         destformat = NULL;
@@ -1577,7 +1638,7 @@ static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
     SDL_GetRGBA (threshold, format, &tr, &tg, &tb, &ta);
     SDL_GetRGBA (diff_color, format, &dr, &dg, &db, &da);
 
-    for(y=0; y < surf->h; y++) {
+    for(y=ystart; y < yend; y++) {
         pixels = (Uint8 *) surf->pixels + y*surf->pitch;
         if (surf2) {
             pixels2 = (Uint8 *) surf2->pixels + y*surf2->pitch;
@@ -1696,6 +1757,9 @@ static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
                         }
                     }
 
+                    if (mask) {
+                        bitmask_setbit (mask, x, y);
+                    }
                     similar++;
                 }
 
@@ -1764,6 +1828,9 @@ static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
                     }
                 }
 
+                if (mask) {
+                    bitmask_setbit (mask, x, y);
+                }
                 similar++;
             }
         }
@@ -1774,12 +1841,172 @@ static int get_threshold (SDL_Surface *destsurf, SDL_Surface *surf,
 
 
 
+/* The 32 bit threshold path compares whole pixels byte by byte, which
+ * needs the r, g and b channels of both surfaces in the same whole bytes.
+ */
+static int
+threshold_format_32 (SDL_PixelFormat *format)
+{
+    return (format->BytesPerPixel == 4 &&
+            format->Rmask == (Uint32) 0xff << format->Rshift &&
+            format->Gmask == (Uint32) 0xff << format->Gshift &&
+            format->Bmask == (Uint32) 0xff << format->Bshift);
+}
+
+#if defined(__GNUC__)
+#define THRESHOLD_POPCOUNT(w) __builtin_popcountl (w)
+#else
+static int
+threshold_popcount (BITMASK_W w)
+{
+    int count;
+
+    for (count = 0; w; ++count) {
+        w &= w - 1;
+    }
+    return count;
+}
+#define THRESHOLD_POPCOUNT(w) threshold_popcount (w)
+#endif
+
+typedef struct {
+    SDL_Surface *destsurf;
+    SDL_Surface *surf;
+    SDL_Surface *surf2;
+    bitmask_t *mask;
+    Uint32 color;
+    Uint32 threshold;
+    Uint32 diff_color;
+    int change_return;
+    int inverse;
+    int fast;
+    int similar[PG_MAX_BANDS];
+} threshold_job_t;
+
+static int
+get_threshold_32 (threshold_job_t *job, int ystart, int yend)
+{
+    SDL_Surface *surf = job->surf, *surf2 = job->surf2;
+    SDL_Surface *destsurf = job->change_return ? job->destsurf : NULL;
+    bitmask_t *mask = job->mask;
+    Uint32 rgbmask = (surf->format->Rmask | surf->format->Gmask |
+                      surf->format->Bmask);
+    /* Bytes outside the rgb channels, alpha and padding, are never
+       compared, so give them a threshold which always passes. */
+    Uint32 thresh = (job->threshold & rgbmask) | ~rgbmask;
+    Uint32 color = job->color, diff_color = job->diff_color;
+    Uint32 *row, *row2, *destrow;
+    Uint32 pix, ref, d;
+    BITMASK_W bits;
+    int x, y, i, n, shift, within;
+    int similar = 0;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i ones = _mm_set1_epi32 (-1);
+    const __m128i vthresh = _mm_set1_epi32 ((int) thresh);
+    const __m128i vcolor = _mm_set1_epi32 ((int) color);
+    const __m128i vdiff = _mm_set1_epi32 ((int) diff_color);
+    const __m128i vinverse = _mm_set1_epi32 (job->inverse ? -1 : 0);
+    __m128i p, q, ok;
+#endif
+
+    row2 = NULL;
+    destrow = NULL;
+    for (y = ystart; y < yend; ++y) {
+        row = (Uint32 *) ((Uint8 *) surf->pixels + y * surf->pitch);
+        if (surf2) {
+            row2 = (Uint32 *) ((Uint8 *) surf2->pixels + y * surf2->pitch);
+        }
+        if (destsurf) {
+            destrow = (Uint32 *) ((Uint8 *) destsurf->pixels +
+                                  y * destsurf->pitch);
+        }
+
+        /* Work in runs of one mask word, so the match bits can be
+           counted, and stored in the mask, a word at a time. */
+        for (x = 0; x < surf->w; x += BITMASK_W_LEN) {
+            n = MIN (surf->w - x, (int) BITMASK_W_LEN);
+            bits = 0;
+            i = 0;
+#if defined(PG_TRANSFORM_SSE2)
+            for (; i + 4 <= n; i += 4) {
+                p = _mm_loadu_si128 ((const __m128i *) (row + x + i));
+                q = row2 ? _mm_loadu_si128 ((const __m128i *) (row2 + x + i))
+                         : vcolor;
+                /* |p - q| <= thresh for every byte of a pixel */
+                ok = _mm_or_si128 (_mm_subs_epu8 (p, q), _mm_subs_epu8 (q, p));
+                ok = _mm_cmpeq_epi8 (_mm_subs_epu8 (ok, vthresh), zero);
+                ok = _mm_xor_si128 (_mm_cmpeq_epi32 (ok, ones), vinverse);
+                bits |= ((BITMASK_W)
+                         _mm_movemask_ps (_mm_castsi128_ps (ok))) << i;
+                if (destrow) {
+                    q = job->change_return == 2 ? p : vcolor;
+                    q = _mm_or_si128 (_mm_and_si128 (ok, q),
+                                      _mm_andnot_si128 (ok, vdiff));
+                    _mm_storeu_si128 ((__m128i *) (destrow + x + i), q);
+                }
+            }
+#endif
+            for (; i < n; ++i) {
+                pix = row[x + i];
+                ref = row2 ? row2[x + i] : color;
+                within = 1;
+                for (shift = 0; shift < 32; shift += 8) {
+                    d = (Uint32) abs ((int) ((pix >> shift) & 0xff) -
+                                      (int) ((ref >> shift) & 0xff));
+                    if (d > ((thresh >> shift) & 0xff)) {
+                        within = 0;
+                        break;
+                    }
+                }
+                if (within ^ job->inverse) {
+                    bits |= BITMASK_N (i);
+                    if (destrow) {
+                        destrow[x + i] = job->change_return == 2 ? pix : color;
+                    }
+                }
+                else if (destrow) {
+                    destrow[x + i] = diff_color;
+                }
+            }
+
+            similar += THRESHOLD_POPCOUNT (bits);
+            if (mask) {
+                mask->bits[x / BITMASK_W_LEN * mask->h + y] = bits;
+            }
+        }
+    }
+    return similar;
+}
+
+static void
+threshold_band (void *data, int band, int start, int end)
+{
+    threshold_job_t *job = (threshold_job_t *) data;
+
+    if (job->fast) {
+        job->similar[band] = get_threshold_32 (job, start, end);
+    }
+    else {
+        job->similar[band] = get_threshold (job->destsurf, job->surf,
+                                            job->surf2, job->mask,
+                                            job->color, job->threshold,
+                                            job->diff_color,
+                                            job->change_return,
+                                            job->inverse, start, end);
+    }
+}
+
+
 static PyObject* surf_threshold(PyObject* self, PyObject* arg)
 {
-    PyObject *surfobj, *surfobj2 = NULL, *surfobj3 = NULL;
+    PyObject *destobj, *surfobj2, *surfobj3 = NULL;
     SDL_Surface* surf = NULL, *destsurf = NULL, *surf2 = NULL;
-    int bpp, change_return = 1, inverse = 0;
+    bitmask_t *mask = NULL;
+    int change_return = 1, inverse = 0;
     int num_threshold_pixels = 0;
+    int nbands, i;
+    threshold_job_t job;
 
     PyObject *rgba_obj_color;
     PyObject *rgba_obj_threshold = NULL;
@@ -1793,20 +2020,53 @@ static PyObject* surf_threshold(PyObject* self, PyObject* arg)
     Uint32 color_diff_color;
 
     /*get all the arguments*/
-    if (!PyArg_ParseTuple (arg, "O!O!O|OOiO!i", &PySurface_Type, &surfobj,
+    if (!PyArg_ParseTuple (arg, "OO!O|OOiOi", &destobj,
                            &PySurface_Type, &surfobj2,
                            &rgba_obj_color,  &rgba_obj_threshold, &rgba_obj_diff_color,
                            &change_return,
-                           &PySurface_Type, &surfobj3, &inverse))
+                           &surfobj3, &inverse))
         return NULL;
 
 
-    destsurf = PySurface_AsSurface (surfobj);
     surf = PySurface_AsSurface (surfobj2);
+    if (surfobj3 == Py_None) {
+        surfobj3 = NULL;
+    }
     if(surfobj3) {
+        if (!PySurface_Check (surfobj3)) {
+            return RAISE (PyExc_TypeError,
+                          "the second Surface must be a Surface or None");
+        }
         surf2 = PySurface_AsSurface (surfobj3);
     }
 
+    if (PySurface_Check (destobj)) {
+        destsurf = PySurface_AsSurface (destobj);
+        if (change_return &&
+            (destsurf->w < surf->w || destsurf->h < surf->h)) {
+            return RAISE (PyExc_ValueError,
+                          "DestSurface is smaller than Surface");
+        }
+    }
+    else if (PyObject_TypeCheck (destobj, &PyMask_Type)) {
+        mask = PyMask_AsBitmap (destobj);
+        if (mask->w != surf->w || mask->h != surf->h) {
+            return RAISE (PyExc_ValueError,
+                          "Mask must be the same size as Surface");
+        }
+        change_return = 0;
+    }
+    else if (destobj == Py_None) {
+        change_return = 0;
+    }
+    else {
+        return RAISE (PyExc_TypeError,
+                      "DestSurface must be a Surface, a Mask or None");
+    }
+    if (!destsurf) {
+        destobj = NULL;
+    }
+
 
 
     if (PyInt_Check (rgba_obj_color)) {
@@ -1868,9 +2128,26 @@ static PyObject* surf_threshold(PyObject* self, PyObject* arg)
                                         rgba_diff_color[3]);
     }
 
-    bpp = surf->format->BytesPerPixel;
-
-    PySurface_Lock(surfobj);
+    job.destsurf = destsurf;
+    job.surf = surf;
+    job.surf2 = surf2;
+    job.mask = mask;
+    job.color = color;
+    job.threshold = color_threshold;
+    job.diff_color = color_diff_color;
+    job.change_return = change_return;
+    job.inverse = inverse ? 1 : 0;
+    job.fast = (threshold_format_32 (surf->format) &&
+                (!surf2 ||
+                 (surf2->format->BytesPerPixel == 4 &&
+                  surf2->format->Rmask == surf->format->Rmask &&
+                  surf2->format->Gmask == surf->format->Gmask &&
+                  surf2->format->Bmask == surf->format->Bmask)) &&
+                (!change_return || destsurf->format->BytesPerPixel == 4));
+
+    if (destobj) {
+        PySurface_Lock(destobj);
+    }
     PySurface_Lock(surfobj2);
 
     if(surfobj3) {
@@ -1878,20 +2155,33 @@ static PyObject* surf_threshold(PyObject* self, PyObject* arg)
     }
     Py_BEGIN_ALLOW_THREADS;
 
-
-    num_threshold_pixels = get_threshold (destsurf,
-                                          surf,
-                                          surf2,
-                                          color,
-                                          color_threshold,
-                                          color_diff_color,
-                                          change_return,
-                                          inverse);
-
+    /* The 32 bit path writes every destination pixel it covers, so only
+       fill with diff_color when part of DestSurface is left over. */
+    if (change_return &&
+        (!job.fast || destsurf->w != surf->w || destsurf->h != surf->h ||
+         destsurf->clip_rect.x != 0 || destsurf->clip_rect.y != 0 ||
+         destsurf->clip_rect.w != destsurf->w ||
+         destsurf->clip_rect.h != destsurf->h)) {
+        SDL_FillRect (destsurf, NULL, color_diff_color);
+    }
+    if (mask && !job.fast) {
+        memset (mask->bits, 0, mask->h * ((mask->w - 1) / BITMASK_W_LEN + 1) *
+                sizeof (BITMASK_W));
+    }
+
+    if (surf->w > 0) {
+        nbands = pg_run_bands (threshold_band, &job, surf->h,
+                               THRESHOLD_MIN_BAND_PIXELS / surf->w);
+        for (i = 0; i < nbands; ++i) {
+            num_threshold_pixels += job.similar[i];
+        }
+    }
 
     Py_END_ALLOW_THREADS;
 
-    PySurface_Unlock(surfobj);
+    if (destobj) {
+        PySurface_Unlock(destobj);
+    }
     PySurface_Unlock(surfobj2);
     if(surfobj3) {
         PySurface_Unlock(surfobj3);
@@ -2248,6 +2538,186 @@ surf_laplacian (PyObject* self, PyObject* arg)
         return PySurface_New (newsurf);
 }
 
+/* Checks the source of a blur and returns the surface to write to,
+   a new one like surf when surfobj2 is NULL. */
+static SDL_Surface*
+blur_dest_surface (SDL_Surface *surf, PyObject *surfobj2)
+{
+    SDL_Surface *newsurf;
+
+    if (surf->format->BytesPerPixel != 3 && surf->format->BytesPerPixel != 4)
+        return (SDL_Surface*) (RAISE (PyExc_ValueError,
+                               "Only 24 and 32 bit surfaces can be blurred."));
+
+    if (!surfobj2)
+        return newsurf_fromsurf (surf, surf->w, surf->h);
+
+    newsurf = PySurface_AsSurface (surfobj2);
+    if (newsurf->w != surf->w || newsurf->h != surf->h)
+        return (SDL_Surface*) (RAISE (PyExc_ValueError,
+                               "Destination surface not the same size."));
+    if (surf->format->BytesPerPixel != newsurf->format->BytesPerPixel)
+        return (SDL_Surface*) (RAISE (PyExc_ValueError,
+                   "Source and destination surfaces need the same format."));
+    return newsurf;
+}
+
+/* Runs one of the blur functions and wraps up the destination surface.
+   kind is 0 for a box blur, 1 for a gaussian, 2 for convolve. */
+static PyObject*
+blur_run_surfaces (PyObject *surfobj, PyObject *surfobj2, int kind,
+                   double radius, const float *kx, int nx,
+                   const float *ky, int ny)
+{
+    SDL_Surface *surf = PySurface_AsSurface (surfobj);
+    SDL_Surface *newsurf;
+    int result;
+
+    newsurf = blur_dest_surface (surf, surfobj2);
+    if (!newsurf)
+        return NULL;
+
+    if (surfobj2)
+        PySurface_Prep (surfobj2);
+    PySurface_Prep (surfobj);
+    SDL_LockSurface (newsurf);
+    SDL_LockSurface (surf);
+
+    Py_BEGIN_ALLOW_THREADS;
+    if (kind == 0)
+        result = blur_box (surf, newsurf, (int) radius);
+    else if (kind == 1)
+        result = blur_gaussian (surf, newsurf, radius);
+    else
+        result = blur_convolve (surf, newsurf, kx, nx, ky, ny);
+    Py_END_ALLOW_THREADS;
+
+    SDL_UnlockSurface (surf);
+    SDL_UnlockSurface (newsurf);
+    PySurface_Unprep (surfobj);
+    if (surfobj2)
+        PySurface_Unprep (surfobj2);
+
+    if (result) {
+        if (!surfobj2)
+            SDL_FreeSurface (newsurf);
+        return PyErr_NoMemory ();
+    }
+    if (surfobj2)
+    {
+        Py_INCREF (surfobj2);
+        return surfobj2;
+    }
+    else
+        return PySurface_New (newsurf);
+}
+
+static PyObject*
+surf_box_blur (PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *surfobj2 = NULL;
+    int radius;
+
+    if (!PyArg_ParseTuple (arg, "O!i|O!", &PySurface_Type, &surfobj,
+                           &radius, &PySurface_Type, &surfobj2))
+        return NULL;
+    if (radius < 0)
+        return RAISE (PyExc_ValueError, "radius cannot be negative");
+
+    return blur_run_surfaces (surfobj, surfobj2, 0, radius, NULL, 0, NULL, 0);
+}
+
+static PyObject*
+surf_gaussian_blur (PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *surfobj2 = NULL;
+    double radius;
+
+    if (!PyArg_ParseTuple (arg, "O!d|O!", &PySurface_Type, &surfobj,
+                           &radius, &PySurface_Type, &surfobj2))
+        return NULL;
+    if (radius < 0.0)
+        return RAISE (PyExc_ValueError, "radius cannot be negative");
+
+    return blur_run_surfaces (surfobj, surfobj2, 1, radius, NULL, 0, NULL, 0);
+}
+
+/* Copies a sequence of numbers into a new float array.  Returns NULL
+   with an exception set on error. */
+static float*
+blur_kernel_from_sequence (PyObject *seq, int *length)
+{
+    PyObject *item;
+    float *kernel;
+    double value;
+    Py_ssize_t i, n;
+
+    if (!PySequence_Check (seq))
+        return (float*) (RAISE (PyExc_TypeError,
+                                "kernel must be a sequence of numbers"));
+    n = PySequence_Length (seq);
+    if (n < 0)
+        return NULL;
+    if (n % 2 == 0)
+        return (float*) (RAISE (PyExc_ValueError,
+                                "kernel must have an odd length"));
+
+    kernel = (float*) PyMem_Malloc (sizeof (float) * n);
+    if (!kernel)
+        return (float*) PyErr_NoMemory ();
+    for (i = 0; i < n; ++i) {
+        item = PySequence_GetItem (seq, i);
+        if (!item) {
+            PyMem_Free (kernel);
+            return NULL;
+        }
+        value = PyFloat_AsDouble (item);
+        Py_DECREF (item);
+        if (value == -1.0 && PyErr_Occurred ()) {
+            PyMem_Free (kernel);
+            return NULL;
+        }
+        kernel[i] = (float) value;
+    }
+    *length = (int) n;
+    return kernel;
+}
+
+static PyObject*
+surf_convolve (PyObject* self, PyObject* arg)
+{
+    PyObject *surfobj, *kxobj, *kyobj = Py_None, *surfobj2 = NULL;
+    PyObject *result;
+    float *kx, *ky;
+    int nx, ny;
+
+    if (!PyArg_ParseTuple (arg, "O!O|OO!", &PySurface_Type, &surfobj,
+                           &kxobj, &kyobj, &PySurface_Type, &surfobj2))
+        return NULL;
+
+    kx = blur_kernel_from_sequence (kxobj, &nx);
+    if (!kx)
+        return NULL;
+    if (kyobj == Py_None) {
+        ky = kx;
+        ny = nx;
+    }
+    else {
+        ky = blur_kernel_from_sequence (kyobj, &ny);
+        if (!ky) {
+            PyMem_Free (kx);
+            return NULL;
+        }
+    }
+
+    result = blur_run_surfaces (surfobj, surfobj2, 2, 0.0, kx, nx, ky, ny);
+
+    if (ky != kx)
+        PyMem_Free (ky);
+    PyMem_Free (kx);
+    return result;
+}
+
 
 
 
@@ -2623,6 +3093,59 @@ surf_average_surfaces (PyObject* self, PyObject* arg)
     return ret;
 }
 
+/* Sums each of the four bytes of the 32 bit pixels in a clipped area. */
+static void
+average_color_32 (SDL_Surface *surf, int x, int y, int width, int height,
+                  Uint64 totals[4])
+{
+    Uint8 *pixels;
+    int row, col, i;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i p, acc16, acc32;
+    Uint32 lanes[4];
+#endif
+
+    totals[0] = totals[1] = totals[2] = totals[3] = 0;
+    for (row = y; row < y + height; row++) {
+        pixels = (Uint8 *) surf->pixels + row * surf->pitch + x * 4;
+        col = 0;
+#if defined(PG_TRANSFORM_SSE2)
+        acc32 = zero;
+        while (col + 4 <= width) {
+            /* Each 16 bit lane takes two bytes per step, so flush to 32
+               bits every 128 steps before it can overflow. */
+            acc16 = zero;
+            for (i = 0; i < 128 && col + 4 <= width; ++i, col += 4) {
+                p = _mm_loadu_si128 ((const __m128i *) (pixels + col * 4));
+                acc16 = _mm_add_epi16 (acc16, _mm_unpacklo_epi8 (p, zero));
+                acc16 = _mm_add_epi16 (acc16, _mm_unpackhi_epi8 (p, zero));
+            }
+            acc32 = _mm_add_epi32 (acc32, _mm_unpacklo_epi16 (acc16, zero));
+            acc32 = _mm_add_epi32 (acc32, _mm_unpackhi_epi16 (acc16, zero));
+        }
+        _mm_storeu_si128 ((__m128i *) lanes, acc32);
+        for (i = 0; i < 4; ++i) {
+            totals[i] += lanes[i];
+        }
+#endif
+        for (; col < width; ++col) {
+            for (i = 0; i < 4; ++i) {
+                totals[i] += pixels[col * 4 + i];
+            }
+        }
+    }
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    /* totals are by byte in memory, callers index them by shift */
+    {
+        Uint64 t;
+
+        t = totals[0]; totals[0] = totals[3]; totals[3] = t;
+        t = totals[1]; totals[1] = totals[2]; totals[2] = t;
+    }
+#endif
+}
+
 /* VS 2015 crashes when compiling this function, turning off optimisations to
  try to fix it */
 #if defined(_MSC_VER) && (_MSC_VER == 1900)
@@ -2635,6 +3158,7 @@ void average_color(SDL_Surface* surf, int x, int y, int width, int height, Uint8
     unsigned int rtot, gtot, btot, atot, size, rshift, gshift, bshift, ashift;
     unsigned int rloss, gloss, bloss, aloss;
     int row, col, width_and_x, height_and_y;
+    Uint64 totals[4];
 
     SDL_PixelFormat *format;
 
@@ -2719,6 +3243,15 @@ void average_color(SDL_Surface* surf, int x, int y, int width, int height, Uint8
             }
             break;
         default:                  /* case 4: */
+            if (threshold_format_32 (format) &&
+                (amask == 0 || amask == (Uint32) 0xff << ashift)) {
+                average_color_32 (surf, x, y, width, height, totals);
+                rtot = (unsigned int) totals[rshift >> 3];
+                gtot = (unsigned int) totals[gshift >> 3];
+                btot = (unsigned int) totals[bshift >> 3];
+                atot = amask ? (unsigned int) totals[ashift >> 3] : 0;
+                break;
+            }
             for (row = y; row < height_and_y; row++) {
                 pixels = (Uint8 *) surf->pixels + row*surf->pitch + x*4;
                 for (col = x; col < width_and_x; col++) {
@@ -2779,6 +3312,559 @@ static PyObject* surf_average_color(PyObject* self, PyObject* arg)
     return Py_BuildValue ("(bbbb)", r, g, b, a);
 }
 
+/* A running average over a stream of same sized frames.
+
+   Frames are kept as 32 bit pixels with 8 bit channels, laid out like the
+   first frame added when that is possible.  In window mode each byte of the
+   last `window` frames is summed into a 16 bit accumulator, so adding a
+   frame only adds the new pixels and subtracts the ones dropping out of the
+   ring.  In exponential mode the accumulators hold an 8.8 fixed point mean.
+*/
+
+/* 255 * 256 still fits a 16 bit accumulator */
+#define RUNNING_MAX_WINDOW 256
+
+typedef struct {
+    PyObject_HEAD
+    int w, h;
+    int window;         /* ring size, 0 in exponential mode */
+    int weight;         /* weight of a new frame out of 256, exponential */
+    int count;          /* frames currently in the average */
+    int oldest;         /* ring slot of the oldest frame */
+    int has_layout;
+    Uint32 rmask, gmask, bmask, amask;
+    int rshift, gshift, bshift, ashift;
+    Uint16 *accum;      /* w * h * 4 sums, or 8.8 means */
+    Uint8 *frames;      /* window * w * h * 4 bytes of past frames */
+    Uint8 *rowbuf;      /* w * 4 bytes for converting other formats */
+} PyRunningAverageObject;
+
+/* The methods change accum, frames and rowbuf in place, so they keep the
+   GIL: Python threads sharing an average then can not interleave. */
+
+static PyTypeObject PyRunningAverage_Type;
+
+static void
+running_add_row (Uint16 *acc, Uint8 *slot, const Uint8 *src, int n,
+                 int full)
+{
+    int i = 0;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i s, o, a0, a1;
+
+    for (; i + 16 <= n; i += 16) {
+        s = _mm_loadu_si128 ((const __m128i *) (src + i));
+        a0 = _mm_loadu_si128 ((const __m128i *) (acc + i));
+        a1 = _mm_loadu_si128 ((const __m128i *) (acc + i + 8));
+        a0 = _mm_add_epi16 (a0, _mm_unpacklo_epi8 (s, zero));
+        a1 = _mm_add_epi16 (a1, _mm_unpackhi_epi8 (s, zero));
+        if (full) {
+            o = _mm_loadu_si128 ((const __m128i *) (slot + i));
+            a0 = _mm_sub_epi16 (a0, _mm_unpacklo_epi8 (o, zero));
+            a1 = _mm_sub_epi16 (a1, _mm_unpackhi_epi8 (o, zero));
+        }
+        _mm_storeu_si128 ((__m128i *) (acc + i), a0);
+        _mm_storeu_si128 ((__m128i *) (acc + i + 8), a1);
+        _mm_storeu_si128 ((__m128i *) (slot + i), s);
+    }
+#endif
+    for (; i < n; ++i) {
+        acc[i] = (Uint16) (acc[i] + src[i] - (full ? slot[i] : 0));
+        slot[i] = src[i];
+    }
+}
+
+static void
+running_remove_row (Uint16 *acc, const Uint8 *slot, int n)
+{
+    int i = 0;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i o, a0, a1;
+
+    for (; i + 16 <= n; i += 16) {
+        o = _mm_loadu_si128 ((const __m128i *) (slot + i));
+        a0 = _mm_loadu_si128 ((const __m128i *) (acc + i));
+        a1 = _mm_loadu_si128 ((const __m128i *) (acc + i + 8));
+        a0 = _mm_sub_epi16 (a0, _mm_unpacklo_epi8 (o, zero));
+        a1 = _mm_sub_epi16 (a1, _mm_unpackhi_epi8 (o, zero));
+        _mm_storeu_si128 ((__m128i *) (acc + i), a0);
+        _mm_storeu_si128 ((__m128i *) (acc + i + 8), a1);
+    }
+#endif
+    for (; i < n; ++i) {
+        acc[i] = (Uint16) (acc[i] - slot[i]);
+    }
+}
+
+/* mean = mean * (256 - weight) / 256 + pixel * weight, in 8.8 fixed point.
+   The two terms add up to at most 255 << 8, so nothing overflows. */
+static void
+running_blend_row (Uint16 *acc, const Uint8 *src, int n, int weight,
+                   int first)
+{
+    int i = 0;
+    Uint32 keep = (Uint32) (256 - weight) << 8;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i vkeep = _mm_set1_epi16 ((short) keep);
+    const __m128i vweight = _mm_set1_epi16 ((short) weight);
+    __m128i s, a0, a1;
+
+    for (; i + 16 <= n; i += 16) {
+        s = _mm_loadu_si128 ((const __m128i *) (src + i));
+        if (first) {
+            a0 = _mm_slli_epi16 (_mm_unpacklo_epi8 (s, zero), 8);
+            a1 = _mm_slli_epi16 (_mm_unpackhi_epi8 (s, zero), 8);
+        }
+        else {
+            a0 = _mm_loadu_si128 ((const __m128i *) (acc + i));
+            a1 = _mm_loadu_si128 ((const __m128i *) (acc + i + 8));
+            a0 = _mm_add_epi16 (_mm_mulhi_epu16 (a0, vkeep),
+                                _mm_mullo_epi16 (_mm_unpacklo_epi8 (s, zero),
+                                                 vweight));
+            a1 = _mm_add_epi16 (_mm_mulhi_epu16 (a1, vkeep),
+                                _mm_mullo_epi16 (_mm_unpackhi_epi8 (s, zero),
+                                                 vweight));
+        }
+        _mm_storeu_si128 ((__m128i *) (acc + i), a0);
+        _mm_storeu_si128 ((__m128i *) (acc + i + 8), a1);
+    }
+#endif
+    for (; i < n; ++i) {
+        if (first) {
+            acc[i] = (Uint16) (src[i] << 8);
+        }
+        else {
+            acc[i] = (Uint16) (((acc[i] * keep) >> 16) + src[i] * weight);
+        }
+    }
+}
+
+#if defined(PG_TRANSFORM_SSE2)
+static __m128i
+running_divide (__m128i v, __m128 recip, __m128 bias)
+{
+    return _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (_mm_cvtepi32_ps (v),
+                                                     recip), bias));
+}
+#endif
+
+static void
+running_output_row (const Uint16 *acc, Uint8 *dst, int n, int count,
+                    int exponential)
+{
+    int i = 0;
+#if defined(PG_TRANSFORM_SSE2)
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i half = _mm_set1_epi16 (exponential ? 128 : count / 2);
+    /* The small bias keeps exact quotients from rounding down, it is
+       well under the 1 / count gap to the next quotient. */
+    const __m128 recip = _mm_set1_ps (1.0f / count);
+    const __m128 bias = _mm_set1_ps (0.001f);
+    __m128i a0, a1, q0, q1;
+#endif
+
+    if (exponential) {
+#if defined(PG_TRANSFORM_SSE2)
+        for (; i + 16 <= n; i += 16) {
+            a0 = _mm_loadu_si128 ((const __m128i *) (acc + i));
+            a1 = _mm_loadu_si128 ((const __m128i *) (acc + i + 8));
+            a0 = _mm_srli_epi16 (_mm_add_epi16 (a0, half), 8);
+            a1 = _mm_srli_epi16 (_mm_add_epi16 (a1, half), 8);
+            _mm_storeu_si128 ((__m128i *) (dst + i), _mm_packus_epi16 (a0, a1));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = (Uint8) ((acc[i] + 128) >> 8);
+        }
+        return;
+    }
+
+#if defined(PG_TRANSFORM_SSE2)
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *) (acc + i)),
+                            half);
+        a1 = _mm_add_epi16 (_mm_loadu_si128 ((const __m128i *) (acc + i + 8)),
+                            half);
+        q0 = _mm_packs_epi32 (running_divide (_mm_unpacklo_epi16 (a0, zero),
+                                              recip, bias),
+                              running_divide (_mm_unpackhi_epi16 (a0, zero),
+                                              recip, bias));
+        q1 = _mm_packs_epi32 (running_divide (_mm_unpacklo_epi16 (a1, zero),
+                                              recip, bias),
+                              running_divide (_mm_unpackhi_epi16 (a1, zero),
+                                              recip, bias));
+        _mm_storeu_si128 ((__m128i *) (dst + i), _mm_packus_epi16 (q0, q1));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = (Uint8) ((acc[i] + count / 2) / count);
+    }
+}
+
+static int
+running_check_surface (PyRunningAverageObject *self, SDL_Surface *surf)
+{
+    SDL_PixelFormat *format = surf->format;
+
+    if (surf->w != self->w || surf->h != self->h) {
+        PyErr_SetString (PyExc_ValueError,
+                         "Surface is not the RunningAverage size");
+        return 0;
+    }
+    if (self->has_layout) {
+        return 1;
+    }
+
+    /* Keep the frames in the layout of the first one when it has 8 bit
+       channels, so such frames can be used without conversion. */
+    if (threshold_format_32 (format) &&
+        (format->Amask == 0 || format->Amask == (Uint32) 0xff << format->Ashift)) {
+        self->rmask = format->Rmask;
+        self->gmask = format->Gmask;
+        self->bmask = format->Bmask;
+        self->amask = format->Amask;
+        self->rshift = format->Rshift;
+        self->gshift = format->Gshift;
+        self->bshift = format->Bshift;
+        self->ashift = 0;
+        while (((self->rmask | self->gmask | self->bmask) >> self->ashift) &
+               0xff) {
+            self->ashift += 8;
+        }
+    }
+    else {
+        self->rmask = 0xff0000;
+        self->gmask = 0xff00;
+        self->bmask = 0xff;
+        self->amask = format->Amask ? 0xff000000 : 0;
+        self->rshift = 16;
+        self->gshift = 8;
+        self->bshift = 0;
+        self->ashift = 24;
+    }
+    self->has_layout = 1;
+    return 1;
+}
+
+/* Returns row y of surf in the stored layout, converting if needed. */
+static const Uint8*
+running_get_row (PyRunningAverageObject *self, SDL_Surface *surf, int y)
+{
+    SDL_PixelFormat *format = surf->format;
+    Uint8 *pixels = (Uint8 *) surf->pixels;
+    Uint32 *row = (Uint32 *) self->rowbuf;
+    Uint32 the_color;
+    Uint8 *pix;
+    Uint8 r, g, b, a;
+    int x;
+
+    if (format->BytesPerPixel == 4 && format->Rmask == self->rmask &&
+        format->Gmask == self->gmask && format->Bmask == self->bmask) {
+        return pixels + y * surf->pitch;
+    }
+    for (x = 0; x < surf->w; ++x) {
+        SURF_GET_AT (the_color, surf, x, y, pixels, format, pix);
+        SDL_GetRGBA (the_color, format, &r, &g, &b, &a);
+        row[x] = (((Uint32) r << self->rshift) | ((Uint32) g << self->gshift) |
+                  ((Uint32) b << self->bshift) | ((Uint32) a << self->ashift));
+    }
+    return self->rowbuf;
+}
+
+static void
+running_add (PyRunningAverageObject *self, SDL_Surface *surf)
+{
+    int n = self->w * 4;
+    size_t framesize = (size_t) n * self->h;
+    int full, slot, y;
+    Uint8 *frame;
+
+    if (!self->window) {
+        for (y = 0; y < self->h; ++y) {
+            running_blend_row (self->accum + (size_t) y * n,
+                               running_get_row (self, surf, y), n,
+                               self->weight, self->count == 0);
+        }
+        ++self->count;
+        return;
+    }
+
+    full = self->count == self->window;
+    slot = full ? self->oldest : (self->oldest + self->count) % self->window;
+    frame = self->frames + slot * framesize;
+    for (y = 0; y < self->h; ++y) {
+        running_add_row (self->accum + (size_t) y * n, frame + (size_t) y * n,
+                         running_get_row (self, surf, y), n, full);
+    }
+    if (full) {
+        self->oldest = (self->oldest + 1) % self->window;
+    }
+    else {
+        ++self->count;
+    }
+}
+
+static PyObject*
+running_average_add (PyObject *self, PyObject *arg)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+    PyObject *surfobj;
+    SDL_Surface *surf;
+
+    if (!PyArg_ParseTuple (arg, "O!", &PySurface_Type, &surfobj))
+        return NULL;
+    surf = PySurface_AsSurface (surfobj);
+    if (!running_check_surface (ra, surf))
+        return NULL;
+
+    PySurface_Lock (surfobj);
+    running_add (ra, surf);
+    PySurface_Unlock (surfobj);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+running_average_remove (PyObject *self)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+    int n = ra->w * 4;
+    size_t framesize = (size_t) n * ra->h;
+    Uint8 *frame;
+    int y;
+
+    if (!ra->window)
+        return RAISE (PyExc_ValueError,
+                      "exponential averages can not remove frames");
+    if (!ra->count)
+        return RAISE (PyExc_ValueError, "no frames to remove");
+
+    frame = ra->frames + ra->oldest * framesize;
+    for (y = 0; y < ra->h; ++y) {
+        running_remove_row (ra->accum + (size_t) y * n,
+                            frame + (size_t) y * n, n);
+    }
+    ra->oldest = (ra->oldest + 1) % ra->window;
+    --ra->count;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+running_average_clear (PyObject *self)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+
+    /* Window sums are rebuilt from zero, exponential means from the next
+       frame added. */
+    memset (ra->accum, 0, sizeof (Uint16) * 4 * ra->w * ra->h);
+    ra->count = 0;
+    ra->oldest = 0;
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+running_average_get_count (PyObject *self)
+{
+    return PyInt_FromLong (((PyRunningAverageObject *) self)->count);
+}
+
+static PyObject*
+running_average_get_size (PyObject *self)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+
+    return Py_BuildValue ("(ii)", ra->w, ra->h);
+}
+
+static PyObject*
+running_average_get_surface (PyObject *self, PyObject *arg)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+    PyObject *surfobj = NULL;
+    SDL_Surface *newsurf;
+    SDL_PixelFormat *format;
+    Uint8 *pixels, *byte_buf;
+    Uint32 the_color, *row;
+    int n = ra->w * 4;
+    int direct, x, y;
+
+    if (!PyArg_ParseTuple (arg, "|O!", &PySurface_Type, &surfobj))
+        return NULL;
+    if (!ra->count)
+        return RAISE (PyExc_ValueError, "no frames have been added");
+
+    if (surfobj) {
+        newsurf = PySurface_AsSurface (surfobj);
+        if (newsurf->w != ra->w || newsurf->h != ra->h)
+            return RAISE (PyExc_ValueError,
+                          "Destination surface not the same size.");
+    }
+    else {
+        newsurf = SDL_CreateRGBSurface (ra->amask ? SDL_SRCALPHA : 0,
+                                        ra->w, ra->h, 32, ra->rmask,
+                                        ra->gmask, ra->bmask, ra->amask);
+        if (!newsurf)
+            return RAISE (PyExc_SDLError, SDL_GetError ());
+    }
+
+    format = newsurf->format;
+    direct = (format->BytesPerPixel == 4 && format->Rmask == ra->rmask &&
+              format->Gmask == ra->gmask && format->Bmask == ra->bmask);
+    if (surfobj) {
+        PySurface_Lock (surfobj);
+    }
+    else {
+        SDL_LockSurface (newsurf);
+    }
+    pixels = (Uint8 *) newsurf->pixels;
+    for (y = 0; y < ra->h; ++y) {
+        if (direct) {
+            running_output_row (ra->accum + (size_t) y * n,
+                                pixels + y * newsurf->pitch, n, ra->count,
+                                !ra->window);
+            continue;
+        }
+        running_output_row (ra->accum + (size_t) y * n, ra->rowbuf, n,
+                            ra->count, !ra->window);
+        row = (Uint32 *) ra->rowbuf;
+        for (x = 0; x < ra->w; ++x) {
+            the_color = SDL_MapRGBA (format,
+                                     (Uint8) (row[x] >> ra->rshift),
+                                     (Uint8) (row[x] >> ra->gshift),
+                                     (Uint8) (row[x] >> ra->bshift),
+                                     (Uint8) (row[x] >> ra->ashift));
+            SURF_SET_AT (the_color, newsurf, x, y, pixels, format, byte_buf);
+        }
+    }
+    if (surfobj) {
+        PySurface_Unlock (surfobj);
+        Py_INCREF (surfobj);
+        return surfobj;
+    }
+    SDL_UnlockSurface (newsurf);
+    return PySurface_New (newsurf);
+}
+
+static PyMethodDef running_average_methods[] =
+{
+    { "add", running_average_add, METH_VARARGS,
+      DOC_RUNNINGAVERAGEADD },
+    { "remove", (PyCFunction) running_average_remove, METH_NOARGS,
+      DOC_RUNNINGAVERAGEREMOVE },
+    { "clear", (PyCFunction) running_average_clear, METH_NOARGS,
+      DOC_RUNNINGAVERAGECLEAR },
+    { "get_count", (PyCFunction) running_average_get_count, METH_NOARGS,
+      DOC_RUNNINGAVERAGEGETCOUNT },
+    { "get_size", (PyCFunction) running_average_get_size, METH_NOARGS,
+      DOC_RUNNINGAVERAGEGETSIZE },
+    { "get_surface", running_average_get_surface, METH_VARARGS,
+      DOC_RUNNINGAVERAGEGETSURFACE },
+    { NULL, NULL, 0, NULL }
+};
+
+static void
+running_average_dealloc (PyObject *self)
+{
+    PyRunningAverageObject *ra = (PyRunningAverageObject *) self;
+
+    free (ra->accum);
+    free (ra->frames);
+    free (ra->rowbuf);
+    PyObject_DEL (self);
+}
+
+static PyTypeObject PyRunningAverage_Type =
+{
+    TYPE_HEAD (NULL, 0)
+    "pygame.transform.RunningAverage",
+    sizeof (PyRunningAverageObject),
+    0,
+    running_average_dealloc,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    NULL,
+    0,
+    (hashfunc)NULL,
+    (ternaryfunc)NULL,
+    (reprfunc)NULL,
+    0L,0L,0L,0L,
+    DOC_PYGAMETRANSFORMRUNNINGAVERAGE,  /* Documentation string */
+    0,                                  /* tp_traverse */
+    0,                                  /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    0,                                  /* tp_iter */
+    0,                                  /* tp_iternext */
+    running_average_methods,            /* tp_methods */
+    0,                                  /* tp_members */
+    0,                                  /* tp_getset */
+    0,                                  /* tp_base */
+    0,                                  /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    0,                                  /* tp_init */
+    0,                                  /* tp_alloc */
+    0,                                  /* tp_new */
+};
+
+static PyObject*
+RunningAverage (PyObject *self, PyObject *arg, PyObject *kwds)
+{
+    PyRunningAverageObject *ra;
+    int w, h, window = 8;
+    double weight = 0.0;
+    static char *kwids[] = { "size", "window", "weight", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords (arg, kwds, "(ii)|id", kwids,
+                                      &w, &h, &window, &weight))
+        return NULL;
+    if (w < 0 || h < 0)
+        return RAISE (PyExc_ValueError, "Cannot average negative size");
+    if (weight < 0.0 || weight > 1.0)
+        return RAISE (PyExc_ValueError, "weight must be from 0.0 to 1.0");
+    if (weight == 0.0 && (window < 1 || window > RUNNING_MAX_WINDOW))
+        return RAISE (PyExc_ValueError, "window must be from 1 to 256");
+
+    ra = PyObject_NEW (PyRunningAverageObject, &PyRunningAverage_Type);
+    if (!ra)
+        return NULL;
+    ra->w = w;
+    ra->h = h;
+    ra->count = 0;
+    ra->oldest = 0;
+    ra->has_layout = 0;
+    if (weight > 0.0) {
+        ra->window = 0;
+        ra->weight = (int) (weight * 256.0 + 0.5);
+        if (ra->weight < 1)
+            ra->weight = 1;
+    }
+    else {
+        ra->window = window;
+        ra->weight = 0;
+    }
+    ra->accum = (Uint16 *) calloc ((size_t) w * h * 4 + 1, sizeof (Uint16));
+    ra->rowbuf = (Uint8 *) malloc ((size_t) w * 4 + 1);
+    ra->frames = NULL;
+    if (ra->window) {
+        ra->frames = (Uint8 *) malloc ((size_t) ra->window * w * h * 4 + 1);
+    }
+    if (!ra->accum || !ra->rowbuf || (ra->window && !ra->frames)) {
+        Py_DECREF (ra);
+        return PyErr_NoMemory ();
+    }
+    return (PyObject *) ra;
+}
+
 static PyMethodDef _transform_methods[] =
 {
     { "scale", surf_scale, METH_VARARGS, DOC_PYGAMETRANSFORMSCALE },
@@ -2787,6 +3873,9 @@ static PyMethodDef _transform_methods[] =
     { "rotozoom", surf_rotozoom, METH_VARARGS, DOC_PYGAMETRANSFORMROTOZOOM},
     { "chop", surf_chop, METH_VARARGS, DOC_PYGAMETRANSFORMCHOP },
     { "scale2x", surf_scale2x, METH_VARARGS, DOC_PYGAMETRANSFORMSCALE2X },
+    { "scale3x", surf_scale3x, METH_VARARGS, DOC_PYGAMETRANSFORMSCALE3X },
+    { "scale4x", surf_scale4x, METH_VARARGS, DOC_PYGAMETRANSFORMSCALE4X },
+    { "xbr2x", surf_xbr2x, METH_VARARGS, DOC_PYGAMETRANSFORMXBR2X },
     { "smoothscale", surf_scalesmooth, METH_VARARGS, DOC_PYGAMETRANSFORMSMOOTHSCALE },
     { "get_smoothscale_backend", (PyCFunction) surf_get_smoothscale_backend, METH_NOARGS,
           DOC_PYGAMETRANSFORMGETSMOOTHSCALEBACKEND },
@@ -2795,8 +3884,13 @@ static PyMethodDef _transform_methods[] =
           DOC_PYGAMETRANSFORMSETSMOOTHSCALEBACKEND },
     { "threshold", surf_threshold, METH_VARARGS, DOC_PYGAMETRANSFORMTHRESHOLD },
     { "laplacian", surf_laplacian, METH_VARARGS, DOC_PYGAMETRANSFORMTHRESHOLD },
+    { "box_blur", surf_box_blur, METH_VARARGS, DOC_PYGAMETRANSFORMBOXBLUR },
+    { "gaussian_blur", surf_gaussian_blur, METH_VARARGS, DOC_PYGAMETRANSFORMGAUSSIANBLUR },
+    { "convolve", surf_convolve, METH_VARARGS, DOC_PYGAMETRANSFORMCONVOLVE },
     { "average_surfaces", surf_average_surfaces, METH_VARARGS, DOC_PYGAMETRANSFORMAVERAGESURFACES },
     { "average_color", surf_average_color, METH_VARARGS, DOC_PYGAMETRANSFORMAVERAGECOLOR },
+    { "RunningAverage", (PyCFunction) RunningAverage,
+          METH_VARARGS | METH_KEYWORDS, DOC_PYGAMETRANSFORMRUNNINGAVERAGE },
 
     { NULL, NULL, 0, NULL }
 };
@@ -2837,6 +3931,15 @@ MODINIT_DEFINE (transform)
     if (PyErr_Occurred ()) {
         MODINIT_ERROR;
     }
+    import_pygame_mask ();
+    if (PyErr_Occurred ()) {
+        MODINIT_ERROR;
+    }
+
+    /* create the running average type */
+    if (PyType_Ready (&PyRunningAverage_Type) < 0) {
+        MODINIT_ERROR;
+    }
 
     /* create the module */
 #if PY3
@@ -2850,6 +3953,12 @@ MODINIT_DEFINE (transform)
     if (module == 0) {
         MODINIT_ERROR;
     }
+    if (PyModule_AddObject (module, "RunningAverageType",
+                            (PyObject *) &PyRunningAverage_Type) == -1) {
+        DECREF_MOD (module);
+        MODINIT_ERROR;
+    }
+    Py_INCREF ((PyObject *) &PyRunningAverage_Type);
 
     st = GETSTATE (module);
     if (st->filter_type == 0) {
@@ -111,7 +111,8 @@ def createPygameMods():
         "transform" : (
             "transform.c",
             "rotozoom.c",
-            "scale2x.c"
+            "scale2x.c",
+            "blur.c"
         )
     }
 
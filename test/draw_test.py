@@ -22,6 +22,50 @@ from pygame import draw
 
 ################################################################################
 
+def blend_reference(flag, color, pixel, has_alpha):
+    """The pixel a special_flags blend of color gives, per the BLEND_*
+    macros of surface.h.  Pixels without alpha read and come back as 255.
+    """
+    sR, sG, sB, sA = color
+    d = list(pixel[:3])
+    if has_alpha:
+        dA = pixel[3]
+    else:
+        dA = 255
+    s = (sR, sG, sB)
+    if flag in (pygame.BLEND_ADD, pygame.BLEND_RGBA_ADD):
+        d = [min(dc + sc, 255) for dc, sc in zip(d, s)]
+        if flag == pygame.BLEND_RGBA_ADD:
+            dA = min(dA + sA, 255)
+    elif flag in (pygame.BLEND_SUB, pygame.BLEND_RGBA_SUB):
+        d = [max(dc - sc, 0) for dc, sc in zip(d, s)]
+        if flag == pygame.BLEND_RGBA_SUB:
+            dA = max(dA - sA, 0)
+    elif flag in (pygame.BLEND_MULT, pygame.BLEND_RGBA_MULT):
+        d = [(dc * sc) >> 8 for dc, sc in zip(d, s)]
+        if flag == pygame.BLEND_RGBA_MULT:
+            dA = (dA * sA) >> 8
+    elif flag in (pygame.BLEND_MIN, pygame.BLEND_RGBA_MIN):
+        d = [min(dc, sc) for dc, sc in zip(d, s)]
+        if flag == pygame.BLEND_RGBA_MIN:
+            dA = min(dA, sA)
+    elif flag in (pygame.BLEND_MAX, pygame.BLEND_RGBA_MAX):
+        d = [max(dc, sc) for dc, sc in zip(d, s)]
+        if flag == pygame.BLEND_RGBA_MAX:
+            dA = max(dA, sA)
+    elif flag == pygame.BLEND_PREMULTIPLIED:
+        d = [min(sc + dc - ((dc * sA) >> 8), 255) for dc, sc in zip(d, s)]
+        dA = sA + dA - (sA * dA) // 255
+    elif dA:
+        d = [((dc << 8) + (sc - dc) * sA + sc) >> 8 for dc, sc in zip(d, s)]
+        dA = sA + dA - (sA * dA) // 255
+    else:
+        d = list(s)
+        dA = sA
+    if not has_alpha:
+        dA = 255
+    return tuple(d) + (dA,)
+
 class DrawModuleTest(unittest.TestCase):
     def setUp(self):
         (self.surf_w, self.surf_h) = self.surf_size = (320, 200)
@@ -212,6 +256,37 @@ class DrawModuleTest(unittest.TestCase):
 
         self.fail() 
 
+    def test_line__clipped_width(self):
+        # a wide line keeps its pixels where they are when it is clipped
+        clipped = pygame.Surface((100, 100))
+        clip = pygame.Rect(30, 20, 40, 50)
+        clipped.set_clip(clip)
+        whole = pygame.Surface((100, 100))
+        for start, end in [((-50, 5), (150, 90)), ((10, -40), (80, 140))]:
+            clipped.fill((0, 0, 0))
+            whole.fill((0, 0, 0))
+            draw.line(clipped, (255, 255, 255), start, end, 5)
+            draw.line(whole, (255, 255, 255), start, end, 5)
+            for x in range(100):
+                for y in range(100):
+                    if clip.collidepoint(x, y):
+                        expected = whole.get_at((x, y))
+                    else:
+                        expected = (0, 0, 0, 255)
+                    self.assertEqual(clipped.get_at((x, y)), expected)
+
+    def test_circle__width(self):
+        # a wide outline is solid, with no gaps between its rings
+        self.surf.fill((0, 0, 0, 0))
+        draw.circle(self.surf, self.color, (50, 50), 40, 10)
+        for x in range(100):
+            for y in range(100):
+                dist = ((x - 49.5) ** 2 + (y - 49.5) ** 2) ** 0.5
+                if 31.5 < dist < 38.5:
+                    self.assertEqual(self.surf.get_at((x, y)), self.color)
+                elif dist < 29 or dist > 41:
+                    self.assertNotEqual(self.surf.get_at((x, y)), self.color)
+
     def todo_test_circle(self):
 
         # __doc__ (as of 2008-08-02) for pygame.draw.circle:
@@ -276,6 +351,368 @@ class DrawModuleTest(unittest.TestCase):
 
         self.fail() 
 
+    def test_polygon__fill(self):
+        # a triangle with a concave notch, filled in scanlines.
+        points = [(10, 10), (60, 10), (60, 50), (35, 20), (10, 50)]
+        drawn = draw.polygon(self.surf, self.color, points)
+        self.assertEqual(drawn, pygame.Rect(10, 10, 51, 41))
+
+        self.assertEqual(self.surf.get_at((10, 10)), self.color)
+        self.assertEqual(self.surf.get_at((60, 10)), self.color)
+        self.assertEqual(self.surf.get_at((35, 15)), self.color)
+        self.assertEqual(self.surf.get_at((12, 45)), self.color)
+        self.assertEqual(self.surf.get_at((58, 45)), self.color)
+        # inside the notch, and outside the shape.
+        self.assertNotEqual(self.surf.get_at((35, 30)), self.color)
+        self.assertNotEqual(self.surf.get_at((9, 10)), self.color)
+        self.assertNotEqual(self.surf.get_at((61, 30)), self.color)
+
+        # clipped rows are skipped, the rest are still drawn.
+        self.surf.fill((0, 0, 0, 0))
+        self.surf.set_clip(pygame.Rect(0, 30, 320, 10))
+        draw.polygon(self.surf, self.color, points)
+        self.surf.set_clip(None)
+        self.assertNotEqual(self.surf.get_at((12, 29)), self.color)
+        self.assertEqual(self.surf.get_at((12, 30)), self.color)
+        self.assertEqual(self.surf.get_at((12, 39)), self.color)
+        self.assertNotEqual(self.surf.get_at((12, 40)), self.color)
+
+    def test_aapolygon(self):
+        surf = pygame.Surface((40, 40), 0, 32)
+        surf.fill((0, 0, 0))
+        drawn = draw.aapolygon(surf, (255, 255, 255), [(10, 10), (20, 10),
+                                                       (20, 20), (10, 20)])
+        self.assertEqual(drawn, pygame.Rect(10, 10, 11, 11))
+
+        # pixels are squares around their coordinate, so the edges of the
+        # square are half covered and its corners a quarter.
+        self.assertEqual(surf.get_at((15, 15)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((10, 15)), (128, 128, 128, 255))
+        self.assertEqual(surf.get_at((15, 20)), (128, 128, 128, 255))
+        self.assertEqual(surf.get_at((10, 10)), (64, 64, 64, 255))
+        self.assertEqual(surf.get_at((9, 15)), (0, 0, 0, 255))
+
+        self.assertRaises(ValueError, draw.aapolygon,
+                          pygame.Surface((10, 10), 0, 8), (255, 0, 0),
+                          [(0, 0), (5, 0), (5, 5)])
+
+    def test_aacircle(self):
+        surf = pygame.Surface((40, 40), 0, 32)
+        surf.fill((0, 0, 0))
+        drawn = draw.aacircle(surf, (255, 255, 255), (20, 20), 5)
+        self.assertEqual(drawn, pygame.Rect(15, 15, 11, 11))
+        self.assertEqual(surf.get_at((20, 20)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((20, 26)), (0, 0, 0, 255))
+        edge = surf.get_at((25, 20))
+        self.assertTrue(0 < edge[0] < 255)
+
+        self.assertRaises(ValueError, draw.aacircle, surf, (255, 0, 0),
+                          (20, 20), -1)
+        self.assertRaises(ValueError, draw.aacircle,
+                          pygame.Surface((10, 10), 0, 8), (255, 0, 0),
+                          (5, 5), 3)
+
+    def test_aarect(self):
+        surf = pygame.Surface((40, 40), 0, 32)
+        surf.fill((0, 0, 0))
+        drawn = draw.aarect(surf, (255, 255, 255), (10, 10, 10, 10))
+        self.assertEqual(drawn, pygame.Rect(10, 10, 10, 10))
+        self.assertEqual(surf.get_at((10, 10)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((19, 19)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((20, 19)), (0, 0, 0, 255))
+
+        # a rounded corner leaves its outer pixel empty and blends the
+        # one inside it.
+        surf.fill((0, 0, 0))
+        draw.aarect(surf, (255, 255, 255), (10, 10, 10, 10), 4)
+        self.assertEqual(surf.get_at((10, 10)), (0, 0, 0, 255))
+        corner = surf.get_at((11, 11))
+        self.assertTrue(0 < corner[0] < 255)
+        self.assertEqual(surf.get_at((15, 10)), (255, 255, 255, 255))
+
+        self.assertRaises(ValueError, draw.aarect, surf, (255, 0, 0),
+                          (10, 10, 10, 10), -1)
+
+    def test_path_fill(self):
+        surf = pygame.Surface((60, 60), 0, 32)
+        surf.fill((0, 0, 0))
+        path = draw.Path()
+        path.move_to(10, 10)
+        path.line_to(20, 10)
+        path.line_to(20, 20)
+        path.line_to(10, 20)
+        path.close()
+        drawn = path.fill(surf, (255, 255, 255))
+        self.assertEqual(drawn, pygame.Rect(10, 10, 11, 11))
+        self.assertEqual(surf.get_at((15, 15)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((10, 15)), (128, 128, 128, 255))
+        self.assertEqual(surf.get_at((9, 15)), (0, 0, 0, 255))
+
+        # the kept coverage is reused at another offset
+        drawn = path.fill(surf, (255, 0, 0), (30, 30))
+        self.assertEqual(drawn, pygame.Rect(40, 40, 11, 11))
+        self.assertEqual(surf.get_at((45, 45)), (255, 0, 0, 255))
+        self.assertEqual(surf.get_at((15, 15)), (255, 255, 255, 255))
+
+        # an outline inside another is a hole
+        surf.fill((0, 0, 0))
+        path.move_to(13, 13)
+        path.line_to(17, 13)
+        path.line_to(17, 17)
+        path.line_to(13, 17)
+        path.fill(surf, (255, 255, 255))
+        self.assertEqual(surf.get_at((15, 15)), (0, 0, 0, 255))
+        self.assertEqual(surf.get_at((11, 15)), (255, 255, 255, 255))
+
+        self.assertRaises(ValueError, path.fill,
+                          pygame.Surface((10, 10), 0, 8), (255, 0, 0))
+
+    def test_path_curves(self):
+        surf = pygame.Surface((60, 60), 0, 32)
+        surf.fill((0, 0, 0))
+        path = draw.Path()
+        path.move_to(10, 40)
+        path.quad_to(30, 0, 50, 40)
+        path.fill(surf, (255, 255, 255))
+        # the curve peaks at y = 20
+        self.assertEqual(surf.get_at((30, 25)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((30, 18)), (0, 0, 0, 255))
+
+        path.clear()
+        surf.fill((0, 0, 0))
+        path.move_to(10, 40)
+        path.cubic_to(10, 10, 50, 10, 50, 40)
+        path.fill(surf, (255, 255, 255))
+        self.assertEqual(surf.get_at((30, 30)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((30, 15)), (0, 0, 0, 255))
+
+        self.assertRaises(ValueError, draw.Path, 0)
+
+    def test_path_stroke(self):
+        surf = pygame.Surface((60, 60), 0, 32)
+        surf.fill((0, 0, 0))
+        path = draw.Path()
+        path.move_to(10, 10)
+        path.line_to(40, 10)
+        drawn = path.stroke(surf, (255, 255, 255), 3)
+        self.assertEqual(drawn, pygame.Rect(10, 9, 31, 3))
+        self.assertEqual(surf.get_at((25, 9)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((25, 11)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((25, 12)), (0, 0, 0, 255))
+        self.assertEqual(surf.get_at((9, 10)), (0, 0, 0, 255))
+
+        # square caps reach half the width past the ends
+        surf.fill((0, 0, 0))
+        drawn = path.stroke(surf, (255, 255, 255), 3, draw.JOIN_MITER,
+                            draw.CAP_SQUARE)
+        self.assertEqual(drawn, pygame.Rect(9, 9, 33, 3))
+        self.assertEqual(surf.get_at((9, 10)), (255, 255, 255, 255))
+
+        # a closed outline gets its corners joined
+        path.clear()
+        surf.fill((0, 0, 0))
+        path.move_to(10, 10)
+        path.line_to(40, 10)
+        path.line_to(40, 40)
+        path.line_to(10, 40)
+        path.close()
+        path.stroke(surf, (255, 255, 255), 3)
+        self.assertEqual(surf.get_at((9, 9)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((25, 25)), (0, 0, 0, 255))
+        surf.fill((0, 0, 0))
+        path.stroke(surf, (255, 255, 255), 3, draw.JOIN_BEVEL)
+        self.assertNotEqual(surf.get_at((9, 9)), (255, 255, 255, 255))
+        self.assertEqual(surf.get_at((11, 11)), (255, 255, 255, 255))
+
+        self.assertRaises(ValueError, path.stroke, surf, (255, 0, 0), 0)
+        self.assertRaises(ValueError, path.stroke, surf, (255, 0, 0), 1, 3)
+        self.assertRaises(ValueError, path.stroke, surf, (255, 0, 0), 1,
+                          draw.JOIN_MITER, 3)
+
+    def test_polygons(self):
+        squares = [[(x, 5), (x + 4, 5), (x + 4, 9), (x, 9)]
+                   for x in range(0, 100, 10)]
+        drawn = draw.polygons(self.surf, self.color, squares)
+        self.assertEqual(drawn, pygame.Rect(0, 5, 95, 5))
+        for x in range(0, 100, 10):
+            self.assertEqual(self.surf.get_at((x + 2, 7)), self.color)
+            self.assertNotEqual(self.surf.get_at((x + 6, 7)), self.color)
+
+        colors = [(255, 0, 0), (0, 255, 0)]
+        draw.polygons(self.surf, colors, squares[:2])
+        self.assertEqual(self.surf.get_at((2, 7)), (255, 0, 0, 255))
+        self.assertEqual(self.surf.get_at((12, 7)), (0, 255, 0, 255))
+
+        self.assertRaises(TypeError, draw.polygons, self.surf, colors, squares)
+        self.assertRaises(ValueError, draw.polygons, self.surf, self.color,
+                          [[(0, 0), (1, 1)]])
+
+    def test_batch(self):
+        prims = [(draw.BATCH_POINT, 3, 4, 0, 0, self.color, 0),
+                 (draw.BATCH_LINE, 10, 20, 30, 20, self.color, 1),
+                 (draw.BATCH_RECT, 40, 40, 5, 5, self.color, 0),
+                 (draw.BATCH_CIRCLE, 100, 100, 6, 0, self.color, 0),
+                 (draw.BATCH_ELLIPSE, 200, 50, 20, 10, self.color, 0)]
+        drawn = draw.batch(self.surf, prims)
+        self.assertEqual(drawn, pygame.Rect(3, 4, 218, 103))
+        for pos in [(3, 4), (10, 20), (30, 20), (40, 40), (44, 44),
+                    (100, 100), (210, 55)]:
+            self.assertEqual(self.surf.get_at(pos), self.color)
+        self.assertNotEqual(self.surf.get_at((45, 45)), self.color)
+
+        # packed records take an already mapped color
+        import array
+        mapped = self.surf.map_rgb((255, 0, 0))
+        packed = array.array('i', [draw.BATCH_RECT, 0, 0, 2, 2, 0, 0])
+        packed[5] = mapped - (1 << 32) if mapped >= (1 << 31) else mapped
+        drawn = draw.batch(self.surf, packed)
+        self.assertEqual(drawn, pygame.Rect(0, 0, 2, 2))
+        self.assertEqual(self.surf.get_at((1, 1)), (255, 0, 0, 255))
+
+        self.assertEqual(draw.batch(self.surf, []), pygame.Rect(0, 0, 0, 0))
+        self.assertRaises(ValueError, draw.batch, self.surf,
+                          [(99, 0, 0, 0, 0, self.color, 0)])
+        self.assertRaises(ValueError, draw.batch, self.surf,
+                          [(draw.BATCH_CIRCLE, 0, 0, 2, 0, self.color, 3)])
+        self.assertRaises(ValueError, draw.batch, self.surf, b'\0' * 10)
+        self.assertRaises(TypeError, draw.batch, self.surf, [(0, 0, 0)])
+
+    def test_special_flags(self):
+        surf = pygame.Surface((40, 10), 0, 32)
+        surf.fill((100, 100, 100))
+        draw.line(surf, (10, 20, 200), (0, 1), (39, 1), 1, pygame.BLEND_ADD)
+        self.assertEqual(surf.get_at((20, 1)), (110, 120, 255, 255))
+        self.assertEqual(surf.get_at((20, 2)), (100, 100, 100, 255))
+
+        # the color's alpha is used even though surf has none
+        surf.fill((0, 0, 0))
+        draw.rect(surf, (255, 255, 255, 128), (0, 0, 40, 10), 0,
+                  pygame.BLEND_ALPHA)
+        for x in range(40):
+            self.assertEqual(surf.get_at((x, 5)), (128, 128, 128, 255))
+
+        # fully transparent pixels take the color
+        drawn = draw.circle(self.surf, self.color, (50, 50), 10, 0,
+                            pygame.BLEND_ALPHA)
+        self.assertEqual(drawn, pygame.Rect(40, 40, 20, 20))
+        self.assertEqual(self.surf.get_at((50, 50)), self.color)
+
+        self.assertRaises(ValueError, draw.line, surf, self.color,
+                          (0, 0), (5, 5), 1, 0x20)
+
+    def test_special_flags__modes(self):
+        # Spans of 32 bit pixels are blended four at a time with SSE2 and
+        # the rest one by one, 24 bit pixels always one by one.  All must
+        # give what the BLEND_* macros give.
+        color = (200, 90, 30, 100)
+        flags = [pygame.BLEND_ADD, pygame.BLEND_SUB, pygame.BLEND_MULT,
+                 pygame.BLEND_MIN, pygame.BLEND_MAX,
+                 pygame.BLEND_RGBA_ADD, pygame.BLEND_RGBA_SUB,
+                 pygame.BLEND_RGBA_MULT, pygame.BLEND_RGBA_MIN,
+                 pygame.BLEND_RGBA_MAX, pygame.BLEND_PREMULTIPLIED,
+                 pygame.BLEND_ALPHA]
+        pixels = [((x * 23) % 256, (x * 57 + 10) % 256, 255 - x * 19,
+                   (x * 40) % 256) for x in range(11)]
+
+        for flag in flags:
+            rows = []
+            for size_flags, depth in ((0, 32), (pygame.SRCALPHA, 32),
+                                      (0, 24)):
+                surf = pygame.Surface((11, 1), size_flags, depth)
+                has_alpha = size_flags == pygame.SRCALPHA
+                for x, pixel in enumerate(pixels):
+                    surf.set_at((x, 0), pixel)
+                draw.rect(surf, color, (0, 0, 11, 1), 0, flag)
+                row = [tuple(surf.get_at((x, 0))) for x in range(11)]
+                expected = [blend_reference(flag, color, pixel, has_alpha)
+                            for pixel in pixels]
+                self.assertEqual(row, expected,
+                                 "flag %d, depth %d, alpha %s" %
+                                 (flag, depth, has_alpha))
+                if not has_alpha:
+                    rows.append(row)
+            self.assertEqual(rows[0], rows[1])
+
+        surf = pygame.Surface((8, 1), 0, 32)
+        for flag, expected in ((pygame.BLEND_MULT, (78, 35, 11, 255)),
+                               (pygame.BLEND_MIN, (100, 90, 30, 255)),
+                               (pygame.BLEND_MAX, (200, 100, 100, 255)),
+                               (pygame.BLEND_PREMULTIPLIED,
+                                (255, 151, 91, 255))):
+            surf.fill((100, 100, 100))
+            draw.line(surf, color, (0, 0), (7, 0), 1, flag)
+            for x in range(8):
+                self.assertEqual(surf.get_at((x, 0)), expected)
+
+    def test_special_flags__shapes(self):
+        # Each pixel of a shape is blended once, and the same pixels are
+        # drawn as without special_flags.
+        shapes = [
+            lambda s, c, f: draw.arc(s, c, (5, 5, 50, 40), 0.3, 4.0, 3, f),
+            lambda s, c, f: draw.ellipse(s, c, (5, 5, 50, 40), 0, f),
+            lambda s, c, f: draw.ellipse(s, c, (5, 5, 50, 40), 4, f),
+            lambda s, c, f: draw.polygon(s, c, [(5, 5), (55, 20), (30, 55),
+                                                (10, 40)], 0, f),
+            lambda s, c, f: draw.polygon(s, c, [(5, 5), (55, 20), (30, 55),
+                                                (10, 40)], 3, f),
+            lambda s, c, f: draw.lines(s, c, True, [(5, 5), (55, 20),
+                                                    (30, 55)], 4, f),
+        ]
+        plain = pygame.Surface((60, 60), 0, 32)
+        blended = pygame.Surface((60, 60), 0, 32)
+        for shape in shapes:
+            plain.fill((0, 0, 0))
+            shape(plain, (255, 255, 255), 0)
+            blended.fill((100, 100, 100))
+            shape(blended, (10, 20, 30), pygame.BLEND_ADD)
+            for y in range(60):
+                for x in range(60):
+                    if plain.get_at((x, y)) == (255, 255, 255, 255):
+                        self.assertEqual(blended.get_at((x, y)),
+                                         (110, 120, 130, 255))
+                    else:
+                        self.assertEqual(blended.get_at((x, y)),
+                                         (100, 100, 100, 255))
+
+        # the antialiased shades mix between the pixel and the blended pixel
+        blended.fill((50, 50, 50))
+        draw.aalines(blended, (100, 0, 0), True,
+                     [(5.5, 5.2), (50.3, 12.7), (30.1, 50.9)], 1,
+                     pygame.BLEND_ADD)
+        reds = set()
+        for y in range(60):
+            for x in range(60):
+                r, g, b, a = blended.get_at((x, y))
+                self.assertEqual((g, b), (50, 50))
+                self.assert_(50 <= r <= 150)
+                reds.add(r)
+        self.assert_(len(reds) > 2)
+
+    def test_special_flags__batch(self):
+        # batch blends each primitive as the single shape functions do
+        prims = [(draw.BATCH_POINT, 3, 4, 0, 0, (10, 20, 30), 0),
+                 (draw.BATCH_LINE, 10, 20, 50, 20, (10, 20, 30), 3),
+                 (draw.BATCH_RECT, 5, 30, 20, 10, (10, 20, 30), 0),
+                 (draw.BATCH_RECT, 30, 30, 20, 10, (10, 20, 30), 2),
+                 (draw.BATCH_CIRCLE, 15, 50, 6, 0, (10, 20, 30), 0),
+                 (draw.BATCH_ELLIPSE, 30, 44, 24, 14, (10, 20, 30), 3)]
+        for flag in (pygame.BLEND_ADD, pygame.BLEND_MULT, pygame.BLEND_MAX):
+            batched = pygame.Surface((60, 60), 0, 32)
+            single = pygame.Surface((60, 60), 0, 32)
+            batched.fill((100, 150, 200))
+            single.fill((100, 150, 200))
+            draw.batch(batched, prims, flag)
+            draw.rect(single, (10, 20, 30), (3, 4, 1, 1), 0, flag)
+            draw.line(single, (10, 20, 30), (10, 20), (50, 20), 3, flag)
+            draw.rect(single, (10, 20, 30), (5, 30, 20, 10), 0, flag)
+            draw.rect(single, (10, 20, 30), (30, 30, 20, 10), 2, flag)
+            draw.circle(single, (10, 20, 30), (15, 50), 6, 0, flag)
+            draw.ellipse(single, (10, 20, 30), (30, 44, 24, 14), 3, flag)
+            for y in range(60):
+                for x in range(60):
+                    self.assertEqual(batched.get_at((x, y)),
+                                     single.get_at((x, y)))
+
 ################################################################################
 
 if __name__ == '__main__':
@@ -403,6 +403,41 @@ class FontTypeTest( unittest.TestCase ):
         f.set_bold(False)
         self.failIf(f.get_bold())
 
+    def test_set_render_cache(self):
+        f = pygame_font.Font(None, 20)
+        self.assertEqual(f.get_render_cache_stats(), (0, 0, 0, 0, 0))
+        f.render("foo", True, (0, 0, 0))
+        self.assertEqual(f.get_render_cache_stats(), (0, 0, 0, 0, 0))
+
+        f.set_render_cache(1 << 20)
+        s1 = f.render("foo", True, (0, 0, 0))
+        s2 = f.render("foo", True, (0, 0, 0))
+        self.assertTrue(s1 is s2)
+        hits, misses, evictions, count, nbytes = f.get_render_cache_stats()
+        self.assertEqual((hits, misses, evictions, count), (1, 1, 0, 1))
+        self.assertTrue(nbytes >= s1.get_pitch() * s1.get_height())
+
+        # Any change in text, antialias, colors or style is a miss.
+        self.assertFalse(f.render("foo", False, (0, 0, 0)) is s1)
+        self.assertFalse(f.render("foo", True, (0, 0, 1)) is s1)
+        self.assertFalse(f.render("foo", True, (0, 0, 0), (0, 0, 0)) is s1)
+        self.assertFalse(f.render(as_unicode("foo"), True, (0, 0, 0)) is s1)
+        f.set_bold(True)
+        self.assertFalse(f.render("foo", True, (0, 0, 0)) is s1)
+        f.set_bold(False)
+        self.assertTrue(f.render("foo", True, (0, 0, 0)) is s1)
+
+        # Least recently used surfaces are evicted to fit the limit.
+        f.set_render_cache(nbytes)
+        self.assertEqual(f.get_render_cache_stats()[3], 1)
+        f.render("x", True, (0, 0, 0))
+        self.assertFalse(f.render("foo", True, (0, 0, 0)) is s1)
+        self.assertTrue(f.get_render_cache_stats()[2] > 0)
+
+        f.set_render_cache(0)
+        self.assertEqual(f.get_render_cache_stats(), (0, 0, 0, 0, 0))
+        self.assertRaises(ValueError, f.set_render_cache, -1)
+
     def test_set_italic(self):
         f = pygame_font.Font(None, 20)
         self.failIf(f.get_italic())
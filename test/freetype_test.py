@@ -564,6 +564,76 @@ class FreeTypeFontTest(unittest.TestCase):
                              (r, f.rotation, r_reduced))
         self.assertRaises(TypeError, setattr, f, 'rotation', '12')
 
+    def test_freetype_Font_layout_cache_size(self):
+        font = ft.Font(self._sans_path, size=24)
+        self.assertEqual(font.layout_cache_size, 16)
+        labels = ['Score: %d' % i for i in range(6)]
+        expected = [font.render(text, (0, 0, 0))[0] for text in labels]
+        expected = [pygame.image.tostring(surf, 'RGBA') for surf in expected]
+        rects = [font.get_rect(text) for text in labels]
+
+        def check():
+            for n in range(3):
+                for i, text in enumerate(labels):
+                    surf, r = font.render(text, (0, 0, 0))
+                    self.assertEqual(r, rects[i])
+                    self.assertEqual(pygame.image.tostring(surf, 'RGBA'),
+                                     expected[i])
+                    self.assertEqual(font.get_rect(text), rects[i])
+                    self.assertEqual(font.get_rect(text, size=12),
+                                     font.get_rect(text, size=12))
+
+        check()
+        font.layout_cache_size = 2
+        self.assertEqual(font.layout_cache_size, 2)
+        check()
+        # Cached layouts survive their glyphs being evicted
+        ft.set_cache_limit(1)
+        try:
+            check()
+        finally:
+            ft.set_cache_limit()
+        # text None reuses the last layout
+        surf = pygame.Surface(rects[-1].size, pygame.SRCALPHA, 32)
+        font.render_to(surf, (0, 0), labels[-1], (0, 0, 0))
+        font.get_rect(labels[0])
+        self.assertEqual(font.render_to(surf, (0, 0), None, (0, 0, 0)),
+                         rects[0])
+        self.assertRaises(ValueError, setattr, font, 'layout_cache_size', 0)
+        self.assertRaises(TypeError, setattr, font, 'layout_cache_size', 'a')
+        self.assertRaises(RuntimeError, getattr, nullfont(),
+                          'layout_cache_size')
+
+    def test_freetype_Font_use_atlas(self):
+        font = self._TEST_FONTS['sans']
+        self.assertFalse(font.use_atlas)
+        color = pygame.Color(10, 80, 200)
+        text = 'Atlas glyphs, atlas glyphs'
+        plain = pygame.Surface((400, 60), 0, 32)
+        plain.fill((255, 255, 255))
+        atlas = plain.copy()
+
+        prect = font.render_to(plain, (10, 10), text, color, size=24)
+        font.use_atlas = True
+        try:
+            # Once to fill the atlas, once to blit from it
+            arect = font.render_to(atlas, (10, 10), text, color, size=24)
+            atlas.fill((255, 255, 255))
+            arect = font.render_to(atlas, (10, 10), text, color, size=24)
+            self.assertEqual(arect, prect)
+            for y in range(plain.get_height()):
+                for x in range(plain.get_width()):
+                    p = plain.get_at((x, y))
+                    a = atlas.get_at((x, y))
+                    for i in range(3):
+                        self.assertTrue(abs(p[i] - a[i]) <= 2,
+                                        "%s != %s at %s" % (p, a, (x, y)))
+            # A clipped render_to still works
+            font.render_to(atlas, (-5, -5), text, color, size=24)
+            self.assertRaises(TypeError, setattr, font, 'use_atlas', 1)
+        finally:
+            font.use_atlas = False
+
     def test_freetype_Font_render_to(self):
         # Rendering to an existing target surface is equivalent to
         # blitting a surface returned by Font.render with the target.
@@ -835,6 +905,61 @@ class FreeTypeFontTest(unittest.TestCase):
         finally:
             font.antialiased = save_antialiased
 
+    def test_freetype_Font_render_paragraph(self):
+        font = self._TEST_FONTS['sans']
+        line_height = font.get_sized_height(24)
+        text = 'The quick brown fox jumps over the lazy dog'
+
+        surf, rect = font.render_paragraph(text, 200, size=24)
+        self.assertTrue(isinstance(surf, pygame.Surface))
+        self.assertTrue(isinstance(rect, pygame.Rect))
+        self.assertEqual(rect.size, surf.get_size())
+        self.assertEqual(rect.width, 200)
+        self.assertTrue(rect.height > 2 * line_height)
+        self.assertTrue(0 < rect.y < line_height)
+
+        # Width 0 only breaks at newlines
+        one = font.render_paragraph('line', size=24)[1]
+        three = font.render_paragraph('line\nline\nline', size=24)[1]
+        self.assertEqual(three.width, one.width)
+        self.assertTrue(abs(three.height - one.height - 2 * line_height) <= 1)
+        double = font.render_paragraph('line\nline\nline', size=24,
+                                       line_spacing=2.0)[1]
+        self.assertTrue(abs(double.height - one.height - 4 * line_height) <= 1)
+
+        # Alignment within the width
+        def ink(align, text='x'):
+            surf = font.render_paragraph(text, 200, (0, 0, 0), size=24,
+                                         align=align)[0]
+            return surf.get_bounding_rect()
+
+        self.assertTrue(ink(ft.ALIGN_LEFT).left < 10)
+        self.assertTrue(ink(ft.ALIGN_RIGHT).right > 190)
+        self.assertTrue(abs(ink(ft.ALIGN_CENTER).centerx - 100) <= 3)
+        self.assertTrue(ink(ft.ALIGN_JUSTIFY).left < 10)
+        left = ink(ft.ALIGN_LEFT, text)
+        justified = ink(ft.ALIGN_JUSTIFY, text)
+        self.assertEqual(justified.height, left.height)
+        self.assertTrue(justified.right > 190)
+
+        # A word longer than the width is broken
+        word = font.render_paragraph('W' * 20, 100, size=24)[1]
+        self.assertEqual(word.width, 100)
+        self.assertTrue(word.height > 2 * line_height)
+
+        self.assertRaises(ValueError, font.render_paragraph, text, -1)
+        self.assertRaises(ValueError, font.render_paragraph, text, 100,
+                          align=4)
+        self.assertRaises(ValueError, font.render_paragraph, text, 100,
+                          line_spacing=-1.0)
+        self.assertRaises(TypeError, font.render_paragraph, 12, 100)
+        font.vertical = True
+        try:
+            self.assertRaises(ValueError, font.render_paragraph, text, 100,
+                              size=24)
+        finally:
+            font.vertical = False
+
     def test_freetype_Font_render_raw(self):
     
         font = self._TEST_FONTS['sans']
@@ -1126,22 +1251,15 @@ class FreeTypeFontTest(unittest.TestCase):
         self.assertEqual(self._TEST_FONTS['sans'].path, self._sans_path)
         self.assertRaises(AttributeError, getattr, nullfont(), 'path')
 
-    # This Font cache test is conditional on freetype being built by a debug
-    # version of Python or with the C macro PGFT_DEBUG_CACHE defined.
     def test_freetype_Font_cache(self):
         glyphs = "abcde"
         glen = len(glyphs)
         other_glyphs = "123"
         oglen = len(other_glyphs)
         uempty = unicode_("")
-##        many_glyphs = (uempty.join([unichr_(i) for i in range(32,127)] +
-##                                   [unichr_(i) for i in range(161,172)] +
-##                                   [unichr_(i) for i in range(174,239)]))
         many_glyphs = uempty.join([unichr_(i) for i in range(32,127)])
         mglen = len(many_glyphs)
 
-        count = 0
-        access = 0
         hit = 0
         miss = 0
 
@@ -1149,89 +1267,90 @@ class FreeTypeFontTest(unittest.TestCase):
         f.style = ft.STYLE_NORMAL
         f.antialiased = True
 
-        # Ensure debug counters are zero
-        self.assertEqual(f._debug_cache_stats, (0, 0, 0, 0, 0))
+        # Ensure counters are zero
+        self.assertEqual(ft.get_cache_stats(f), (0, 0, 0, 0))
         # Load some basic glyphs
-        count = access = miss = glen
+        miss = glen
         f.render_raw(glyphs)
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
+        self.assertTrue(ft.get_cache_stats(f)[3] > 0)
         # Vertical should not affect the cache
-        access += glen
         hit += glen
         f.vertical = True
         f.render_raw(glyphs)
         f.vertical = False
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # New glyphs will
-        count += oglen
-        access += oglen
         miss += oglen
         f.render_raw(other_glyphs)
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # Point size does
-        count += glen
-        access += glen
         miss += glen
         f.render_raw(glyphs, size=12)
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # Underline style does not
-        access += oglen
         hit += oglen
         f.underline = True
         f.render_raw(other_glyphs)
         f.underline = False
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # Oblique style does
-        count += glen
-        access += glen
         miss += glen
         f.oblique = True
         f.render_raw(glyphs)
         f.oblique = False
-        self.assertEqual(f._debug_cache_stats, (count, 0, access, hit, miss))
-        # Strong style does; by this point cache clears can happen
-        count += glen
-        access += glen
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
+        # Strong style does
         miss += glen
         f.strong = True
         f.render_raw(glyphs)
         f.strong = False
-        ccount, cdelete_count, caccess, chit, cmiss = f._debug_cache_stats
-        self.assertEqual((ccount + cdelete_count, caccess, chit, cmiss),
-                         (count, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # Rotation does
-        count += glen
-        access += glen
         miss += glen
         f.render_raw(glyphs, rotation=10)
-        ccount, cdelete_count, caccess, chit, cmiss = f._debug_cache_stats
-        self.assertEqual((ccount + cdelete_count, caccess, chit, cmiss),
-                         (count, access, hit, miss))
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
         # aliased (mono) glyphs do
-        count += oglen
-        access += oglen
         miss += oglen
         f.antialiased = False
         f.render_raw(other_glyphs)
         f.antialiased = True
-        ccount, cdelete_count, caccess, chit, cmiss = f._debug_cache_stats
-        self.assertEqual((ccount + cdelete_count, caccess, chit, cmiss),
-                         (count, access, hit, miss))
-        # Trigger a cleanup for sure.
-        count += 2 * mglen
-        access += 2 * mglen
-        miss += 2 * mglen
-        f.get_metrics(many_glyphs, size=8)
-        f.get_metrics(many_glyphs, size=10)
-        ccount, cdelete_count, caccess, chit, cmiss = f._debug_cache_stats
-        self.assertTrue(ccount < count)
-        self.assertEqual((ccount + cdelete_count, caccess, chit, cmiss),
-                         (count, access, hit, miss))
-
-    try:
-        ft.Font._debug_cache_stats
-    except AttributeError:
-        del test_freetype_Font_cache
+        self.assertEqual(ft.get_cache_stats(f)[:3], (hit, miss, 0))
+        # The module counters include this font's
+        ghit, gmiss, gevictions, gmemory = ft.get_cache_stats()
+        fhit, fmiss, fevictions, fmemory = ft.get_cache_stats(f)
+        self.assertTrue(ghit >= fhit and gmiss >= fmiss)
+        self.assertTrue(gmemory >= fmemory)
+        # A tiny memory limit evicts least recently used glyphs.
+        ft.set_cache_limit(1)
+        try:
+            hits, misses, evictions, memory = ft.get_cache_stats(f)
+            self.assertTrue(evictions > 0)
+            self.assertEqual(memory, 0)
+            f.render_raw(glyphs)
+            miss += glen
+            self.assertEqual(ft.get_cache_stats(f)[:2], (hit, miss))
+            f.get_metrics(many_glyphs, size=8)
+            miss += mglen
+            hits, misses, evictions, memory = ft.get_cache_stats(f)
+            self.assertEqual((hits, misses), (hit, miss))
+            self.assertTrue(evictions > glen + mglen - 2)
+        finally:
+            ft.set_cache_limit()
+
+    def test_cache_limit(self):
+        DEFAULT_CACHE_LIMIT = 4 * 1024 * 1024
+        self.assertEqual(ft.get_cache_limit(), DEFAULT_CACHE_LIMIT)
+        try:
+            ft.set_cache_limit(1 << 20)
+            self.assertEqual(ft.get_cache_limit(), 1 << 20)
+            self.assertRaises(ValueError, ft.set_cache_limit, -1)
+            ft.set_cache_limit(0)
+            self.assertEqual(ft.get_cache_limit(), DEFAULT_CACHE_LIMIT)
+        finally:
+            ft.set_cache_limit()
+        self.assertRaises(TypeError, ft.get_cache_stats, 1)
+        self.assertRaises(RuntimeError, ft.get_cache_stats, nullfont())
 
     def test_undefined_character_code(self):
         # To be consistent with pygame.font.Font, undefined codes
@@ -14,6 +14,8 @@ else:
     is_pygame_pkg = __name__.startswith('pygame.tests.')
 
 import unittest
+import array
+import math
 import pygame
 import pygame.gfxdraw
 from pygame.locals import *
@@ -68,6 +70,13 @@ class GfxdrawDefaultTest( unittest.TestCase ):
                      surf.get_masks()))
         self.failIfEqual(sc, color, fail_msg)
 
+    def check_edge_at(self, surf, posn, fg, bg):
+        # a partly covered pixel is a blend of the two colors, which only
+        # the deeper surfaces can hold
+        if surf.get_bitsize() >= 24:
+            self.check_not_at(surf, posn, fg)
+            self.check_not_at(surf, posn, bg)
+
     def setUp(self):
         Surface = pygame.Surface
         size = self.default_size
@@ -219,6 +228,43 @@ class GfxdrawDefaultTest( unittest.TestCase ):
             for posn in bg_test_points:
                 self.check_at(surf, posn, bg_adjusted)
 
+    def test_box_blend(self):
+        """box(surface, rect, color): translucent color on 32 bit surfaces"""
+        rect = pygame.Rect(10, 15, 55, 3)
+        for surf in self.surfaces:
+            if surf.get_bitsize() != 32:
+                continue
+            surf.fill((200, 100, 200))
+            pygame.gfxdraw.box(surf, rect, (0, 100, 0, 128))
+            for posn in [rect.topleft, (rect.right - 1, rect.bottom - 1)]:
+                sc = surf.get_at(posn)
+                self.failUnlessEqual(sc[:3], (100, 100, 100),
+                                     "%s at %s, masks: %s" %
+                                     (sc, posn, surf.get_masks()))
+            sc = surf.get_at(rect.bottomright)
+            self.failUnlessEqual(sc[:3], (200, 100, 200))
+
+    def test_aabox(self):
+        """aabox(surface, rect, rad, color): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        rect = pygame.Rect(10, 15, 55, 62)
+        fg_test_points = [rect.topleft,
+                          (rect.right - 1, rect.top),
+                          (rect.left, rect.bottom - 1),
+                          (rect.right - 1, rect.bottom - 1)]
+        bg_test_points = [(rect.left - 1, rect.top),
+                          (rect.left, rect.top - 1),
+                          rect.bottomright]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            pygame.gfxdraw.aabox(surf, rect, 0, fg)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+
     def test_line(self):
         """line(surface, x1, y1, x2, y2, color): return None"""
         fg = self.foreground_color
@@ -354,6 +400,24 @@ class GfxdrawDefaultTest( unittest.TestCase ):
             for posn in bg_test_points:
                 self.check_at(surf, posn, bg_adjusted)
 
+    def test_filled_aacircle(self):
+        """filled_aacircle(surface, x, y, r, color): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        x = 45
+        y = 40
+        r = 30
+        fg_test_points = [(x, y), (x, y - r + 1), (x - r + 1, y)]
+        bg_test_points = [(x, y - r - 1), (x + r + 1, y), (x - r, y - r)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            pygame.gfxdraw.filled_aacircle(surf, x, y, r, fg)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+
     def test_ellipse(self):
         """ellipse(surface, x, y, rx, ry, color): return None"""
         fg = self.foreground_color
@@ -444,6 +508,32 @@ class GfxdrawDefaultTest( unittest.TestCase ):
             for posn in bg_test_points:
                 self.check_at(surf, posn, bg_adjusted)
 
+
+    def test_filled_aaellipse(self):
+        """filled_aaellipse(surface, x, y, rx, ry, color): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        x = 45
+        y = 40
+        rx = 30
+        ry = 20
+        fg_test_points = [(x, y), (x, y - ry + 1), (x, y + ry - 1),
+                          (x - rx + 1, y), (x + rx - 1, y)]
+        edge_test_points = [(x, y - ry), (x, y + ry),
+                            (x - rx, y), (x + rx, y)]
+        bg_test_points = [(x, y - ry - 2), (x, y + ry + 2),
+                          (x - rx - 2, y), (x + rx + 2, y)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            pygame.gfxdraw.filled_aaellipse(surf, x, y, rx, ry, fg)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+            for posn in edge_test_points:
+                self.check_edge_at(surf, posn, fg_adjusted, bg_adjusted)
+
     def test_pie(self):
         """pie(surface, x, y, r, start, end, color): return None"""
         fg = self.foreground_color
@@ -545,6 +635,33 @@ class GfxdrawDefaultTest( unittest.TestCase ):
             for posn in bg_test_points:
                 self.check_at(surf, posn, bg_adjusted)
 
+
+    def test_filled_aatrigon(self):
+        """filled_aatrigon(surface, x1, y1, x2, y2, x3, y3, color): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        x1 = 10
+        y1 = 10
+        x2 = 80
+        y2 = 10
+        x3 = 10
+        y3 = 80
+        fg_test_points = [(x1 + 1, y1 + 1), (x1 + 10, y1 + 30),
+                          (x2 - 3, y2 + 1), (x3 + 1, y3 - 3)]
+        # the edges run through the middle of these pixels
+        edge_test_points = [(x1, y1 + 20), (x1 + 20, y1), (45, 45)]
+        bg_test_points = [(x1 - 2, y1 + 20), (x1 + 20, y1 - 2), (47, 47)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            pygame.gfxdraw.filled_aatrigon(surf, x1, y1, x2, y2, x3, y3, fg)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+            for posn in edge_test_points:
+                self.check_edge_at(surf, posn, fg_adjusted, bg_adjusted)
+
     def test_polygon(self):
         """polygon(surface, points, color): return None"""
         fg = self.foreground_color
@@ -644,6 +761,39 @@ class GfxdrawDefaultTest( unittest.TestCase ):
             for posn in bg_test_points:
                 self.check_at(surf, posn, bg_adjusted)
 
+
+    def test_filled_aapolygon(self):
+        """filled_aapolygon(surface, points, color): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        # a square with a notch cut up into its bottom
+        points = [(10, 10), (80, 10), (80, 80), (45, 40), (10, 80)]
+        fg_test_points = [(11, 11), (45, 30), (75, 70), (15, 70)]
+        edge_test_points = [(80, 45), (10, 45), (45, 10), (45, 40)]
+        bg_test_points = [(82, 45), (8, 45), (45, 8), (45, 70)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            pygame.gfxdraw.filled_aapolygon(surf, points, fg)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+            for posn in edge_test_points:
+                self.check_edge_at(surf, posn, fg_adjusted, bg_adjusted)
+
+        # the middle of a star, inside the outline twice, is left unfilled
+        star = [(45 + 35 * math.cos(math.radians(-90 + 144 * i)),
+                 45 + 35 * math.sin(math.radians(-90 + 144 * i)))
+                for i in range(5)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            surf.fill(bg)
+            pygame.gfxdraw.filled_aapolygon(surf, star, fg)
+            self.check_at(surf, (45, 45), bg_adjusted)
+            self.check_at(surf, (45, 18), fg_adjusted)
+
     def test_textured_polygon(self):
         """textured_polygon(surface, points, texture, tx, ty): return None"""
         w, h = self.default_size
@@ -684,6 +834,53 @@ class GfxdrawDefaultTest( unittest.TestCase ):
                               points,
                               texture, 0, 0)
 
+    def test_textured_triangles(self):
+        """textured_triangles(surface, texture, vertices): return None"""
+        fg = self.foreground_color
+        bg = self.background_color
+        texture = pygame.Surface((2, 2), 0, 32)
+        texture.fill(bg)
+        texture.set_at((1, 0), fg)
+        texture.set_at((0, 1), fg)
+        # a quad from (10, 10) to (50, 50) showing the texture once
+        vertices = [(10, 10, 0, 0), (50, 10, 2, 0), (50, 50, 2, 2),
+                    (10, 10, 0, 0), (50, 50, 2, 2), (10, 50, 0, 2)]
+        fg_test_points = [(40, 20), (20, 40), (49, 10), (10, 49)]
+        bg_test_points = [(20, 20), (40, 40), (10, 10), (49, 49)]
+        for surf in self.surfaces:
+            fg_adjusted = surf.unmap_rgb(surf.map_rgb(fg))
+            bg_adjusted = surf.unmap_rgb(surf.map_rgb(bg))
+            surf.fill(fg)
+            pygame.gfxdraw.textured_triangles(surf, texture, vertices)
+            for posn in fg_test_points:
+                self.check_at(surf, posn, fg_adjusted)
+            for posn in bg_test_points:
+                self.check_at(surf, posn, bg_adjusted)
+            # outside the quad
+            for posn in [(9, 20), (50, 20), (20, 50)]:
+                self.check_at(surf, posn, fg_adjusted)
+
+        # packed floats, with depths, drawn in perspective
+        surf = self.surfaces[3]
+        packed = array.array('f', [10, 10, 0, 0, 1, 50, 10, 2, 0, 1,
+                                   50, 50, 2, 2, 1, 10, 10, 0, 0, 1,
+                                   50, 50, 2, 2, 1, 10, 50, 0, 2, 1])
+        surf.fill(fg)
+        pygame.gfxdraw.textured_triangles(surf, texture, packed, True)
+        self.check_at(surf, (20, 20), surf.unmap_rgb(surf.map_rgb(bg)))
+        self.check_at(surf, (40, 20), surf.unmap_rgb(surf.map_rgb(fg)))
+
+        self.failUnlessRaises(ValueError,
+                              pygame.gfxdraw.textured_triangles,
+                              surf, texture, vertices[:4])
+        self.failUnlessRaises(ValueError,
+                              pygame.gfxdraw.textured_triangles,
+                              surf, texture,
+                              [(0, 0, 0, 0, 0)] * 3, True)
+        self.failUnlessRaises(TypeError,
+                              pygame.gfxdraw.textured_triangles,
+                              surf, texture, [(0, 0)] * 3)
+
     def test_bezier(self):
         """bezier(surface, points, steps, color): return None"""
         fg = self.foreground_color
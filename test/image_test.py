@@ -16,7 +16,7 @@ if is_pygame_pkg:
 else:
     from test.test_utils import example_path, png
 import pygame, pygame.image, pygame.pkgdata
-from pygame.compat import xrange_, ord_
+from pygame.compat import xrange_, ord_, as_bytes
 
 import os
 import array
@@ -113,6 +113,404 @@ class ImageModuleTest( unittest.TestCase ):
         
         # surf = pygame.image.load(open(os.path.join("examples", "data", "alien1.jpg"), "rb"))
 
+    def test_load__buffer(self):
+        """ load reads images from objects with the buffer protocol.
+        """
+        path = example_path('data/asprite.bmp')
+        expected = pygame.image.load(path)
+        f = open(path, 'rb')
+        try:
+            data = f.read()
+        finally:
+            f.close()
+
+        for source in (bytearray(data), memoryview(bytearray(data))):
+            surf = pygame.image.load(source, 'asprite.bmp')
+            self.assertEqual(surf.get_size(), expected.get_size())
+            self.assertEqual(pygame.image.tostring(surf, 'RGB'),
+                             pygame.image.tostring(expected, 'RGB'))
+            surf = pygame.image.load_basic(source)
+            self.assertEqual(pygame.image.tostring(surf, 'RGB'),
+                             pygame.image.tostring(expected, 'RGB'))
+
+        self.assertRaises(pygame.error, pygame.image.load,
+                          bytearray(data[:20]), 'asprite.bmp')
+
+    def test_load__mmap(self):
+        """ load reads an mmap from its current position, and lets go of it.
+        """
+        import mmap
+
+        path = example_path('data/asprite.bmp')
+        expected = pygame.image.load(path)
+        f = open(path, 'rb')
+        try:
+            data = f.read()
+        finally:
+            f.close()
+
+        prefix = as_bytes('not an image')
+        handle, name = tempfile.mkstemp('.bmp')
+        try:
+            os.write(handle, prefix + data)
+            mm = mmap.mmap(handle, 0, access=mmap.ACCESS_READ)
+            try:
+                try:
+                    memoryview(mm)
+                except TypeError:
+                    # Before Python 3 mmap has no buffer protocol; it is
+                    # a file object, closed once loaded.
+                    return
+                mm.seek(len(prefix))
+                surf = pygame.image.load(mm, 'asprite.bmp')
+                self.assertEqual(surf.get_size(), expected.get_size())
+                self.assertEqual(pygame.image.tostring(surf, 'RGB'),
+                                 pygame.image.tostring(expected, 'RGB'))
+
+                mm.seek(0)
+                self.assertRaises(pygame.error, pygame.image.load, mm,
+                                  'asprite.bmp')
+            finally:
+                # Fails with BufferError if a view is still held
+                mm.close()
+        finally:
+            os.close(handle)
+            os.remove(name)
+
+    def test_load_many(self):
+        """ load_many returns the same images as load, in order.
+        """
+        names = ['asprite.bmp', 'chimp.bmp', 'fist.bmp', 'liquid.bmp']
+        if pygame.image.get_extended():
+            names += ['alien1.png', 'alien1.jpg', 'brick.png']
+        paths = [example_path(os.path.join('data', n)) for n in names]
+
+        for workers in (0, 1, 3):
+            surfs = pygame.image.load_many(paths, workers=workers)
+            self.assertEqual(len(surfs), len(paths))
+            for path, surf in zip(paths, surfs):
+                expected = pygame.image.load(path)
+                self.assertEqual(surf.get_size(), expected.get_size())
+                self.assertEqual(surf.get_bitsize(), expected.get_bitsize())
+                self.assertEqual(pygame.image.tostring(surf, 'RGB'),
+                                 pygame.image.tostring(expected, 'RGB'))
+
+        self.assertEqual(pygame.image.load_many([]), [])
+
+        # Conversion to the format of a given surface.
+        target = pygame.Surface((1, 1), 0, 32)
+        surfs = pygame.image.load_many(paths[:2], convert=target)
+        for surf in surfs:
+            self.assertEqual(surf.get_bitsize(), 32)
+            self.assertEqual(surf.get_masks(), target.get_masks())
+
+        bad = paths[:1] + [example_path('data/no_such_image.bmp')]
+        self.assertRaises(pygame.error, pygame.image.load_many, bad)
+        self.assertRaises(ValueError, pygame.image.load_many, paths,
+                          workers=-1)
+        self.assertRaises(TypeError, pygame.image.load_many, [1])
+
+    def test_load__convert(self):
+        """ load with convert gives what load and then convert give.
+        """
+        names = ['asprite.bmp', 'chimp.bmp']
+        if pygame.image.get_extended():
+            names += ['alien1.png', 'alien1.jpg', 'brick.png']
+        paths = [example_path(os.path.join('data', n)) for n in names]
+
+        handle, qoi_name = tempfile.mkstemp(".qoi")
+        os.close(handle)
+        try:
+            source = pygame.Surface((21, 13), pygame.SRCALPHA, 32)
+            for y in xrange_(13):
+                for x in xrange_(21):
+                    source.set_at((x, y), (x * 12, y * 19, x + y, x * y))
+            pygame.image.save(source, qoi_name)
+            paths.append(qoi_name)
+
+            targets = [pygame.Surface((1, 1), pygame.SRCALPHA, 32),
+                       pygame.Surface((1, 1), pygame.SRCALPHA, 32,
+                                      (0xff, 0xff00, 0xff0000, 0xff000000)),
+                       pygame.Surface((1, 1), 0, 32),
+                       pygame.Surface((1, 1), 0, 24),
+                       pygame.Surface((1, 1), 0, 16)]
+            for path in paths:
+                for target in targets:
+                    expected = pygame.image.load(path).convert(target)
+                    surf = pygame.image.load(path, convert=target)
+                    self.assertEqual(surf.get_size(), expected.get_size())
+                    self.assertEqual(surf.get_bitsize(), target.get_bitsize())
+                    self.assertEqual(surf.get_masks(), target.get_masks())
+                    format = target.get_masks()[3] and 'RGBA' or 'RGB'
+                    self.assertEqual(pygame.image.tostring(surf, format),
+                                     pygame.image.tostring(expected, format))
+
+                    f = open(path, 'rb')
+                    try:
+                        surf = pygame.image.load(f, path, convert=target)
+                    finally:
+                        f.close()
+                    self.assertEqual(pygame.image.tostring(surf, format),
+                                     pygame.image.tostring(expected, format))
+        finally:
+            os.remove(qoi_name)
+
+        self.assertRaises(pygame.error, pygame.image.load,
+                          example_path('data/no_such_image.png'),
+                          convert=targets[0])
+
+    def test_load_async(self):
+        """ load_async posts a user event carrying the loaded surface.
+        """
+        import time
+
+        good = example_path('data/asprite.bmp')
+        bad = example_path('data/no_such_image.bmp')
+        self.assertRaises(ValueError, pygame.image.load_async, good,
+                          type=pygame.KEYDOWN)
+
+        pygame.display.init()
+        try:
+            self.assertRaises(TypeError, pygame.image.load_async, 1)
+            pygame.event.clear()
+            pygame.image.load_async(good, tag='sprite')
+            pygame.image.load_async(bad, 2, pygame.USEREVENT + 1)
+
+            types = [pygame.USEREVENT, pygame.USEREVENT + 1]
+            events = []
+            deadline = time.time() + 10
+            while len(events) < 2 and time.time() < deadline:
+                events.extend(pygame.event.get(types))
+                time.sleep(0.01)
+            self.assertEqual(len(events), 2)
+
+            loaded, failed = events
+            self.assertEqual(loaded.type, pygame.USEREVENT)
+            self.assertEqual(loaded.tag, 'sprite')
+            self.assertEqual(loaded.path, good)
+            self.assertEqual(loaded.error, None)
+            expected = pygame.image.load(good)
+            self.assertEqual(loaded.surface.get_size(), expected.get_size())
+            self.assertEqual(pygame.image.tostring(loaded.surface, 'RGB'),
+                             pygame.image.tostring(expected, 'RGB'))
+
+            self.assertEqual(failed.type, pygame.USEREVENT + 1)
+            self.assertEqual(failed.tag, 2)
+            self.assertEqual(failed.surface, None)
+            self.assertTrue(failed.error)
+        finally:
+            pygame.display.quit()
+
+    def test_load_async__buffer(self):
+        """ load_async loads from objects with the buffer protocol, and
+        lets go of them once loaded.
+        """
+        import time
+
+        path = example_path('data/asprite.bmp')
+        expected = pygame.image.load(path)
+        f = open(path, 'rb')
+        try:
+            data = f.read()
+        finally:
+            f.close()
+
+        pygame.display.init()
+        try:
+            f = open(path, 'rb')
+            try:
+                self.assertRaises(TypeError, pygame.image.load_async, f)
+            finally:
+                f.close()
+
+            pygame.event.clear()
+            sources = [bytearray(data), memoryview(bytearray(data)),
+                       bytearray(data[:20])]
+            for i, source in enumerate(sources):
+                pygame.image.load_async(source, i, namehint='asprite.bmp')
+
+            events = []
+            deadline = time.time() + 10
+            while len(events) < len(sources) and time.time() < deadline:
+                events.extend(pygame.event.get(pygame.USEREVENT))
+                time.sleep(0.01)
+            self.assertEqual([e.tag for e in events], [0, 1, 2])
+
+            for e in events[:2]:
+                self.assertTrue(e.path is sources[e.tag])
+                self.assertEqual(e.error, None)
+                self.assertEqual(pygame.image.tostring(e.surface, 'RGB'),
+                                 pygame.image.tostring(expected, 'RGB'))
+            self.assertEqual(events[2].surface, None)
+            self.assertTrue(events[2].error)
+
+            # The loader thread has released the buffers: they can resize.
+            sources[0].extend(as_bytes('x'))
+            sources[2].extend(as_bytes('x'))
+        finally:
+            pygame.display.quit()
+
+    def test_save_pack__and_load_pack(self):
+        """ images and masks come back from a texture pack unchanged.
+        """
+        import pygame.mask
+
+        rgba = pygame.Surface((7, 5), pygame.SRCALPHA, 32)
+        rgba.fill((10, 20, 30, 40))
+        rgba.set_at((3, 2), (200, 100, 50, 255))
+        indexed = pygame.Surface((3, 9), 0, 8)
+        indexed.set_palette_at(1, (1, 2, 3))
+        indexed.fill(1, (0, 0, 3, 4))
+        indexed.set_colorkey(1)
+        rgb = pygame.Surface((5, 3), 0, 24)
+        rgb.fill((90, 80, 70))
+        rgb.set_alpha(128)
+        surfaces = {'rgba': rgba, 'indexed': indexed, 'rgb': rgb,
+                    'empty': pygame.Surface((0, 4), 0, 32)}
+        masks = {'rgba': pygame.mask.from_surface(rgba)}
+
+        f_descriptor, f_path = tempfile.mkstemp(suffix='.pack')
+        os.close(f_descriptor)
+        try:
+            pygame.image.save_pack(f_path, surfaces, masks)
+            loaded, loaded_masks = pygame.image.load_pack(f_path)
+
+            self.assertEqual(sorted(loaded.keys()), sorted(surfaces.keys()))
+            for name, surf in surfaces.items():
+                result = loaded[name]
+                self.assertEqual(result.get_size(), surf.get_size())
+                self.assertEqual(result.get_bitsize(), surf.get_bitsize())
+                self.assertEqual(result.get_masks(), surf.get_masks())
+                self.assertEqual(result.get_colorkey(), surf.get_colorkey())
+                self.assertEqual(result.get_alpha(), surf.get_alpha())
+                for y in range(surf.get_height()):
+                    for x in range(surf.get_width()):
+                        self.assertEqual(result.get_at((x, y)),
+                                         surf.get_at((x, y)))
+
+            self.assertEqual(list(loaded_masks.keys()), ['rgba'])
+            mask = loaded_masks['rgba']
+            self.assertEqual(mask.get_size(), (7, 5))
+            self.assertEqual(mask.count(), 1)
+            self.assertEqual(mask.get_at((3, 2)), 1)
+
+            # Drawing on a loaded surface leaves the pack alone.
+            loaded['rgb'].fill((0, 0, 0))
+            del loaded, loaded_masks, result
+            again = pygame.image.load_pack(f_path)[0]
+            self.assertEqual(again['rgb'].get_at((0, 0)), (90, 80, 70, 255))
+            del again
+        finally:
+            os.remove(f_path)
+
+        self.assertRaises(TypeError, pygame.image.save_pack, f_path,
+                          {'x': 1})
+        self.assertRaises(ValueError, pygame.image.save_pack, f_path,
+                          {'rgb': rgb}, {'rgb': masks['rgba']})
+        self.assertFalse(os.path.exists(f_path))
+        self.assertRaises(pygame.error, pygame.image.load_pack,
+                          example_path('data/asprite.bmp'))
+
+    def test_save__options(self):
+        """ the encoder options are used and round trip correctly.
+        """
+        surf = pygame.Surface((64, 48), 0, 24)
+        for y in range(48):
+            for x in range(64):
+                surf.set_at((x, y), (x * 4, y * 5, (x ^ y) & 0xff))
+
+        self.assertRaises(ValueError, pygame.image.save, surf, 'x.png',
+                          quality=0)
+        self.assertRaises(ValueError, pygame.image.save, surf, 'x.png',
+                          compression=10)
+        self.assertRaises(ValueError, pygame.image.save, surf, 'x.png',
+                          filters=1)
+        if not pygame.image.get_extended():
+            return
+
+        def saved_size(suffix, **options):
+            f_path = tempfile.mktemp(suffix=suffix)
+            try:
+                pygame.image.save(surf, f_path, **options)
+                size = os.path.getsize(f_path)
+                loaded = pygame.image.load(f_path)
+                if suffix == '.png':
+                    self.assertEqual(pygame.image.tostring(loaded, 'RGB'),
+                                     pygame.image.tostring(surf, 'RGB'))
+            finally:
+                os.remove(f_path)
+            return size
+
+        self.assertTrue(saved_size('.png', compression=0) >
+                        saved_size('.png', compression=9))
+        saved_size('.png', filters=pygame.image.PNG_FILTER_NONE)
+        saved_size('.png', filters=(pygame.image.PNG_FILTER_SUB |
+                                    pygame.image.PNG_FILTER_PAETH))
+        self.assertTrue(saved_size('.jpg', quality=95) >
+                        saved_size('.jpg', quality=10))
+
+        # Big enough to be compressed on several threads.
+        big = pygame.Surface((700, 500), pygame.SRCALPHA, 32)
+        for x in range(0, 700, 7):
+            big.fill((x % 256, 255 - x % 256, 90, x % 200 + 20),
+                     (x, 0, 7, 500))
+        for y in range(0, 500, 3):
+            big.fill((y % 256, 40, 200, 255), (y, y, 30, 3))
+        for compression in (-1, 0, 9):
+            f_path = tempfile.mktemp(suffix='.png')
+            try:
+                pygame.image.save(big, f_path, compression=compression)
+                loaded = pygame.image.load(f_path)
+            finally:
+                os.remove(f_path)
+            self.assertEqual(pygame.image.tostring(loaded, 'RGBA'),
+                             pygame.image.tostring(big, 'RGBA'))
+
+    def test_save_async(self):
+        """ save_async writes the file and then posts a user event.
+        """
+        import time
+
+        surf = pygame.Surface((20, 10), 0, 32)
+        surf.fill((10, 200, 30))
+        self.assertRaises(ValueError, pygame.image.save_async, surf,
+                          'x.bmp', type=pygame.KEYDOWN)
+        self.assertRaises(ValueError, pygame.image.save_async, surf,
+                          'x.jpg', quality=101)
+
+        f_path = tempfile.mktemp(suffix='.bmp')
+        bad_path = os.path.join(f_path + '.missing', 'x.bmp')
+        pygame.display.init()
+        try:
+            pygame.event.clear()
+            pygame.image.save_async(surf, f_path, tag='shot')
+            # The pixels were copied; changing the surface is safe.
+            surf.fill((0, 0, 0))
+            pygame.image.save_async(surf, bad_path, 2, pygame.USEREVENT + 1)
+
+            types = [pygame.USEREVENT, pygame.USEREVENT + 1]
+            events = []
+            deadline = time.time() + 10
+            while len(events) < 2 and time.time() < deadline:
+                events.extend(pygame.event.get(types))
+                time.sleep(0.01)
+            self.assertEqual(len(events), 2)
+
+            saved, failed = events
+            self.assertEqual(saved.tag, 'shot')
+            self.assertEqual(saved.path, f_path)
+            self.assertEqual(saved.error, None)
+            loaded = pygame.image.load(f_path)
+            self.assertEqual(loaded.get_at((5, 5)), (10, 200, 30, 255))
+
+            self.assertEqual(failed.type, pygame.USEREVENT + 1)
+            self.assertEqual(failed.tag, 2)
+            self.assertTrue(failed.error)
+        finally:
+            pygame.display.quit()
+            if os.path.exists(f_path):
+                os.remove(f_path)
+
     def testSaveJPG(self):
         """ JPG equivalent to issue #211 - color channel swapping
 
@@ -235,9 +633,10 @@ class ImageModuleTest( unittest.TestCase ):
         magic_hex['png'] = [0x89 ,0x50 ,0x4e ,0x47]
         magic_hex['tga'] = [0x0, 0x0, 0xa]
         magic_hex['bmp'] = [0x42, 0x4d]
+        magic_hex['qoi'] = [0x71, 0x6f, 0x69, 0x66]
 
 
-        formats = ["jpg", "png", "tga", "bmp"]
+        formats = ["jpg", "png", "tga", "bmp", "qoi"]
         # uppercase too... JPG
         formats = formats + [x.upper() for x in formats]
 
@@ -260,6 +659,105 @@ class ImageModuleTest( unittest.TestCase ):
                 pass
 
                 
+    def test_save__and_load_qoi_tga(self):
+        """ see if QOI and TGA files, read and written by pygame itself, keep
+        every pixel, and that QOI matches PNG.
+        """
+        w, h = 67, 45
+        surfaces = [pygame.Surface((w, h), pygame.SRCALPHA, 32),
+                    pygame.Surface((w, h), 0, 32),
+                    pygame.Surface((w, h), 0, 24),
+                    pygame.Surface((w, h), 0, 8)]
+        for surf in surfaces:
+            for y in xrange_(h):
+                for x in xrange_(w):
+                    if x < 20:
+                        # runs for the RLE and QOI run chunks
+                        color = (40, 80, 120, 200)
+                    else:
+                        color = (x * 3 % 256, (x + y) % 256, y * 5 % 256,
+                                 (x * y) % 256)
+                    surf.set_at((x, y), color)
+
+        keyed = pygame.Surface((w, h), 0, 8)
+        keyed.fill((10, 20, 30))
+        keyed.fill((1, 2, 3), (5, 5, 10, 10))
+        keyed.set_colorkey((1, 2, 3))
+
+        handle, qoi_name = tempfile.mkstemp(".qoi")
+        os.close(handle)
+        handle, tga_name = tempfile.mkstemp(".tga")
+        os.close(handle)
+        try:
+            for surf in surfaces:
+                for name in (qoi_name, tga_name):
+                    pygame.image.save(surf, name)
+                    loaded = pygame.image.load(name)
+                    f = open(name, "rb")
+                    try:
+                        from_file = pygame.image.load(f, name)
+                    finally:
+                        f.close()
+                    self.assertEqual(loaded.get_size(), (w, h))
+                    for y in xrange_(h):
+                        for x in xrange_(w):
+                            expected = surf.get_at((x, y))
+                            if not surf.get_flags() & pygame.SRCALPHA:
+                                expected.a = 255
+                            self.assertEqual(loaded.get_at((x, y)), expected)
+                            self.assertEqual(from_file.get_at((x, y)),
+                                             expected)
+
+            pygame.image.save(keyed, qoi_name)
+            loaded = pygame.image.load(qoi_name)
+            self.assertEqual(loaded.get_at((0, 0)), (10, 20, 30, 255))
+            self.assertEqual(loaded.get_at((7, 7)).a, 0)
+
+            open(qoi_name, "wb").write(as_bytes("qoif"))
+            self.assertRaises(pygame.error, pygame.image.load, qoi_name)
+
+            if pygame.image.get_extended():
+                # QOI is lossless like PNG
+                handle, png_name = tempfile.mkstemp(".png")
+                os.close(handle)
+                try:
+                    surf = surfaces[0]
+                    pygame.image.save(surf, png_name)
+                    pygame.image.save(surf, qoi_name)
+                    self.assertEqual(
+                        pygame.image.tostring(pygame.image.load(png_name),
+                                              "RGBA"),
+                        pygame.image.tostring(pygame.image.load(qoi_name),
+                                              "RGBA"))
+                finally:
+                    os.remove(png_name)
+        finally:
+            os.remove(qoi_name)
+            os.remove(tga_name)
+
+    def test_save__qoi_long_run_at_end(self):
+        """ see if a QOI image ending in a large solid area, whose run
+        chunks alone fill the encoder buffer, is written whole.
+        """
+        w, h = 2048, 2100
+        surf = pygame.Surface((w, h), pygame.SRCALPHA, 32)
+        surf.fill((90, 60, 30, 255))
+        for y in xrange_(4):
+            for x in xrange_(w):
+                surf.set_at((x, y), (x % 256, (x * 7 + y) % 256, y * 50,
+                                     (x * 3) % 256))
+
+        handle, qoi_name = tempfile.mkstemp(".qoi")
+        os.close(handle)
+        try:
+            pygame.image.save(surf, qoi_name)
+            loaded = pygame.image.load(qoi_name)
+            self.assertEqual(loaded.get_size(), (w, h))
+            self.assertEqual(pygame.image.tostring(loaded, "RGBA"),
+                             pygame.image.tostring(surf, "RGBA"))
+        finally:
+            os.remove(qoi_name)
+
     def test_save_colorkey(self):
         """ make sure the color key is not changed when saving.
         """
@@ -407,6 +905,56 @@ class ImageModuleTest( unittest.TestCase ):
         self.assert_(AreSurfacesIdentical(test_surface, test_to_from_argb_string))
         #"ERROR: image.fromstring and image.tostring with ARGB are not symmetric"
 
+    def test_tobuffer(self):
+        """ see if tobuffer writes what tostring returns.
+        """
+        w, h = 13, 7
+        surfaces = [pygame.Surface((w, h), pygame.SRCALPHA, 32),
+                    pygame.Surface((w, h), 0, 32),
+                    pygame.Surface((w, h), 0, 32,
+                                   (0xff0000, 0xff00, 0xff, 0)),
+                    pygame.Surface((w, h), 0, 24),
+                    pygame.Surface((w, h), 0, 24,
+                                   (0xff, 0xff00, 0xff0000, 0)),
+                    pygame.Surface((w, h), 0, 16),
+                    pygame.Surface((w, h), 0, 8)]
+        for surf in surfaces:
+            for y in xrange_(h):
+                for x in xrange_(w):
+                    surf.set_at((x, y), (x * 19 % 256, y * 37 % 256,
+                                         (x + y) * 11 % 256, (x * y) % 256))
+            for format, size in [("RGB", 3), ("RGBX", 4),
+                                 ("RGBA", 4), ("ARGB", 4)]:
+                for flipped in (False, True):
+                    expected = pygame.image.tostring(surf, format, flipped)
+                    buf = bytearray(w * h * size + 5)
+                    pygame.image.tobuffer(surf, format, buf, flipped)
+                    self.assertEqual(bytes(buf[:w * h * size]), expected)
+                    self.assertEqual(bytes(buf[w * h * size:]), as_bytes('\0' * 5))
+
+                # The byte copying paths must still match get_at.
+                if surf.get_bitsize() < 24:
+                    continue
+                data = bytearray(pygame.image.tostring(surf, format))
+                for y in xrange_(h):
+                    for x in xrange_(w):
+                        c = surf.get_at((x, y))
+                        i = (y * w + x) * size
+                        pixel = list(data[i:i + size])
+                        if format == "ARGB":
+                            pixel = pixel[1:] + pixel[:1]
+                        self.assertEqual(pixel[:3], [c.r, c.g, c.b])
+                        if format in ("RGBA", "ARGB"):
+                            self.assertEqual(pixel[3], c.a)
+
+        surf = surfaces[0]
+        self.assertRaises(ValueError, pygame.image.tobuffer,
+                          surf, "RGBA", bytearray(w * h * 4 - 1))
+        self.assertRaises(ValueError, pygame.image.tobuffer,
+                          surf, "P", bytearray(w * h))
+        self.assertRaises(Exception, pygame.image.tobuffer,
+                          surf, "RGBA", as_bytes('\0' * (w * h * 4)))
+
     def todo_test_frombuffer(self):
 
         # __doc__ (as of 2008-08-02) for pygame.image.frombuffer:
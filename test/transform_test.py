@@ -463,6 +463,78 @@ class TransformModuleTest( unittest.TestCase ):
                                              (44,44,44,255), False, s2)
             self.assertEqual(num_threshold_pixels, 0)
 
+    def test_threshold__mask(self):
+        # A Mask as DestSurface gets a bit for each pixel counted.
+        threshold = pygame.transform.threshold
+
+        s1 = pygame.Surface((70, 5), SRCALPHA, 32)
+        s1.fill((40, 40, 40))
+        s1.set_at((0, 0), (170, 170, 170))
+        s1.set_at((69, 4), (170, 170, 170))
+        mask = pygame.mask.Mask((70, 5))
+        mask.fill()
+
+        num_threshold_pixels = threshold(mask, s1, (30, 30, 30), (11, 11, 11))
+        self.assertEqual(num_threshold_pixels, 70 * 5 - 2)
+        self.assertEqual(mask.count(), num_threshold_pixels)
+        self.assertEqual(mask.get_at((0, 0)), 0)
+        self.assertEqual(mask.get_at((69, 4)), 0)
+        self.assertEqual(mask.get_at((68, 4)), 1)
+
+        num_threshold_pixels = threshold(mask, s1, (30, 30, 30), (11, 11, 11),
+                                         (0, 0, 0), 1, None, True)
+        self.assertEqual(num_threshold_pixels, 2)
+        self.assertEqual(mask.count(), 2)
+        self.assertEqual(mask.get_at((69, 4)), 1)
+
+        # Count only.
+        self.assertEqual(threshold(None, s1, (170, 170, 170)), 2)
+
+        # 16 bit surfaces take the per pixel path.
+        s2 = pygame.Surface((70, 5), 0, 16)
+        s2.fill((40, 40, 40))
+        s2.set_at((3, 2), (170, 170, 170))
+        self.assertEqual(threshold(mask, s2, (40, 40, 40), (11, 11, 11)),
+                         70 * 5 - 1)
+        self.assertEqual(mask.count(), 70 * 5 - 1)
+        self.assertEqual(mask.get_at((3, 2)), 0)
+
+        self.assertRaises(ValueError, threshold,
+                          pygame.mask.Mask((10, 10)), s1, (0, 0, 0))
+        self.assertRaises(TypeError, threshold, 1, s1, (0, 0, 0))
+
+    def test_threshold__large_surface(self):
+        # Big enough to be split into bands of rows.
+        threshold = pygame.transform.threshold
+        w, h = 640, 480
+
+        s1 = pygame.Surface((w, h), 0, 32)
+        s2 = pygame.Surface((w, h), 0, 32)
+        dest_surface = pygame.Surface((w, h), 0, 32)
+        s1.fill((100, 100, 100))
+        s2.fill((105, 95, 100))
+        for y in range(0, h, 7):
+            s1.set_at((y % w, y), (200, 100, 100))
+
+        num_changed = len(range(0, h, 7))
+        num_threshold_pixels = threshold(dest_surface, s1, (0, 0, 0),
+                                         (5, 5, 5), (255, 0, 0), 2, s2)
+        self.assertEqual(num_threshold_pixels, w * h - num_changed)
+        self.assertEqual(dest_surface.get_at((1, 0)), (100, 100, 100, 255))
+        self.assertEqual(dest_surface.get_at((0, 0)), (255, 0, 0, 255))
+        self.assertEqual(dest_surface.get_at((w - 1, h - 1)),
+                         (100, 100, 100, 255))
+        self.assertEqual(dest_surface.get_at((7, 7)), (255, 0, 0, 255))
+
+        # A larger destination keeps diff_color outside the compared area.
+        big_dest = pygame.Surface((w + 10, h + 10), 0, 32)
+        threshold(big_dest, s1, (100, 100, 100), (0, 0, 0), (0, 0, 255), 1)
+        self.assertEqual(big_dest.get_at((w + 5, h + 5)), (0, 0, 255, 255))
+        self.assertEqual(big_dest.get_at((1, 0)), (100, 100, 100, 255))
+
+        self.assertRaises(ValueError, threshold,
+                          pygame.Surface((10, 10), 0, 32), s1, (0, 0, 0))
+
 
 
 
@@ -499,6 +571,81 @@ class TransformModuleTest( unittest.TestCase ):
         self.assertEqual(s2.get_at((0,31)), (255,0,0,255))
         self.assertEqual(s2.get_at((31,31)), (255,0,0,255))
 
+    def test_box_blur(self):
+        s1 = pygame.Surface((20, 10), 0, 32)
+        s1.fill((0, 0, 0))
+        pygame.draw.line(s1, (90, 150, 30), (10, 0), (10, 9))
+
+        s2 = pygame.transform.box_blur(s1, 1)
+        self.assertEqual(s2.get_size(), s1.get_size())
+        for x in (9, 10, 11):
+            self.assertEqual(s2.get_at((x, 5)), (30, 50, 10, 255))
+        self.assertEqual(s2.get_at((8, 5)), (0, 0, 0, 255))
+        self.assertEqual(s2.get_at((12, 0)), (0, 0, 0, 255))
+
+        # edges repeat, so a flat surface stays flat at any radius.
+        s1.fill((10, 200, 70))
+        s3 = pygame.Surface((20, 10), 0, 32)
+        self.assertTrue(pygame.transform.box_blur(s1, 25, s3) is s3)
+        for pos in ((0, 0), (19, 9), (7, 3)):
+            self.assertEqual(s3.get_at(pos), (10, 200, 70, 255))
+
+        # blurring in place, and radius 0 copies.
+        pygame.transform.box_blur(s1, 0, s1)
+        self.assertEqual(s1.get_at((3, 3)), (10, 200, 70, 255))
+
+        self.assertRaises(ValueError, pygame.transform.box_blur, s1, -1)
+        self.assertRaises(ValueError, pygame.transform.box_blur,
+                          pygame.Surface((20, 10), 0, 8), 1)
+        self.assertRaises(ValueError, pygame.transform.box_blur,
+                          s1, 1, pygame.Surface((10, 10), 0, 32))
+
+    def test_gaussian_blur(self):
+        s1 = pygame.Surface((40, 8), 0, 24)
+        s1.fill((0, 0, 0))
+        s1.fill((200, 100, 50), (20, 0, 20, 8))
+
+        s2 = pygame.transform.gaussian_blur(s1, 6)
+        self.assertEqual(s2.get_at((0, 4)), (0, 0, 0, 255))
+        self.assertEqual(s2.get_at((39, 4)), (200, 100, 50, 255))
+        last = -1
+        for x in range(40):
+            r = s2.get_at((x, 4))[0]
+            self.assertTrue(r >= last)
+            last = r
+        self.assertTrue(0 < s2.get_at((19, 4))[0] < 200)
+        self.assertTrue(0 < s2.get_at((20, 4))[0] < 200)
+
+        s2 = pygame.transform.gaussian_blur(s1, 0)
+        self.assertEqual(s2.get_at((19, 4)), (0, 0, 0, 255))
+        self.assertEqual(s2.get_at((20, 4)), (200, 100, 50, 255))
+
+    def test_convolve(self):
+        s1 = pygame.Surface((20, 10), pygame.SRCALPHA, 32)
+        s1.fill((0, 0, 0, 0))
+        pygame.draw.line(s1, (100, 40, 20, 200), (10, 0), (10, 9))
+
+        s2 = pygame.transform.convolve(s1, [1])
+        self.assertEqual(s2.get_at((10, 3)), (100, 40, 20, 200))
+
+        # the middle weight lands on the pixel itself.
+        s2 = pygame.transform.convolve(s1, [0, 0, 1], [1])
+        self.assertEqual(s2.get_at((9, 3)), (100, 40, 20, 200))
+        self.assertEqual(s2.get_at((10, 3)), (0, 0, 0, 0))
+
+        s2 = pygame.transform.convolve(s1, [.25, .5, .25], [1])
+        self.assertEqual(s2.get_at((9, 3)), (25, 10, 5, 50))
+        self.assertEqual(s2.get_at((10, 3)), (50, 20, 10, 100))
+
+        # results are clamped.
+        s2 = pygame.transform.convolve(s1, [-1, 3, -1])
+        self.assertEqual(s2.get_at((9, 3)), (0, 0, 0, 0))
+        self.assertEqual(s2.get_at((10, 3)), (255, 120, 60, 255))
+
+        self.assertRaises(ValueError, pygame.transform.convolve, s1, [.5, .5])
+        self.assertRaises(ValueError, pygame.transform.convolve, s1, [])
+        self.assertRaises(TypeError, pygame.transform.convolve, s1, [1, 'a', 1])
+
     def test_average_surfaces(self):
         """
         """
@@ -577,6 +724,84 @@ class TransformModuleTest( unittest.TestCase ):
             self.assertEqual(pygame.transform.average_color(s),(5,75,150,0))
             self.assertEqual(pygame.transform.average_color(s, (16,0,16,32)), (0,100,200,0))
 
+    def test_average_color__32_alpha(self):
+        # Wide enough for the 32 bit path to take several 4 pixel steps.
+        s = pygame.Surface((66, 3), SRCALPHA, 32)
+        s.fill((0, 100, 200, 40))
+        s.fill((10, 50, 100, 20), (0, 0, 33, 3))
+
+        self.assertEqual(pygame.transform.average_color(s),
+                         (5, 75, 150, 30))
+        self.assertEqual(pygame.transform.average_color(s, (33, 1, 33, 2)),
+                         (0, 100, 200, 40))
+
+    def test_running_average__window(self):
+        RunningAverage = pygame.transform.RunningAverage
+
+        w, h = 21, 5
+        frames = []
+        for value in (10, 20, 60, 100):
+            s = pygame.Surface((w, h), 0, 32)
+            s.fill((value, value // 2, 255 - value))
+            frames.append(s)
+
+        ra = RunningAverage((w, h), window=3)
+        self.assertEqual(ra.get_size(), (w, h))
+        self.assertEqual(ra.get_count(), 0)
+        self.assertRaises(ValueError, ra.get_surface)
+
+        ra.add(frames[0])
+        ra.add(frames[1])
+        self.assertEqual(ra.get_count(), 2)
+        avg = ra.get_surface()
+        self.assertEqual(avg.get_size(), (w, h))
+        self.assertEqual(avg.get_at((0, 0))[:3], (15, 8, 240))
+        self.assertEqual(avg.get_at((w - 1, h - 1))[:3], (15, 8, 240))
+
+        # A full window drops the oldest frame: (20 + 60 + 100) / 3
+        ra.add(frames[2])
+        ra.add(frames[3])
+        self.assertEqual(ra.get_count(), 3)
+        self.assertEqual(ra.get_surface().get_at((3, 2))[:3], (60, 30, 195))
+
+        ra.remove()
+        self.assertEqual(ra.get_count(), 2)
+        dest = pygame.Surface((w, h), 0, 24)
+        self.assert_(ra.get_surface(dest) is dest)
+        self.assertEqual(dest.get_at((w - 1, 0))[:3], (80, 40, 175))
+
+        ra.clear()
+        self.assertEqual(ra.get_count(), 0)
+        self.assertRaises(ValueError, ra.remove)
+
+        # Other formats are converted when added.
+        s16 = pygame.Surface((w, h), 0, 16)
+        s16.fill((0, 0, 0))
+        ra.add(s16)
+        self.assertEqual(ra.get_surface().get_at((0, 0))[:3], (0, 0, 0))
+
+        self.assertRaises(ValueError, ra.add, pygame.Surface((w + 1, h)))
+        self.assertRaises(ValueError, RunningAverage, (w, h), window=0)
+        self.assertRaises(ValueError, RunningAverage, (w, h), window=257)
+
+    def test_running_average__exponential(self):
+        RunningAverage = pygame.transform.RunningAverage
+
+        w, h = 9, 4
+        ra = RunningAverage((w, h), weight=0.5)
+        s = pygame.Surface((w, h), 0, 32)
+
+        s.fill((200, 100, 0))
+        ra.add(s)
+        self.assertEqual(ra.get_surface().get_at((0, 0))[:3], (200, 100, 0))
+        s.fill((0, 100, 200))
+        ra.add(s)
+        self.assertEqual(ra.get_surface().get_at((w - 1, h - 1))[:3],
+                         (100, 100, 100))
+        self.assertEqual(ra.get_count(), 2)
+        self.assertRaises(ValueError, ra.remove)
+        self.assertRaises(ValueError, RunningAverage, (w, h), weight=1.5)
+
     def todo_test_rotate(self):
 
         # __doc__ (as of 2008-06-25) for pygame.transform.rotate:
@@ -624,6 +849,71 @@ class TransformModuleTest( unittest.TestCase ):
         s2 = pygame.transform.scale2x(s)
         self.assertEquals(s2.get_rect().size, (64, 64))
 
+    def _pixel_art_surface(self, depth):
+        # a diagonal edge, which all the pixel art scalers smooth.
+        s = pygame.Surface((6, 6), 0, depth)
+        s.fill((0, 0, 0))
+        for x in range(6):
+            for y in range(x + 1):
+                s.set_at((x, y), (255, 255, 255))
+        return s
+
+    def test_scale2x__depths(self):
+        for depth in (8, 16, 24, 32):
+            s = self._pixel_art_surface(depth)
+            white, black = s.get_at((5, 0)), s.get_at((0, 5))
+            s2 = pygame.transform.scale2x(s)
+            self.assertEqual(s2.get_size(), (12, 12))
+            self.assertEqual(s2.get_at((0, 0)), white)
+            self.assertEqual(s2.get_at((0, 11)), black)
+            # the step next to (0, 1) is filled in.
+            self.assertEqual(s2.get_at((1, 2)), white)
+            self.assertEqual(s2.get_at((0, 2)), black)
+            self.assertEqual(s2.get_at((0, 3)), black)
+
+    def test_scale3x(self):
+        s = self._pixel_art_surface(32)
+        s3 = pygame.transform.scale3x(s)
+        self.assertEqual(s3.get_size(), (18, 18))
+        self.assertEqual(s3.get_at((4, 4)), (255, 255, 255, 255))
+        self.assertEqual(s3.get_at((1, 3)), (255, 255, 255, 255))
+        self.assertEqual(s3.get_at((4, 7)), (0, 0, 0, 255))
+
+        dest = pygame.Surface((18, 18), 0, 32)
+        self.assertTrue(pygame.transform.scale3x(s, dest) is dest)
+        self.assertRaises(ValueError, pygame.transform.scale3x, s,
+                          pygame.Surface((12, 12), 0, 32))
+
+    def test_scale4x(self):
+        for depth in (8, 24, 32):
+            s = self._pixel_art_surface(depth)
+            s4 = pygame.transform.scale4x(s)
+            twice = pygame.transform.scale2x(pygame.transform.scale2x(s))
+            self.assertEqual(s4.get_size(), (24, 24))
+            for x in range(24):
+                for y in range(24):
+                    self.assertEqual(s4.get_at((x, y)), twice.get_at((x, y)))
+
+    def test_xbr2x(self):
+        s = self._pixel_art_surface(32)
+        s2 = pygame.transform.xbr2x(s)
+        self.assertEqual(s2.get_size(), (12, 12))
+        self.assertEqual(s2.get_at((11, 0)), (255, 255, 255, 255))
+        self.assertEqual(s2.get_at((0, 11)), (0, 0, 0, 255))
+
+        # pixels along the edge are blended.
+        r = s2.get_at((1, 2))[0]
+        self.assertTrue(0 < r < 255)
+
+        # flat areas are left alone.
+        s.fill((10, 20, 30))
+        dest = pygame.Surface((12, 12), 0, 32)
+        pygame.transform.xbr2x(s, dest)
+        self.assertEqual(dest.get_at((5, 7)), (10, 20, 30, 255))
+
+        self.assertRaises(ValueError, pygame.transform.xbr2x,
+                          pygame.Surface((6, 6), 0, 8))
+
     def test_get_smoothscale_backend(self):
         filter_type = pygame.transform.get_smoothscale_backend()
         self.failUnless(filter_type in ['GENERIC', 'MMX', 'SSE'])